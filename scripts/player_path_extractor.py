@@ -15,7 +15,7 @@ infile = sys.argv[1]
 db = sqlite3.connect(infile)
 
 # Get the player positions from the Player Action table
-query = 'SELECT time, position_x, position_y, position_z FROM Player_Action'
+query = 'SELECT time, position_x, position_y, position_z FROM Player_Action_Text_Time'
 c = db.cursor()
 c.execute(query)
 rows = c.fetchall()
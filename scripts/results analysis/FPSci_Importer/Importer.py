@@ -116,7 +116,7 @@ class Importer:
         return events
 
     def getTrialTargetPositionsXYZ(self, trial, targetId=None):
-        query = "SELECT * FROM Target_Trajectory WHERE [time] <= \'{0}\' AND [time] >= \'{1}\'".format(trial.endTime, trial.startTime)
+        query = "SELECT * FROM Target_Trajectory_Text_Time WHERE [time] <= \'{0}\' AND [time] >= \'{1}\'".format(trial.endTime, trial.startTime)
         if targetId is not None: query += ' AND [target_id] = \'{2}\''.format(targetId)
         positions = {}
         for row in self.queryDb(query): 
@@ -155,7 +155,7 @@ class Importer:
     def getTrialPlayerActions(self, trial):
         """Get all player actions from a particular trial"""
         actions = []
-        for row in self.queryDb("SELECT * FROM Player_Action WHERE [time] <= \'" + trial.endTime + "\' AND [time] >= \'" + trial.startTime + "\'"): 
+        for row in self.queryDb("SELECT * FROM Player_Action_Text_Time WHERE [time] <= \'" + trial.endTime + "\' AND [time] >= \'" + trial.startTime + "\'"): 
             actions.append(PlayerAction(row[0], row[1], row[2], row[3], row[4] , row[5], row[6], row[7]))
         return actions
 
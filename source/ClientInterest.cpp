@@ -0,0 +1,110 @@
+#include "ClientInterest.h"
+#include "PhysicsScene.h"
+
+int ClientInterest::entityBytes(const EntityState& state, const EntityState* baseline, bool delta) {
+	if (!delta) return BatchEntityUpdatePacket::REPLACE_BYTES_PER_ENTITY;
+	uint8 changed = BatchEntityUpdatePacket::EntityDelta::ALL_FIELDS;
+	if (notNull(baseline)) {
+		changed = 0;
+		if (baseline->position != state.position) changed |= BatchEntityUpdatePacket::EntityDelta::POSITION;
+		if (baseline->rotation != state.rotation) changed |= BatchEntityUpdatePacket::EntityDelta::ROTATION;
+		if (changed == 0) return 0;
+	}
+	return BatchEntityUpdatePacket::deltaBytes(BatchEntityUpdatePacket::EntityDelta(state, changed));
+}
+
+void ClientInterest::select(const InterestConfig& config, const CFrame& viewer, uint16 viewerIndex, const PhysicsScene* scene,
+	const Snapshot& current, const Array<float>& priorities, const Snapshot* baseline, bool delta, RealTime now, Snapshot& result)
+{
+	m_stats = Stats();
+
+	// Refill the budget (holding at most 100 ms of it, or a datagram, for bursts), each update's header comes out of it
+	const bool budgeted = config.bandwidthKbps > 0.0f;
+	if (budgeted) {
+		const double bytesPerSecond = config.bandwidthKbps * 1000.0 / 8.0;
+		const RealTime elapsed = isNaN(m_lastTime) ? 0.0 : max(0.0, now - m_lastTime);
+		m_budgetBytes = min(m_budgetBytes + bytesPerSecond * elapsed, max(bytesPerSecond * 0.1, (double)BatchEntityUpdatePacket::MAX_DATAGRAM_BYTES));
+		m_budgetBytes -= BatchEntityUpdatePacket::HEADER_BYTES;
+	}
+	m_lastTime = now;
+
+	const float cosHalfCone = (config.viewConeDegrees >= 360.0f) ? -2.0f : cosf(toRadians(config.viewConeDegrees * 0.5f));
+	const Vector3 look = viewer.lookVector();
+	m_candidates.fastClear();
+	m_chosen.resize(current.size());
+	int b = 0;
+	for (int i = 0; i < current.size(); i++) {
+		m_chosen[i] = false;
+		const EntityState& state = current[i];
+		// Both snapshots are sorted by index, so walk them together
+		while (notNull(baseline) && b < baseline->size() && (*baseline)[b].index < state.index) b++;
+		const EntityState* baselineState = (notNull(baseline) && b < baseline->size() && (*baseline)[b].index == state.index) ? &(*baseline)[b] : nullptr;
+
+		if (state.index == viewerIndex) continue;
+		const Vector3 toEntity = BatchEntityUpdatePacket::unpackPosition(state.position) - viewer.translation;
+		const float distance = toEntity.length();
+		if (distance > config.maxDistance) continue;
+		m_stats.relevant++;
+
+		bool visible = (distance <= 0.0f) || (toEntity.dot(look) >= cosHalfCone * distance);
+		if (visible && config.occlusion && notNull(scene)) {
+			visible = scene->staticLineOfSight(viewer.translation, viewer.translation + toEntity);
+		}
+		if (visible) m_stats.visible++;
+
+		if (state.index >= m_entities.size()) m_entities.resize(state.index + 1);
+		EntityInterest& interest = m_entities[state.index];
+		const float rateHz = visible ? config.visibleRateHz : config.hiddenRateHz;
+		if (rateHz > 0.0f && now - interest.lastSent < 1.0 / rateHz) continue;
+		m_stats.due++;
+
+		const int bytes = entityBytes(state, baselineState, delta);
+		if (bytes == 0) {
+			// The client already has this state
+			interest.accumulated = 0.0f;
+			interest.lastSent = now;
+			continue;
+		}
+		// Nearer entities gather priority faster (down to half the rate at the max distance)
+		interest.accumulated += priorities[i] * (visible ? 1.0f : config.hiddenPriority) * (1.0f - 0.5f * distance / config.maxDistance);
+		Candidate& c = m_candidates.next();
+		c.position = i;
+		c.bytes = bytes;
+		c.accumulated = interest.accumulated;
+	}
+
+	// Send the entities that have gathered the most priority first
+	std::sort(m_candidates.begin(), m_candidates.end(), [](const Candidate& x, const Candidate& y) { return x.accumulated > y.accumulated; });
+	for (const Candidate& c : m_candidates) {
+		if (budgeted && c.bytes > m_budgetBytes) {
+			m_stats.deferred++;
+			continue;
+		}
+		if (budgeted) m_budgetBytes -= c.bytes;
+		EntityInterest& interest = m_entities[current[c.position].index];
+		interest.accumulated = 0.0f;
+		interest.lastSent = now;
+		m_chosen[c.position] = true;
+		m_stats.sent++;
+	}
+
+	// The client's snapshot is its baseline with the chosen entities replaced (or added)
+	result.fastClear();
+	b = 0;
+	for (int i = 0; i < current.size(); i++) {
+		const EntityState& state = current[i];
+		while (notNull(baseline) && b < baseline->size() && (*baseline)[b].index < state.index) result.append((*baseline)[b++]);
+		const bool inBaseline = notNull(baseline) && b < baseline->size() && (*baseline)[b].index == state.index;
+		if (m_chosen[i]) result.append(state);
+		else if (inBaseline) result.append((*baseline)[b]);
+		if (inBaseline) b++;
+	}
+	while (notNull(baseline) && b < baseline->size()) result.append((*baseline)[b++]);
+}
+
+void ClientInterest::clear() {
+	m_entities.fastClear();
+	m_budgetBytes = 0.0;
+	m_lastTime = fnan();
+	m_stats = Stats();
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <G3D/G3D.h>
+#include "FpsConfig.h"
+#include "SnapshotHistory.h"
+
+class PhysicsScene;
+
+/** Chooses the entities the server sends one client on each network frame (interest management, see InterestConfig)
+
+	Entities farther than the max distance are never sent. The rest are visible if they are inside the client's view cone
+	(and not hidden behind the static scene geometry), and are sent at most at the visible or hidden rate. Each entity that
+	is due gathers its priority every network frame, and the entities that have waited longest (weighted by priority) are
+	sent first until the client's bandwidth budget is spent, so lower priority entities are delayed rather than starved.
+	The client's own entity is never sent (clients ignore updates to it).
+*/
+class ClientInterest {
+public:
+	typedef SnapshotHistory::EntityState EntityState;
+	typedef SnapshotHistory::Snapshot Snapshot;
+
+	/** Counts from the last select() */
+	struct Stats {
+		int		relevant = 0;			///< Entities in range
+		int		visible = 0;			///< Entities in range that are visible
+		int		due = 0;				///< Entities in range whose send rate allowed an update
+		int		deferred = 0;			///< Entities that were due but didn't fit in the bandwidth budget
+		int		sent = 0;				///< Entities sent (that changed since the baseline)
+	};
+
+protected:
+	/** Scheduling state for one entity (indexed by network index) */
+	struct EntityInterest {
+		float		accumulated = 0.0f;			///< Priority gathered since the entity was last sent
+		RealTime	lastSent = -finf();			///< Time the entity was last sent (or found unchanged)
+	};
+
+	/** An entity that is due this network frame */
+	struct Candidate {
+		int			position;					///< Position in the current snapshot
+		int			bytes;						///< Bytes sending it takes
+		float		accumulated;
+	};
+
+	Array<EntityInterest>	m_entities;
+	Array<Candidate>		m_candidates;			///< Reused each network frame
+	Array<bool>				m_chosen;				///< Is each entity in the current snapshot sent? (reused each network frame)
+	double					m_budgetBytes = 0.0;	///< Bytes left in the bandwidth budget (a token bucket)
+	RealTime				m_lastTime = fnan();
+	Stats					m_stats;
+
+	/** Bytes it takes to send this state against its baseline state (nullptr if it isn't in the baseline), 0 if it is unchanged */
+	static int entityBytes(const EntityState& state, const EntityState* baseline, bool delta);
+
+public:
+	/** Choose the entities to send this network frame and build the snapshot the client holds once it has them: the baseline
+		(nullptr for none) with the chosen entities' current states. Both snapshots are sorted by index, priorities holds the
+		priority of each entity in current. Without deltas every chosen entity is sent in full. */
+	void select(const InterestConfig& config, const CFrame& viewer, uint16 viewerIndex, const PhysicsScene* scene,
+		const Snapshot& current, const Array<float>& priorities, const Snapshot* baseline, bool delta, RealTime now, Snapshot& result);
+
+	/** Forget the scheduling state (e.g. for a new connection) */
+	void clear();
+
+	const Stats& stats() const { return m_stats; }
+};
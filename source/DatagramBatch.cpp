@@ -0,0 +1,108 @@
+#include "DatagramBatch.h"
+
+#ifdef G3D_LINUX
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <errno.h>
+#include <string.h>
+#endif
+
+bool DatagramBatch::supported() {
+#ifdef G3D_LINUX
+	return true;
+#else
+	return false;
+#endif
+}
+
+int DatagramBatch::receive(ENetSocket socket, bool batched) {
+	m_count = 0;
+#ifdef G3D_LINUX
+	if (batched) {
+		mmsghdr messages[MAX_DATAGRAMS];
+		iovec buffers[MAX_DATAGRAMS];
+		sockaddr_in sources[MAX_DATAGRAMS];
+		memset(messages, 0, sizeof(messages));
+		for (int i = 0; i < MAX_DATAGRAMS; i++) {
+			buffers[i].iov_base = m_data[i];
+			buffers[i].iov_len = DATAGRAM_SIZE;
+			messages[i].msg_hdr.msg_iov = &buffers[i];
+			messages[i].msg_hdr.msg_iovlen = 1;
+			messages[i].msg_hdr.msg_name = &sources[i];
+			messages[i].msg_hdr.msg_namelen = sizeof(sources[i]);
+		}
+		const int received = recvmmsg(socket, messages, MAX_DATAGRAMS, MSG_DONTWAIT, nullptr);
+		if (received < 0) return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+		for (int i = 0; i < received; i++) {
+			// ENet addresses keep the host in network order and the port in host order
+			m_addresses[i].host = sources[i].sin_addr.s_addr;
+			m_addresses[i].port = ENET_NET_TO_HOST_16(sources[i].sin_port);
+			m_lengths[i] = messages[i].msg_len;
+			if (messages[i].msg_hdr.msg_flags & MSG_TRUNC) {
+				// Only the start of the datagram fit in the buffer, drop it rather than parse a partial packet
+				m_lengths[i] = 0;
+				m_truncated++;
+			}
+		}
+		m_count = received;
+		return m_count;
+	}
+#endif
+	// Portable fallback, one datagram per call
+	while (m_count < MAX_DATAGRAMS) {
+		ENetBuffer buff;
+		buff.data = m_data[m_count];
+		buff.dataLength = DATAGRAM_SIZE;
+		const int length = enet_socket_receive(socket, &m_addresses[m_count], &buff, 1);
+		if (length < 0) return (m_count > 0) ? m_count : -1;
+		if (length == 0) break;
+		m_lengths[m_count++] = (size_t)length;
+	}
+	return m_count;
+}
+
+int DatagramBatch::sendToAll(ENetSocket socket, const void* data, size_t length, const Array<ENetAddress>& addresses, bool batched) {
+	int sent = 0;
+#ifdef G3D_LINUX
+	if (batched) {
+		mmsghdr messages[MAX_DATAGRAMS];
+		sockaddr_in destinations[MAX_DATAGRAMS];
+		iovec buffer;
+		buffer.iov_base = const_cast<void*>(data);		// Every message shares the same (unmodified) payload
+		buffer.iov_len = length;
+		for (int start = 0; start < addresses.size(); start += MAX_DATAGRAMS) {
+			const int count = min(addresses.size() - start, (int)MAX_DATAGRAMS);
+			memset(messages, 0, sizeof(mmsghdr) * count);
+			for (int i = 0; i < count; i++) {
+				memset(&destinations[i], 0, sizeof(sockaddr_in));
+				destinations[i].sin_family = AF_INET;
+				destinations[i].sin_addr.s_addr = addresses[start + i].host;
+				destinations[i].sin_port = ENET_HOST_TO_NET_16(addresses[start + i].port);
+				messages[i].msg_hdr.msg_iov = &buffer;
+				messages[i].msg_hdr.msg_iovlen = 1;
+				messages[i].msg_hdr.msg_name = &destinations[i];
+				messages[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+			}
+			int done = 0;
+			while (done < count) {
+				const int result = sendmmsg(socket, messages + done, count - done, MSG_DONTWAIT);
+				if (result <= 0) {
+					done++;			// Skip (drop) the datagram that failed and carry on with the rest
+					continue;
+				}
+				done += result;
+				sent += result;
+			}
+		}
+		return sent;
+	}
+#endif
+	// Portable fallback, one datagram per call
+	ENetBuffer buff;
+	buff.data = const_cast<void*>(data);
+	buff.dataLength = length;
+	for (const ENetAddress& address : addresses) {
+		if (enet_socket_send(socket, &address, &buff, 1) > 0) sent++;
+	}
+	return sent;
+}
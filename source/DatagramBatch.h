@@ -0,0 +1,43 @@
+#pragma once
+#include <G3D/G3D.h>
+#include <enet/enet.h>
+
+/** Batched datagram I/O for the unreliable channel
+
+	When batching is enabled on Linux, each receive()/sendToAll() is a single recvmmsg()/sendmmsg() system call covering up to
+	MAX_DATAGRAMS datagrams. Elsewhere (or with batching disabled) the same calls fall back to one enet_socket_receive()/
+	enet_socket_send() per datagram, so callers don't need to know which mode is in use.
+*/
+class DatagramBatch {
+public:
+	static const int MAX_DATAGRAMS = 32;					///< Most datagrams read by a single receive() (or sent per system call)
+	static const int DATAGRAM_SIZE = ENET_HOST_DEFAULT_MTU;	///< Receive buffer size for each datagram
+
+protected:
+	uint8			m_data[MAX_DATAGRAMS][DATAGRAM_SIZE];	///< Receive buffers (reused for every batch)
+	size_t			m_lengths[MAX_DATAGRAMS];
+	ENetAddress		m_addresses[MAX_DATAGRAMS];
+	int				m_count = 0;							///< Datagrams held from the last receive()
+	uint64			m_truncated = 0;						///< Datagrams dropped for being longer than DATAGRAM_SIZE
+
+public:
+	/** Is recvmmsg()/sendmmsg() batching available on this platform? */
+	static bool supported();
+
+	/** Replace the held datagrams with any pending on the (non-blocking) socket.
+		Returns the number received (0 if nothing is pending, -1 on a socket error). A datagram longer than DATAGRAM_SIZE
+		is held with a length of 0 (so it is never parsed) and counted in truncatedCount(). */
+	int receive(ENetSocket socket, bool batched);
+
+	int count() const { return m_count; }
+	const uint8* data(int i) const { return m_data[i]; }
+	size_t length(int i) const { return m_lengths[i]; }
+	const ENetAddress& address(int i) const { return m_addresses[i]; }
+	/** Datagrams dropped so far for being longer than DATAGRAM_SIZE (the batched receive's are counted, the fallback's are
+		dropped by ENet, which reports them as socket errors) */
+	uint64 truncatedCount() const { return m_truncated; }
+
+	/** Send the same datagram to every address (a datagram that can't be sent right away is dropped, as with enet_socket_send()).
+		Returns the number of datagrams sent. */
+	static int sendToAll(ENetSocket socket, const void* data, size_t length, const Array<ENetAddress>& addresses, bool batched);
+};
@@ -0,0 +1,87 @@
+#include "EntityBatchAssembler.h"
+
+EntityBatchAssembler::EntityBatchAssembler() {
+	m_assembled = GenericPacket::createForBroadcast<BatchEntityUpdatePacket>();
+}
+
+void EntityBatchAssembler::drop(Pending& pending) {
+	if (pending.frame == 0) return;
+	debugPrintf("Dropped entity update for frame %d, received %d of its %d parts\n", pending.frame, pending.received, pending.partCount);
+	pending.frame = 0;
+	m_droppedCount++;
+}
+
+void EntityBatchAssembler::clear() {
+	for (Pending& p : m_pending) {
+		p.frame = 0;
+	}
+	m_completedFrame = 0;
+}
+
+BatchEntityUpdatePacket* EntityBatchAssembler::add(BatchEntityUpdatePacket* part) {
+	if (part->m_partCount <= 1) return part;
+	if (part->m_frameNumber <= m_completedFrame || part->m_partIndex >= part->m_partCount) return nullptr;
+
+	// Find the update this part belongs to, or the slot to start it in (an unused one, or else the oldest)
+	Pending* pending = nullptr;
+	Pending* oldest = &m_pending[0];
+	for (Pending& p : m_pending) {
+		if (p.frame == part->m_frameNumber) {
+			pending = &p;
+			break;
+		}
+		if (p.frame < oldest->frame) oldest = &p;
+	}
+	if (notNull(pending) && (pending->baselineFrame != part->m_baselineFrame || pending->updateType != part->m_updateType || pending->partCount != part->m_partCount)) {
+		// Parts of a different update for the same frame (the server changed the baseline it encoded against), start over
+		drop(*pending);
+	}
+	if (isNull(pending) || pending->frame == 0) {
+		if (isNull(pending)) {
+			pending = oldest;
+			drop(*pending);
+		}
+		pending->frame = part->m_frameNumber;
+		pending->baselineFrame = part->m_baselineFrame;
+		pending->updateType = part->m_updateType;
+		pending->partCount = part->m_partCount;
+		pending->received = 0;
+		pending->havePart.resize(part->m_partCount);
+		pending->updates.resize(part->m_partCount);
+		pending->deltas.resize(part->m_partCount);
+		for (bool& have : pending->havePart) have = false;
+	}
+
+	if (pending->havePart[part->m_partIndex]) return nullptr;		// Duplicate
+	pending->havePart[part->m_partIndex] = true;
+	pending->received++;
+	// Copy the entities, the received packet is reused once it has been handled
+	pending->updates[part->m_partIndex].fastClear();
+	pending->updates[part->m_partIndex].append(part->m_updates);
+	pending->deltas[part->m_partIndex].fastClear();
+	pending->deltas[part->m_partIndex].append(part->m_deltas);
+	if (pending->received < pending->partCount) return nullptr;
+
+	// Put the parts together in order
+	m_assembled->m_updates.fastClear();
+	m_assembled->m_deltas.fastClear();
+	for (int i = 0; i < pending->partCount; i++) {
+		m_assembled->m_updates.append(pending->updates[i]);
+		m_assembled->m_deltas.append(pending->deltas[i]);
+	}
+	m_assembled->m_frameNumber = pending->frame;
+	m_assembled->m_baselineFrame = pending->baselineFrame;
+	m_assembled->m_updateType = pending->updateType;
+	m_assembled->m_partIndex = 0;
+	m_assembled->m_partCount = 1;
+	m_assembled->m_arrivalTime = part->m_arrivalTime;		// When the last part arrived
+	m_completedFrame = pending->frame;
+	m_completedCount++;
+	pending->frame = 0;
+
+	// Older updates can't be used once a newer one is complete
+	for (Pending& p : m_pending) {
+		if (p.frame != 0 && p.frame < m_completedFrame) drop(p);
+	}
+	return m_assembled.get();
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <G3D/G3D.h>
+#include "Packet.h"
+
+/** Puts entity updates that were split into several datagrams (see BatchEntityUpdatePacket::split()) back together
+
+	Parts are collected by frame number (which identifies the snapshot) until every part of an update has arrived, then the
+	whole update is returned. Only the latest few incomplete updates are held: once a newer update completes (or more than
+	MAX_PENDING are waiting) the older ones can no longer be used, so their parts are dropped.
+*/
+class EntityBatchAssembler {
+public:
+	typedef BatchEntityUpdatePacket::EntityUpdate EntityUpdate;
+	typedef BatchEntityUpdatePacket::EntityDelta EntityDelta;
+
+	static const int MAX_PENDING = 8;			///< Most incomplete updates held at once
+
+protected:
+	/** The parts received so far for one update */
+	struct Pending {
+		uint32							frame = 0;			///< Frame number of the update (0 for an unused slot)
+		uint32							baselineFrame = 0;
+		BatchEntityUpdatePacket::NetworkUpdateType updateType = BatchEntityUpdatePacket::NOOP;
+		int								partCount = 0;
+		int								received = 0;		///< Number of distinct parts received
+		Array<bool>						havePart;
+		Array<Array<EntityUpdate>>		updates;			///< Entities from each part (REPLACE_FRAME updates)
+		Array<Array<EntityDelta>>		deltas;				///< Entities from each part (DELTA_FRAME updates)
+	};
+
+	Pending								m_pending[MAX_PENDING];
+	shared_ptr<BatchEntityUpdatePacket>	m_assembled;		///< The last completed update (reused for each one)
+	uint32								m_completedFrame = 0;	///< Frame of the last completed update
+	int									m_completedCount = 0;
+	int									m_droppedCount = 0;
+
+	/** Forget the parts held in a slot (counting the update as dropped) */
+	void drop(Pending& pending);
+
+public:
+	EntityBatchAssembler();
+
+	/** Add a received update (or part of one). Returns the complete update once all of its parts have arrived (valid until
+		the next call), the update itself if it wasn't split, or nullptr while parts are still missing (or the part is late
+		or a duplicate). */
+	BatchEntityUpdatePacket* add(BatchEntityUpdatePacket* part);
+
+	/** Drop every incomplete update (e.g. when reconnecting) */
+	void clear();
+
+	/** Number of split updates put back together */
+	int completedCount() const { return m_completedCount; }
+	/** Number of split updates dropped before all of their parts arrived */
+	int droppedCount() const { return m_droppedCount; }
+};
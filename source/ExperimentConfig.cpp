@@ -16,6 +16,13 @@ ExperimentConfig::ExperimentConfig(const Any& any) : FpsConfig(any) {
 		reader.getIfPresent("clientPort", clientPort);
 		reader.getIfPresent("numPlayers", numPlayers);
 		reader.getIfPresent("isNetworked", isNetworked);
+		reader.getIfPresent("batchedDatagramIO", batchedDatagramIO);
+		reader.getIfPresent("deltaSnapshots", deltaSnapshots);
+		reader.getIfPresent("networkThread", networkThread);
+		reader.getIfPresent("interest", interest);
+		reader.getIfPresent("interpolation", interpolation);
+		reader.getIfPresent("lagCompensation", lagCompensation);
+		reader.getIfPresent("prediction", prediction);
 		logPrintf("serverAddress is : %s:%d\n", serverAddress.c_str(), serverPort);
 		break;
 	default:
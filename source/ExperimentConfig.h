@@ -16,6 +16,13 @@ public:
 	int serverPort = 12345;								///< Port for server to listen to
 	int clientPort = 12350;								///< Port for the client to listen to
 	int numPlayers = 2;									///< Number of connections to wait for before starting the game
+	bool batchedDatagramIO = true;						///< Read/write many unreliable datagrams per system call (where supported)
+	bool deltaSnapshots = true;							///< Send entity updates as deltas against the last snapshot each client acknowledged
+	bool networkThread = false;							///< Poll the network on a dedicated thread (packets are still handled once per frame)
+	InterestConfig interest;							///< Which entities the server sends each client (interest management)
+	InterpolationConfig interpolation;					///< How clients show the entity states they receive
+	LagCompensationConfig lagCompensation;				///< How the server checks the hits clients report
+	PredictionConfig prediction;						///< Client side movement prediction (and server reconciliation)
 	bool isNetworked;									///< Checks if the experiment is networked or not
 	
 	ExperimentConfig() { init(); }
@@ -107,10 +107,13 @@ void FPSciApp::initExperiment() {
 		m_unreliableServerAddress.port = experimentConfig.serverPort + 1;
 		m_unreliableSocket = enet_socket_create(ENET_SOCKET_TYPE_DATAGRAM);
 		enet_socket_set_option(m_unreliableSocket, ENET_SOCKOPT_NONBLOCK, 1); //Set socket to non-blocking
+		NetworkUtils::setBatchedIO(experimentConfig.batchedDatagramIO);
+		registerPacketHandlers();
 
 		// initialize variables to be reset by handshakes
 		m_enetConnected = false;
 		m_socketConnected = false;
+		startNetworkThread();
 	}
 	sessConfig->isNetworked = &experimentConfig.isNetworked;
 }
@@ -142,6 +145,7 @@ void FPSciApp::openUserSettingsWindow() {
 
 /** Handle the user settings window visibility */
 void FPSciApp::closeUserSettingsWindow() {
+	if (isNull(m_userSettingsWindow)) return;		// No GUI (see FPSciServerApp::runHeadless())
 	if (sessConfig->menu.allowUserSettingsSave)
 	{						  // If the user could have saved their settings
 		saveUserConfig(true); // Save the user config (if it has changed) whenever this window is closed
@@ -188,7 +192,7 @@ void FPSciApp::updateMouseSensitivity() {
 		player->turnScale = currentTurnScale();
 	}
 
-	m_userSettingsWindow->updateCmp360();
+	if (notNull(m_userSettingsWindow)) m_userSettingsWindow->updateCmp360();
 }
 
 void FPSciApp::setMouseInputMode(MouseInputMode mode) {
@@ -229,8 +233,8 @@ void FPSciApp::loadConfigs(const ConfigFiles& configs) {
 	userStatusTable.printToLog();
 	userStatusTable.validate(sessionIds, userTable.getIds());
 
-	// Get info about the system
-	SystemInfo info = SystemInfo::get();
+	// Get info about the system (a headless server has no GL context to get the GPU from)
+	SystemInfo info = SystemInfo::get(notNull(renderDevice));
 	info.printToLog(); // Print system info to log.txt
 
 	// Get system configuration
@@ -465,6 +469,21 @@ void FPSciApp::updateControls(bool firstSession) {
 	if (!rect.isEmpty())
 		m_weaponControls->setRect(rect);
 	addWidget(m_weaponControls);
+
+	// Update the logger stats
+	visible = false;
+	rect = Rect2D();
+	if (notNull(m_loggerControls))
+	{
+		visible = m_loggerControls->visible();
+		rect = m_loggerControls->rect();
+		removeWidget(m_loggerControls);
+	}
+	m_loggerControls = LoggerControls::create(this, theme);
+	m_loggerControls->setVisible(visible);
+	if (!rect.isEmpty())
+		m_loggerControls->setRect(rect);
+	addWidget(m_loggerControls);
 }
 
 void FPSciApp::makeGUI() {
@@ -492,6 +511,7 @@ void FPSciApp::makeGUI() {
 		debugPane->addButton("Render Controls [1]", this, &FPSciApp::showRenderControls);
 		debugPane->addButton("Player Controls [2]", this, &FPSciApp::showPlayerControls);
 		debugPane->addButton("Weapon Controls [3]", this, &FPSciApp::showWeaponControls);
+		debugPane->addButton("Logger Stats [5]", this, &FPSciApp::showLoggerControls);
 		if (notNull(waypointManager))
 			debugPane->addButton("Waypoint Manager [4]", waypointManager, &WaypointManager::showWaypointWindow);
 	}
@@ -535,6 +555,10 @@ void FPSciApp::showWeaponControls() {
 	m_weaponControls->setVisible(true);
 }
 
+void FPSciApp::showLoggerControls() {
+	m_loggerControls->setVisible(true);
+}
+
 void FPSciApp::presentQuestion(Question question) {
 	if (notNull(dialog))
 		removeWidget(dialog);				  // Remove the current dialog widget (if valid)
@@ -716,37 +740,7 @@ void FPSciApp::initPlayer(bool setSpawnPosition) {
 	}
 
 	// Set player values from session config
-	player->moveRate = &sessConfig->player.moveRate;
-	player->sprintMultiplier = &sessConfig->player.sprintMultiplier;
-	player->headBobEnabled = &sessConfig->player.headBobEnabled;
-	player->headBobAmplitude = &sessConfig->player.headBobAmplitude;
-	player->headBobFrequency = &sessConfig->player.headBobFrequency;
-	player->respawnPos = &sessConfig->player.respawnPos;
-	player->respawnToPos = &sessConfig->player.respawnToPos;
-	player->respawnHeading = &sessConfig->player.respawnHeading;
-	player->accelerationEnabled = &sessConfig->player.accelerationEnabled;
-	player->movementAcceleration = &sessConfig->player.movementAcceleration;
-	player->movementDeceleration = &sessConfig->player.movementDeceleration;
-	player->moveScale = &sessConfig->player.moveScale;
-	player->axisLock = &sessConfig->player.axisLock;
-	player->jumpVelocity = &sessConfig->player.jumpVelocity;
-	player->jumpInterval = &sessConfig->player.jumpInterval;
-	player->jumpTouch = &sessConfig->player.jumpTouch;
-	player->height = &sessConfig->player.height;
-	player->crouchHeight = &sessConfig->player.crouchHeight;
-	player->movementRestrictionX = &sessConfig->player.movementRestrictionX;
-	player->movementRestrictionZ = &sessConfig->player.movementRestrictionZ;
-	player->restrictedMovementEnabled = &sessConfig->player.restrictedMovementEnabled;
-	player->restrictionBoxAngle = &sessConfig->player.restrictionBoxAngle;
-	player->counterStrafing = &sessConfig->player.counterStrafing;
-	player->propagatePlayerConfigsToAll = &sessConfig->player.propagatePlayerConfigsToAll;
-	player->propagatePlayerConfigsToSelectedClient = &sessConfig->player.propagatePlayerConfigsToSelectedClient;
-	player->readFromFile = &sessConfig->player.readFromFile;
-	player->selectedClientIdx = &sessConfig->player.selectedClientIdx;
-	player->clientPlayerConfigs = &sessConfig->player.clientPlayerConfigs;
-	player->cornerPosition = &sessConfig->player.cornerPosition;
-	player->defenderRandomDisplacementAngle = &sessConfig->player.defenderRandomDisplacementAngle;
-	player->playerType = &sessConfig->player.playerType;
+	player->setConfig(&sessConfig->player);
 	// Respawn player
 	player->respawn();
 	updateMouseSensitivity();
@@ -936,6 +930,7 @@ void FPSciApp::updateSession(const String& id, bool forceReload) {
 		/* Set the latency to be what the new latency */
 		NetworkUtils::setAddressLatency(m_reliableServerAddress, sessConfig->networkLatency);
 		NetworkUtils::setAddressLatency(m_unreliableServerAddress, sessConfig->networkLatency);
+		NetworkUtils::setAddressImpairment({ m_reliableServerAddress, m_unreliableServerAddress }, sessConfig->player.uplinkImpairment);
 	}
 }
 
@@ -951,6 +946,7 @@ void FPSciApp::quitRequest() {
 		m_pyLogger->mergeLogToDb(true);
 	}
 	if (experimentConfig.isNetworked && m_serverPeer != nullptr) { // disconnect from the server if we're running in Network mode
+		stopNetworkThread();
 		enet_peer_disconnect(m_serverPeer, 0);
 	}
 	setExitCode(0);
@@ -1010,256 +1006,431 @@ void FPSciApp::onNetwork() {
 		// Get and serialize the players frame
 		shared_ptr<BatchEntityUpdatePacket> updatePacket = GenericPacket::createUnreliable<BatchEntityUpdatePacket>(&m_unreliableSocket, &m_unreliableServerAddress);
 		Array<BatchEntityUpdatePacket::EntityUpdate> updates;
-		updates.append(BatchEntityUpdatePacket::EntityUpdate(scene()->entity("player")->frame(), m_playerGUID.toString16()));
-		updatePacket->populate(m_networkFrameNum, updates, BatchEntityUpdatePacket::NetworkUpdateType::REPLACE_FRAME);
+		// With prediction the server simulates the player from its inputs, so the update only acknowledges the last snapshot
+		if (!experimentConfig.prediction.enable) {
+			updates.append(BatchEntityUpdatePacket::EntityUpdate(scene()->entity("player")->frame(), m_playerEntityIndex));
+		}
+		updatePacket->populate(m_networkFrameNum, updates, BatchEntityUpdatePacket::NetworkUpdateType::REPLACE_FRAME, m_receivedSnapshots.ackedFrame());
 		NetworkUtils::send(updatePacket);
 		//updatePacket->send();
-	}
 
-	/* Recevie and handle any packets */
-	shared_ptr<GenericPacket> inPacket = NetworkUtils::receivePacket(m_localHost, &m_unreliableSocket);
-	while (inPacket != nullptr) {
-		ENetAddress srcAddr = inPacket->srcAddr();
-		char ip[16];
-		enet_address_get_host_ip(&srcAddr, ip, 16);
-		/* Handle Unreliable packets here */
-		if (!inPacket->isReliable()) {
-			switch (inPacket->type()) {
-			case BATCH_ENTITY_UPDATE: {
-				/* Take a set of entity updates from the server and apply them to local entities */
-				BatchEntityUpdatePacket* typedPacket = static_cast<BatchEntityUpdatePacket*>(inPacket.get());
-				//TODO: refactor this out into some other place, maybe NetworkUtils??
-				for (BatchEntityUpdatePacket::EntityUpdate e : typedPacket->m_updates) {
-					if (e.name != m_playerGUID.toString16()) { // Don't listen to updates for this client
-						shared_ptr<NetworkedEntity> entity = (*scene()).typedEntity<NetworkedEntity>(e.name);
-						if (entity == nullptr) {
-							debugPrintf("Recieved update for entity %s, but it doesn't exist\n", e.name.c_str());
-						}
-						else {
-							switch (typedPacket->m_updateType) {
-							case BatchEntityUpdatePacket::NetworkUpdateType::NOOP:
-								// Do nothing (No-Op)
-								break;
-							case BatchEntityUpdatePacket::NetworkUpdateType::REPLACE_FRAME:
-								entity->setFrame(e.frame);
-								break;
-							}
-						}
-					}
-				}
-				break;
-			}
-			case HANDSHAKE_REPLY: {
-				m_socketConnected = true;
-				debugPrintf("Received HANDSHAKE_REPLY from server\n");
-				break;
-			}
-			case PLAYER_INTERACT: {
-				PlayerInteractPacket* typedPacket = static_cast<PlayerInteractPacket*> (inPacket.get());
-				if (typedPacket->m_actorID != m_playerGUID) {
-					// Only log actions that happen on another machine
-					const shared_ptr<NetworkedEntity> clientEntity = scene()->typedEntity<NetworkedEntity>(typedPacket->m_actorID.toString16());
-					RemotePlayerAction rpa = RemotePlayerAction();
-					rpa.time = sess->logger->getFileTime();
-					rpa.viewDirection = clientEntity->getLookAzEl();
-					rpa.position = clientEntity->frame().translation;
-					rpa.state = sess->currentState;
-					rpa.action = (PlayerActionType)typedPacket->m_remoteAction;
-					rpa.actorID = typedPacket->m_actorID.toString16();
-					sess->logger->logRemotePlayerAction(rpa);
-				}
-				break;
-			}
-			default:
-				debugPrintf("WARNING: Unhandled packet received on unreliable channel of type %d\n", inPacket->type());
+		if (experimentConfig.prediction.enable) {
+			// Resend every input the server hasn't acknowledged, so a lost packet is covered by the next one
+			m_prediction.unacked(experimentConfig.prediction.maxInputsPerPacket, m_sentInputs);
+			if (m_sentInputs.size() > 0) {
+				shared_ptr<PlayerInputPacket> inputPacket = GenericPacket::createUnreliable<PlayerInputPacket>(&m_unreliableSocket, &m_unreliableServerAddress);
+				inputPacket->populate(m_networkFrameNum, m_sentInputs);
+				NetworkUtils::send(inputPacket);
 			}
 		}
-		else {
-			switch (inPacket->type()) {
-				/* Handle Reliable packets here */
-			case RELIABLE_CONNECT: {
-				ENetAddress localAddress;
-				enet_socket_get_address(m_unreliableSocket, &localAddress);
-				char ipStr[16];
-				enet_address_get_host_ip(&localAddress, ipStr, 16);
-				debugPrintf("Registering client...\n");
-				debugPrintf("\tPort: %i\n", localAddress.port);
-				debugPrintf("\tHost: %s\n", ipStr);
-				shared_ptr<RegisterClientPacket> registrationPacket = GenericPacket::createReliable<RegisterClientPacket>(m_serverPeer);
-				registrationPacket->populate(m_serverPeer, m_playerGUID, localAddress.port);
-				NetworkUtils::send(registrationPacket);
-				//registrationPacket->send();
-				break;
-			}
-			case CREATE_ENTITY: {
-				CreateEntityPacket* typedPacket = static_cast<CreateEntityPacket*> (inPacket.get());
-				if (typedPacket->m_guid != m_playerGUID) {
-					debugPrintf("Created entity with ID %s\n", typedPacket->m_guid.toString16());
-
-					Any modelSpec = PARSE_ANY(ArticulatedModel::Specification{			///< Basic model spec for target
-						filename = "model/target/pointingplayer.obj";
-						preprocess = {
-						transformGeometry(all(), Matrix4::yawDegrees(120));
-						//transformGeometry(all(), Matrix4::translation(0, -1, 0));
-						};
-						cleanGeometrySettings = ArticulatedModel::CleanGeometrySettings{
-						allowVertexMerging = true;
-						forceComputeNormals = false;
-						forceComputeTangents = false;
-						forceVertexMerging = true;
-						maxEdgeLength = inf;
-						maxNormalWeldAngleDegrees = 0;
-						maxSmoothAngleDegrees = 0;
-						};
-						});
-					shared_ptr<Model> model = ArticulatedModel::create(modelSpec);
-
-					const shared_ptr<NetworkedEntity>& target = NetworkedEntity::create(typedPacket->m_guid.toString16(), &(*scene()), model, CFrame());
-					//target->setFrame(position);
-					target->setWorldSpace(true);
-					//target->setHitSound(config->hitSound, m_app->soundTable, config->hitSoundVol);
-					//target->setDestoyedSound(config->destroyedSound, m_app->soundTable, config->destroyedSoundVol);
-					target->setColor(G3D::Color3(20.0, 20.0, 200.0));
-
-					(*scene()).insert(target);
-					netSess->addHittableTarget(target);
-				}
-				break;
-			}
-			case CLIENT_REGISTRATION_REPLY: {
-				RegistrationReplyPacket* typedPacket = static_cast<RegistrationReplyPacket*>(inPacket.get());
-				debugPrintf("INFO: Received registration reply...\n");
-				if (typedPacket->m_guid == m_playerGUID) {
-					if (typedPacket->m_status == 0) {
-						m_enetConnected = true;
-						debugPrintf("INFO: Received registration from server\n");
-
-						/* Set the amount of latency to add */
-						NetworkUtils::setAddressLatency(m_unreliableServerAddress, sessConfig->networkLatency);
-						NetworkUtils::setAddressLatency(typedPacket->srcAddr(), sessConfig->networkLatency);
-					}
-					else {
-						debugPrintf("WARN: Server connection refused (%i)", typedPacket->m_status);
-					}
-				}
-				break;
-			}
-			case MOVE_CLIENT: {
-				MoveClientPacket* typedPacket = static_cast<MoveClientPacket*> (inPacket.get());
-				shared_ptr<PlayerEntity> entity = scene()->typedEntity<PlayerEntity>("player");
-				entity->setFrame(typedPacket->m_newPosition);
-				break;
-			}
-			case DESTROY_ENTITY: {
-				DestroyEntityPacket* typedPacket = static_cast<DestroyEntityPacket*>(inPacket.get());
-				debugPrintf("Recieved destroy entity request for: %s\n", typedPacket->m_guid.toString16());
-				shared_ptr<NetworkedEntity> entity = scene()->typedEntity<NetworkedEntity>(typedPacket->m_guid.toString16());
-				scene()->remove(entity);
-				break;
-			}
-			case SET_SPAWN_LOCATION: {
-				SetSpawnPacket* typedPacket = static_cast<SetSpawnPacket*> (inPacket.get());
-				debugPrintf("Recieved an updated spawn position\n");
-				shared_ptr<PlayerEntity> player = scene()->typedEntity<PlayerEntity>("player");
-				player->setRespawnPosition(typedPacket->m_spawnPositionTranslation);
-				player->setRespawnHeadingDegrees(typedPacket->m_spawnHeading);
-				break;
-			}
-			case RESPAWN_CLIENT: {
-				debugPrintf("Recieved a request to respawn\n");
-				scene()->typedEntity<PlayerEntity>("player")->respawn();
-				//netSess->resetSession();
-				break;
-			}
-			case START_NETWORKED_SESSION: {
-				StartSessionPacket* typedPacket = static_cast<StartSessionPacket*> (inPacket.get());
-				netSess->startRound();
-				m_networkFrameNum = typedPacket->m_frameNumber; // Set the frame number to sync with the server
-				debugPrintf("Recieved a request to start session.\n");
-				break;
-			}
-			case SEND_PLAYER_CONFIG: {
-				//TODO: Decide if we can just replace the the local player config and do that instead
-				SendPlayerConfigPacket* typedPacket = static_cast<SendPlayerConfigPacket*> (inPacket.get());
-				sessConfig->player.moveRate = typedPacket->m_playerConfig->moveRate;
-				sessConfig->player.moveScale = typedPacket->m_playerConfig->moveScale;
+	}
 
-				(sessConfig->player.axisLock)[0] = typedPacket->m_playerConfig->axisLock[0];
-				(sessConfig->player.axisLock)[1] = typedPacket->m_playerConfig->axisLock[1];
-				(sessConfig->player.axisLock)[2] = typedPacket->m_playerConfig->axisLock[2];
+	/* Receive and handle any packets (see registerPacketHandlers()) */
+	receivePackets();
+	updateInterpolatedEntities();
 
-				sessConfig->player.accelerationEnabled = typedPacket->m_playerConfig->accelerationEnabled;
-				sessConfig->player.movementAcceleration = typedPacket->m_playerConfig->movementAcceleration;
-				sessConfig->player.movementDeceleration = typedPacket->m_playerConfig->movementDeceleration;
+	logImpairments();
+}
 
-				sessConfig->player.sprintMultiplier = typedPacket->m_playerConfig->sprintMultiplier;
+void FPSciApp::startNetworkThread() {
+	if (!experimentConfig.networkThread || notNull(m_networkThread)) return;
+	m_networkThread = NetworkThread::create(m_localHost, &m_unreliableSocket);
+}
 
-				sessConfig->player.jumpVelocity = typedPacket->m_playerConfig->jumpVelocity;
-				sessConfig->player.jumpInterval = typedPacket->m_playerConfig->jumpInterval;
-				sessConfig->player.jumpTouch = typedPacket->m_playerConfig->jumpTouch;
+void FPSciApp::stopNetworkThread() {
+	if (isNull(m_networkThread)) return;
+	m_networkThread->stop();
+	m_networkThread = nullptr;
+}
+
+void FPSciApp::receivePackets() {
+	if (notNull(m_networkThread)) {
+		m_packetDispatcher.dispatchQueued(*m_networkThread);
+	}
+	else {
+		m_packetDispatcher.dispatchPending(m_localHost, &m_unreliableSocket);
+	}
+}
+
+void FPSciApp::logImpairments() {
+	NetworkUtils::takeImpairmentRecords(m_impairmentRecords);
+	if (isNull(sess) || isNull(sess->logger)) return;
+	for (const ImpairmentRecord& record : m_impairmentRecords) {
+		sess->logger->logImpairment(record);
+	}
+}
 
-				sessConfig->player.height = typedPacket->m_playerConfig->height;
-				sessConfig->player.crouchHeight = typedPacket->m_playerConfig->crouchHeight;
+void FPSciApp::registerPacketHandlers() {
+	/* Unreliable packets */
+	m_packetDispatcher.on(BATCH_ENTITY_UPDATE, PacketDispatcher::UNRELIABLE, this, &FPSciApp::onBatchEntityUpdate);
+	m_packetDispatcher.on(HANDSHAKE_REPLY, PacketDispatcher::UNRELIABLE, this, &FPSciApp::onHandshakeReply);
+	m_packetDispatcher.on(PLAYER_INTERACT, PacketDispatcher::UNRELIABLE, this, &FPSciApp::onPlayerInteract);
+	m_packetDispatcher.on(PLAYER_STATE, PacketDispatcher::UNRELIABLE, this, &FPSciApp::onPlayerState);
+
+	/* Reliable packets */
+	m_packetDispatcher.on(RELIABLE_CONNECT, PacketDispatcher::RELIABLE, this, &FPSciApp::onReliableConnect);
+	m_packetDispatcher.on(CREATE_ENTITY, PacketDispatcher::RELIABLE, this, &FPSciApp::onCreateEntity);
+	m_packetDispatcher.on(CLIENT_REGISTRATION_REPLY, PacketDispatcher::RELIABLE, this, &FPSciApp::onRegistrationReply);
+	m_packetDispatcher.on(MOVE_CLIENT, PacketDispatcher::RELIABLE, this, &FPSciApp::onMoveClient);
+	m_packetDispatcher.on(DESTROY_ENTITY, PacketDispatcher::RELIABLE, this, &FPSciApp::onDestroyEntity);
+	m_packetDispatcher.on(SET_SPAWN_LOCATION, PacketDispatcher::RELIABLE, this, &FPSciApp::onSetSpawnLocation);
+	m_packetDispatcher.on(RESPAWN_CLIENT, PacketDispatcher::RELIABLE, this, &FPSciApp::onRespawnClient);
+	m_packetDispatcher.on(START_NETWORKED_SESSION, PacketDispatcher::RELIABLE, this, &FPSciApp::onStartSession);
+	m_packetDispatcher.on(SEND_PLAYER_CONFIG, PacketDispatcher::RELIABLE, this, &FPSciApp::onSendPlayerConfig);
+	m_packetDispatcher.on(ADD_POINTS, PacketDispatcher::RELIABLE, this, &FPSciApp::onAddPoints);
+	m_packetDispatcher.on(RESET_CLIENT_ROUND, PacketDispatcher::RELIABLE, this, &FPSciApp::onResetClientRound);
+	m_packetDispatcher.on(CLIENT_FEEDBACK_START, PacketDispatcher::RELIABLE, this, &FPSciApp::onClientFeedbackStart);
+	m_packetDispatcher.on(CLIENT_SESSION_END, PacketDispatcher::RELIABLE, this, &FPSciApp::onClientSessionEnd);
+}
 
-				sessConfig->player.headBobEnabled = typedPacket->m_playerConfig->headBobEnabled;
-				sessConfig->player.headBobAmplitude = typedPacket->m_playerConfig->headBobAmplitude;
-				sessConfig->player.headBobFrequency = typedPacket->m_playerConfig->headBobFrequency;
+void FPSciApp::onBatchEntityUpdate(BatchEntityUpdatePacket* part) {
+	/* Take a set of entity updates from the server and apply them to local entities */
+	//TODO: refactor this out into some other place, maybe NetworkUtils??
+	BatchEntityUpdatePacket* packet = m_entityBatches.add(part);
+	if (isNull(packet)) return;		// Waiting for the rest of the parts
+	switch (packet->m_updateType) {
+	case BatchEntityUpdatePacket::NetworkUpdateType::NOOP:
+		// Do nothing (No-Op)
+		break;
+	case BatchEntityUpdatePacket::NetworkUpdateType::REPLACE_FRAME:
+		if (experimentConfig.interpolation.enable) m_interpolator.addSnapshot(packet->m_frameNumber, packet->m_arrivalTime);
+		else m_shownServerFrame = max(m_shownServerFrame, (double)packet->m_frameNumber);
+		for (const BatchEntityUpdatePacket::EntityUpdate& e : packet->m_updates) {
+			setNetworkedEntityFrame(e.index, e.frame, packet->m_frameNumber);
+		}
+		break;
+	case BatchEntityUpdatePacket::NetworkUpdateType::DELTA_FRAME:
+		if (!receiveSnapshot(packet)) break;
+		if (experimentConfig.interpolation.enable) {
+			// Every entity gets a sample on this frame (unchanged ones too), so a pause isn't interpolated into a slow move
+			m_interpolator.addSnapshot(packet->m_frameNumber, packet->m_arrivalTime);
+			const shared_ptr<const SnapshotHistory::Snapshot> snapshot = m_receivedSnapshots.find(packet->m_frameNumber);
+			for (const SnapshotHistory::EntityState& state : *snapshot) {
+				setNetworkedEntityFrame(state.index, state.frame(), packet->m_frameNumber);
+			}
+			break;
+		}
+		// Only the entities that changed since the baseline are included
+		m_shownServerFrame = packet->m_frameNumber;
+		for (const BatchEntityUpdatePacket::EntityDelta& d : packet->m_deltas) {
+			setNetworkedEntityFrame(d.state.index, d.state.frame(), packet->m_frameNumber);
+		}
+		break;
+	}
+}
 
-				sessConfig->player.respawnPos = typedPacket->m_playerConfig->respawnPos;
-				sessConfig->player.respawnToPos = typedPacket->m_playerConfig->respawnToPos;
-				sessConfig->player.respawnHeading = typedPacket->m_playerConfig->respawnHeading;
+bool FPSciApp::receiveSnapshot(BatchEntityUpdatePacket* packet) {
+	if (packet->m_frameNumber <= m_receivedSnapshots.latestFrame()) return false;		// Reordered behind a newer snapshot
+	shared_ptr<const SnapshotHistory::Snapshot> baseline;
+	if (packet->m_baselineFrame != 0) {
+		baseline = m_receivedSnapshots.find(packet->m_baselineFrame);
+		if (isNull(baseline)) {
+			debugPrintf("Dropped entity update for frame %d, its baseline (frame %d) isn't held\n", packet->m_frameNumber, packet->m_baselineFrame);
+			return false;
+		}
+	}
+	const shared_ptr<SnapshotHistory::Snapshot> snapshot = std::make_shared<SnapshotHistory::Snapshot>();
+	SnapshotHistory::apply(baseline.get(), packet->m_deltas, *snapshot);
+	m_receivedSnapshots.record(packet->m_frameNumber, snapshot);
+	m_receivedSnapshots.acknowledge(packet->m_frameNumber);		// Sent back to the server in our next update
+	return true;
+}
 
-				sessConfig->player.movementRestrictionX = typedPacket->m_playerConfig->movementRestrictionX;
-				sessConfig->player.movementRestrictionZ = typedPacket->m_playerConfig->movementRestrictionZ;
-				sessConfig->player.restrictedMovementEnabled = typedPacket->m_playerConfig->restrictedMovementEnabled;
-				sessConfig->player.restrictionBoxAngle = typedPacket->m_playerConfig->restrictionBoxAngle;
+void FPSciApp::setNetworkedEntityFrame(uint16 index, const CFrame& frame, uint32 serverFrame) {
+	if (index == m_playerEntityIndex) return;		// Don't listen to updates for this client
+	if (experimentConfig.interpolation.enable) {
+		m_interpolator.addSample(index, serverFrame, frame);		// Shown by updateInterpolatedEntities()
+		return;
+	}
+	const String* name = m_entityIndices.nameOf(index);
+	shared_ptr<NetworkedEntity> entity = notNull(name) ? (*scene()).typedEntity<NetworkedEntity>(*name) : nullptr;
+	if (entity == nullptr) {
+		debugPrintf("Recieved update for entity index %d, but it doesn't exist\n", index);
+	}
+	else {
+		entity->setFrame(frame);
+	}
+}
 
-				sessConfig->player.counterStrafing = typedPacket->m_playerConfig->counterStrafing;
+void FPSciApp::updateInterpolatedEntities() {
+	const InterpolationConfig& config = experimentConfig.interpolation;
+	if (!config.enable) return;
+	m_interpolator.getEntities(m_interpolatedEntities);
+	if (m_interpolatedEntities.size() == 0) return;
+
+	const double frame = m_interpolator.renderFrame(SnapshotInterpolator::Clock::now(), config.delayMs / 1000.0);
+	m_shownServerFrame = frame;
+	SnapshotInterpolator::FrameStats stats;
+	for (const uint16 index : m_interpolatedEntities) {
+		if (index == m_playerEntityIndex) continue;
+		CFrame cframe;
+		if (m_interpolator.evaluate(index, frame, config.maxExtrapolationMs / 1000.0, cframe, stats) == SnapshotInterpolator::NO_DATA) continue;
+		const String* name = m_entityIndices.nameOf(index);
+		const shared_ptr<NetworkedEntity> entity = notNull(name) ? scene()->typedEntity<NetworkedEntity>(*name) : nullptr;
+		if (notNull(entity)) entity->setFrame(cframe);
+	}
+
+	if (config.logStats && notNull(sess) && notNull(sess->logger)) {
+		InterpolationStats row;
+		row.time = FPSciLogger::getTime();
+		row.interpolated = stats.interpolated;
+		row.extrapolated = stats.extrapolated;
+		row.held = stats.held;
+		row.delayMs = (float)(1000.0 * m_interpolator.framesToSeconds(m_interpolator.latestFrame() - frame));
+		row.maxExtrapolationMs = stats.maxExtrapolationMs;
+		sess->logger->logInterpolationStats(row);
+	}
+}
 
-				sessConfig->player.playerType = typedPacket->m_playerConfig->playerType;
+void FPSciApp::recordPlayerInput(float dt) {
+	const shared_ptr<PlayerEntity> player = scene()->typedEntity<PlayerEntity>("player");
+	if (isNull(player)) return;
+	m_playerInput.dt = dt;
+	if (!player->moveEnabled()) m_playerInput.flags |= PlayerEntity::InputCommand::MOTION_DISABLED;
+	const PlayerEntity::MovementState state = player->movementState();
+	if (player->teleports() != m_playerTeleports || m_prediction.latestSequence() == 0) {
+		// Respawned or moved this frame (or the first input since connecting), the server takes the result rather than simulating the input
+		m_playerInput.flags |= PlayerEntity::InputCommand::RESPAWNED;
+		m_playerInput.result = state;
+		m_playerTeleports = player->teleports();
+	}
+	m_prediction.record(m_playerInput, state);
+	m_playerInput = PlayerEntity::InputCommand();
+}
 
-				sessConfig->networkedSessionProgress = typedPacket->m_networkedSessionProgress;
+void FPSciApp::onPlayerState(PlayerStatePacket* packet) {
+	const PredictionConfig& config = experimentConfig.prediction;
+	if (!config.enable) return;
+	float positionError;
+	RealTime inputTime;
+	if (!m_prediction.acknowledge(packet->m_sequence, packet->m_state, positionError, inputTime)) return;		// Reordered behind a newer state
+	if (positionError <= config.correctionThresholdM) return;
+
+	// Take the server's state and replay the inputs it hasn't simulated yet on top of it
+	const PlayerPrediction::Clock::time_point start = PlayerPrediction::Clock::now();
+	const shared_ptr<PlayerEntity> player = scene()->typedEntity<PlayerEntity>("player");
+	player->setMovementState(packet->m_state);
+	for (int i = 0; i < m_prediction.pending(); i++) {
+		player->simulateInput(m_prediction[i].input, scene()->time());
+		m_prediction.setPredicted(i, player->movementState());
+	}
+	player->applyInput(m_playerInput);				// This frame's input is simulated with the scene
+	m_playerTeleports = player->teleports();		// Respawns replayed don't make this frame's input a respawn
+
+	if (config.logCorrections && notNull(sess) && notNull(sess->logger)) {
+		PredictionCorrection row;
+		row.time = FPSciLogger::getTime();
+		row.sequence = packet->m_sequence;
+		row.serverFrame = packet->m_frameNumber;
+		row.positionError = positionError;
+		row.replayed = m_prediction.pending();
+		row.roundTripMs = (inputTime > 0.0) ? (float)(1000.0 * (System::time() - inputTime)) : 0.0f;
+		row.costUs = (float)std::chrono::duration<double, std::micro>(PlayerPrediction::Clock::now() - start).count();
+		sess->logger->logPredictionCorrection(row);
+	}
+}
 
-				sessConfig->player.clientLatency = typedPacket->m_playerConfig->clientLatency;
+void FPSciApp::onHandshakeReply(HandshakeReplyPacket* packet) {
+	m_socketConnected = true;
+	debugPrintf("Received HANDSHAKE_REPLY from server\n");
+}
 
-				sessConfig->player.defenderRandomDisplacementAngle = typedPacket->m_playerConfig->defenderRandomDisplacementAngle;
-				sessConfig->player.cornerPosition = typedPacket->m_playerConfig->cornerPosition;
+void FPSciApp::onPlayerInteract(PlayerInteractPacket* packet) {
+	if (packet->m_actorID != m_playerGUID) {
+		// Only log actions that happen on another machine
+		const shared_ptr<NetworkedEntity> clientEntity = scene()->typedEntity<NetworkedEntity>(packet->m_actorID.toString16());
+		RemotePlayerAction rpa = RemotePlayerAction();
+		rpa.time = FPSciLogger::frameTime();
+		rpa.viewDirection = clientEntity->getLookAzEl();
+		rpa.position = clientEntity->frame().translation;
+		rpa.state = sess->currentState;
+		rpa.action = (PlayerActionType)packet->m_remoteAction;
+		rpa.actorID = packet->m_actorID;
+		sess->logger->logRemotePlayerAction(rpa);
+	}
+}
 
+void FPSciApp::onReliableConnect(ReliableConnectPacket* packet) {
+	ENetAddress localAddress;
+	enet_socket_get_address(m_unreliableSocket, &localAddress);
+	char ipStr[16];
+	enet_address_get_host_ip(&localAddress, ipStr, 16);
+	debugPrintf("Registering client...\n");
+	debugPrintf("\tPort: %i\n", localAddress.port);
+	debugPrintf("\tHost: %s\n", ipStr);
+	shared_ptr<RegisterClientPacket> registrationPacket = GenericPacket::createReliable<RegisterClientPacket>(m_serverPeer);
+	registrationPacket->populate(m_serverPeer, m_playerGUID, localAddress.port);
+	NetworkUtils::send(registrationPacket);
+	//registrationPacket->send();
+}
 
-				//Set Latency
-				NetworkUtils::setAddressLatency(m_unreliableServerAddress, sessConfig->player.clientLatency);
-				NetworkUtils::setAddressLatency(typedPacket->srcAddr(), sessConfig->player.clientLatency);
+void FPSciApp::onCreateEntity(CreateEntityPacket* packet) {
+	if (packet->m_guid != m_playerGUID) {
+		m_entityIndices.set(packet->m_entityIndex, packet->m_guid.toString16());
+		debugPrintf("Created entity with ID %s\n", packet->m_guid.toString16());
+
+		Any modelSpec = PARSE_ANY(ArticulatedModel::Specification{			///< Basic model spec for target
+			filename = "model/target/pointingplayer.obj";
+			preprocess = {
+			transformGeometry(all(), Matrix4::yawDegrees(120));
+			//transformGeometry(all(), Matrix4::translation(0, -1, 0));
+			};
+			cleanGeometrySettings = ArticulatedModel::CleanGeometrySettings{
+			allowVertexMerging = true;
+			forceComputeNormals = false;
+			forceComputeTangents = false;
+			forceVertexMerging = true;
+			maxEdgeLength = inf;
+			maxNormalWeldAngleDegrees = 0;
+			maxSmoothAngleDegrees = 0;
+			};
+			});
+		shared_ptr<Model> model = ArticulatedModel::create(modelSpec);
+
+		const shared_ptr<NetworkedEntity>& target = NetworkedEntity::create(packet->m_guid.toString16(), &(*scene()), model, CFrame());
+		//target->setFrame(position);
+		target->setWorldSpace(true);
+		//target->setHitSound(config->hitSound, m_app->soundTable, config->hitSoundVol);
+		//target->setDestoyedSound(config->destroyedSound, m_app->soundTable, config->destroyedSoundVol);
+		target->setColor(G3D::Color3(20.0, 20.0, 200.0));
+		target->setNetworkIndex(packet->m_entityIndex);
+
+		(*scene()).insert(target);
+		netSess->addHittableTarget(target);
+	}
+}
 
-				break;
-			}
-			case ADD_POINTS: {
-				sessConfig->clientScore++;
-				debugPrintf("Enemy Hit! Points Added!\n");
-				scene()->typedEntity<PlayerEntity>("player")->respawn();
-				break;
-			}
-			case RESET_CLIENT_ROUND: {
-				netSess.get()->resetRound();
-				scene()->typedEntity<PlayerEntity>("player")->respawn();
-				sessConfig->clientScore = 0;
-				break;
-			}
-			case CLIENT_FEEDBACK_START: {
-				netSess.get()->feedbackStart();
-				break;
-			}
-			case CLIENT_SESSION_END: {
-				netSess->endSession();
-				break;
-			}
-			default:
-				debugPrintf("WARNING: unhandled packet received on reliable channel of type: %d\n", inPacket->type());
-			}
+void FPSciApp::onRegistrationReply(RegistrationReplyPacket* packet) {
+	debugPrintf("INFO: Received registration reply...\n");
+	if (packet->m_guid == m_playerGUID) {
+		if (packet->m_status == 0) {
+			m_enetConnected = true;
+			m_playerEntityIndex = packet->m_entityIndex;
+			m_receivedSnapshots.clear();		// Snapshots from a previous connection can't be used as baselines
+			m_entityBatches.clear();
+			m_interpolator.clear();
+			m_shownServerFrame = 0.0;
+			m_prediction.clear();				// The server starts a new input sequence for each connection
+			debugPrintf("INFO: Received registration from server\n");
+
+			/* Set the amount of latency to add */
+			NetworkUtils::setAddressLatency(m_unreliableServerAddress, sessConfig->networkLatency);
+			NetworkUtils::setAddressLatency(packet->srcAddr(), sessConfig->networkLatency);
+			NetworkUtils::setAddressImpairment({ packet->srcAddr(), m_unreliableServerAddress }, sessConfig->player.uplinkImpairment);
+		}
+		else {
+			debugPrintf("WARN: Server connection refused (%i)", packet->m_status);
 		}
-		inPacket = NetworkUtils::receivePacket(m_localHost, &m_unreliableSocket);
 	}
 }
 
+void FPSciApp::onMoveClient(MoveClientPacket* packet) {
+	shared_ptr<PlayerEntity> entity = scene()->typedEntity<PlayerEntity>("player");
+	entity->teleport(packet->m_newPosition);
+}
+
+void FPSciApp::onDestroyEntity(DestroyEntityPacket* packet) {
+	debugPrintf("Recieved destroy entity request for: %s\n", packet->m_guid.toString16());
+	shared_ptr<NetworkedEntity> entity = scene()->typedEntity<NetworkedEntity>(packet->m_guid.toString16());
+	scene()->remove(entity);
+	m_interpolator.removeEntity(m_entityIndices.indexOf(packet->m_guid.toString16()));		// Its index may be reused
+	m_entityIndices.remove(packet->m_guid.toString16());
+}
+
+void FPSciApp::onSetSpawnLocation(SetSpawnPacket* packet) {
+	debugPrintf("Recieved an updated spawn position\n");
+	shared_ptr<PlayerEntity> player = scene()->typedEntity<PlayerEntity>("player");
+	player->setRespawnPosition(packet->m_spawnPositionTranslation);
+	player->setRespawnHeadingDegrees(packet->m_spawnHeading);
+}
+
+void FPSciApp::onRespawnClient(RespawnClientPacket* packet) {
+	debugPrintf("Recieved a request to respawn\n");
+	scene()->typedEntity<PlayerEntity>("player")->respawn();
+	//netSess->resetSession();
+}
+
+void FPSciApp::onStartSession(StartSessionPacket* packet) {
+	netSess->startRound();
+	m_networkFrameNum = packet->m_frameNumber; // Set the frame number to sync with the server
+	debugPrintf("Recieved a request to start session.\n");
+}
+
+void FPSciApp::onSendPlayerConfig(SendPlayerConfigPacket* packet) {
+	//TODO: Decide if we can just replace the the local player config and do that instead
+	sessConfig->player.moveRate = packet->m_playerConfig->moveRate;
+	sessConfig->player.moveScale = packet->m_playerConfig->moveScale;
+
+	(sessConfig->player.axisLock)[0] = packet->m_playerConfig->axisLock[0];
+	(sessConfig->player.axisLock)[1] = packet->m_playerConfig->axisLock[1];
+	(sessConfig->player.axisLock)[2] = packet->m_playerConfig->axisLock[2];
+
+	sessConfig->player.accelerationEnabled = packet->m_playerConfig->accelerationEnabled;
+	sessConfig->player.movementAcceleration = packet->m_playerConfig->movementAcceleration;
+	sessConfig->player.movementDeceleration = packet->m_playerConfig->movementDeceleration;
+
+	sessConfig->player.sprintMultiplier = packet->m_playerConfig->sprintMultiplier;
+
+	sessConfig->player.jumpVelocity = packet->m_playerConfig->jumpVelocity;
+	sessConfig->player.jumpInterval = packet->m_playerConfig->jumpInterval;
+	sessConfig->player.jumpTouch = packet->m_playerConfig->jumpTouch;
+
+	sessConfig->player.height = packet->m_playerConfig->height;
+	sessConfig->player.crouchHeight = packet->m_playerConfig->crouchHeight;
+
+	sessConfig->player.headBobEnabled = packet->m_playerConfig->headBobEnabled;
+	sessConfig->player.headBobAmplitude = packet->m_playerConfig->headBobAmplitude;
+	sessConfig->player.headBobFrequency = packet->m_playerConfig->headBobFrequency;
+
+	sessConfig->player.respawnPos = packet->m_playerConfig->respawnPos;
+	sessConfig->player.respawnToPos = packet->m_playerConfig->respawnToPos;
+	sessConfig->player.respawnHeading = packet->m_playerConfig->respawnHeading;
+
+	sessConfig->player.movementRestrictionX = packet->m_playerConfig->movementRestrictionX;
+	sessConfig->player.movementRestrictionZ = packet->m_playerConfig->movementRestrictionZ;
+	sessConfig->player.restrictedMovementEnabled = packet->m_playerConfig->restrictedMovementEnabled;
+	sessConfig->player.restrictionBoxAngle = packet->m_playerConfig->restrictionBoxAngle;
+
+	sessConfig->player.counterStrafing = packet->m_playerConfig->counterStrafing;
+
+	sessConfig->player.playerType = packet->m_playerConfig->playerType;
+
+	sessConfig->networkedSessionProgress = packet->m_networkedSessionProgress;
+
+	sessConfig->player.clientLatency = packet->m_playerConfig->clientLatency;
+	sessConfig->player.uplinkImpairment = packet->m_playerConfig->uplinkImpairment;
+
+	sessConfig->player.defenderRandomDisplacementAngle = packet->m_playerConfig->defenderRandomDisplacementAngle;
+	sessConfig->player.cornerPosition = packet->m_playerConfig->cornerPosition;
+
+
+	//Set Latency
+	NetworkUtils::setAddressLatency(m_unreliableServerAddress, sessConfig->player.clientLatency);
+	NetworkUtils::setAddressLatency(packet->srcAddr(), sessConfig->player.clientLatency);
+	NetworkUtils::setAddressImpairment({ packet->srcAddr(), m_unreliableServerAddress }, sessConfig->player.uplinkImpairment);
+
+}
+
+void FPSciApp::onAddPoints(AddPointPacket* packet) {
+	sessConfig->clientScore++;
+	debugPrintf("Enemy Hit! Points Added!\n");
+	scene()->typedEntity<PlayerEntity>("player")->respawn();
+}
+
+void FPSciApp::onResetClientRound(ResetClientRoundPacket* packet) {
+	netSess.get()->resetRound();
+	scene()->typedEntity<PlayerEntity>("player")->respawn();
+	sessConfig->clientScore = 0;
+}
+
+void FPSciApp::onClientFeedbackStart(ClientFeedbackStartPacket* packet) {
+	netSess.get()->feedbackStart();
+}
+
+void FPSciApp::onClientSessionEnd(ClientSessionEndPacket* packet) {
+	netSess->endSession();
+}
+
 void FPSciApp::onSimulation(RealTime rdt, SimTime sdt, SimTime idt) {
 	// TODO: this should eventually probably use sdt instead of rdt
 	RealTime currentRealTime;
@@ -1364,6 +1535,10 @@ void FPSciApp::onSimulation(RealTime rdt, SimTime sdt, SimTime idt) {
 	if (scene())
 	{
 		scene()->onSimulation(sdt);
+		if (experimentConfig.prediction.enable && m_enetConnected)
+		{
+			recordPlayerInput((float)sdt);
+		}
 	}
 
 	// make sure mouse sensitivity is set right
@@ -1466,6 +1641,11 @@ bool FPSciApp::onEvent(const GEvent& event) {
 				m_weaponControls->setVisible(!m_weaponControls->visible());
 				foundKey = true;
 			}
+			else if (keyMap.map["toggleLoggerWindow"].contains(ksym))
+			{
+				m_loggerControls->setVisible(!m_loggerControls->visible());
+				foundKey = true;
+			}
 			else if (keyMap.map["reloadConfigs"].contains(ksym))
 			{
 				loadConfigs(startupConfig.experimentList[experimentIdx]); // (Re)load the configs
@@ -1745,7 +1925,7 @@ void FPSciApp::hitTarget(shared_ptr<TargetEntity> target) {
 	if (experimentConfig.isNetworked) {
 		if (sess->currentState != PresentationState::networkedSessionRoundFeedback && sess->currentState != PresentationState::networkedSessionRoundTimeout && sess->currentState != PresentationState::initialNetworkedState && sess->currentState != PresentationState::networkedSessionRoundOver) {
 			shared_ptr<ReportHitPacket> outPacket = GenericPacket::createReliable<ReportHitPacket>(m_serverPeer);
-			outPacket->populate(m_networkFrameNum, GUniqueID::fromString16(target->name().c_str()), m_playerGUID);
+			outPacket->populate(m_networkFrameNum, GUniqueID::fromString16(target->name().c_str()), m_playerGUID, m_shownServerFrame, weapon->hitRay());
 			NetworkUtils::send(outPacket);
 		}
 		return;
@@ -1867,12 +2047,14 @@ void FPSciApp::onUserInput(UserInput* ui) {
 	const shared_ptr<PlayerEntity>& player = scene()->typedEntity<PlayerEntity>("player");
 	if (m_mouseInputMode == MouseInputMode::MOUSE_FPM && activeCamera() == playerCamera && notNull(player))
 	{
-		player->updateFromInput(ui); // Only update the player if the mouse input mode is FPM and the active camera is the player view camera
+		m_playerInput = player->updateFromInput(ui); // Only update the player if the mouse input mode is FPM and the active camera is the player view camera
 	}
 	else if (notNull(player))
 	{ // Zero the player velocity and rotation when in the setting menu
-		player->setDesiredOSVelocity(Vector3::zero());
-		player->setDesiredAngularVelocity(0.0, 0.0);
+		m_playerInput = PlayerEntity::InputCommand();
+		m_playerInput.flags = PlayerEntity::InputCommand::HALTED;
+		m_playerInput.time = System::time();
+		player->applyInput(m_playerInput);
 	}
 
 	// Handle scope behavior
@@ -2001,6 +2183,7 @@ void FPSciApp::setReticle(const int r) {
 void FPSciApp::onCleanup() {
 	// Called after the application loop ends.  Place a majority of cleanup code
 	// here instead of in the constructor so that exceptions can be caught.
+	stopNetworkThread();
 }
 
 /** Overridden (optimized) oneFrame() function to improve latency */
@@ -2063,6 +2246,7 @@ void FPSciApp::oneFrame() {
 		Profiler::nextFrame();
 		m_lastTime = m_now;
 		m_now = System::time();
+		FPSciLogger::updateFrameTime();
 		RealTime timeStep = m_now - m_lastTime;
 
 		// User input
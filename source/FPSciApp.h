@@ -12,6 +12,11 @@
 #include <G3D/G3D.h>
 #include <combaseapi.h>
 #include "NetworkUtils.h"
+#include "PacketDispatcher.h"
+#include "NetworkThread.h"
+#include "EntityBatchAssembler.h"
+#include "SnapshotInterpolator.h"
+#include "PlayerPrediction.h"
 #include "ExperimentConfig.h"
 #include "StartupConfig.h"
 #include "KeyMapping.h"
@@ -167,6 +172,7 @@ protected:
 	shared_ptr<PlayerControls> m_playerControls; ///< Player controls window (developer mode)
 	shared_ptr<RenderControls> m_renderControls; ///< Render controls window (developer mode)
 	shared_ptr<WeaponControls> m_weaponControls; ///< Weapon controls window (developer mode)
+	shared_ptr<LoggerControls> m_loggerControls; ///< Logger stats window (developer mode)
 
 	// Shader buffers
 	shared_ptr<Framebuffer> m_ldrBuffer2D;				///< Buffer to use for 2D content (if split)
@@ -187,11 +193,66 @@ protected:
 	ENetAddress m_reliableServerAddress;				///< Address of server for reliable traffic
 	ENetAddress m_unreliableServerAddress;				///< Address of server for unreliable traffic
 	
-	bool m_enetConnected;
-	bool m_socketConnected;
+	bool m_enetConnected = false;
+	bool m_socketConnected = false;
 
 	uint32 m_serverFrame;
 
+	EntityIndexTable m_entityIndices;					///< Network indices of the networked entities (assigned by the server)
+	uint16 m_playerEntityIndex = NetworkedEntity::NO_NETWORK_INDEX;	///< Network index of this client's player (from the registration reply)
+	SnapshotHistory m_receivedSnapshots;				///< Entity snapshots received from the server (baselines for its delta updates)
+	EntityBatchAssembler m_entityBatches;				///< Puts entity updates the server split into several datagrams back together
+	SnapshotInterpolator m_interpolator;				///< Received entity states, shown a fixed delay behind the server (if the experiment config's interpolation is enabled)
+	Array<uint16> m_interpolatedEntities;				///< Indices of the entities the interpolator holds samples for (reused each frame)
+	double m_shownServerFrame = 0.0;					///< Server frame of the remote entity states being shown (reported with hits for the server's lag compensation)
+	PlayerPrediction m_prediction;						///< Movement inputs the server hasn't acknowledged yet (if the experiment config's prediction is enabled)
+	PlayerEntity::InputCommand m_playerInput;			///< The player's input this frame (recorded for prediction once it is simulated)
+	uint32 m_playerTeleports = 0;						///< The player's teleport count when its last input was recorded
+	Array<PlayerEntity::InputCommand> m_sentInputs;		///< Inputs being sent to the server (reused each frame)
+
+	PacketDispatcher m_packetDispatcher;				///< Routes received packets to the handlers set up in registerPacketHandlers()
+	Array<ImpairmentRecord> m_impairmentRecords;		///< Emulated network impairment decisions to log (reused each frame)
+	shared_ptr<NetworkThread> m_networkThread;			///< Polls the network between frames (if the experiment config's networkThread is set)
+
+	/** Register a handler for each packet type this app receives (called once the network is set up) */
+	virtual void registerPacketHandlers();
+
+	// Packet handlers (see registerPacketHandlers())
+	virtual void onBatchEntityUpdate(BatchEntityUpdatePacket* packet);
+	void onHandshakeReply(HandshakeReplyPacket* packet);
+	virtual void onPlayerInteract(PlayerInteractPacket* packet);
+	virtual void onReliableConnect(ReliableConnectPacket* packet);
+	void onCreateEntity(CreateEntityPacket* packet);
+	void onRegistrationReply(RegistrationReplyPacket* packet);
+	void onMoveClient(MoveClientPacket* packet);
+	void onDestroyEntity(DestroyEntityPacket* packet);
+	void onSetSpawnLocation(SetSpawnPacket* packet);
+	void onRespawnClient(RespawnClientPacket* packet);
+	void onStartSession(StartSessionPacket* packet);
+	void onSendPlayerConfig(SendPlayerConfigPacket* packet);
+	void onAddPoints(AddPointPacket* packet);
+	void onResetClientRound(ResetClientRoundPacket* packet);
+	void onClientFeedbackStart(ClientFeedbackStartPacket* packet);
+	void onClientSessionEnd(ClientSessionEndPacket* packet);
+	void onPlayerState(PlayerStatePacket* packet);
+
+	/** Rebuild and record the snapshot for a DELTA_FRAME update, returns false if its baseline isn't held (or it is out of date) */
+	bool receiveSnapshot(BatchEntityUpdatePacket* packet);
+	/** Apply a frame from the server to a networked entity (ignoring updates for this client's player), or buffer it for interpolation */
+	void setNetworkedEntityFrame(uint16 index, const CFrame& frame, uint32 serverFrame);
+	/** Show the buffered remote entities a fixed delay behind the server (and log how they were found) when interpolation is enabled */
+	void updateInterpolatedEntities();
+	/** Record this frame's (simulated) player input and the state predicted from it, marking it as a respawn if the player was moved */
+	void recordPlayerInput(float dt);
+	/** Log the decisions made by the network impairment emulator (see NetworkUtils::setAddressImpairment()) since the last call */
+	void logImpairments();
+	/** Start polling the network on its own thread if the experiment config asks for it (called once the network is set up) */
+	void startNetworkThread();
+	/** Stop the network thread (if running), so ENet can be used directly again */
+	void stopNetworkThread();
+	/** Handle every packet received since the last call (see registerPacketHandlers()) */
+	void receivePackets();
+
 	/** Called from onInit */
 	void makeGUI();
 	void updateControls(bool firstSession = false);
@@ -297,6 +358,8 @@ public:
 	void showRenderControls();
 	/** Show the weapon controls */
 	void showWeaponControls();
+	/** Show the logger stats */
+	void showLoggerControls();
 	/** Save scene w/ updated player position */
 	void exportScene();
 
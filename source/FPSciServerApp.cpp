@@ -3,10 +3,18 @@
 #include "PhysicsScene.h"
 #include "WaypointManager.h"
 #include "NetworkedSession.h"
+#ifdef G3D_WINDOWS
 #include <Windows.h>
+#else
+#include <errno.h>
+#endif
+#include <thread>
 
 FPSciServerApp::FPSciServerApp(const GApp::Settings& settings) : FPSciApp(settings) {}
 
+FPSciServerApp::FPSciServerApp(const GApp::Settings& settings, bool headless) :
+    FPSciApp(settings, headless ? NoWindow::create(settings.window) : nullptr, nullptr, !headless), m_headless(headless) {}
+
 
 
 
@@ -29,7 +37,7 @@ void FPSciServerApp::initExperiment() {
     m_lastOnSimulationRealTime = 0.0;
 
     // Setup/update waypoint manager
-    if (startupConfig.developerMode && startupConfig.waypointEditorMode) {
+    if (!m_headless && startupConfig.developerMode && startupConfig.waypointEditorMode) {
         FPSciApp::waypointManager = WaypointManager::create(this);
     }
 
@@ -42,21 +50,29 @@ void FPSciServerApp::initExperiment() {
     weapon->setHitCallback(std::bind(&FPSciServerApp::hitTarget, this, std::placeholders::_1));
     weapon->setMissCallback(std::bind(&FPSciServerApp::missEvent, this));
 
-    // Load models and set the reticle
-    loadModels();
-    setReticle(reticleConfig.index);
-
-    // Load fonts and images
-    outputFont = GFont::fromFile(System::findDataFile("arial.fnt"));
-    hudTextures.set("scoreBannerBackdrop", Texture::fromFile(System::findDataFile("gui/scoreBannerBackdrop.png")));
-
-    // Setup the GUI
-    showRenderingStats = false;
-    makeGUI();
-
-    updateMouseSensitivity();				// Update (apply) mouse sensitivity
-    const Array<String> sessions = m_userSettingsWindow->updateSessionDropDown();	// Update the session drop down to remove already completed sessions
-    updateSession(sessions[0], true);		// Update session to create results file/start collection
+    if (m_headless) {
+        // No models, textures or GUI without a GL context, start the current user's next session
+        m_tickPeriod = 1.0 / startupConfig.serverTickRate;
+        const bool hasStatus = notNull(userStatusTable.getUserStatus(userStatusTable.currentUser));
+        updateSession(hasStatus ? userStatusTable.getNextSession() : "", true);
+    }
+    else {
+        // Load models and set the reticle
+        loadModels();
+        setReticle(reticleConfig.index);
+
+        // Load fonts and images
+        outputFont = GFont::fromFile(System::findDataFile("arial.fnt"));
+        hudTextures.set("scoreBannerBackdrop", Texture::fromFile(System::findDataFile("gui/scoreBannerBackdrop.png")));
+
+        // Setup the GUI
+        showRenderingStats = false;
+        makeGUI();
+
+        updateMouseSensitivity();				// Update (apply) mouse sensitivity
+        const Array<String> sessions = m_userSettingsWindow->updateSessionDropDown();	// Update the session drop down to remove already completed sessions
+        updateSession(sessions[0], true);		// Update session to create results file/start collection
+    }
 
     /* This is where added code begins */
 
@@ -72,11 +88,18 @@ void FPSciServerApp::initExperiment() {
 
     m_unreliableSocket = enet_socket_create(ENET_SOCKET_TYPE_DATAGRAM);         // create the unreliable socket
     enet_socket_set_option(m_unreliableSocket, ENET_SOCKOPT_NONBLOCK, 1);       // Set socket to non-blocking
+    NetworkUtils::setBatchedIO(experimentConfig.batchedDatagramIO);
+    registerPacketHandlers();
     localAddress.port += 1;                                                 // We use the reliable connection port + 1 for the unreliable connections (instead of another value in the experiment config)
     if (enet_socket_bind(m_unreliableSocket, &localAddress)) {
+#ifdef G3D_WINDOWS
         debugPrintf("bind failed with error: %d\n", WSAGetLastError());
+#else
+        debugPrintf("bind failed with error: %d\n", errno);
+#endif
         throw std::runtime_error("Could not bind to the local address");
     }
+    startNetworkThread();
 
     debugPrintf("Began listening\n");
     isServer = true;
@@ -95,361 +118,565 @@ void FPSciServerApp::onNetwork() {
         m_networkFrameNum++;
     //}
     
-    /* First we receive on the unreliable connection */
-
-    shared_ptr<GenericPacket> inPacket = NetworkUtils::receivePacket(m_localHost, &m_unreliableSocket);
-    while (inPacket != nullptr) {
-        char ip[16];
-        ENetAddress srcAddr = inPacket->srcAddr();
-        enet_address_get_host_ip(&srcAddr, ip, 16);
-        NetworkUtils::ConnectedClient* client = getClientFromAddress(inPacket->srcAddr());
-        if (!inPacket->isReliable()) {
-            switch (inPacket->type()) {
-            case HANDSHAKE: {
-                shared_ptr<HandshakeReplyPacket> outPacket = GenericPacket::createUnreliable<HandshakeReplyPacket>(&m_unreliableSocket, &srcAddr);
-                NetworkUtils::send(outPacket);
-                /*if (outPacket->send() <= 0) {
-                    debugPrintf("Failed to send the handshke reply\n");
-                }*/
-                break;
-            }
-            case BATCH_ENTITY_UPDATE: {
-                BatchEntityUpdatePacket* typedPacket = static_cast<BatchEntityUpdatePacket*> (inPacket.get());
-                client->frameNumber = typedPacket->m_frameNumber;
-                for (BatchEntityUpdatePacket::EntityUpdate e : typedPacket->m_updates) {
-                    shared_ptr<NetworkedEntity> entity = (*scene()).typedEntity<NetworkedEntity>(e.name);
-                    if (entity == nullptr) {
-                        debugPrintf("Recieved update for entity %s, but it doesn't exist\n", e.name.c_str());
-                    }
-                    else {
-                        switch (typedPacket->m_updateType) {
-                        case BatchEntityUpdatePacket::NetworkUpdateType::NOOP:
-                            // Do nothing (No-Op)
-                            break;
-                        case BatchEntityUpdatePacket::NetworkUpdateType::REPLACE_FRAME:
-                            entity->setFrame(e.frame);
-                            break;
-                        }
-                    }
-                }
-                break;
-            }
-            case PLAYER_INTERACT: {
-                PlayerInteractPacket* typedPacket = static_cast<PlayerInteractPacket*> (inPacket.get());
-                shared_ptr<NetworkedEntity> clientEntity = scene()->typedEntity<NetworkedEntity>(typedPacket->m_actorID.toString16());
-                RemotePlayerAction rpa = RemotePlayerAction();
-                rpa.time = sess->logger->getFileTime();
-                rpa.viewDirection = clientEntity->getLookAzEl();
-                rpa.position = clientEntity->frame().translation;
-                rpa.state = sess->currentState;
-                rpa.action = (PlayerActionType)typedPacket->m_remoteAction;
-                rpa.actorID = typedPacket->m_actorID.toString16();
-                sess->logger->logRemotePlayerAction(rpa);
-                break;
-            }
-            default:
-                debugPrintf("WARNING: unhandled packet receved on the unreliable channel of type: %d\n", inPacket->type());
-                break;
-            }
+    /* Receive and handle any packets (see registerPacketHandlers()) */
+    receivePackets();
+    sendPlayerStates();
+
+    /* Now we send the position of all entities to all connected clients */
+    sendEntitySnapshots();
+    logSnapshotStats();
+    logImpairments();
+
+    // Broadcast the PlayerConfig to all clients
+    if (sessConfig->player.propagatePlayerConfigsToAll) {
+        sessConfig->player.propagatePlayerConfigsToAll = false;
+        shared_ptr<SendPlayerConfigPacket> configPacket = GenericPacket::createForBroadcast<SendPlayerConfigPacket>();
+        configPacket->populate(sessConfig->player, sessConfig->networkedSessionProgress);
+        for (NetworkUtils::ConnectedClient* c : m_connectedClients) {
+            setClientPlayerConfig(c, configPacket->selectedConfig());
+        }
+        NetworkUtils::broadcastReliable(configPacket, m_localHost);
+    }
+
+    if (sessConfig->player.propagatePlayerConfigsToSelectedClient) {
+        sessConfig->player.propagatePlayerConfigsToSelectedClient = false;
+        shared_ptr<SendPlayerConfigPacket> configPacket;
+        NetworkUtils::ConnectedClient* selectedClient = m_connectedClients[(sessConfig->player.selectedClientIdx == 0) ? 0 : 1];
+        configPacket = GenericPacket::createReliable<SendPlayerConfigPacket>(selectedClient->peer);
+        configPacket->populate(sessConfig->player, sessConfig->networkedSessionProgress);
+        setClientPlayerConfig(selectedClient, configPacket->selectedConfig());
+        NetworkUtils::send(configPacket);
+    }
+}
+
+void FPSciServerApp::sendEntitySnapshots() {
+    // Snapshot of every entity the clients know about (sorted by index, so it can be compared against the baselines)
+    Array<shared_ptr<NetworkedEntity>> entityArray;
+    scene()->getTypedEntityArray<NetworkedEntity>(entityArray);
+    const shared_ptr<SnapshotHistory::Snapshot> snapshot = std::make_shared<SnapshotHistory::Snapshot>();
+    for (shared_ptr<NetworkedEntity> e : entityArray) {
+        if (e->networkIndex() == NetworkedEntity::NO_NETWORK_INDEX) continue;      // Clients don't know about this entity
+        snapshot->append(SnapshotHistory::EntityState(e->networkIndex(), e->frame()));
+    }
+    std::sort(snapshot->begin(), snapshot->end(), [](const SnapshotHistory::EntityState& a, const SnapshotHistory::EntityState& b) { return a.index < b.index; });
+    m_hitHistory.record(m_networkFrameNum, System::time(), snapshot);       // Reported hits are checked against these poses
+
+    if (experimentConfig.interest.enable) {
+        sendRelevantSnapshots(*snapshot);
+        return;
+    }
+
+    // Clients with the same baseline get the same update, so it is only encoded (and serialized) once for each baseline
+    Table<uint32, Array<NetworkUtils::ConnectedClient*>> clientsByBaseline;
+    for (NetworkUtils::ConnectedClient* c : m_connectedClients) {
+        const uint32 baselineFrame = (experimentConfig.deltaSnapshots && notNull(c->snapshots.baseline())) ? c->snapshots.ackedFrame() : 0;
+        clientsByBaseline.getCreate(baselineFrame).append(c);
+    }
+    for (const uint32 baselineFrame : clientsByBaseline.getKeys()) {
+        const Array<NetworkUtils::ConnectedClient*>& clients = clientsByBaseline[baselineFrame];
+        sendSnapshot(clients, baselineFrame, snapshot, snapshot->size());
+        for (NetworkUtils::ConnectedClient* c : clients) {
+            c->snapshots.sendStats.entitiesRelevant += snapshot->size();
+        }
+    }
+}
+
+void FPSciServerApp::sendRelevantSnapshots(const SnapshotHistory::Snapshot& snapshot) {
+    const InterestConfig& config = experimentConfig.interest;
+    Array<shared_ptr<NetworkedEntity>> viewers;
+    for (NetworkUtils::ConnectedClient* c : m_connectedClients) {
+        viewers.append(scene()->typedEntity<NetworkedEntity>(c->guid.toString16()));
+    }
+    // The clients' entities (players) are given their own priority
+    m_entityPriorities.resize(snapshot.size());
+    for (int i = 0; i < snapshot.size(); i++) {
+        m_entityPriorities[i] = config.targetPriority;
+        for (const shared_ptr<NetworkedEntity>& v : viewers) {
+            if (notNull(v) && v->networkIndex() == snapshot[i].index) m_entityPriorities[i] = config.playerPriority;
+        }
+    }
+
+    // Each client's update is chosen for it, so it is encoded for that client alone
+    const RealTime now = System::time();
+    const shared_ptr<PhysicsScene> physicsScene = typedScene<PhysicsScene>();
+    for (int i = 0; i < m_connectedClients.size(); i++) {
+        NetworkUtils::ConnectedClient* c = m_connectedClients[i];
+        if (isNull(viewers[i])) continue;       // The client's entity hasn't been created yet
+        const shared_ptr<const SnapshotHistory::Snapshot> baseline = experimentConfig.deltaSnapshots ? c->snapshots.baseline() : nullptr;
+        const uint32 baselineFrame = notNull(baseline) ? c->snapshots.ackedFrame() : 0;
+        const shared_ptr<SnapshotHistory::Snapshot> view = std::make_shared<SnapshotHistory::Snapshot>();
+        c->interest.select(config, viewers[i]->frame(), viewers[i]->networkIndex(), physicsScene.get(), snapshot, m_entityPriorities,
+            baseline.get(), experimentConfig.deltaSnapshots, now, *view);
+        sendSnapshot({ c }, baselineFrame, view, snapshot.size());
+        c->snapshots.sendStats.entitiesRelevant += c->interest.stats().relevant;
+        c->snapshots.sendStats.entitiesDeferred += c->interest.stats().deferred;
+    }
+}
+
+void FPSciServerApp::sendSnapshot(const Array<NetworkUtils::ConnectedClient*>& clients, uint32 baselineFrame, const shared_ptr<const SnapshotHistory::Snapshot>& snapshot, int entitiesTotal) {
+    shared_ptr<BatchEntityUpdatePacket> updatePacket = GenericPacket::createForBroadcast<BatchEntityUpdatePacket>();
+    if (experimentConfig.deltaSnapshots) {
+        const shared_ptr<const SnapshotHistory::Snapshot> baseline = clients[0]->snapshots.find(baselineFrame);
+        SnapshotHistory::diff(baseline.get(), *snapshot, m_snapshotDeltas);
+        updatePacket->populateDelta(m_networkFrameNum, baselineFrame, m_snapshotDeltas);
+    }
+    else {
+        Array<BatchEntityUpdatePacket::EntityUpdate> updates;
+        for (const SnapshotHistory::EntityState& state : *snapshot) {
+            updates.append(BatchEntityUpdatePacket::EntityUpdate(state.frame(), state.index));
+        }
+        updatePacket->populate(m_networkFrameNum, updates, BatchEntityUpdatePacket::NetworkUpdateType::REPLACE_FRAME);
+    }
+
+    // Large updates go out in several datagrams, each small enough to arrive unfragmented
+    updatePacket->split(m_snapshotParts);
+    Array<ENetAddress*> clientAddresses;
+    int bytes = 0;
+    for (const shared_ptr<BatchEntityUpdatePacket>& part : m_snapshotParts) {
+        bytes += part->serializedSize();
+    }
+    const int fullBytes = BatchEntityUpdatePacket::HEADER_BYTES + entitiesTotal * BatchEntityUpdatePacket::REPLACE_BYTES_PER_ENTITY;
+    const int entitiesSent = experimentConfig.deltaSnapshots ? m_snapshotDeltas.size() : snapshot->size();
+    for (NetworkUtils::ConnectedClient* c : clients) {
+        clientAddresses.append(&c->unreliableAddress);
+        c->snapshots.record(m_networkFrameNum, snapshot);
+        SnapshotHistory::SendStats& sent = c->snapshots.sendStats;
+        sent.snapshots++;
+        if (baselineFrame == 0) sent.fullSnapshots++;
+        sent.bytesSent += bytes;
+        sent.fullBytes += fullBytes;
+        sent.entitiesSent += entitiesSent;
+        sent.entitiesTotal += entitiesTotal;
+    }
+    for (const shared_ptr<BatchEntityUpdatePacket>& part : m_snapshotParts) {
+        NetworkUtils::broadcastUnreliable(part, &m_unreliableSocket, clientAddresses);
+    }
+}
+
+void FPSciServerApp::logSnapshotStats() {
+    const RealTime now = System::time();
+    if (now - m_lastSnapshotStatsTime < s_snapshotStatsPeriodS) return;
+    m_lastSnapshotStatsTime = now;
+    for (NetworkUtils::ConnectedClient* c : m_connectedClients) {
+        SnapshotHistory::SendStats& sent = c->snapshots.sendStats;
+        if (sent.snapshots > 0 && notNull(sess) && notNull(sess->logger)) {
+            SnapshotStats row;
+            row.time = FPSciLogger::getTime();
+            row.playerID = c->guid;
+            row.state = sess->currentState;
+            row.snapshots = sent.snapshots;
+            row.fullSnapshots = sent.fullSnapshots;
+            row.bytesSent = sent.bytesSent;
+            row.fullBytes = sent.fullBytes;
+            row.entitiesSent = sent.entitiesSent;
+            row.entitiesTotal = sent.entitiesTotal;
+            row.entitiesRelevant = sent.entitiesRelevant;
+            row.entitiesDeferred = sent.entitiesDeferred;
+            sess->logger->logSnapshotStats(row);
+        }
+        sent = SnapshotHistory::SendStats();
+    }
+}
+
+void FPSciServerApp::sendPlayerStates() {
+    for (NetworkUtils::ConnectedClient* c : m_connectedClients) {
+        if (isNull(c->movement) || !c->inputsSimulated) continue;
+        c->inputsSimulated = false;
+        shared_ptr<PlayerStatePacket> statePacket = GenericPacket::createUnreliable<PlayerStatePacket>(&m_unreliableSocket, &c->unreliableAddress);
+        statePacket->populate(m_networkFrameNum, c->inputSequence, c->movement->movementState());
+        NetworkUtils::send(statePacket);
+    }
+}
+
+void FPSciServerApp::setClientPlayerConfig(NetworkUtils::ConnectedClient* client, const PlayerConfig& config) {
+    client->playerConfig = config;
+    client->playerConfig.respawnToPos = false;      // The client respawns itself and sends the result (as a RESPAWNED input)
+}
+
+void FPSciServerApp::registerPacketHandlers() {
+    /* Unreliable packets */
+    m_packetDispatcher.on(HANDSHAKE, PacketDispatcher::UNRELIABLE, this, &FPSciServerApp::onHandshake);
+    m_packetDispatcher.on(BATCH_ENTITY_UPDATE, PacketDispatcher::UNRELIABLE, this, &FPSciServerApp::onBatchEntityUpdate);
+    m_packetDispatcher.on(PLAYER_INTERACT, PacketDispatcher::UNRELIABLE, this, &FPSciServerApp::onPlayerInteract);
+    m_packetDispatcher.on(PLAYER_INPUT, PacketDispatcher::UNRELIABLE, this, &FPSciServerApp::onPlayerInput);
+
+    /* Reliable packets */
+    m_packetDispatcher.on(RELIABLE_CONNECT, PacketDispatcher::RELIABLE, this, &FPSciServerApp::onReliableConnect);
+    m_packetDispatcher.on(RELIABLE_DISCONNECT, PacketDispatcher::RELIABLE, this, &FPSciServerApp::onReliableDisconnect);
+    m_packetDispatcher.on(REGISTER_CLIENT, PacketDispatcher::RELIABLE, this, &FPSciServerApp::onRegisterClient);
+    m_packetDispatcher.on(REPORT_HIT, PacketDispatcher::RELIABLE, this, &FPSciServerApp::onReportHit);
+    m_packetDispatcher.on(READY_UP_CLIENT, PacketDispatcher::RELIABLE, this, &FPSciServerApp::onReadyUpClient);
+    m_packetDispatcher.on(CLIENT_ROUND_TIMEOUT, PacketDispatcher::RELIABLE, this, &FPSciServerApp::onClientRoundTimeout);
+    m_packetDispatcher.on(CLIENT_FEEDBACK_SUBMITTED, PacketDispatcher::RELIABLE, this, &FPSciServerApp::onClientFeedbackSubmitted);
+}
+
+void FPSciServerApp::onHandshake(HandshakePacket* packet) {
+    ENetAddress srcAddr = packet->srcAddr();
+    shared_ptr<HandshakeReplyPacket> outPacket = GenericPacket::createUnreliable<HandshakeReplyPacket>(&m_unreliableSocket, &srcAddr);
+    NetworkUtils::send(outPacket);
+    /*if (outPacket->send() <= 0) {
+        debugPrintf("Failed to send the handshke reply\n");
+    }*/
+}
+
+void FPSciServerApp::onBatchEntityUpdate(BatchEntityUpdatePacket* packet) {
+    NetworkUtils::ConnectedClient* client = getClientFromAddress(packet->srcAddr());
+    client->frameNumber = packet->m_frameNumber;
+    client->snapshots.acknowledge(packet->m_baselineFrame);        // Last snapshot this client received (the next baseline)
+    if (experimentConfig.prediction.enable) return;                 // The client's movement is simulated from its inputs (see onPlayerInput())
+    for (const BatchEntityUpdatePacket::EntityUpdate& e : packet->m_updates) {
+        const String* name = m_entityIndices.nameOf(e.index);
+        shared_ptr<NetworkedEntity> entity = notNull(name) ? (*scene()).typedEntity<NetworkedEntity>(*name) : nullptr;
+        if (entity == nullptr) {
+            debugPrintf("Recieved update for entity index %d, but it doesn't exist\n", e.index);
         }
-        // This is a reliable packet and should be handled as such
         else {
-            switch (inPacket->type()) {
-            case RELIABLE_CONNECT: {
-                debugPrintf("connection recieved...\n");
-                logPrintf("made connection to %s in response to input\n", ip);
+            switch (packet->m_updateType) {
+            case BatchEntityUpdatePacket::NetworkUpdateType::NOOP:
+                // Do nothing (No-Op)
                 break;
-            }
-            case RELIABLE_DISCONNECT: {
-                debugPrintf("disconnection recieved...\n");
-                logPrintf("%s disconnected.\n", ip);
-                /* Removes the clinet from the list of connected clients and orders all other clients to delete that entity */
-                shared_ptr<NetworkedEntity> entity = scene()->typedEntity<NetworkedEntity>(client->guid.toString16());
-                if (entity != nullptr) {
-                    scene()->remove(entity);
-                }
-                for (int i = 0; i < m_connectedClients.length(); i++) {
-                    if (m_connectedClients[i]->guid == client->guid) {
-                        m_connectedClients.remove(i, 1);
-                    }
-                }
-                
-                shared_ptr<DestroyEntityPacket> outPacket = GenericPacket::createForBroadcast<DestroyEntityPacket>();
-                outPacket->populate(m_networkFrameNum, client->guid);
-                NetworkUtils::broadcastReliable(outPacket, m_localHost);
-                //NetworkUtils::send(outPacket);
-                //outPacket->send();
-                break;
-            }
-            case REGISTER_CLIENT: {
-                RegisterClientPacket* typedPacket = static_cast<RegisterClientPacket*> (inPacket.get());
-                debugPrintf("Registering client...\n");
-                NetworkUtils::ConnectedClient* newClient = NetworkUtils::registerClient(typedPacket);   // TODO: Decide if this should be in NetworkUtils or not
-                m_connectedClients.append(newClient);
-                /* Reply to the registration */
-                shared_ptr<RegistrationReplyPacket> registrationReply = GenericPacket::createReliable<RegistrationReplyPacket>(newClient->peer);
-                registrationReply->populate(newClient->guid, 0);
-                NetworkUtils::send(registrationReply);
-                ENetAddress addr = typedPacket->srcAddr();
-                addr.port = typedPacket->m_portNum;
-                /* Set the amount of latency to add */
-                NetworkUtils::setAddressLatency(addr, sessConfig->networkLatency);
-                NetworkUtils::setAddressLatency(typedPacket->srcAddr(), sessConfig->networkLatency);
-                //registrationReply->send();
-                debugPrintf("\tRegistered client: %s\n", newClient->guid.toString16());
-
-                Any modelSpec = PARSE_ANY(ArticulatedModel::Specification{			///< Basic model spec for target
-                    filename = "model/target/pointingplayer.obj";
-                    preprocess = {
-                    transformGeometry(all(), Matrix4::yawDegrees(120));
-                    //transformGeometry(all(), Matrix4::translation(0, -1, 0));
-                    };
-                    cleanGeometrySettings = ArticulatedModel::CleanGeometrySettings{
-                    allowVertexMerging = true;
-                    forceComputeNormals = false;
-                    forceComputeTangents = false;
-                    forceVertexMerging = true;
-                    maxEdgeLength = inf;
-                    maxNormalWeldAngleDegrees = 0;
-                    maxSmoothAngleDegrees = 0;
-                    };
-                    });
-                shared_ptr<Model> model = ArticulatedModel::create(modelSpec);
-                /* Create a new entity for the client */
-                const shared_ptr<NetworkedEntity>& target = NetworkedEntity::create(newClient->guid.toString16(), &(*scene()), model, CFrame());
-
-                target->setWorldSpace(true);
-                target->setColor(G3D::Color3(20.0, 20.0, 200.0));
-
-                /* Add the new target to the scene */
-                (*scene()).insert(target);
-
-                /* ADD NEW CLIENT TO OTHER CLIENTS, ADD OTHER CLIENTS TO NEW CLIENT */
-                shared_ptr<CreateEntityPacket> createEntityPacket = GenericPacket::createForBroadcast<CreateEntityPacket>();
-                createEntityPacket->populate(m_networkFrameNum, newClient->guid);
-                NetworkUtils::broadcastReliable(createEntityPacket, m_localHost);
-                debugPrintf("Sent a broadcast packet to all connected peers\n");
-
-                for (int i = 0; i < m_connectedClients.length(); i++) {
-                    // Create entitys on the new client for all other clients
-                    if (newClient->guid != m_connectedClients[i]->guid) {
-                        createEntityPacket = GenericPacket::createReliable<CreateEntityPacket>(newClient->peer);
-                        createEntityPacket->populate(m_networkFrameNum, m_connectedClients[i]->guid);
-                        NetworkUtils::send(createEntityPacket);
-                        //createEntityPacket->send();
-                        debugPrintf("Sent add to %s to add %s\n", newClient->guid.toString16(), m_connectedClients[i]->guid.toString16());
-                    }
-                }
-                // move the client to a different location
-                // TODO: Make this smart not just some test code
-                if (m_connectedClients.length() % 2 == 0) {
-                    Point3 position = Point3(-46, -2.3, 0);
-                    float heading = 90;
-                    shared_ptr<SetSpawnPacket> setSpawnPacket = GenericPacket::createReliable<SetSpawnPacket>(newClient->peer);
-                    setSpawnPacket->populate(position, heading);
-                    NetworkUtils::send(setSpawnPacket);
-                    //setSpawnPacket->send();
-                    shared_ptr<RespawnClientPacket> respawnPacket = GenericPacket::createReliable<RespawnClientPacket>(newClient->peer);
-                    respawnPacket->populate();
-                    NetworkUtils::send(respawnPacket);
-                    //respawnPacket->send();
-                }
-                break;
-            }
-            case PacketType::REPORT_HIT: {
-                // This just causes everyone to respawn
-                ReportHitPacket* typedPacket = static_cast<ReportHitPacket*> (inPacket.get());
-                shared_ptr<NetworkedEntity> hitEntity = scene()->typedEntity<NetworkedEntity>(typedPacket->m_shotID.toString16());
-                //NetworkUtils::ConnectedClient* hitClient = getClientFromGUID(hitID);
-
-                // Log the hit on the server
-                const shared_ptr<NetworkedEntity> shooterEntity = scene()->typedEntity<NetworkedEntity>(typedPacket->m_shooterID.toString16());
-                RemotePlayerAction rpa = RemotePlayerAction();
-                rpa.time = sess->logger->getFileTime();
-                rpa.viewDirection = shooterEntity->getLookAzEl();
-                rpa.position = shooterEntity->frame().translation;
-                rpa.state = sess->currentState;
-                rpa.action = PlayerActionType::Hit;
-                rpa.actorID = typedPacket->m_shooterID.toString16();
-                rpa.affectedID = typedPacket->m_shooterID.toString16();
-                sess->logger->logRemotePlayerAction(rpa);
-
-                float damage = 1.001 / sessConfig->hitsToKill;
-
-                if (hitEntity->doDamage(damage)) { //TODO: PARAMETERIZE THIS DAMAGE VALUE SOME HOW! DO IT! DON'T FORGET!  DON'T DO IT!
-                    debugPrintf("A player died! Resetting game...\n");
-                    m_clientsReady = 0;
-                    //static_cast<NetworkedSession*>(sess.get())->resetSession();
-                    netSess->resetRound();
-                    scene()->typedEntity<PlayerEntity>("player")->setPlayerMovement(true); //Allow the server to move freely
-
-                    Array<shared_ptr<NetworkedEntity>> entities;
-                    scene()->getTypedEntityArray<NetworkedEntity>(entities);
-                    for (shared_ptr<NetworkedEntity> entity : entities) {
-                        entity->respawn();
-                    }
-
-                    /* Send a respawn packet to everyone */
-                    shared_ptr<RespawnClientPacket> respawnPacket = GenericPacket::createForBroadcast<RespawnClientPacket>();
-                    respawnPacket->populate(m_networkFrameNum);
-                    NetworkUtils::broadcastReliable(respawnPacket, m_localHost);
-                    shared_ptr<AddPointPacket> pointPacket = GenericPacket::createReliable<AddPointPacket>(client->peer);
-                    NetworkUtils::send(pointPacket);
-                }
-                // Notify every player of the hit
-                shared_ptr<PlayerInteractPacket> interactPacket = GenericPacket::createForBroadcast<PlayerInteractPacket>();
-                interactPacket->populate(m_networkFrameNum, PlayerActionType::Hit, typedPacket->m_shooterID);
-                Array<ENetAddress*> clientAddresses;
-                for (NetworkUtils::ConnectedClient* c : m_connectedClients) {
-                    clientAddresses.append(&c->unreliableAddress);
-                }
-                /* Send this as a player interact packet so that clients log it */
-                NetworkUtils::broadcastUnreliable(interactPacket, &m_unreliableSocket, clientAddresses);
-                break;
-            }
-            case READY_UP_CLIENT: {
-                m_clientsReady++;
-                debugPrintf("Connected Number of Clients: %d\nReady Clients: %d\n", m_connectedClients.length(), m_clientsReady);
-                if (m_clientsReady >= experimentConfig.numPlayers)
-                {
-                    if (m_clientsReady >= experimentConfig.numPlayers)
-                    {
-                        if (sessConfig->numberOfRoundsPlayed % 2 == 0) {
-
-                            m_clientFirstRoundPeeker = rand() % 2;
-                            // Make them instantly spawn to the new location
-                            m_peekersRoundConfigs[peekerDefenderConfigCombinationsIdx[sessConfig->numberOfRoundsPlayed / 2].first].respawnToPos = true;
-                            m_defendersRoundConfigs[peekerDefenderConfigCombinationsIdx[sessConfig->numberOfRoundsPlayed / 2].second].respawnToPos = true;
-
-                            shared_ptr<SendPlayerConfigPacket> outPacket = GenericPacket::createReliable<SendPlayerConfigPacket>(m_connectedClients[m_clientFirstRoundPeeker]->peer);
-                            outPacket->populate(m_peekersRoundConfigs[peekerDefenderConfigCombinationsIdx[sessConfig->numberOfRoundsPlayed / 2].first], sessConfig->networkedSessionProgress);
-                            NetworkUtils::send(outPacket);
-                            outPacket = GenericPacket::createReliable<SendPlayerConfigPacket>(m_connectedClients[!m_clientFirstRoundPeeker]->peer);
-                            outPacket->populate(m_defendersRoundConfigs[peekerDefenderConfigCombinationsIdx[sessConfig->numberOfRoundsPlayed / 2].second], sessConfig->networkedSessionProgress);
-                            NetworkUtils::send(outPacket);
-
-                            // Set Latency 
-                            NetworkUtils::setAddressLatency(m_connectedClients[m_clientFirstRoundPeeker]->peer->address, m_peekersRoundConfigs[peekerDefenderConfigCombinationsIdx[sessConfig->numberOfRoundsPlayed / 2].first].clientLatency);
-                            NetworkUtils::setAddressLatency(m_connectedClients[m_clientFirstRoundPeeker]->unreliableAddress, m_peekersRoundConfigs[peekerDefenderConfigCombinationsIdx[sessConfig->numberOfRoundsPlayed / 2].first].clientLatency);
-
-                            NetworkUtils::setAddressLatency(m_connectedClients[!m_clientFirstRoundPeeker]->peer->address, m_defendersRoundConfigs[peekerDefenderConfigCombinationsIdx[sessConfig->numberOfRoundsPlayed / 2].second].clientLatency);
-                            NetworkUtils::setAddressLatency(m_connectedClients[!m_clientFirstRoundPeeker]->unreliableAddress, m_defendersRoundConfigs[peekerDefenderConfigCombinationsIdx[sessConfig->numberOfRoundsPlayed / 2].second].clientLatency);
-
-                            //Log configs
-                            sess->logger->logPlayerConfig(m_peekersRoundConfigs[peekerDefenderConfigCombinationsIdx[sessConfig->numberOfRoundsPlayed / 2].first], m_connectedClients[m_clientFirstRoundPeeker]->guid, sessConfig->numberOfRoundsPlayed);
-                            sess->logger->logPlayerConfig(m_defendersRoundConfigs[peekerDefenderConfigCombinationsIdx[sessConfig->numberOfRoundsPlayed / 2].second], m_connectedClients[!m_clientFirstRoundPeeker]->guid, sessConfig->numberOfRoundsPlayed);
-                        }
-                        else {
-
-                            // Make them instantly spawn to the new location
-                            m_peekersRoundConfigs[peekerDefenderConfigCombinationsIdx[sessConfig->numberOfRoundsPlayed / 2].first].respawnToPos = true;
-                            m_defendersRoundConfigs[peekerDefenderConfigCombinationsIdx[sessConfig->numberOfRoundsPlayed / 2].second].respawnToPos = true;
-
-                            shared_ptr<SendPlayerConfigPacket> outPacket = GenericPacket::createReliable<SendPlayerConfigPacket>(m_connectedClients[!m_clientFirstRoundPeeker]->peer);
-                            outPacket->populate(m_peekersRoundConfigs[peekerDefenderConfigCombinationsIdx[sessConfig->numberOfRoundsPlayed / 2].first], sessConfig->networkedSessionProgress);
-                            NetworkUtils::send(outPacket);
-                            outPacket = GenericPacket::createReliable<SendPlayerConfigPacket>(m_connectedClients[m_clientFirstRoundPeeker]->peer);
-                            outPacket->populate(m_defendersRoundConfigs[peekerDefenderConfigCombinationsIdx[sessConfig->numberOfRoundsPlayed / 2].second], sessConfig->networkedSessionProgress);
-                            NetworkUtils::send(outPacket);
-
-                            // Set Latency 
-                            NetworkUtils::setAddressLatency(m_connectedClients[!m_clientFirstRoundPeeker]->peer->address, m_peekersRoundConfigs[peekerDefenderConfigCombinationsIdx[sessConfig->numberOfRoundsPlayed / 2].first].clientLatency);
-                            NetworkUtils::setAddressLatency(m_connectedClients[!m_clientFirstRoundPeeker]->unreliableAddress, m_peekersRoundConfigs[peekerDefenderConfigCombinationsIdx[sessConfig->numberOfRoundsPlayed / 2].first].clientLatency);
-
-                            NetworkUtils::setAddressLatency(m_connectedClients[m_clientFirstRoundPeeker]->peer->address, m_defendersRoundConfigs[peekerDefenderConfigCombinationsIdx[sessConfig->numberOfRoundsPlayed / 2].second].clientLatency);
-                            NetworkUtils::setAddressLatency(m_connectedClients[m_clientFirstRoundPeeker]->unreliableAddress, m_defendersRoundConfigs[peekerDefenderConfigCombinationsIdx[sessConfig->numberOfRoundsPlayed / 2].second].clientLatency);
-
-                            //Log configs
-                            sess->logger->logPlayerConfig(m_peekersRoundConfigs[peekerDefenderConfigCombinationsIdx[sessConfig->numberOfRoundsPlayed / 2].first], m_connectedClients[!m_clientFirstRoundPeeker]->guid, sessConfig->numberOfRoundsPlayed);
-                            sess->logger->logPlayerConfig(m_defendersRoundConfigs[peekerDefenderConfigCombinationsIdx[sessConfig->numberOfRoundsPlayed / 2].second], m_connectedClients[m_clientFirstRoundPeeker]->guid, sessConfig->numberOfRoundsPlayed);
-                        }
-                        shared_ptr<StartSessionPacket> startSessPacket = GenericPacket::createForBroadcast<StartSessionPacket>();
-                        NetworkUtils::broadcastReliable(startSessPacket, m_localHost);
-                        m_clientFeedbackSubmitted = 0;
-                        netSess.get()->startRound();
-                        debugPrintf("All PLAYERS ARE READY!\n");
-                    }
-                }
-                break;
-            }
-            case CLIENT_ROUND_TIMEOUT: {
-                m_clientsTimedOut++;
-                
-                if (m_clientsTimedOut >= experimentConfig.numPlayers)
-                {
-                    sessConfig->numberOfRoundsPlayed++;
-                    debugPrintf("Rounds Played %d, Rounds Left %d\n", sessConfig->numberOfRoundsPlayed, sessConfig->trials[0].count - sessConfig->numberOfRoundsPlayed);
-                    sessConfig->networkedSessionProgress = (float)sessConfig->numberOfRoundsPlayed / (float)sessConfig->trials[0].count;
-                    debugPrintf("SESSION PROGRESS: %f\n", sessConfig->networkedSessionProgress);
-                    m_clientsReady = 0;
-                    m_clientsTimedOut = 0;
-                    debugPrintf("Round Over!\n");
-
-                    shared_ptr<ClientFeedbackStartPacket> outPacket = GenericPacket::createForBroadcast<ClientFeedbackStartPacket>();
-                    NetworkUtils::broadcastReliable(outPacket, m_localHost);
-                }
-                break;
-            }
-            case CLIENT_FEEDBACK_SUBMITTED: {
-                m_clientFeedbackSubmitted++;
-
-                if (sessConfig->numberOfRoundsPlayed >= sessConfig->trials[0].count)
-                {
-                    debugPrintf("SESSION OVER");
-                    shared_ptr<ClientSessionEndPacket> outPacket = GenericPacket::createForBroadcast<ClientSessionEndPacket>();
-                    NetworkUtils::broadcastReliable(outPacket, m_localHost);
-                }
-
-                else if (m_clientFeedbackSubmitted >= experimentConfig.numPlayers) {
-                    shared_ptr<ResetClientRoundPacket> outPacket = GenericPacket::createForBroadcast<ResetClientRoundPacket>();
-                    NetworkUtils::broadcastReliable(outPacket, m_localHost);
-                }
-                break;
-            }
-            default:
-                debugPrintf("WARNING: unhandled packet receved on the reliable channel of type: %d\n", inPacket->type());
+            case BatchEntityUpdatePacket::NetworkUpdateType::REPLACE_FRAME:
+                entity->setFrame(e.frame);
                 break;
             }
         }
-        
-        inPacket = NetworkUtils::receivePacket(m_localHost, &m_unreliableSocket);
     }
+}
 
-    /* Now we send the position of all entities to all connected clients */
-    Array<shared_ptr<NetworkedEntity>> entityArray;
-    scene()->getTypedEntityArray<NetworkedEntity>(entityArray);
-    Array<BatchEntityUpdatePacket::EntityUpdate> updates;
-    for (shared_ptr<NetworkedEntity> e : entityArray) {
-        updates.append(BatchEntityUpdatePacket::EntityUpdate(e->frame(), e->name()));
+void FPSciServerApp::onPlayerInput(PlayerInputPacket* packet) {
+    NetworkUtils::ConnectedClient* client = getClientFromAddress(packet->srcAddr());
+    if (isNull(client) || isNull(client->movement)) return;
+    for (const PlayerEntity::InputCommand& input : packet->m_inputs) {
+        if (input.sequence <= client->inputSequence) continue;         // Already simulated (inputs are resent until acknowledged)
+        PlayerEntity::InputCommand step = input;
+        step.dt = (input.dt > 0.0f) ? min(input.dt, s_maxInputDtS) : 0.0f;
+        client->movement->simulateInput(step, scene()->time());
+        client->inputSequence = input.sequence;
+        client->inputsSimulated = true;
+    }
+    // The other clients are sent the client where the server simulated it
+    shared_ptr<NetworkedEntity> entity = scene()->typedEntity<NetworkedEntity>(client->guid.toString16());
+    if (notNull(entity)) entity->setFrame(client->movement->frame());
+}
+
+void FPSciServerApp::onPlayerInteract(PlayerInteractPacket* packet) {
+    shared_ptr<NetworkedEntity> clientEntity = scene()->typedEntity<NetworkedEntity>(packet->m_actorID.toString16());
+    RemotePlayerAction rpa = RemotePlayerAction();
+    rpa.time = FPSciLogger::frameTime();
+    rpa.viewDirection = clientEntity->getLookAzEl();
+    rpa.position = clientEntity->frame().translation;
+    rpa.state = sess->currentState;
+    rpa.action = (PlayerActionType)packet->m_remoteAction;
+    rpa.actorID = packet->m_actorID;
+    sess->logger->logRemotePlayerAction(rpa);
+}
+
+void FPSciServerApp::onReliableConnect(ReliableConnectPacket* packet) {
+    char ip[16];
+    ENetAddress srcAddr = packet->srcAddr();
+    enet_address_get_host_ip(&srcAddr, ip, 16);
+    debugPrintf("connection recieved...\n");
+    logPrintf("made connection to %s in response to input\n", ip);
+}
+
+void FPSciServerApp::onReliableDisconnect(ReliableDisconnectPacket* packet) {
+    char ip[16];
+    ENetAddress srcAddr = packet->srcAddr();
+    enet_address_get_host_ip(&srcAddr, ip, 16);
+    NetworkUtils::ConnectedClient* client = getClientFromAddress(srcAddr);
+    debugPrintf("disconnection recieved...\n");
+    logPrintf("%s disconnected.\n", ip);
+    /* Removes the clinet from the list of connected clients and orders all other clients to delete that entity */
+    shared_ptr<NetworkedEntity> entity = scene()->typedEntity<NetworkedEntity>(client->guid.toString16());
+    if (entity != nullptr) {
+        scene()->remove(entity);
+    }
+    m_entityIndices.remove(client->guid.toString16());
+    for (int i = 0; i < m_connectedClients.length(); i++) {
+        if (m_connectedClients[i]->guid == client->guid) {
+            m_connectedClients.remove(i, 1);
+        }
     }
-    shared_ptr<BatchEntityUpdatePacket> updatePacket = GenericPacket::createForBroadcast<BatchEntityUpdatePacket>();
-    updatePacket->populate(m_networkFrameNum, updates, BatchEntityUpdatePacket::NetworkUpdateType::REPLACE_FRAME);
     
+    shared_ptr<DestroyEntityPacket> outPacket = GenericPacket::createForBroadcast<DestroyEntityPacket>();
+    outPacket->populate(m_networkFrameNum, client->guid);
+    NetworkUtils::broadcastReliable(outPacket, m_localHost);
+    //NetworkUtils::send(outPacket);
+    //outPacket->send();
+}
+
+void FPSciServerApp::onRegisterClient(RegisterClientPacket* packet) {
+    debugPrintf("Registering client...\n");
+    NetworkUtils::ConnectedClient* newClient = NetworkUtils::registerClient(packet);   // TODO: Decide if this should be in NetworkUtils or not
+    m_connectedClients.append(newClient);
+    const uint16 entityIndex = m_entityIndices.assign(newClient->guid.toString16());   // Identifies the client's entity in entity updates
+    /* Reply to the registration */
+    shared_ptr<RegistrationReplyPacket> registrationReply = GenericPacket::createReliable<RegistrationReplyPacket>(newClient->peer);
+    registrationReply->populate(newClient->guid, 0, entityIndex);
+    NetworkUtils::send(registrationReply);
+    ENetAddress addr = packet->srcAddr();
+    addr.port = packet->m_portNum;
+    /* Set the amount of latency to add */
+    NetworkUtils::setAddressLatency(addr, sessConfig->networkLatency);
+    NetworkUtils::setAddressLatency(packet->srcAddr(), sessConfig->networkLatency);
+    NetworkUtils::setAddressImpairment({ packet->srcAddr(), addr }, sessConfig->player.downlinkImpairment, m_connectedClients.size() - 1);
+    //registrationReply->send();
+    debugPrintf("\tRegistered client: %s\n", newClient->guid.toString16());
+
+    Any modelSpec = PARSE_ANY(ArticulatedModel::Specification{			///< Basic model spec for target
+        filename = "model/target/pointingplayer.obj";
+        preprocess = {
+        transformGeometry(all(), Matrix4::yawDegrees(120));
+        //transformGeometry(all(), Matrix4::translation(0, -1, 0));
+        };
+        cleanGeometrySettings = ArticulatedModel::CleanGeometrySettings{
+        allowVertexMerging = true;
+        forceComputeNormals = false;
+        forceComputeTangents = false;
+        forceVertexMerging = true;
+        maxEdgeLength = inf;
+        maxNormalWeldAngleDegrees = 0;
+        maxSmoothAngleDegrees = 0;
+        };
+        });
+    // A headless server can't load the model (its materials need a GL context), the entity only carries the client's frame
+    shared_ptr<Model> model = m_headless ? nullptr : ArticulatedModel::create(modelSpec);
+    /* Create a new entity for the client */
+    const shared_ptr<NetworkedEntity>& target = NetworkedEntity::create(newClient->guid.toString16(), &(*scene()), model, CFrame());
+
+    target->setWorldSpace(true);
+    target->setColor(G3D::Color3(20.0, 20.0, 200.0));
+    target->setNetworkIndex(entityIndex);
+
+    /* Add the new target to the scene */
+    (*scene()).insert(target);
+
+    if (experimentConfig.prediction.enable) {
+        /* Simulate the client's movement from its inputs, colliding with the scene like the server's player */
+        const shared_ptr<PlayerEntity> player = scene()->typedEntity<PlayerEntity>("player");
+        setClientPlayerConfig(newClient, sessConfig->player);
+        newClient->movement = dynamic_pointer_cast<PlayerEntity>(PlayerEntity::create(newClient->guid.toString16() + "_movement", &(*scene()), CFrame(), nullptr));
+        newClient->movement->setCollisionProxySphere(player->collisionProxySphere());
+        newClient->movement->setConfig(&newClient->playerConfig);
+        newClient->movement->setPlayerMovement(true);
+    }
+
+    /* ADD NEW CLIENT TO OTHER CLIENTS, ADD OTHER CLIENTS TO NEW CLIENT */
+    shared_ptr<CreateEntityPacket> createEntityPacket = GenericPacket::createForBroadcast<CreateEntityPacket>();
+    createEntityPacket->populate(m_networkFrameNum, newClient->guid, entityIndex);
+    NetworkUtils::broadcastReliable(createEntityPacket, m_localHost);
+    debugPrintf("Sent a broadcast packet to all connected peers\n");
+
+    for (int i = 0; i < m_connectedClients.length(); i++) {
+        // Create entitys on the new client for all other clients
+        if (newClient->guid != m_connectedClients[i]->guid) {
+            createEntityPacket = GenericPacket::createReliable<CreateEntityPacket>(newClient->peer);
+            createEntityPacket->populate(m_networkFrameNum, m_connectedClients[i]->guid, m_entityIndices.indexOf(m_connectedClients[i]->guid.toString16()));
+            NetworkUtils::send(createEntityPacket);
+            //createEntityPacket->send();
+            debugPrintf("Sent add to %s to add %s\n", newClient->guid.toString16(), m_connectedClients[i]->guid.toString16());
+        }
+    }
+    // move the client to a different location
+    // TODO: Make this smart not just some test code
+    if (m_connectedClients.length() % 2 == 0) {
+        Point3 position = Point3(-46, -2.3, 0);
+        float heading = 90;
+        shared_ptr<SetSpawnPacket> setSpawnPacket = GenericPacket::createReliable<SetSpawnPacket>(newClient->peer);
+        setSpawnPacket->populate(position, heading);
+        NetworkUtils::send(setSpawnPacket);
+        //setSpawnPacket->send();
+        shared_ptr<RespawnClientPacket> respawnPacket = GenericPacket::createReliable<RespawnClientPacket>(newClient->peer);
+        respawnPacket->populate();
+        NetworkUtils::send(respawnPacket);
+        //respawnPacket->send();
+    }
+}
+
+void FPSciServerApp::onReportHit(ReportHitPacket* packet) {
+    NetworkUtils::ConnectedClient* client = getClientFromAddress(packet->srcAddr());
+    // This just causes everyone to respawn
+    shared_ptr<NetworkedEntity> hitEntity = scene()->typedEntity<NetworkedEntity>(packet->m_shotID.toString16());
+    //NetworkUtils::ConnectedClient* hitClient = getClientFromGUID(hitID);
+
+    // Log the hit on the server
+    const shared_ptr<NetworkedEntity> shooterEntity = scene()->typedEntity<NetworkedEntity>(packet->m_shooterID.toString16());
+    RemotePlayerAction rpa = RemotePlayerAction();
+    rpa.time = FPSciLogger::frameTime();
+    rpa.viewDirection = shooterEntity->getLookAzEl();
+    rpa.position = shooterEntity->frame().translation;
+    rpa.state = sess->currentState;
+    rpa.action = PlayerActionType::Hit;
+    rpa.actorID = packet->m_shooterID;
+    rpa.affectedID = packet->m_shooterID;
+    sess->logger->logRemotePlayerAction(rpa);
+
+    if (experimentConfig.lagCompensation.enable && !validateHit(packet, hitEntity)) return;
+
+    float damage = 1.001 / sessConfig->hitsToKill;
+
+    if (hitEntity->doDamage(damage)) { //TODO: PARAMETERIZE THIS DAMAGE VALUE SOME HOW! DO IT! DON'T FORGET!  DON'T DO IT!
+        debugPrintf("A player died! Resetting game...\n");
+        m_clientsReady = 0;
+        //static_cast<NetworkedSession*>(sess.get())->resetSession();
+        netSess->resetRound();
+        scene()->typedEntity<PlayerEntity>("player")->setPlayerMovement(true); //Allow the server to move freely
+
+        Array<shared_ptr<NetworkedEntity>> entities;
+        scene()->getTypedEntityArray<NetworkedEntity>(entities);
+        for (shared_ptr<NetworkedEntity> entity : entities) {
+            entity->respawn();
+        }
+
+        /* Send a respawn packet to everyone */
+        shared_ptr<RespawnClientPacket> respawnPacket = GenericPacket::createForBroadcast<RespawnClientPacket>();
+        respawnPacket->populate(m_networkFrameNum);
+        NetworkUtils::broadcastReliable(respawnPacket, m_localHost);
+        shared_ptr<AddPointPacket> pointPacket = GenericPacket::createReliable<AddPointPacket>(client->peer);
+        NetworkUtils::send(pointPacket);
+    }
+    // Notify every player of the hit
+    shared_ptr<PlayerInteractPacket> interactPacket = GenericPacket::createForBroadcast<PlayerInteractPacket>();
+    interactPacket->populate(m_networkFrameNum, PlayerActionType::Hit, packet->m_shooterID);
     Array<ENetAddress*> clientAddresses;
     for (NetworkUtils::ConnectedClient* c : m_connectedClients) {
         clientAddresses.append(&c->unreliableAddress);
     }
-    NetworkUtils::broadcastUnreliable(updatePacket, &m_unreliableSocket, clientAddresses);
+    /* Send this as a player interact packet so that clients log it */
+    NetworkUtils::broadcastUnreliable(interactPacket, &m_unreliableSocket, clientAddresses);
+}
 
-    // Broadcast the PlayerConfig to all clients
-    if (sessConfig->player.propagatePlayerConfigsToAll) {
-        sessConfig->player.propagatePlayerConfigsToAll = false;
-        shared_ptr<SendPlayerConfigPacket> configPacket = GenericPacket::createForBroadcast<SendPlayerConfigPacket>();
-        configPacket->populate(sessConfig->player, sessConfig->networkedSessionProgress);
-        NetworkUtils::broadcastReliable(configPacket, m_localHost);
+bool FPSciServerApp::validateHit(ReportHitPacket* packet, const shared_ptr<NetworkedEntity>& hitEntity) {
+    const LagCompensationConfig& config = experimentConfig.lagCompensation;
+    const Ray shot = Ray::fromOriginAndDirection(packet->m_shotOrigin, packet->m_shotDirection.directionOrZero());
+    const uint16 targetIndex = notNull(hitEntity) ? hitEntity->networkIndex() : NetworkedEntity::NO_NETWORK_INDEX;
+    const LagCompensator::Validation v = m_hitHistory.validate(config, shot, packet->m_viewFrame, targetIndex, typedScene<PhysicsScene>().get());
+    const bool accepted = (v.result == LagCompensator::HIT);
+    if (config.logHits && notNull(sess) && notNull(sess->logger)) {
+        HitValidation row;
+        row.time = FPSciLogger::getTime();
+        row.shooterID = packet->m_shooterID;
+        row.targetID = packet->m_shotID;
+        row.serverFrame = m_networkFrameNum;
+        row.viewFrame = packet->m_viewFrame;
+        row.testedFrame = v.testedFrame;
+        row.rewindMs = v.rewindMs;
+        row.clamped = v.clamped;
+        row.missDistance = v.missDistance;
+        row.result = LagCompensator::resultToString(v.result);
+        row.costUs = v.costUs;
+        sess->logger->logHitValidation(row);
+    }
+    if (!accepted) {
+        debugPrintf("Rejected hit on %s (%s on frame %.2f, %.1f ms back)\n", packet->m_shotID.toString16().c_str(), LagCompensator::resultToString(v.result), v.testedFrame, v.rewindMs);
     }
+    return accepted;
+}
 
-    if (sessConfig->player.propagatePlayerConfigsToSelectedClient) {
-        sessConfig->player.propagatePlayerConfigsToSelectedClient = false;
-        shared_ptr<SendPlayerConfigPacket> configPacket;
-        if (sessConfig->player.selectedClientIdx == 0) {
-            configPacket = GenericPacket::createReliable<SendPlayerConfigPacket>(m_connectedClients[0]->peer);
-        }
-        else {
-            configPacket = GenericPacket::createReliable<SendPlayerConfigPacket>(m_connectedClients[1]->peer);
+void FPSciServerApp::onReadyUpClient(ReadyUpClientPacket* packet) {
+    m_clientsReady++;
+    debugPrintf("Connected Number of Clients: %d\nReady Clients: %d\n", m_connectedClients.length(), m_clientsReady);
+    if (m_clientsReady >= experimentConfig.numPlayers)
+    {
+        if (m_clientsReady >= experimentConfig.numPlayers)
+        {
+            if (sessConfig->numberOfRoundsPlayed % 2 == 0) {
+
+                m_clientFirstRoundPeeker = rand() % 2;
+                // Make them instantly spawn to the new location
+                m_peekersRoundConfigs[peekerDefenderConfigCombinationsIdx[sessConfig->numberOfRoundsPlayed / 2].first].respawnToPos = true;
+                m_defendersRoundConfigs[peekerDefenderConfigCombinationsIdx[sessConfig->numberOfRoundsPlayed / 2].second].respawnToPos = true;
+
+                shared_ptr<SendPlayerConfigPacket> outPacket = GenericPacket::createReliable<SendPlayerConfigPacket>(m_connectedClients[m_clientFirstRoundPeeker]->peer);
+                outPacket->populate(m_peekersRoundConfigs[peekerDefenderConfigCombinationsIdx[sessConfig->numberOfRoundsPlayed / 2].first], sessConfig->networkedSessionProgress);
+                setClientPlayerConfig(m_connectedClients[m_clientFirstRoundPeeker], outPacket->selectedConfig());
+                NetworkUtils::send(outPacket);
+                outPacket = GenericPacket::createReliable<SendPlayerConfigPacket>(m_connectedClients[!m_clientFirstRoundPeeker]->peer);
+                outPacket->populate(m_defendersRoundConfigs[peekerDefenderConfigCombinationsIdx[sessConfig->numberOfRoundsPlayed / 2].second], sessConfig->networkedSessionProgress);
+                setClientPlayerConfig(m_connectedClients[!m_clientFirstRoundPeeker], outPacket->selectedConfig());
+                NetworkUtils::send(outPacket);
+
+                // Set Latency 
+                NetworkUtils::setAddressLatency(m_connectedClients[m_clientFirstRoundPeeker]->peer->address, m_peekersRoundConfigs[peekerDefenderConfigCombinationsIdx[sessConfig->numberOfRoundsPlayed / 2].first].clientLatency);
+                NetworkUtils::setAddressLatency(m_connectedClients[m_clientFirstRoundPeeker]->unreliableAddress, m_peekersRoundConfigs[peekerDefenderConfigCombinationsIdx[sessConfig->numberOfRoundsPlayed / 2].first].clientLatency);
+                NetworkUtils::setAddressImpairment({ m_connectedClients[m_clientFirstRoundPeeker]->peer->address, m_connectedClients[m_clientFirstRoundPeeker]->unreliableAddress }, m_peekersRoundConfigs[peekerDefenderConfigCombinationsIdx[sessConfig->numberOfRoundsPlayed / 2].first].downlinkImpairment, m_clientFirstRoundPeeker);
+
+                NetworkUtils::setAddressLatency(m_connectedClients[!m_clientFirstRoundPeeker]->peer->address, m_defendersRoundConfigs[peekerDefenderConfigCombinationsIdx[sessConfig->numberOfRoundsPlayed / 2].second].clientLatency);
+                NetworkUtils::setAddressLatency(m_connectedClients[!m_clientFirstRoundPeeker]->unreliableAddress, m_defendersRoundConfigs[peekerDefenderConfigCombinationsIdx[sessConfig->numberOfRoundsPlayed / 2].second].clientLatency);
+                NetworkUtils::setAddressImpairment({ m_connectedClients[!m_clientFirstRoundPeeker]->peer->address, m_connectedClients[!m_clientFirstRoundPeeker]->unreliableAddress }, m_defendersRoundConfigs[peekerDefenderConfigCombinationsIdx[sessConfig->numberOfRoundsPlayed / 2].second].downlinkImpairment, !m_clientFirstRoundPeeker);
+
+                //Log configs
+                sess->logger->logPlayerConfig(m_peekersRoundConfigs[peekerDefenderConfigCombinationsIdx[sessConfig->numberOfRoundsPlayed / 2].first], m_connectedClients[m_clientFirstRoundPeeker]->guid, sessConfig->numberOfRoundsPlayed);
+                sess->logger->logPlayerConfig(m_defendersRoundConfigs[peekerDefenderConfigCombinationsIdx[sessConfig->numberOfRoundsPlayed / 2].second], m_connectedClients[!m_clientFirstRoundPeeker]->guid, sessConfig->numberOfRoundsPlayed);
+            }
+            else {
+
+                // Make them instantly spawn to the new location
+                m_peekersRoundConfigs[peekerDefenderConfigCombinationsIdx[sessConfig->numberOfRoundsPlayed / 2].first].respawnToPos = true;
+                m_defendersRoundConfigs[peekerDefenderConfigCombinationsIdx[sessConfig->numberOfRoundsPlayed / 2].second].respawnToPos = true;
+
+                shared_ptr<SendPlayerConfigPacket> outPacket = GenericPacket::createReliable<SendPlayerConfigPacket>(m_connectedClients[!m_clientFirstRoundPeeker]->peer);
+                outPacket->populate(m_peekersRoundConfigs[peekerDefenderConfigCombinationsIdx[sessConfig->numberOfRoundsPlayed / 2].first], sessConfig->networkedSessionProgress);
+                setClientPlayerConfig(m_connectedClients[!m_clientFirstRoundPeeker], outPacket->selectedConfig());
+                NetworkUtils::send(outPacket);
+                outPacket = GenericPacket::createReliable<SendPlayerConfigPacket>(m_connectedClients[m_clientFirstRoundPeeker]->peer);
+                outPacket->populate(m_defendersRoundConfigs[peekerDefenderConfigCombinationsIdx[sessConfig->numberOfRoundsPlayed / 2].second], sessConfig->networkedSessionProgress);
+                setClientPlayerConfig(m_connectedClients[m_clientFirstRoundPeeker], outPacket->selectedConfig());
+                NetworkUtils::send(outPacket);
+
+                // Set Latency 
+                NetworkUtils::setAddressLatency(m_connectedClients[!m_clientFirstRoundPeeker]->peer->address, m_peekersRoundConfigs[peekerDefenderConfigCombinationsIdx[sessConfig->numberOfRoundsPlayed / 2].first].clientLatency);
+                NetworkUtils::setAddressLatency(m_connectedClients[!m_clientFirstRoundPeeker]->unreliableAddress, m_peekersRoundConfigs[peekerDefenderConfigCombinationsIdx[sessConfig->numberOfRoundsPlayed / 2].first].clientLatency);
+                NetworkUtils::setAddressImpairment({ m_connectedClients[!m_clientFirstRoundPeeker]->peer->address, m_connectedClients[!m_clientFirstRoundPeeker]->unreliableAddress }, m_peekersRoundConfigs[peekerDefenderConfigCombinationsIdx[sessConfig->numberOfRoundsPlayed / 2].first].downlinkImpairment, !m_clientFirstRoundPeeker);
+
+                NetworkUtils::setAddressLatency(m_connectedClients[m_clientFirstRoundPeeker]->peer->address, m_defendersRoundConfigs[peekerDefenderConfigCombinationsIdx[sessConfig->numberOfRoundsPlayed / 2].second].clientLatency);
+                NetworkUtils::setAddressLatency(m_connectedClients[m_clientFirstRoundPeeker]->unreliableAddress, m_defendersRoundConfigs[peekerDefenderConfigCombinationsIdx[sessConfig->numberOfRoundsPlayed / 2].second].clientLatency);
+                NetworkUtils::setAddressImpairment({ m_connectedClients[m_clientFirstRoundPeeker]->peer->address, m_connectedClients[m_clientFirstRoundPeeker]->unreliableAddress }, m_defendersRoundConfigs[peekerDefenderConfigCombinationsIdx[sessConfig->numberOfRoundsPlayed / 2].second].downlinkImpairment, m_clientFirstRoundPeeker);
+
+                //Log configs
+                sess->logger->logPlayerConfig(m_peekersRoundConfigs[peekerDefenderConfigCombinationsIdx[sessConfig->numberOfRoundsPlayed / 2].first], m_connectedClients[!m_clientFirstRoundPeeker]->guid, sessConfig->numberOfRoundsPlayed);
+                sess->logger->logPlayerConfig(m_defendersRoundConfigs[peekerDefenderConfigCombinationsIdx[sessConfig->numberOfRoundsPlayed / 2].second], m_connectedClients[m_clientFirstRoundPeeker]->guid, sessConfig->numberOfRoundsPlayed);
+            }
+            shared_ptr<StartSessionPacket> startSessPacket = GenericPacket::createForBroadcast<StartSessionPacket>();
+            NetworkUtils::broadcastReliable(startSessPacket, m_localHost);
+            m_clientFeedbackSubmitted = 0;
+            netSess.get()->startRound();
+            debugPrintf("All PLAYERS ARE READY!\n");
         }
-        configPacket->populate(sessConfig->player, sessConfig->networkedSessionProgress);
-        NetworkUtils::send(configPacket);
+    }
+}
+
+void FPSciServerApp::onClientRoundTimeout(ClientRoundTimeoutPacket* packet) {
+    m_clientsTimedOut++;
+    
+    if (m_clientsTimedOut >= experimentConfig.numPlayers)
+    {
+        sessConfig->numberOfRoundsPlayed++;
+        debugPrintf("Rounds Played %d, Rounds Left %d\n", sessConfig->numberOfRoundsPlayed, sessConfig->trials[0].count - sessConfig->numberOfRoundsPlayed);
+        sessConfig->networkedSessionProgress = (float)sessConfig->numberOfRoundsPlayed / (float)sessConfig->trials[0].count;
+        debugPrintf("SESSION PROGRESS: %f\n", sessConfig->networkedSessionProgress);
+        m_clientsReady = 0;
+        m_clientsTimedOut = 0;
+        debugPrintf("Round Over!\n");
+
+        shared_ptr<ClientFeedbackStartPacket> outPacket = GenericPacket::createForBroadcast<ClientFeedbackStartPacket>();
+        NetworkUtils::broadcastReliable(outPacket, m_localHost);
+    }
+}
+
+void FPSciServerApp::onClientFeedbackSubmitted(ClientFeedbackSubmittedPacket* packet) {
+    m_clientFeedbackSubmitted++;
+
+    if (sessConfig->numberOfRoundsPlayed >= sessConfig->trials[0].count)
+    {
+        debugPrintf("SESSION OVER");
+        shared_ptr<ClientSessionEndPacket> outPacket = GenericPacket::createForBroadcast<ClientSessionEndPacket>();
+        NetworkUtils::broadcastReliable(outPacket, m_localHost);
+    }
+
+    else if (m_clientFeedbackSubmitted >= experimentConfig.numPlayers) {
+        shared_ptr<ResetClientRoundPacket> outPacket = GenericPacket::createForBroadcast<ResetClientRoundPacket>();
+        NetworkUtils::broadcastReliable(outPacket, m_localHost);
     }
 }
 
@@ -462,7 +689,9 @@ void FPSciServerApp::onInit() {
     // Seed random based on the time
     Random::common().reset(uint32(time(0)));
 
-    GApp::onInit(); // Initialize the G3D application (one time)
+    if (!m_headless) {
+        GApp::onInit(); // Initialize the G3D application (one time)
+    }
     FPSciServerApp::initExperiment();
     preparePerRoundConfigs();
 }
@@ -519,6 +748,7 @@ void FPSciServerApp::oneFrame() {
         Profiler::nextFrame();
         m_lastTime = m_now;
         m_now = System::time();
+        FPSciLogger::updateFrameTime();
         RealTime timeStep = m_now - m_lastTime;
 
         // User input
@@ -695,6 +925,92 @@ void FPSciServerApp::oneFrame() {
     }
 }
 
+int FPSciServerApp::runHeadless(uint64 tickLimit) {
+    debugAssertM(m_headless, "runHeadless() called on a server with a window (use run())");
+    m_endProgram = false;
+    onInit();
+    logPrintf("Running headless at %.1f ticks/s\n", 1.0 / m_tickPeriod);
+    m_now = System::time();
+    m_nextTickTime = m_now;
+    while (!m_endProgram && (tickLimit == 0 || m_ticks < tickLimit)) {
+        waitForTick();
+        oneTick();
+    }
+    logTickReport();
+    onCleanup();
+    return m_exitCode;
+}
+
+void FPSciServerApp::waitForTick() {
+    m_nextTickTime += m_tickPeriod;
+    RealTime now = System::time();
+    if (now - m_nextTickTime > m_tickPeriod) {
+        // A whole tick behind (e.g. a long session load), start the schedule over rather than running a burst of ticks
+        m_lateTicks++;
+        m_nextTickTime = now;
+        return;
+    }
+    // Sleep until just before the tick is due, then yield until it is (sleeps alone would make the tick rate uneven)
+    if (m_nextTickTime - now > s_tickSpinS) {
+        System::sleep(m_nextTickTime - now - s_tickSpinS);
+    }
+    while (System::time() < m_nextTickTime) {
+        std::this_thread::yield();
+    }
+}
+
+void FPSciServerApp::oneTick() {
+    m_frameNumber++;
+    m_lastTime = m_now;
+    m_now = System::time();
+    FPSciLogger::updateFrameTime();
+
+    // Network
+    m_networkWatch.tick();
+    onNetwork();
+    m_networkWatch.tock();
+
+    // Logic
+    m_logicWatch.tick();
+    onAI();
+    m_logicWatch.tock();
+
+    // Simulation, every tick steps the simulation by the same (fixed) time
+    m_simulationWatch.tick();
+    {
+        const RealTime rdt = m_now - m_lastTime;
+        const SimTime sdt = (SimTime)m_tickPeriod * m_simTimeScale;
+        const SimTime idt = (SimTime)m_tickPeriod;
+
+        // Only the session and scene parts of FPSciApp::onSimulation(), the rest is the local player's input, weapon and GUI
+        sess->onSimulation(rdt, sdt, idt);
+        scene()->onSimulation(sdt);
+
+        m_previousSimTimeStep = float(sdt);
+        m_previousRealTimeStep = float(rdt);
+        setRealTime(realTime() + rdt);
+        setSimTime(simTime() + sdt);
+    }
+    m_simulationWatch.tock();
+
+    const RealTime workS = System::time() - m_now;
+    m_ticks++;
+    m_tickWorkSumS += workS;
+    m_maxTickWorkS = max(m_maxTickWorkS, workS);
+}
+
+void FPSciServerApp::loadHeadlessScene() {
+    // Skip GApp::loadScene(), it draws a loading message
+    const Any sceneAny = scene()->load(m_headlessSceneName);
+    onAfterLoadScene(sceneAny, m_headlessSceneName);
+}
+
+void FPSciServerApp::logTickReport() const {
+    if (m_ticks == 0) return;
+    logPrintf("Headless server ran %llu ticks at %.1f ticks/s, each took %.3f ms on average (max %.3f ms), %llu started over a tick late\n",
+        (unsigned long long)m_ticks, 1.0 / m_tickPeriod, 1000.0 * m_tickWorkSumS / m_ticks, 1000.0 * m_maxTickWorkS, (unsigned long long)m_lateTicks);
+}
+
 void FPSciServerApp::preparePerRoundConfigs() {
 
     int peekersConfigIdx = 0;
@@ -809,7 +1125,7 @@ void FPSciServerApp::updateSession(const String& id, bool forceReload) {
         // Load the session config specified by the id
         sessConfig = experimentConfig.getSessionConfigById(id);
         logPrintf("User selected session: %s. Updating now...\n", id.c_str());
-        m_userSettingsWindow->setSelectedSession(id);
+        if (notNull(m_userSettingsWindow)) m_userSettingsWindow->setSelectedSession(id);
         // Create the session based on the loaded config
         if (experimentConfig.isNetworked) {
             netSess = NetworkedSession::create(this, sessConfig);
@@ -827,35 +1143,37 @@ void FPSciServerApp::updateSession(const String& id, bool forceReload) {
         sess = (shared_ptr<Session>)netSess;
     }
 
-    // Update reticle
-    reticleConfig.index = sessConfig->reticle.indexSpecified ? sessConfig->reticle.index : currentUser()->reticle.index;
-    reticleConfig.scale = sessConfig->reticle.scaleSpecified ? sessConfig->reticle.scale : currentUser()->reticle.scale;
-    reticleConfig.color = sessConfig->reticle.colorSpecified ? sessConfig->reticle.color : currentUser()->reticle.color;
-    reticleConfig.changeTimeS = sessConfig->reticle.changeTimeSpecified ? sessConfig->reticle.changeTimeS : currentUser()->reticle.changeTimeS;
-    setReticle(reticleConfig.index);
+    if (!m_headless) {
+        // Update reticle
+        reticleConfig.index = sessConfig->reticle.indexSpecified ? sessConfig->reticle.index : currentUser()->reticle.index;
+        reticleConfig.scale = sessConfig->reticle.scaleSpecified ? sessConfig->reticle.scale : currentUser()->reticle.scale;
+        reticleConfig.color = sessConfig->reticle.colorSpecified ? sessConfig->reticle.color : currentUser()->reticle.color;
+        reticleConfig.changeTimeS = sessConfig->reticle.changeTimeSpecified ? sessConfig->reticle.changeTimeS : currentUser()->reticle.changeTimeS;
+        setReticle(reticleConfig.index);
 
-    // Update the controls for this session
-    updateControls(m_firstSession); // If first session consider showing the menu
+        // Update the controls for this session
+        updateControls(m_firstSession); // If first session consider showing the menu
 
-    // Update the frame rate/delay
-    updateParameters(sessConfig->render.frameDelay, sessConfig->render.frameRate);
+        // Update the frame rate/delay
+        updateParameters(sessConfig->render.frameDelay, sessConfig->render.frameRate);
 
-    // Handle buffer setup here
-    updateShaderBuffers();
+        // Handle buffer setup here
+        updateShaderBuffers();
 
-    // Update shader table
-    m_shaderTable.clear();
-    if (!sessConfig->render.shader3D.empty())
-    {
-        m_shaderTable.set(sessConfig->render.shader3D, G3D::Shader::getShaderFromPattern(sessConfig->render.shader3D));
-    }
-    if (!sessConfig->render.shader2D.empty())
-    {
-        m_shaderTable.set(sessConfig->render.shader2D, G3D::Shader::getShaderFromPattern(sessConfig->render.shader2D));
-    }
-    if (!sessConfig->render.shaderComposite.empty())
-    {
-        m_shaderTable.set(sessConfig->render.shaderComposite, G3D::Shader::getShaderFromPattern(sessConfig->render.shaderComposite));
+        // Update shader table
+        m_shaderTable.clear();
+        if (!sessConfig->render.shader3D.empty())
+        {
+            m_shaderTable.set(sessConfig->render.shader3D, G3D::Shader::getShaderFromPattern(sessConfig->render.shader3D));
+        }
+        if (!sessConfig->render.shader2D.empty())
+        {
+            m_shaderTable.set(sessConfig->render.shader2D, G3D::Shader::getShaderFromPattern(sessConfig->render.shader2D));
+        }
+        if (!sessConfig->render.shaderComposite.empty())
+        {
+            m_shaderTable.set(sessConfig->render.shaderComposite, G3D::Shader::getShaderFromPattern(sessConfig->render.shaderComposite));
+        }
     }
 
     // Update shader parameters
@@ -865,16 +1183,26 @@ void FPSciServerApp::updateSession(const String& id, bool forceReload) {
     m_lastCompositeTime = m_startTime;
     m_frameNumber = 0;
 
-    // Load (session dependent) fonts
-    hudFont = GFont::fromFile(System::findDataFile(sessConfig->hud.hudFont));
-    m_combatFont = GFont::fromFile(System::findDataFile(sessConfig->targetView.combatTextFont));
+    if (!m_headless) {
+        // Load (session dependent) fonts
+        hudFont = GFont::fromFile(System::findDataFile(sessConfig->hud.hudFont));
+        m_combatFont = GFont::fromFile(System::findDataFile(sessConfig->targetView.combatTextFont));
+    }
 
     // Handle clearing the targets here (clear any remaining targets before loading a new scene)
     if (notNull(scene()))
         sess->clearTargets();
 
     // Load the experiment scene if we haven't already (target only)
-    if (sessConfig->scene.name.empty())
+    if (m_headless)
+    {
+        if (m_loadedScene.name.empty() || forceReload)
+        {
+            loadHeadlessScene();
+            m_loadedScene.name = m_headlessSceneName;
+        }
+    }
+    else if (sessConfig->scene.name.empty())
     {
         // No scene specified, load default scene
         if (m_loadedScene.name.empty() || forceReload)
@@ -900,30 +1228,32 @@ void FPSciServerApp::updateSession(const String& id, bool forceReload) {
     weapon->setScene(scene());
     weapon->setCamera(activeCamera());
 
-    // Update weapon model (if drawn) and sounds
-    weapon->loadModels();
-    weapon->loadSounds();
-    if (!sessConfig->audio.sceneHitSound.empty())
-    {
-        m_sceneHitSound = Sound::create(System::findDataFile(sessConfig->audio.sceneHitSound));
-    }
-    if (!sessConfig->audio.refTargetHitSound.empty())
-    {
-        m_refTargetHitSound = Sound::create(System::findDataFile(sessConfig->audio.refTargetHitSound));
-    }
+    if (!m_headless) {
+        // Update weapon model (if drawn) and sounds
+        weapon->loadModels();
+        weapon->loadSounds();
+        if (!sessConfig->audio.sceneHitSound.empty())
+        {
+            m_sceneHitSound = Sound::create(System::findDataFile(sessConfig->audio.sceneHitSound));
+        }
+        if (!sessConfig->audio.refTargetHitSound.empty())
+        {
+            m_refTargetHitSound = Sound::create(System::findDataFile(sessConfig->audio.refTargetHitSound));
+        }
 
-    // Load static HUD textures
-    for (StaticHudElement element : sessConfig->hud.staticElements)
-    {
-        hudTextures.set(element.filename, Texture::fromFile(System::findDataFile(element.filename)));
-    }
+        // Load static HUD textures
+        for (StaticHudElement element : sessConfig->hud.staticElements)
+        {
+            hudTextures.set(element.filename, Texture::fromFile(System::findDataFile(element.filename)));
+        }
 
-    // Update colored materials to choose from for target health
-    for (String id : sessConfig->getUniqueTargetIds())
-    {
-        shared_ptr<TargetConfig> tconfig = experimentConfig.getTargetConfigById(id);
-        materials.remove(id);
-        materials.set(id, makeMaterials(tconfig));
+        // Update colored materials to choose from for target health
+        for (String id : sessConfig->getUniqueTargetIds())
+        {
+            shared_ptr<TargetConfig> tconfig = experimentConfig.getTargetConfigById(id);
+            materials.remove(id);
+            materials.set(id, makeMaterials(tconfig));
+        }
     }
 
     const String resultsDirPath = startupConfig.experimentList[experimentIdx].resultsDirPath;
@@ -963,7 +1293,7 @@ void FPSciServerApp::updateSession(const String& id, bool forceReload) {
     sess->onInit(logPath, experimentConfig.description + "/" + sessConfig->description);
 
     // Don't create a results file for a user w/ no sessions left
-    if (m_userSettingsWindow->sessionsForSelectedUser() == 0)
+    if (m_headless ? id.empty() : m_userSettingsWindow->sessionsForSelectedUser() == 0)
     {
         logPrintf("No sessions remaining for selected user.\n");
     }
@@ -5,6 +5,7 @@
 #pragma once
 #include "FPSciApp.h"
 #include "NoWindow.h"
+#include "LagCompensator.h"
 
 class FPSciServerApp : public FPSciApp {
 
@@ -21,9 +22,79 @@ protected:
     Array <PlayerConfig> m_defendersRoundConfigs;                      ///< Keeps the round configs for the defenders
     Array <std::pair<int, int>> peekerDefenderConfigCombinationsIdx;   ///< Holds index of all possible combinations of matches between peekers and defenders
     Array <NetworkUtils::ConnectedClient*> m_connectedClients;          //> List of all connected clients and all atributes needed to comunicate with them
+    Array <BatchEntityUpdatePacket::EntityDelta> m_snapshotDeltas;     ///< Deltas for the snapshot being sent (reused each frame)
+    Array <shared_ptr<BatchEntityUpdatePacket>> m_snapshotParts;       ///< Datagrams the update for each baseline is split into (see BatchEntityUpdatePacket::split())
+    Array <float> m_entityPriorities;                                  ///< Interest management priority of each entity in the snapshot being sent
+    LagCompensator m_hitHistory;                                       ///< Every entity's pose on recent network frames, to check reported hits against (see LagCompensationConfig)
+    RealTime m_lastSnapshotStatsTime = 0.0;                            ///< Time the snapshot stats were last logged
+
+    static constexpr RealTime s_snapshotStatsPeriodS = 1.0;            ///< Period to log the (accumulated) snapshot stats for each client
+    static constexpr float s_maxInputDtS = 0.25f;                      ///< Longest time step simulated for a single client input (limits how far one input can move a client)
+
+    // Headless operation (see runHeadless())
+    const bool m_headless = false;                                     ///< Run without a window, GL context, GUI or rendering
+    String m_headlessSceneName = "FPSci Headless Server";              ///< Scene (with no models) loaded by a headless server in place of the session's scene
+    RealTime m_tickPeriod = 0.0;                                       ///< Time between ticks (from the startup config's serverTickRate)
+    RealTime m_nextTickTime = 0.0;                                     ///< Time the next tick is due
+    uint64   m_ticks = 0;                                              ///< Ticks run
+    uint64   m_lateTicks = 0;                                          ///< Ticks that started more than a tick period late (the schedule restarts from them)
+    RealTime m_tickWorkSumS = 0.0;                                     ///< Time spent running ticks (not waiting for them)
+    RealTime m_maxTickWorkS = 0.0;
+
+    static constexpr RealTime s_tickSpinS = 0.001;                     ///< Time before a tick is due to stop sleeping and yield instead (sleeps can overshoot by ~1 ms)
+
+    /** Send each client the current entity snapshot (as a delta against its last acknowledged snapshot when deltaSnapshots is set) */
+    void sendEntitySnapshots();
+    /** Send each client only the entities relevant to it (see InterestConfig and ClientInterest) */
+    void sendRelevantSnapshots(const SnapshotHistory::Snapshot& snapshot);
+    /** Encode the snapshot these clients will hold against their baseline (or in full), send it and record it as sent.
+        entitiesTotal is the number of entities on the server (for the send stats). */
+    void sendSnapshot(const Array<NetworkUtils::ConnectedClient*>& clients, uint32 baselineFrame, const shared_ptr<const SnapshotHistory::Snapshot>& snapshot, int entitiesTotal);
+    /** Re-run the ray test for a reported hit against the target's pose on the frame the shooter saw (see LagCompensator), logging the
+        check to the Hit_Validation table. Returns true if the hit stands. */
+    bool validateHit(ReportHitPacket* packet, const shared_ptr<NetworkedEntity>& hitEntity);
+    /** Log the snapshot bandwidth for each client to the Snapshot_Stats table (once every s_snapshotStatsPeriodS) */
+    void logSnapshotStats();
+    /** Send each predicting client its (server simulated) movement state after the last of its inputs, if any were simulated this frame */
+    void sendPlayerStates();
+    /** Keep a copy of the player config a client is sent, its movement is simulated with it (see PredictionConfig) */
+    void setClientPlayerConfig(NetworkUtils::ConnectedClient* client, const PlayerConfig& config);
+
+    void registerPacketHandlers() override;
+
+    /** Run one fixed length tick of a headless server: the network, sessions and the scene's simulation (no input or rendering) */
+    void oneTick();
+    /** Wait for the next tick to be due (keeping to a fixed schedule unless a tick falls a whole period behind) */
+    void waitForTick();
+    /** Load the model free headless scene (in place of the session's scene, which would need a GL context for its models and textures) */
+    void loadHeadlessScene();
+    /** Write the tick timing statistics to the log */
+    void logTickReport() const;
+
+    // Packet handlers (see registerPacketHandlers())
+    void onHandshake(HandshakePacket* packet);
+    void onBatchEntityUpdate(BatchEntityUpdatePacket* packet) override;
+    void onPlayerInteract(PlayerInteractPacket* packet) override;
+    void onPlayerInput(PlayerInputPacket* packet);
+    void onReliableConnect(ReliableConnectPacket* packet) override;
+    void onReliableDisconnect(ReliableDisconnectPacket* packet);
+    void onRegisterClient(RegisterClientPacket* packet);
+    void onReportHit(ReportHitPacket* packet);
+    void onReadyUpClient(ReadyUpClientPacket* packet);
+    void onClientRoundTimeout(ClientRoundTimeoutPacket* packet);
+    void onClientFeedbackSubmitted(ClientFeedbackSubmittedPacket* packet);
 
 public:
     FPSciServerApp(const GApp::Settings& settings);
+    /** Create a server, without a window or render device (a GL context) when headless is set. A headless server is run with runHeadless(). */
+    FPSciServerApp(const GApp::Settings& settings, bool headless);
+
+    /** Run a headless server until it quits (or has run tickLimit ticks, if it isn't 0): ticks at the startup config's serverTickRate
+        rather than rendering frames, returns the exit code */
+    int runHeadless(uint64 tickLimit = 0);
+    bool headless() const { return m_headless; }
+    /** Ticks a headless server has run */
+    uint64 ticksRun() const { return m_ticks; }
 
     void onInit() override;
     void initExperiment() override;
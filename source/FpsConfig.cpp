@@ -283,6 +283,11 @@ void PlayerConfig::load(FPSciAnyTableReader reader, int settingsVersion) {
 		reader.getIfPresent("defenderRandomDisplacementAngleArray", defenderRandomDisplacementAngleArray);
 
 		reader.getIfPresent("clientLatencyArray", clientLatencyArray);
+		for (float latency : clientLatencyArray) {
+			if (latency < 0.0f) throw format("\"clientLatencyArray\" latencies can't be negative (found %f)!", latency);
+		}
+		reader.getIfPresent("uplinkImpairment", uplinkImpairment);
+		reader.getIfPresent("downlinkImpairment", downlinkImpairment);
 
 		break;
 	default:
@@ -322,12 +327,232 @@ Any PlayerConfig::addToAny(Any a, bool forceAll) const {
 	if (forceAll || def.selectedClientIdx != selectedClientIdx)				a["selectedClientIdx"] = selectedClientIdx;
 	if (forceAll || def.playerType != playerType)							a["playerType"] = playerType;
 	if (forceAll || def.clientLatency != clientLatency)						a["clientLatency"] = clientLatency;
+	if (forceAll || def.uplinkImpairment != uplinkImpairment)				a["uplinkImpairment"] = uplinkImpairment.toAny(forceAll);
+	if (forceAll || def.downlinkImpairment != downlinkImpairment)			a["downlinkImpairment"] = downlinkImpairment.toAny(forceAll);
 	if (forceAll || def.cornerPosition != cornerPosition)					a["cornerPosition"] = cornerPosition;
 	if (forceAll || def.defenderRandomDisplacementAngle != defenderRandomDisplacementAngle)	a["defenderRandomDisplacementAngle"] = defenderRandomDisplacementAngle;
 
 	return a;
 }
 
+NetworkImpairmentConfig::NetworkImpairmentConfig(const Any& any) {
+	FPSciAnyTableReader reader(any);
+	reader.getIfPresent("enable", enable);
+	reader.getIfPresent("seed", seed);
+	reader.getIfPresent("jitterMs", jitterMs);
+	reader.getIfPresent("jitterDistribution", jitterDistribution);
+	jitterDistribution = toLower(jitterDistribution);
+	if (jitterDistribution != "uniform" && jitterDistribution != "normal" && jitterDistribution != "exponential") {
+		throw format("Unknown jitterDistribution \"%s\" (must be \"uniform\", \"normal\", or \"exponential\")!", jitterDistribution.c_str());
+	}
+	reader.getIfPresent("lossRate", lossRate);
+	reader.getIfPresent("burstStartRate", burstStartRate);
+	reader.getIfPresent("burstEndRate", burstEndRate);
+	reader.getIfPresent("burstLossRate", burstLossRate);
+	reader.getIfPresent("reorderRate", reorderRate);
+	reader.getIfPresent("reorderDelayMs", reorderDelayMs);
+	reader.getIfPresent("duplicateRate", duplicateRate);
+	reader.getIfPresent("bandwidthKbps", bandwidthKbps);
+	reader.getIfPresent("bucketBytes", bucketBytes);
+	reader.getIfPresent("queueLimitMs", queueLimitMs);
+
+	const Array<std::pair<const char*, float>> rates = { { "lossRate", lossRate }, { "burstStartRate", burstStartRate }, { "burstEndRate", burstEndRate },
+		{ "burstLossRate", burstLossRate }, { "reorderRate", reorderRate }, { "duplicateRate", duplicateRate } };
+	for (const std::pair<const char*, float>& rate : rates) {
+		if (rate.second < 0.0f || rate.second > 1.0f) {
+			throw format("Network impairment %s must be between 0 and 1 (is %f)!", rate.first, rate.second);
+		}
+	}
+	if (jitterMs < 0.0f || reorderDelayMs < 0.0f || queueLimitMs < 0.0f) {
+		throw format("Network impairment jitterMs, reorderDelayMs and queueLimitMs can't be negative (are %f, %f and %f)!", jitterMs, reorderDelayMs, queueLimitMs);
+	}
+	if (bandwidthKbps < 0.0f) {
+		throw format("Network impairment bandwidthKbps can't be negative (is %f, use 0 for no cap)!", bandwidthKbps);
+	}
+	if (bucketBytes <= 0) {
+		throw format("Network impairment bucketBytes must be positive (is %d)!", bucketBytes);
+	}
+}
+
+Any NetworkImpairmentConfig::toAny(const bool forceAll) const {
+	Any a(Any::TABLE);
+	NetworkImpairmentConfig def;
+	if (forceAll || def.enable != enable)							a["enable"] = enable;
+	if (forceAll || def.seed != seed)								a["seed"] = seed;
+	if (forceAll || def.jitterMs != jitterMs)						a["jitterMs"] = jitterMs;
+	if (forceAll || def.jitterDistribution != jitterDistribution)	a["jitterDistribution"] = jitterDistribution;
+	if (forceAll || def.lossRate != lossRate)						a["lossRate"] = lossRate;
+	if (forceAll || def.burstStartRate != burstStartRate)			a["burstStartRate"] = burstStartRate;
+	if (forceAll || def.burstEndRate != burstEndRate)				a["burstEndRate"] = burstEndRate;
+	if (forceAll || def.burstLossRate != burstLossRate)				a["burstLossRate"] = burstLossRate;
+	if (forceAll || def.reorderRate != reorderRate)					a["reorderRate"] = reorderRate;
+	if (forceAll || def.reorderDelayMs != reorderDelayMs)			a["reorderDelayMs"] = reorderDelayMs;
+	if (forceAll || def.duplicateRate != duplicateRate)				a["duplicateRate"] = duplicateRate;
+	if (forceAll || def.bandwidthKbps != bandwidthKbps)				a["bandwidthKbps"] = bandwidthKbps;
+	if (forceAll || def.bucketBytes != bucketBytes)					a["bucketBytes"] = bucketBytes;
+	if (forceAll || def.queueLimitMs != queueLimitMs)				a["queueLimitMs"] = queueLimitMs;
+	return a;
+}
+
+bool NetworkImpairmentConfig::operator!=(const NetworkImpairmentConfig& other) const {
+	return enable != other.enable ||
+		seed != other.seed ||
+		jitterMs != other.jitterMs ||
+		jitterDistribution != other.jitterDistribution ||
+		lossRate != other.lossRate ||
+		burstStartRate != other.burstStartRate ||
+		burstEndRate != other.burstEndRate ||
+		burstLossRate != other.burstLossRate ||
+		reorderRate != other.reorderRate ||
+		reorderDelayMs != other.reorderDelayMs ||
+		duplicateRate != other.duplicateRate ||
+		bandwidthKbps != other.bandwidthKbps ||
+		bucketBytes != other.bucketBytes ||
+		queueLimitMs != other.queueLimitMs;
+}
+
+void NetworkImpairmentConfig::serialize(BinaryOutput& outBuffer) const {
+	outBuffer.writeBool8(enable);
+	outBuffer.writeInt32(seed);
+	outBuffer.writeFloat32(jitterMs);
+	outBuffer.writeString(jitterDistribution);
+	outBuffer.writeFloat32(lossRate);
+	outBuffer.writeFloat32(burstStartRate);
+	outBuffer.writeFloat32(burstEndRate);
+	outBuffer.writeFloat32(burstLossRate);
+	outBuffer.writeFloat32(reorderRate);
+	outBuffer.writeFloat32(reorderDelayMs);
+	outBuffer.writeFloat32(duplicateRate);
+	outBuffer.writeFloat32(bandwidthKbps);
+	outBuffer.writeInt32(bucketBytes);
+	outBuffer.writeFloat32(queueLimitMs);
+}
+
+void NetworkImpairmentConfig::deserialize(BinaryInput& inBuffer) {
+	enable = inBuffer.readBool8();
+	seed = inBuffer.readInt32();
+	jitterMs = inBuffer.readFloat32();
+	jitterDistribution = inBuffer.readString();
+	lossRate = inBuffer.readFloat32();
+	burstStartRate = inBuffer.readFloat32();
+	burstEndRate = inBuffer.readFloat32();
+	burstLossRate = inBuffer.readFloat32();
+	reorderRate = inBuffer.readFloat32();
+	reorderDelayMs = inBuffer.readFloat32();
+	duplicateRate = inBuffer.readFloat32();
+	bandwidthKbps = inBuffer.readFloat32();
+	bucketBytes = inBuffer.readInt32();
+	queueLimitMs = inBuffer.readFloat32();
+}
+
+InterestConfig::InterestConfig(const Any& any) {
+	FPSciAnyTableReader reader(any);
+	reader.getIfPresent("enable", enable);
+	reader.getIfPresent("maxDistance", maxDistance);
+	reader.getIfPresent("viewConeDegrees", viewConeDegrees);
+	reader.getIfPresent("occlusion", occlusion);
+	reader.getIfPresent("visibleRateHz", visibleRateHz);
+	reader.getIfPresent("hiddenRateHz", hiddenRateHz);
+	reader.getIfPresent("playerPriority", playerPriority);
+	reader.getIfPresent("targetPriority", targetPriority);
+	reader.getIfPresent("hiddenPriority", hiddenPriority);
+	reader.getIfPresent("bandwidthKbps", bandwidthKbps);
+	if (maxDistance <= 0.0f) {
+		throw format("Interest management maxDistance must be greater than 0 (is %f)!", maxDistance);
+	}
+}
+
+Any InterestConfig::toAny(const bool forceAll) const {
+	Any a(Any::TABLE);
+	InterestConfig def;
+	if (forceAll || def.enable != enable)							a["enable"] = enable;
+	if (forceAll || def.maxDistance != maxDistance)					a["maxDistance"] = maxDistance;
+	if (forceAll || def.viewConeDegrees != viewConeDegrees)			a["viewConeDegrees"] = viewConeDegrees;
+	if (forceAll || def.occlusion != occlusion)						a["occlusion"] = occlusion;
+	if (forceAll || def.visibleRateHz != visibleRateHz)				a["visibleRateHz"] = visibleRateHz;
+	if (forceAll || def.hiddenRateHz != hiddenRateHz)				a["hiddenRateHz"] = hiddenRateHz;
+	if (forceAll || def.playerPriority != playerPriority)			a["playerPriority"] = playerPriority;
+	if (forceAll || def.targetPriority != targetPriority)			a["targetPriority"] = targetPriority;
+	if (forceAll || def.hiddenPriority != hiddenPriority)			a["hiddenPriority"] = hiddenPriority;
+	if (forceAll || def.bandwidthKbps != bandwidthKbps)				a["bandwidthKbps"] = bandwidthKbps;
+	return a;
+}
+
+InterpolationConfig::InterpolationConfig(const Any& any) {
+	FPSciAnyTableReader reader(any);
+	reader.getIfPresent("enable", enable);
+	reader.getIfPresent("delayMs", delayMs);
+	reader.getIfPresent("maxExtrapolationMs", maxExtrapolationMs);
+	reader.getIfPresent("logStats", logStats);
+	if (delayMs < 0.0f || maxExtrapolationMs < 0.0f) {
+		throw format("Interpolation delayMs and maxExtrapolationMs can't be negative (are %f and %f)!", delayMs, maxExtrapolationMs);
+	}
+}
+
+Any InterpolationConfig::toAny(const bool forceAll) const {
+	Any a(Any::TABLE);
+	InterpolationConfig def;
+	if (forceAll || def.enable != enable)							a["enable"] = enable;
+	if (forceAll || def.delayMs != delayMs)							a["delayMs"] = delayMs;
+	if (forceAll || def.maxExtrapolationMs != maxExtrapolationMs)	a["maxExtrapolationMs"] = maxExtrapolationMs;
+	if (forceAll || def.logStats != logStats)						a["logStats"] = logStats;
+	return a;
+}
+
+LagCompensationConfig::LagCompensationConfig(const Any& any) {
+	FPSciAnyTableReader reader(any);
+	reader.getIfPresent("enable", enable);
+	reader.getIfPresent("favorShooter", favorShooter);
+	reader.getIfPresent("rewindWindowMs", rewindWindowMs);
+	reader.getIfPresent("hitRadius", hitRadius);
+	reader.getIfPresent("toleranceM", toleranceM);
+	reader.getIfPresent("occlusion", occlusion);
+	reader.getIfPresent("logHits", logHits);
+	if (rewindWindowMs < 0.0f || toleranceM < 0.0f) {
+		throw format("Lag compensation rewindWindowMs and toleranceM can't be negative (are %f and %f)!", rewindWindowMs, toleranceM);
+	}
+	if (hitRadius <= 0.0f) {
+		throw format("Lag compensation hitRadius must be positive (is %f)!", hitRadius);
+	}
+}
+
+Any LagCompensationConfig::toAny(const bool forceAll) const {
+	Any a(Any::TABLE);
+	LagCompensationConfig def;
+	if (forceAll || def.enable != enable)					a["enable"] = enable;
+	if (forceAll || def.favorShooter != favorShooter)		a["favorShooter"] = favorShooter;
+	if (forceAll || def.rewindWindowMs != rewindWindowMs)	a["rewindWindowMs"] = rewindWindowMs;
+	if (forceAll || def.hitRadius != hitRadius)				a["hitRadius"] = hitRadius;
+	if (forceAll || def.toleranceM != toleranceM)			a["toleranceM"] = toleranceM;
+	if (forceAll || def.occlusion != occlusion)				a["occlusion"] = occlusion;
+	if (forceAll || def.logHits != logHits)					a["logHits"] = logHits;
+	return a;
+}
+
+PredictionConfig::PredictionConfig(const Any& any) {
+	FPSciAnyTableReader reader(any);
+	reader.getIfPresent("enable", enable);
+	reader.getIfPresent("correctionThresholdM", correctionThresholdM);
+	reader.getIfPresent("maxInputsPerPacket", maxInputsPerPacket);
+	reader.getIfPresent("logCorrections", logCorrections);
+	if (correctionThresholdM < 0.0f) {
+		throw format("Prediction correctionThresholdM can't be negative (is %f)!", correctionThresholdM);
+	}
+	if (maxInputsPerPacket < 1 || maxInputsPerPacket > 255) {
+		throw format("Prediction maxInputsPerPacket must be between 1 and 255 (is %d)!", maxInputsPerPacket);
+	}
+}
+
+Any PredictionConfig::toAny(const bool forceAll) const {
+	Any a(Any::TABLE);
+	PredictionConfig def;
+	if (forceAll || def.enable != enable)								a["enable"] = enable;
+	if (forceAll || def.correctionThresholdM != correctionThresholdM)	a["correctionThresholdM"] = correctionThresholdM;
+	if (forceAll || def.maxInputsPerPacket != maxInputsPerPacket)		a["maxInputsPerPacket"] = maxInputsPerPacket;
+	if (forceAll || def.logCorrections != logCorrections)				a["logCorrections"] = logCorrections;
+	return a;
+}
+
 StaticHudElement::StaticHudElement(const Any& any) {
 	FPSciAnyTableReader reader(any);
 	reader.get("filename", filename, "Must provide filename for all Static HUD elements!");
@@ -652,6 +877,69 @@ void LoggerConfig::load(FPSciAnyTableReader reader, int settingsVersion) {
 		reader.getIfPresent("logOnChange", logOnChange);
 		reader.getIfPresent("sessionParametersToLog", sessParamsToLog);
 		reader.getIfPresent("logToSingleDb", logToSingleDb);
+		reader.getIfPresent("logTextTimeViews", logTextTimeViews);
+		reader.getIfPresent("logSinks", sinks);
+		Any tableSinksAny;
+		if (reader.getIfPresent("logTableSinks", tableSinksAny)) {
+			for (const String& tableName : tableSinksAny.table().getKeys()) {
+				Array<String> names;
+				for (int i = 0; i < tableSinksAny[tableName].size(); i++) names.append(tableSinksAny[tableName][i].string());
+				tableSinks.set(tableName, names);
+			}
+		}
+		const Array<String> validSinks = { "sqlite", "csv", "binary" };
+		Array<String> allSinks = sinks;
+		for (const String& tableName : tableSinks.getKeys()) allSinks.append(tableSinks[tableName]);
+		for (const String& sink : allSinks) {
+			if (!validSinks.contains(sink)) {
+				throw format("Log sink \"%s\" is invalid, must be one of \"sqlite\", \"csv\", or \"binary\"!", sink.c_str());
+			}
+		}
+		reader.getIfPresent("logShardedTables", shardedTables);
+		reader.getIfPresent("logMaxQueueMB", maxQueueMB);
+		if (reader.getIfPresent("logOverflowPolicy", overflowPolicy)) {
+			overflowPolicy = toLower(overflowPolicy);
+			const Array<String> validPolicies = { "block", "dropoldest", "spill" };
+			if (!validPolicies.contains(overflowPolicy)) {
+				String errString = format("\"logOverflowPolicy\" value \"%s\" is invalid, must be specified as one of the valid policies (", overflowPolicy.c_str());
+				for (String validPolicy : validPolicies) {
+					errString += "\"" + validPolicy + "\", ";
+				}
+				errString = errString.substr(0, errString.length() - 2) + ")!";
+				throw errString;
+			}
+		}
+		if (reader.getIfPresent("logJournalMode", journalMode)) {
+			journalMode = toLower(journalMode);
+			const Array<String> validModes = { "delete", "truncate", "persist", "memory", "wal", "off" };
+			if (!validModes.contains(journalMode)) {
+				String errString = format("\"logJournalMode\" value \"%s\" is invalid, must be specified as one of the valid modes (", journalMode.c_str());
+				for (String validMode : validModes) {
+					errString += "\"" + validMode + "\", ";
+				}
+				errString = errString.substr(0, errString.length() - 2) + ")!";
+				throw errString;
+			}
+		}
+		if (reader.getIfPresent("logSynchronous", synchronous)) {
+			synchronous = toLower(synchronous);
+			const Array<String> validLevels = { "off", "normal", "full", "extra" };
+			if (!validLevels.contains(synchronous)) {
+				String errString = format("\"logSynchronous\" value \"%s\" is invalid, must be specified as one of the valid levels (", synchronous.c_str());
+				for (String validLevel : validLevels) {
+					errString += "\"" + validLevel + "\", ";
+				}
+				errString = errString.substr(0, errString.length() - 2) + ")!";
+				throw errString;
+			}
+		}
+		reader.getIfPresent("logPageSize", pageSize);
+		if (pageSize < 512 || pageSize > 65536 || !isPow2(pageSize)) {
+			throw format("\"logPageSize\" (%d) must be a power of 2 between 512 and 65536!", pageSize);
+		}
+		reader.getIfPresent("logCacheSizeKB", cacheSizeKB);
+		reader.getIfPresent("logMmapSizeMB", mmapSizeMB);
+		reader.getIfPresent("logWalCheckpointPages", walCheckpointPages);
 		break;
 	default:
 		throw format("Did not recognize settings version: %d", settingsVersion);
@@ -670,6 +958,22 @@ Any LoggerConfig::addToAny(Any a, bool forceAll) const {
 	if (forceAll || def.logOnChange != logOnChange)						a["logOnChange"] = logOnChange;
 	if (forceAll || def.sessParamsToLog != sessParamsToLog)				a["sessionParametersToLog"] = sessParamsToLog;
 	if (forceAll || def.logToSingleDb != logToSingleDb)					a["logToSingleDb"] = logToSingleDb;
+	if (forceAll || def.logTextTimeViews != logTextTimeViews)			a["logTextTimeViews"] = logTextTimeViews;
+	if (forceAll || def.sinks != sinks)									a["logSinks"] = sinks;
+	if (forceAll || tableSinks.size() > 0) {
+		Any tableSinksAny(Any::TABLE);
+		for (const String& tableName : tableSinks.getKeys()) tableSinksAny[tableName] = tableSinks[tableName];
+		a["logTableSinks"] = tableSinksAny;
+	}
+	if (forceAll || def.shardedTables != shardedTables)					a["logShardedTables"] = shardedTables;
+	if (forceAll || def.maxQueueMB != maxQueueMB)						a["logMaxQueueMB"] = maxQueueMB;
+	if (forceAll || def.overflowPolicy != overflowPolicy)				a["logOverflowPolicy"] = overflowPolicy;
+	if (forceAll || def.journalMode != journalMode)						a["logJournalMode"] = journalMode;
+	if (forceAll || def.synchronous != synchronous)						a["logSynchronous"] = synchronous;
+	if (forceAll || def.pageSize != pageSize)							a["logPageSize"] = pageSize;
+	if (forceAll || def.cacheSizeKB != cacheSizeKB)						a["logCacheSizeKB"] = cacheSizeKB;
+	if (forceAll || def.mmapSizeMB != mmapSizeMB)						a["logMmapSizeMB"] = mmapSizeMB;
+	if (forceAll || def.walCheckpointPages != walCheckpointPages)		a["logWalCheckpointPages"] = walCheckpointPages;
 	return a;
 }
 
@@ -57,6 +57,95 @@ public:
 
 };
 
+/** Network conditions to emulate (on top of any added latency) for the packets sent in one direction of a connection */
+struct NetworkImpairmentConfig {
+	bool			enable = false;						///< Emulate these network conditions?
+	int				seed = 1;							///< Seed for the impairment decisions (runs with the same seed make the same decisions)
+	float			jitterMs = 0.0f;					///< Jitter added to each packet's delay (ms)
+	String			jitterDistribution = "uniform";		///< Jitter distribution ("uniform", "normal", or "exponential")
+	float			lossRate = 0.0f;					///< Probability an unreliable packet is lost (in the good state if burst loss is used)
+	float			burstStartRate = 0.0f;				///< Per packet probability of entering the (Gilbert-Elliott) burst loss state (0 for Bernoulli loss)
+	float			burstEndRate = 1.0f;				///< Per packet probability of leaving the burst loss state
+	float			burstLossRate = 1.0f;				///< Probability an unreliable packet is lost in the burst loss state
+	float			reorderRate = 0.0f;					///< Probability an unreliable packet is held back so later packets overtake it
+	float			reorderDelayMs = 10.0f;				///< Extra delay for packets that are held back (ms)
+	float			duplicateRate = 0.0f;				///< Probability an unreliable packet is sent twice
+	float			bandwidthKbps = 0.0f;				///< Bandwidth cap (kbit/s, 0 for no cap)
+	int				bucketBytes = 1500;					///< Token bucket size, the largest burst sent without queueing (bytes)
+	float			queueLimitMs = 100.0f;				///< Unreliable packets that would queue longer than this for the bandwidth cap are dropped (ms)
+
+	NetworkImpairmentConfig() {};
+	NetworkImpairmentConfig(const Any& any);
+
+	Any toAny(const bool forceAll = false) const;
+	bool operator!=(const NetworkImpairmentConfig& other) const;
+
+	/** Write/read the config (to send it to a client in a SEND_PLAYER_CONFIG packet) */
+	void serialize(BinaryOutput& outBuffer) const;
+	void deserialize(BinaryInput& inBuffer);
+};
+
+/** Interest management: which entities the server sends each client, and how often (see ClientInterest) */
+struct InterestConfig {
+	bool			enable = false;						///< Send each client only the entities relevant to it (otherwise every entity, every network frame)
+	float			maxDistance = 200.0f;				///< Entities farther than this from the client are never sent (m)
+	float			viewConeDegrees = 120.0f;			///< Full angle of the cone (around the client's view direction) entities are visible in
+	bool			occlusion = true;					///< Treat entities hidden behind the static scene geometry as not visible?
+	float			visibleRateHz = 0.0f;				///< Most updates per second for visible entities (0 for every network frame)
+	float			hiddenRateHz = 4.0f;				///< Most updates per second for entities in range that aren't visible (0 for every network frame)
+	float			playerPriority = 4.0f;				///< Priority of the other clients' entities
+	float			targetPriority = 1.0f;				///< Priority of all other entities
+	float			hiddenPriority = 0.25f;				///< Priority multiplier for entities that aren't visible
+	float			bandwidthKbps = 0.0f;				///< Entity update budget for each client (kbit/s, 0 for no budget)
+
+	InterestConfig() {};
+	InterestConfig(const Any& any);
+
+	Any toAny(const bool forceAll = false) const;
+};
+
+/** Client side interpolation of the entity states received from the server (see SnapshotInterpolator) */
+struct InterpolationConfig {
+	bool			enable = false;						///< Show remote entities a fixed delay behind the server (otherwise each update is shown as it arrives)
+	float			delayMs = 100.0f;					///< Delay behind the (estimated) server clock entities are shown at (ms)
+	float			maxExtrapolationMs = 100.0f;		///< Longest time entities are extrapolated past their latest update (ms)
+	bool			logStats = true;					///< Log the interpolation/extrapolation counts for every frame (to the Interpolation_Stats table)
+
+	InterpolationConfig() {};
+	InterpolationConfig(const Any& any);
+
+	Any toAny(const bool forceAll = false) const;
+};
+
+/** Server side validation of the hits clients report (see LagCompensator) */
+struct LagCompensationConfig {
+	bool			enable = false;						///< Re-run each reported hit on the server (otherwise the shooter's client is trusted)
+	bool			favorShooter = true;				///< Test the shot against the entity poses the shooter saw (otherwise against the current poses)
+	float			rewindWindowMs = 200.0f;			///< Furthest back the server rewinds, older shots are tested at the oldest pose in the window (ms)
+	float			hitRadius = BOUNDING_SPHERE_RADIUS;	///< Radius of the sphere around each entity the shot is tested against (m)
+	float			toleranceM = 0.0f;					///< Distance a shot may pass outside the hit sphere and still hit (m)
+	bool			occlusion = true;					///< Reject hits with static scene geometry between the shooter and the hit point
+	bool			logHits = true;						///< Log each validation (to the Hit_Validation table)
+
+	LagCompensationConfig() {};
+	LagCompensationConfig(const Any& any);
+
+	Any toAny(const bool forceAll = false) const;
+};
+
+/** Client side prediction of the player's own movement, reconciled with the server's authoritative state (see PlayerPrediction) */
+struct PredictionConfig {
+	bool			enable = false;						///< Clients predict their own movement and the server simulates it from their inputs (otherwise clients send their frames)
+	float			correctionThresholdM = 0.01f;		///< Position error above which the client takes the server's state and replays its unacknowledged inputs (m)
+	int				maxInputsPerPacket = 32;			///< Most unacknowledged inputs the client resends per network frame
+	bool			logCorrections = true;				///< Log each correction (to the Prediction_Corrections table)
+
+	PredictionConfig() {};
+	PredictionConfig(const Any& any);
+
+	Any toAny(const bool forceAll = false) const;
+};
+
 class PlayerConfig {
 public:
 	// View parameters
@@ -93,6 +182,8 @@ public:
 	int				selectedClientIdx = 0;						///< Indicates the index of the client that player configs will be propagated to
 	String			playerType = "";							///< Indicates what type of player it is (Peeker/Defender/Other)
 	float			clientLatency = 0.0f;						///< Clients latency over the network
+	NetworkImpairmentConfig uplinkImpairment;					///< Network conditions emulated for packets the client sends to the server
+	NetworkImpairmentConfig downlinkImpairment;					///< Network conditions emulated for packets the server sends to the client
 	Point3			cornerPosition = Point3(0.0f,0.0f,0.0f);	///< Holds the corner position for peeker and defender	
 	float			defenderRandomDisplacementAngle = 0.0f;		///< The defender will be rotated randomly between -defenderRandomDisplacementAngle to defenderRandomDisplacementAngle wrt corner point on respawn
 	Array <PlayerConfig>  clientPlayerConfigs;					///< Player config for all the clients
@@ -316,6 +407,24 @@ public:
 	bool logOnChange = false;			///< Only log to Player_Action/Target_Trajectory table when the player/target position/orientation changes
 
 	bool logToSingleDb = true;			///< Log all results to a single db file?
+	bool logTextTimeViews = true;		///< Create views of the per-frame tables with text (rather than integer ns) times?
+
+	// Output sinks ("sqlite", "csv", or "binary") for the tables written by the logger
+	Array<String> sinks = { "sqlite" };					///< Sinks used for every table (unless specified in tableSinks)
+	Table<String, Array<String>> tableSinks;			///< Sinks to use for specific tables (by table name)
+	Array<String> shardedTables;						///< Tables written by their own thread into a separate (shard) database, merged into the results file at close
+
+	// Queue limits (bound logger memory use when the results file can't keep up)
+	int maxQueueMB = 64;						///< Maximum memory (in MB) held by records waiting to be written to the results file
+	String overflowPolicy = "block";			///< What to do with new records once the queue limit is reached ("block", "dropOldest", or "spill", case insensitive)
+
+	// SQLite durability/throughput settings (applied when the results file is opened, defaults match SQLite's)
+	String journalMode = "delete";				///< SQLite journal mode ("delete", "truncate", "persist", "memory", "wal", or "off")
+	String synchronous = "full";				///< SQLite synchronous level ("off", "normal", "full", or "extra")
+	int pageSize = 4096;						///< Database page size in bytes (only applies when a new results file is created)
+	int cacheSizeKB = 2000;						///< Page cache size in KB
+	int mmapSizeMB = 0;							///< Maximum memory mapped I/O size in MB (0 disables memory mapping)
+	int walCheckpointPages = 1000;				///< Checkpoint the WAL each time it reaches this many pages (only used with "wal" journalMode, 0 disables automatic checkpoints)
 
 	// Session parameter logging
 	Array<String> sessParamsToLog = { "frameRate", "frameDelay" };			///< Parameter names to log to the Sessions table of the DB
@@ -443,6 +443,88 @@ void WeaponControls::updateFireSpreadShape() {
 	m_config.fireSpreadShape = m_spreadShapes[m_spreadShapeIdx];
 }
 
+LoggerControls::LoggerControls(FPSciApp* app, const shared_ptr<GuiTheme>& theme, float width, float height) :
+	GuiWindow("Logger Stats", theme, Rect2D::xywh(5, 5, width, height), GuiTheme::NORMAL_WINDOW_STYLE, GuiWindow::HIDE_ON_CLOSE), m_app(app), m_width(width)
+{
+	// Create the GUI pane
+	GuiPane* pane = GuiWindow::pane();
+
+	auto writerPane = pane->addPane("Writer");
+	m_flushLabel = writerPane->addLabel("");
+	m_flushTimeLabel = writerPane->addLabel("");
+	m_histogramLabel = writerPane->addLabel("");
+	m_throughputLabel = writerPane->addLabel("");
+	m_idleLabel = writerPane->addLabel("");
+	m_blockedLabel = writerPane->addLabel("");
+	for (GuiLabel* label : { m_flushLabel, m_flushTimeLabel, m_histogramLabel, m_throughputLabel, m_idleLabel, m_blockedLabel }) {
+		label->setWidth(width * 0.95f);
+	}
+
+	m_tablePane = pane->addPane("Tables (pending rows/KB, written rows)");
+
+	updateStats();
+	pack();
+	moveTo(Vector2(0, 900));
+}
+
+void LoggerControls::onPose(Array<shared_ptr<Surface> >& posedArray, Array<shared_ptr<Surface2D> >& posed2DArray) {
+	// Only poll the logger while the window is shown
+	if (visible() && System::time() - m_lastUpdate >= m_updatePeriodS) {
+		updateStats();
+	}
+	GuiWindow::onPose(posedArray, posed2DArray);
+}
+
+void LoggerControls::updateStats() {
+	const RealTime now = System::time();
+	const RealTime dt = now - m_lastUpdate;
+	m_lastUpdate = now;
+
+	const shared_ptr<FPSciLogger> logger = notNull(m_app->sess) ? m_app->sess->logger : nullptr;
+	if (isNull(logger)) {
+		m_flushLabel->setCaption("No results file open");
+		for (GuiLabel* label : { m_flushTimeLabel, m_histogramLabel, m_throughputLabel, m_idleLabel, m_blockedLabel }) {
+			label->setCaption("");
+		}
+		m_lastRowsWritten = 0;
+		return;
+	}
+	const FPSciLogger::Stats stats = logger->stats();
+
+	m_flushLabel->setCaption(format("Flushes: %llu (peak queued %.1f KB)", (unsigned long long)stats.flushCount, stats.peakPendingBytes / 1024.0));
+	m_flushTimeLabel->setCaption(format("Flush time: last %.2f ms, mean %.2f ms, max %.2f ms", stats.lastFlushMs, stats.meanFlushMs, stats.maxFlushMs));
+	String histogram = "Flushes <=";
+	const Array<float>& buckets = FPSciLogger::flushHistogramBucketsMs();
+	for (int i = 0; i < stats.flushHistogram.size(); i++) {
+		histogram += (i < buckets.size()) ? format(" %gms:%llu", buckets[i], (unsigned long long)stats.flushHistogram[i]) :
+			format(" >%gms:%llu", buckets.last(), (unsigned long long)stats.flushHistogram[i]);
+	}
+	m_histogramLabel->setCaption(histogram);
+	// Recent rate from the change since the last update (rows written since this logger was opened if it is new)
+	const uint64 newRows = stats.rowsWritten >= m_lastRowsWritten ? stats.rowsWritten - m_lastRowsWritten : stats.rowsWritten;
+	m_lastRowsWritten = stats.rowsWritten;
+	m_throughputLabel->setCaption(format("Throughput: %.0f rows/s (%.0f rows/s average, %llu rows)", dt > 0.0 ? newRows / dt : 0.0, stats.rowsPerSec, (unsigned long long)stats.rowsWritten));
+	m_idleLabel->setCaption(format("Writer idle: %.1f%%", 100.0 * stats.idleRatio));
+	m_blockedLabel->setCaption(format("Blocked log calls: %llu (max %.2f ms)", (unsigned long long)stats.blockedPushes, stats.maxBlockMs));
+
+	// Create the table labels the first time stats are available
+	if (m_tableLabels.size() != stats.tables.size()) {
+		m_tablePane->removeAllChildren();
+		m_tableLabels.clear();
+		for (int i = 0; i < stats.tables.size(); i++) {
+			GuiLabel* label = m_tablePane->addLabel("");
+			label->setWidth(m_width * 0.95f);
+			m_tableLabels.append(label);
+		}
+		pack();
+	}
+	for (int i = 0; i < stats.tables.size(); i++) {
+		const FPSciLogger::TableStats& table = stats.tables[i];
+		m_tableLabels[i]->setCaption(format("%s: %lld / %.1f KB, %llu written", table.tableName.c_str(), (long long)table.pendingRows,
+			table.pendingBytes / 1024.0, (unsigned long long)table.rowsWritten));
+	}
+}
+
 void MenuConfig::load(FPSciAnyTableReader reader, int settingsVersion) {
 	switch (settingsVersion) {
 	case 1:
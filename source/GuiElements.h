@@ -158,6 +158,37 @@ public:
 	}
 };
 
+/** Developer mode window showing the results logger's queue depths, flush times, and throughput */
+class LoggerControls : public GuiWindow {
+protected:
+	FPSciApp* m_app = nullptr;
+
+	GuiLabel* m_flushLabel = nullptr;
+	GuiLabel* m_flushTimeLabel = nullptr;
+	GuiLabel* m_histogramLabel = nullptr;
+	GuiLabel* m_throughputLabel = nullptr;
+	GuiLabel* m_idleLabel = nullptr;
+	GuiLabel* m_blockedLabel = nullptr;
+	GuiPane* m_tablePane = nullptr;
+	Array<GuiLabel*> m_tableLabels;						///< One label per logged table (created once stats are available)
+
+	const float m_width;
+	const RealTime m_updatePeriodS = 0.25;				///< How often the stats are refreshed (while visible)
+	RealTime m_lastUpdate = 0.0;
+	uint64 m_lastRowsWritten = 0;
+
+	/** Refresh the labels from the current session's logger */
+	void updateStats(void);
+
+	LoggerControls(FPSciApp* app, const shared_ptr<GuiTheme>& theme, float width = 400.0f, float height = 10.0f);
+public:
+	static shared_ptr<LoggerControls> create(FPSciApp* app, const shared_ptr<GuiTheme>& theme, float width = 400.0f, float height = 10.0f) {
+		return createShared<LoggerControls>(app, theme, width, height);
+	}
+
+	virtual void onPose(Array<shared_ptr<Surface> >& posedArray, Array<shared_ptr<Surface2D> >& posed2DArray) override;
+};
+
 
 class UserMenu : public GuiWindow {
 protected:
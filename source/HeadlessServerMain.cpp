@@ -0,0 +1,34 @@
+/** \file HeadlessServerMain.cpp */
+
+#include "FPSciServerApp.h"
+
+// Tells C++ to invoke command-line main() function even on OS X and Win32.
+G3D_START_AT_MAIN();
+
+/** Run the server without a window, GL context or rendering (see FPSciServerApp::runHeadless())
+
+	Usage: FirstPersonScienceHeadlessServer [startup config filename]
+
+	The startup config defaults to serverstartupconfig.Any (as for the windowed server), giving each server on a machine
+	its own startup config (and experiment config, for the port) lets one machine host several of them.
+*/
+int main(int argc, const char* argv[]) {
+
+	{
+		G3DSpecification spec;
+		spec.audio = false;
+		spec.logFilename = "headlessserverlog.txt";
+		initGLG3D(spec);
+	}
+
+	FPSciServerApp::startupConfig = StartupConfig::load(argc > 1 ? argv[1] : "serverstartupconfig.Any");
+	// There is no display to size a fullscreen window from (or audio device to play to)
+	FPSciServerApp::startupConfig.fullscreen = false;
+	FPSciServerApp::startupConfig.audioEnable = false;
+
+	FPSciServerApp::Settings settings(FPSciServerApp::startupConfig, argc, argv);
+	settings.window.caption = "First Person Science Headless Server";
+	settings.window.visible = false;
+
+	return FPSciServerApp(settings, true).runHeadless();
+}
@@ -21,6 +21,7 @@ KeyMapping::KeyMapping() {
 	map.set("togglePlayerWindow", Array<GKey>{ (GKey)'2' });
 	map.set("toggleWeaponWindow", Array<GKey>{ (GKey)'3' });
 	map.set("toggleWaypointWindow", Array<GKey>{ (GKey)'4' });
+	map.set("toggleLoggerWindow", Array<GKey>{ (GKey)'5' });
 	map.set("selectWaypoint", Array<GKey>{ GKey::LEFT_MOUSE });
 	map.set("moveWaypointUp", Array<GKey>{ GKey::PAGEUP });
 	map.set("moveWaypointDown", Array<GKey>{ GKey::PAGEDOWN });
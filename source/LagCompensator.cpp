@@ -0,0 +1,144 @@
+#include "LagCompensator.h"
+#include "FpsConfig.h"
+#include "PhysicsScene.h"
+
+int LagCompensator::slot(uint32 frame) const {
+	if (frame == 0) return -1;
+	const int s = frame % CAPACITY;
+	return (m_frames[s] == frame) ? s : -1;
+}
+
+const LagCompensator::EntityState* LagCompensator::findState(const Snapshot& snapshot, uint16 index) {
+	// Snapshots are sorted by index
+	int lo = 0;
+	int hi = snapshot.size() - 1;
+	while (lo <= hi) {
+		const int mid = (lo + hi) / 2;
+		if (snapshot[mid].index == index) return &snapshot[mid];
+		if (snapshot[mid].index < index) lo = mid + 1;
+		else hi = mid - 1;
+	}
+	return nullptr;
+}
+
+void LagCompensator::record(uint32 frame, RealTime time, const shared_ptr<const Snapshot>& snapshot) {
+	const int s = frame % CAPACITY;
+	m_frames[s] = frame;
+	m_times[s] = time;
+	m_snapshots[s] = snapshot;
+	m_latestFrame = max(m_latestFrame, frame);
+}
+
+void LagCompensator::clear() {
+	for (int i = 0; i < CAPACITY; i++) {
+		m_frames[i] = 0;
+		m_times[i] = 0.0;
+		m_snapshots[i].reset();
+	}
+	m_latestFrame = 0;
+}
+
+uint32 LagCompensator::oldestFrame(RealTime windowS) const {
+	const int latest = slot(m_latestFrame);
+	if (latest < 0) return 0;
+	uint32 oldest = m_latestFrame;
+	// Walk back over the held frames (every network frame is recorded, so they are consecutive)
+	for (uint32 frame = m_latestFrame - 1; frame > 0 && m_latestFrame - frame < (uint32)CAPACITY; frame--) {
+		const int s = slot(frame);
+		if (s < 0 || m_times[latest] - m_times[s] > windowS) break;
+		oldest = frame;
+	}
+	return oldest;
+}
+
+bool LagCompensator::frameTime(double frame, RealTime& time) const {
+	const uint32 before = (uint32)floor(frame);
+	const int a = slot(before);
+	const int b = slot(before + 1);
+	if (a < 0) return false;
+	const double alpha = frame - before;
+	if (alpha <= 0.0 || b < 0) {
+		time = m_times[a];
+		return alpha <= 0.0;
+	}
+	time = m_times[a] + alpha * (m_times[b] - m_times[a]);
+	return true;
+}
+
+bool LagCompensator::pose(uint16 index, double frame, CFrame& cframe) const {
+	const uint32 before = (uint32)floor(frame);
+	const int a = slot(before);
+	if (a < 0) return false;
+	const EntityState* stateA = findState(*m_snapshots[a], index);
+	if (isNull(stateA)) return false;
+	const float alpha = (float)(frame - before);
+	const int b = slot(before + 1);
+	const EntityState* stateB = (alpha > 0.0f && b >= 0) ? findState(*m_snapshots[b], index) : nullptr;
+	if (isNull(stateB)) {
+		cframe = stateA->frame();
+		return alpha <= 0.0f;
+	}
+	const CFrame frameA = stateA->frame();
+	const CFrame frameB = stateB->frame();
+	cframe = CFrame(Quat(frameA.rotation).slerp(Quat(frameB.rotation), alpha).toRotationMatrix(), frameA.translation.lerp(frameB.translation, alpha));
+	return true;
+}
+
+LagCompensator::Validation LagCompensator::validate(const LagCompensationConfig& config, const Ray& shot, double viewFrame, uint16 targetIndex, const PhysicsScene* scene) const {
+	const Clock::time_point start = Clock::now();
+	Validation v;
+
+	// Rewind to the frame the shooter saw, but no further than the window
+	double frame = config.favorShooter ? viewFrame : (double)m_latestFrame;
+	const uint32 oldest = oldestFrame(config.rewindWindowMs / 1000.0);
+	if (frame < oldest) {
+		frame = oldest;
+		v.clamped = true;
+	}
+	else if (frame > m_latestFrame) {
+		frame = m_latestFrame;
+		v.clamped = true;
+	}
+	v.testedFrame = frame;
+
+	CFrame target;
+	RealTime testedTime;
+	if (oldest != 0 && pose(targetIndex, frame, target) && frameTime(frame, testedTime)) {
+		v.rewindMs = (float)(1000.0 * (m_times[slot(m_latestFrame)] - testedTime));
+		float hitDistance;
+		v.missDistance = rayMissDistance(shot, target.translation, config.hitRadius, hitDistance);
+		if (v.missDistance > config.toleranceM) {
+			v.result = MISSED;
+		}
+		else if (config.occlusion && notNull(scene) && !scene->staticLineOfSight(shot.origin(), shot.origin() + hitDistance * shot.direction())) {
+			v.result = OCCLUDED;
+		}
+		else {
+			v.result = HIT;
+		}
+	}
+
+	v.costUs = (float)std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+	return v;
+}
+
+float LagCompensator::rayMissDistance(const Ray& ray, const Point3& center, float radius, float& hitDistance) {
+	// Closest approach of the ray (not behind its origin) to the center
+	const float along = max(0.0f, (center - ray.origin()).dot(ray.direction()));
+	const float closest = (ray.origin() + along * ray.direction() - center).length();
+	if (closest > radius) {
+		hitDistance = along;
+		return closest - radius;
+	}
+	hitDistance = max(0.0f, along - sqrt(square(radius) - square(closest)));
+	return 0.0f;
+}
+
+const char* LagCompensator::resultToString(Result result) {
+	switch (result) {
+	case HIT: return "hit";
+	case MISSED: return "missed";
+	case OCCLUDED: return "occluded";
+	default: return "no_history";
+	}
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <G3D/G3D.h>
+#include <chrono>
+#include "SnapshotHistory.h"
+
+struct LagCompensationConfig;
+class PhysicsScene;
+
+/** Checks the hits clients report against the entity poses the shooter saw (server side lag compensation)
+
+	The server records the state of every networked entity on each network frame. A reported hit carries the (fractional)
+	server frame the shooter's client was showing and the shot's ray. The server rewinds to that frame (no further back
+	than the rewind window), interpolating between the recorded frames on either side, and re-runs the ray test against
+	the target's pose there. Shots are tested against a sphere around the entity's frame rather than its model, since a
+	headless server doesn't load models.
+*/
+class LagCompensator {
+public:
+	typedef std::chrono::high_resolution_clock Clock;
+	typedef SnapshotHistory::EntityState EntityState;
+	typedef SnapshotHistory::Snapshot Snapshot;
+
+	static const int CAPACITY = 256;				///< Frames held (about 1 s of network frames at 240 Hz), the rewind window can't reach past these
+
+	/** What a check found */
+	enum Result {
+		HIT,										///< The shot passes through the target's hit sphere (within the tolerance)
+		MISSED,										///< The shot passes outside the target's hit sphere
+		OCCLUDED,									///< Static scene geometry is between the shooter and the hit point
+		NO_HISTORY									///< The target wasn't recorded on the frame tested
+	};
+
+	/** The outcome of checking one hit */
+	struct Validation {
+		Result	result = NO_HISTORY;
+		double	testedFrame = 0.0;					///< (Fractional) server frame the shot was tested on
+		float	rewindMs = 0.0f;					///< Time from the tested frame to the latest recorded frame
+		bool	clamped = false;					///< Was the shooter's frame outside the rewind window (or ahead of the latest frame)?
+		float	missDistance = 0.0f;				///< Distance the shot passes outside the target's hit sphere (0 if it passes through it)
+		float	costUs = 0.0f;						///< Time taken by the check
+	};
+
+protected:
+	uint32						m_frames[CAPACITY] = {};	///< Frame number of each recorded snapshot (0 for empty slots)
+	RealTime					m_times[CAPACITY] = {};		///< Time each snapshot was recorded
+	shared_ptr<const Snapshot>	m_snapshots[CAPACITY];		///< The state of every entity on each frame (shared with the snapshots sent)
+	uint32						m_latestFrame = 0;			///< Most recently recorded frame
+
+	/** The recorded slot for a frame, -1 if it isn't held (any more) */
+	int slot(uint32 frame) const;
+	/** The state of an entity in a recorded snapshot (sorted by index), nullptr if it isn't in it */
+	static const EntityState* findState(const Snapshot& snapshot, uint16 index);
+
+public:
+	/** Store the state of every entity on this frame (replacing the oldest frame) */
+	void record(uint32 frame, RealTime time, const shared_ptr<const Snapshot>& snapshot);
+	void clear();
+
+	uint32 latestFrame() const { return m_latestFrame; }
+	/** The oldest frame held within windowS of the latest frame (0 if nothing is held) */
+	uint32 oldestFrame(RealTime windowS) const;
+	/** The time a (fractional) frame was recorded at, interpolated between the frames on either side. Returns false if they aren't held. */
+	bool frameTime(double frame, RealTime& time) const;
+	/** The pose of an entity on a (fractional) frame, interpolated between the frames on either side. Returns false if the
+		entity isn't held on them. */
+	bool pose(uint16 index, double frame, CFrame& cframe) const;
+
+	/** Re-run the ray test for a reported hit on targetIndex. viewFrame is the server frame the shooter saw, which is
+		tested when config.favorShooter is set (otherwise the latest frame is). scene (if not null) is checked for
+		occluding static geometry. */
+	Validation validate(const LagCompensationConfig& config, const Ray& shot, double viewFrame, uint16 targetIndex, const PhysicsScene* scene) const;
+
+	/** Distance a ray passes outside a sphere (0 if it passes through it). hitDistance is set to the distance along the ray
+		to where it enters the sphere (or to its closest approach when it misses). */
+	static float rayMissDistance(const Ray& ray, const Point3& center, float radius, float& hitDistance);
+
+	static const char* resultToString(Result result);
+};
@@ -1,55 +1,143 @@
 #include "LatentNetwork.h"
+#include "NetworkThread.h"
 
 
 void LatentNetwork::networkThreadTick()
 {
 	std::unique_lock<std::mutex> lk(m_queueMutex);
-	lk.unlock();
-
-	auto tickDuration = std::chrono::nanoseconds(500);
-	std::chrono::time_point<std::chrono::high_resolution_clock> start_timer = std::chrono::high_resolution_clock::now();
+	const auto woken = [this] { return !m_threadRunning || m_sharedPacketQueue.size() > 0 || m_fenceRequested; };
 
 	while (m_threadRunning) {
-		// sleep til ready
-		auto dT = std::chrono::high_resolution_clock::now() - start_timer;
-		std::this_thread::sleep_until(std::chrono::system_clock::now() + (tickDuration - dT));
-		start_timer = std::chrono::high_resolution_clock::now();
-
-		// lock packet queue mutex
-		lk.lock();
-		// copy packet queue into local space
-		decltype(m_sharedPacketQueue) sharedPacketQueue;
-		sharedPacketQueue.swap(m_sharedPacketQueue, sharedPacketQueue);
-		lk.unlock();
-
-		// heapify the read packets
-		for (shared_ptr<LatentPacket> packet : sharedPacketQueue) {
+		// heapify the newly enqueued packets
+		for (const shared_ptr<LatentPacket>& packet : m_sharedPacketQueue) {
 			m_packetHeap.push_back(packet);
 			std::push_heap(m_packetHeap.begin(), m_packetHeap.end(), PacketSendtimeCompare());
 		}
+		m_sharedPacketQueue.fastClear();
+
+		// Update the flush fence (only when someone is waiting on it)
+		if (m_flushWaiters > 0) {
+			uint64 oldestPending = m_enqueuedSeq + 1;
+			for (const shared_ptr<LatentPacket>& packet : m_packetHeap) {
+				oldestPending = min(oldestPending, packet->sequence);
+			}
+			if (oldestPending != m_oldestPendingSeq) {
+				m_oldestPendingSeq = oldestPending;
+				m_sentCV.notify_all();
+			}
+		}
+		m_fenceRequested = false;
+
+		// Nothing to send, wait for a packet
+		if (m_packetHeap.length() == 0) {
+			m_wakeTime = Clock::time_point::max();
+			m_queueCV.wait(lk, woken);
+			continue;
+		}
+
+		// Sleep until just before the next send time (waking up early if a packet is enqueued ahead of it)
+		const Clock::time_point sendTime = m_packetHeap[0]->timeToSend;
+		const Clock::time_point wakeTime = sendTime - spinWindow();
+		if (Clock::now() < wakeTime) {
+			m_wakeTime = sendTime;
+			if (!m_queueCV.wait_until(lk, wakeTime, woken)) {
+				// Track how late the OS woke us up, so the spin window covers it
+				const double lateUs = std::chrono::duration<double, std::micro>(Clock::now() - wakeTime).count();
+				m_oversleepUs = max(lateUs, 0.95 * m_oversleepUs);
+			}
+			continue;
+		}
 
-		// send the packets that need to be sent
-		std::chrono::time_point<std::chrono::high_resolution_clock> now = std::chrono::high_resolution_clock::now();
+		// Spin for the final stretch then send the packets that are due (new packets are picked up on the next pass without a wake up)
+		m_wakeTime = Clock::time_point::min();
+		const SendHook sendHook = m_sendHook;
+		lk.unlock();
+		while (Clock::now() < sendTime) {
+			std::this_thread::yield();
+		}
+		sendDuePackets(sendHook);
+		lk.lock();
+	}
+}
 
-		while (m_packetHeap.length() > 0 && m_packetHeap[0]->timeToSend <= now) {
-			std::pop_heap(m_packetHeap.begin(), m_packetHeap.end(), PacketSendtimeCompare());
-			m_packetHeap.back()->encapsulatedPacket->send();
-			m_packetHeap.pop_back();
+void LatentNetwork::sendDuePackets(const SendHook& sendHook)
+{
+	{
+		std::lock_guard<std::mutex> lk(m_statsMutex);
+		m_spinWindowUs = (double)spinWindow().count();
+	}
+	while (m_packetHeap.length() > 0 && m_packetHeap[0]->timeToSend <= Clock::now()) {
+		std::pop_heap(m_packetHeap.begin(), m_packetHeap.end(), PacketSendtimeCompare());
+		const shared_ptr<LatentPacket> packet = m_packetHeap.back();
+		m_packetHeap.pop_back();
+		NetworkThread* networkThread = NetworkThread::running();
+		if (!sendHook && notNull(networkThread)) {
+			networkThread->postLatent(packet);		// Only the network thread uses ENet while it runs (it records the send when it makes it)
+			continue;
+		}
+		const Clock::time_point sentTime = Clock::now();
+		if (sendHook) {
+			sendHook(packet);
 		}
-		//debugPrintf("Packet heap length: %d\n", m_packetHeap.length());
+		else {
+			packet->send();
+		}
+		recordSend(*packet, sentTime);
 	}
 }
-/*
-LatentNetwork::LatentNetwork()
+
+std::chrono::microseconds LatentNetwork::spinWindow() const
+{
+	return std::chrono::microseconds((int64)clamp(m_oversleepUs + s_minSpinUs, s_minSpinUs, s_maxSpinUs));
+}
+
+const Array<float>& LatentNetwork::errorHistogramBucketsUs() {
+	static const Array<float> buckets = { 5.0f, 10.0f, 20.0f, 50.0f, 100.0f, 200.0f, 500.0f, 1000.0f, 2000.0f, 5000.0f };
+	return buckets;
+}
+
+void LatentNetwork::recordSend(const LatentPacket& packet, Clock::time_point sentTime)
 {
-	// Reserve some space in these arrays here
-	m_sharedPacketQueue.reserve(5000);
+	const double errorUs = std::chrono::duration<double, std::micro>(sentTime - packet.timeToSend).count();
+	const Array<float>& buckets = errorHistogramBucketsUs();
+	int bucket = 0;
+	while (bucket < buckets.size() && errorUs > buckets[bucket]) bucket++;
 
+	std::lock_guard<std::mutex> lk(m_statsMutex);
+	m_sentCount++;
+	m_errorSumUs += errorUs;
+	m_maxErrorUs = max(m_maxErrorUs, errorUs);
+	m_errorHistogram[bucket]++;
+}
+
+LatentNetwork::DeliveryStats LatentNetwork::stats()
+{
+	DeliveryStats s;
+	{
+		std::lock_guard<std::mutex> lk(m_statsMutex);
+		s.sent = m_sentCount;
+		s.meanErrorUs = (m_sentCount > 0) ? m_errorSumUs / m_sentCount : 0.0;
+		s.maxErrorUs = m_maxErrorUs;
+		s.errorHistogram = m_errorHistogram;
+		s.spinWindowUs = m_spinWindowUs;
+	}
+	return s;
+}
 
-	// Thread management
-	m_threadRunning = true;
-	m_thread = std::thread(&LatentNetwork::networkThreadTick, this);
-}*/
+void LatentNetwork::logDeliveryReport()
+{
+	const DeliveryStats s = stats();
+	if (s.sent == 0) return;		// No latency was added
+	logPrintf("Latent network sent %llu delayed packets, sent after their requested time by %.1f us on average (max %.1f us, spin window %.0f us):\n",
+		(unsigned long long)s.sent, s.meanErrorUs, s.maxErrorUs, s.spinWindowUs);
+	const Array<float>& buckets = errorHistogramBucketsUs();
+	uint64 cumulative = 0;
+	for (int i = 0; i < s.errorHistogram.size(); i++) {
+		cumulative += s.errorHistogram[i];
+		const String range = (i < buckets.size()) ? format("<= %6.0f us", buckets[i]) : format(" > %6.0f us", buckets.last());
+		logPrintf("\t%s: %8llu (%5.1f%% cumulative)\n", range.c_str(), (unsigned long long)s.errorHistogram[i], 100.0 * cumulative / s.sent);
+	}
+}
 
 LatentNetwork::~LatentNetwork()
 {
@@ -57,19 +145,31 @@ LatentNetwork::~LatentNetwork()
 		std::lock_guard<std::mutex> lk(m_queueMutex);
 		m_threadRunning = false;
 	}
-	//m_queueCV.notify_one();
+	m_queueCV.notify_one();
 	m_thread.join();
 }
-/*
-void LatentNetwork::flush(bool blockUntilDone)
+
+bool LatentNetwork::flush(bool blockUntilDone, RealTime timeoutS)
 {
-	// Not implemented. Make another condition variable if this is needed.
-	assert(!blockUntilDone);
+	if (!blockUntilDone) return true;
 
-	{
-		std::lock_guard<std::mutex> lk(m_queueMutex);
-		m_flushNow = true;
-	}
+	std::unique_lock<std::mutex> lk(m_queueMutex);
+	const uint64 fence = m_enqueuedSeq;
+	m_flushWaiters++;
+	// Have the thread update the fence now (it may be waiting with nothing to send)
+	m_fenceRequested = true;
 	m_queueCV.notify_one();
+	const RealTime start = System::time();
+	const bool done = m_sentCV.wait_for(lk, std::chrono::duration<double>(timeoutS), [this, fence] {
+		return m_oldestPendingSeq > fence || !m_threadRunning;
+	});
+	m_flushWaiters--;
+	const RealTime waitMs = 1000.0 * (System::time() - start);
+	if (done) {
+		logPrintf("Latent network flush (fence %llu) sent after waiting %.3f ms\n", (unsigned long long)fence, waitMs);
+	}
+	else {
+		logPrintf("Latent network flush (fence %llu) timed out after %.3f ms\n", (unsigned long long)fence, waitMs);
+	}
+	return done;
 }
-*/
\ No newline at end of file
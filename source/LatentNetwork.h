@@ -1,41 +1,120 @@
 #pragma once
 
 #include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <thread>
 #include <G3D/G3D.h>
 #include "Packet.h"
 
 struct LatentPacket : public ReferenceCountedObject {
 	std::chrono::time_point<std::chrono::high_resolution_clock> timeToSend;
 	shared_ptr<GenericPacket> encapsulatedPacket;
+	uint64 sequence = 0;			///< Order this packet was enqueued in (assigned by LatentNetwork::enqueuePacket())
+
+	// Already serialized packets (broadcasts share these bytes between destinations instead of copying the packet)
+	shared_ptr<const BinaryOutput> payload;		///< Serialized bytes to send (only used if there is no encapsulatedPacket)
+	ENetPeer* destPeer = nullptr;				///< Reliable destination for the payload (nullptr to send it unreliably)
+	ENetSocket* srcSocket = nullptr;			///< Socket to send an unreliable payload on
+	ENetAddress destAddr;						///< Unreliable destination for the payload
 
 	LatentPacket(shared_ptr<GenericPacket> packet, std::chrono::time_point<std::chrono::high_resolution_clock> time) {
 		timeToSend = time;
 		encapsulatedPacket = packet;
 	}
 
+	LatentPacket(const shared_ptr<const BinaryOutput>& bytes, ENetPeer* peer, ENetSocket* socket, const ENetAddress& addr, std::chrono::time_point<std::chrono::high_resolution_clock> time) {
+		timeToSend = time;
+		payload = bytes;
+		destPeer = peer;
+		srcSocket = socket;
+		destAddr = addr;
+	}
+
 	static shared_ptr<LatentPacket> create(shared_ptr<GenericPacket> packet, std::chrono::time_point<std::chrono::high_resolution_clock> time) {
 		return createShared<LatentPacket>(packet, time);
 	}
+
+	/** Create a latent send of serialized bytes, over the reliable channel if peer is set (otherwise the unreliable channel) */
+	static shared_ptr<LatentPacket> createSerialized(const shared_ptr<const BinaryOutput>& bytes, ENetPeer* peer, ENetSocket* socket, const ENetAddress& addr, std::chrono::time_point<std::chrono::high_resolution_clock> time) {
+		return createShared<LatentPacket>(bytes, peer, socket, addr, time);
+	}
+
+	int send() {
+		if (notNull(encapsulatedPacket)) return encapsulatedPacket->send();
+		if (notNull(destPeer)) return GenericPacket::sendSerialized(*payload, destPeer);
+		return GenericPacket::sendSerialized(*payload, srcSocket, &destAddr);
+	}
 };
 
 struct PacketSendtimeCompare {
 	bool operator()(const shared_ptr<LatentPacket>& a, const shared_ptr<LatentPacket>& b) const {
-		return b->timeToSend < a->timeToSend;
+		// Packets due at the same time are sent in the order they were enqueued
+		return b->timeToSend < a->timeToSend || (b->timeToSend == a->timeToSend && b->sequence < a->sequence);
 	}
 };
 
+/** Sends packets with (artificial) added latency from a background thread
+
+	Packets wait in a heap ordered by their send time. The thread sleeps on a condition variable until the earliest send
+	time (or until a packet is enqueued ahead of it), then spins for the final stretch so packets go out on time even where
+	the OS wakes threads up late. The spin window tracks how late recent wake ups were, so it only spins as long as needed.
+	With no delayed packets queued the thread just waits.
+*/
 class LatentNetwork {
+public:
+	typedef std::chrono::high_resolution_clock Clock;
+	/** Called in place of sending a due packet (see setSendHook()) */
+	typedef std::function<void(const shared_ptr<LatentPacket>&)> SendHook;
+
+	/** How late packets were sent compared to their requested send time */
+	struct DeliveryStats {
+		uint64			sent = 0;						///< Delayed packets sent
+		double			meanErrorUs = 0.0;				///< Mean time sent after the requested time (us)
+		double			maxErrorUs = 0.0;
+		Array<uint64>	errorHistogram;					///< Packet counts for each of errorHistogramBucketsUs() (plus a final bucket for later packets)
+		double			spinWindowUs = 0.0;				///< Spin window when the last packet was sent (us)
+	};
+
+	/** Upper bounds (in us) of the delivery error histogram buckets */
+	static const Array<float>& errorHistogramBucketsUs();
 
 protected:
-	Array<shared_ptr<LatentPacket>> m_sharedPacketQueue;
-	Array<shared_ptr<LatentPacket>> m_packetHeap;
+	Array<shared_ptr<LatentPacket>> m_sharedPacketQueue;	///< Packets enqueued since the thread last looked (protected by m_queueMutex)
+	Array<shared_ptr<LatentPacket>> m_packetHeap;			///< Packets waiting to be sent, ordered by send time (network thread only)
 
 	bool m_threadRunning;
 	std::thread m_thread;
 	std::mutex m_queueMutex;
-	//std::condition_variable m_queueCV;
+	std::condition_variable m_queueCV;			///< Signaled when a packet is enqueued ahead of the thread's wake up time (or on shutdown)
+	Clock::time_point m_wakeTime = Clock::time_point::max();	///< Time the thread will next wake up on its own (protected by m_queueMutex)
+
+	// Spin window (network thread only)
+	static constexpr double s_minSpinUs = 20.0;		///< Shortest spin before a send time
+	static constexpr double s_maxSpinUs = 2000.0;	///< Longest spin (waking up later than this is left to the OS)
+	double m_oversleepUs = 0.0;					///< Decaying peak of how late timed waits woke up
+
+	// Delivery error statistics (protected by m_statsMutex)
+	std::mutex m_statsMutex;
+	uint64 m_sentCount = 0;
+	double m_errorSumUs = 0.0;
+	double m_maxErrorUs = 0.0;
+	Array<uint64> m_errorHistogram;
+	double m_spinWindowUs = 0.0;				///< Spin window when the last packet was sent
+
+	// Flush fences (packets are numbered as they are enqueued)
+	uint64 m_enqueuedSeq = 0;					///< Sequence number of the last packet enqueued (protected by m_queueMutex)
+	uint64 m_oldestPendingSeq = 1;				///< Lowest sequence number not yet sent (protected by m_queueMutex)
+	int m_flushWaiters = 0;						///< Number of threads blocked in flush() (protected by m_queueMutex)
+	bool m_fenceRequested = false;				///< Set by flush() to have the thread update m_oldestPendingSeq right away (protected by m_queueMutex)
+	std::condition_variable m_sentCV;			///< Signaled when m_oldestPendingSeq advances while there are flush waiters
+	SendHook m_sendHook;						///< Replaces the actual send of due packets, if set (protected by m_queueMutex)
 
 	void networkThreadTick();
+	/** Send every packet in the heap that is due, or pass it to sendHook if set (network thread only, called without the lock held) */
+	void sendDuePackets(const SendHook& sendHook);
+	/** Current spin window before a send time */
+	std::chrono::microseconds spinWindow() const;
 
 public:
 	static LatentNetwork& getInstance()
@@ -49,7 +128,8 @@ private:
 	LatentNetwork() { // constructor
 		// Reserve some space in these arrays here
 		m_sharedPacketQueue.reserve(5000);
-
+		m_errorHistogram.resize(errorHistogramBucketsUs().size() + 1);
+		for (uint64& count : m_errorHistogram) count = 0;
 
 		// Thread management
 		m_threadRunning = true;
@@ -70,9 +150,33 @@ public:
 
 
 	void enqueuePacket(shared_ptr<LatentPacket> packet) {
-		{
-			std::lock_guard<std::mutex> lk(m_queueMutex);
-			m_sharedPacketQueue.push_back(packet);
+		std::lock_guard<std::mutex> lk(m_queueMutex);
+		packet->sequence = ++m_enqueuedSeq;
+		m_sharedPacketQueue.push_back(packet);
+		// Only wake the thread if this packet is due before it would wake up anyway
+		if (packet->timeToSend < m_wakeTime) {
+			m_wakeTime = packet->timeToSend;
+			m_queueCV.notify_one();
 		}
 	};
-};
\ No newline at end of file
+
+	/** Delayed packets are always sent at their scheduled time, so this only waits (if blockUntilDone is set, up to timeoutS)
+		for every packet enqueued before the call to be sent. Returns false if the wait timed out. While the NetworkThread runs,
+		a packet counts as sent once it is handed to that thread (which sends it right away). */
+	bool flush(bool blockUntilDone, RealTime timeoutS = 5.0);
+
+	/** Add a delayed packet's delivery error (from its send time to sentTime, when the send was made) to the statistics.
+		Called by whichever thread makes the actual send, this one or the NetworkThread. */
+	void recordSend(const LatentPacket& packet, Clock::time_point sentTime);
+
+	/** Have hook called in place of sending each due packet (nullptr to send them again), e.g. to test delivery times */
+	void setSendHook(const SendHook& hook) {
+		std::lock_guard<std::mutex> lk(m_queueMutex);
+		m_sendHook = hook;
+	}
+
+	/** Get a snapshot of the delivery error statistics (safe to call from any thread) */
+	DeliveryStats stats();
+	/** Write the delivery error distribution to the log */
+	void logDeliveryReport();
+};
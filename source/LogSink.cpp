@@ -0,0 +1,332 @@
+#include "LogSink.h"
+
+shared_ptr<LogSink> LogSink::create(const String& sinkName, sqlite3* db, const String& filePrefix) {
+	if (sinkName == "sqlite") return SqliteLogSink::create(db);
+	if (sinkName == "csv") return CsvLogSink::create(filePrefix);
+	if (sinkName == "binary") return BinaryLogSink::create(filePrefix);
+	logPrintf("Unknown log sink \"%s\" ignored!\n", sinkName.c_str());
+	return nullptr;
+}
+
+/***************
+ * SQLite sink *
+ ***************/
+
+/** Table writer for the SQLite sink (forwards to a prepared insert statement) */
+class SqliteTableWriter : public LogTableWriter {
+protected:
+	shared_ptr<SqlInsertStatement> m_stmt;
+
+	SqliteTableWriter(const shared_ptr<SqlInsertStatement>& stmt) : m_stmt(stmt) {}
+
+public:
+	static shared_ptr<SqliteTableWriter> create(const shared_ptr<SqlInsertStatement>& stmt) {
+		return createShared<SqliteTableWriter>(stmt);
+	}
+
+	using LogTableWriter::bind;
+	virtual void bind(int col, double value) override			{ m_stmt->bind(col, value); }
+	virtual void bind(int col, int64 value) override			{ m_stmt->bind(col, value); }
+	virtual void bind(int col, int value) override				{ m_stmt->bind(col, value); }
+	virtual void bind(int col, bool value) override				{ m_stmt->bind(col, value); }
+	virtual void bind(int col, const String& value) override	{ m_stmt->bind(col, value); }
+	virtual void bind(int col, const char* value) override		{ m_stmt->bind(col, value); }
+	virtual void bindNull(int col) override						{ m_stmt->bindNull(col); }
+	virtual bool insertRow() override							{ return m_stmt->insertRow(); }
+};
+
+void SqliteLogSink::createTable(const String& tableName, const Array<Array<String>>& columns) {
+	createTableInDB(m_db, tableName, columns);
+}
+
+shared_ptr<LogTableWriter> SqliteLogSink::tableWriter(const String& tableName, int columnCount) {
+	return SqliteTableWriter::create(SqlInsertStatement::create(m_db, tableName, columnCount));
+}
+
+void SqliteLogSink::beginBatch() {
+	// Write the whole batch as a single transaction (one journal sync instead of one per statement)
+	beginTransactionInDB(m_db);
+}
+
+void SqliteLogSink::endBatch() {
+	commitTransactionInDB(m_db);
+}
+
+/************
+ * CSV sink *
+ ************/
+
+/** Table writer for the CSV sink (rows are buffered in memory until the end of the batch) */
+class CsvLogSink::CsvTableWriter : public LogTableWriter {
+protected:
+	std::ofstream	m_file;
+	Array<String>	m_values;			///< Values bound for the current row
+	std::string		m_buffer;			///< Rows waiting to be written
+
+	static const size_t s_maxBufferBytes = 256 * 1024;
+
+	/** Quote a text value if it contains a delimiter, quote, or newline */
+	static String escape(const String& value) {
+		if (value.find_first_of(",\"\r\n") == String::npos) return value;
+		String escaped = "\"";
+		for (char c : value) {
+			if (c == '"') escaped += '"';
+			escaped += c;
+		}
+		return escaped + "\"";
+	}
+
+	void appendLine(const Array<String>& values) {
+		for (int i = 0; i < values.size(); i++) {
+			if (i > 0) m_buffer += ',';
+			m_buffer += values[i].c_str();
+		}
+		m_buffer += '\n';
+		if (m_buffer.size() >= s_maxBufferBytes) flush();
+	}
+
+public:
+	CsvTableWriter(const String& filename, const Array<String>& columnNames) {
+		const bool writeHeader = !FileSystem::exists(filename) && columnNames.size() > 0;
+		m_file.open(filename.c_str(), std::ios_base::out | std::ios_base::app);
+		if (!m_file.is_open()) {
+			logPrintf("Error opening CSV log file: %s\n", filename.c_str());
+		}
+		if (writeHeader) appendLine(columnNames);
+		m_values.resize(columnNames.size());
+	}
+
+	using LogTableWriter::bind;
+	virtual void bind(int col, double value) override			{ setValue(col, format("%.17g", value)); }
+	virtual void bind(int col, float value) override			{ setValue(col, format("%.9g", value)); }
+	virtual void bind(int col, int64 value) override			{ setValue(col, format("%lld", (long long)value)); }
+	virtual void bind(int col, const String& value) override	{ setValue(col, escape(value)); }
+	virtual void bindNull(int col) override						{ setValue(col, ""); }
+
+	void setValue(int col, const String& value) {
+		if (col >= m_values.size()) m_values.resize(col + 1);
+		m_values[col] = value;
+	}
+
+	virtual bool insertRow() override {
+		appendLine(m_values);
+		for (String& value : m_values) value = "";
+		return m_file.good();
+	}
+
+	/** Write any buffered rows to the file */
+	void flush() {
+		if (m_buffer.empty()) return;
+		m_file.write(m_buffer.data(), (std::streamsize)m_buffer.size());
+		m_file.flush();
+		m_buffer.clear();
+	}
+
+	virtual ~CsvTableWriter() {
+		flush();
+	}
+};
+
+shared_ptr<CsvLogSink::CsvTableWriter> CsvLogSink::openTable(const String& tableName, const Array<String>& columnNames) {
+	shared_ptr<CsvTableWriter>* existing = m_tables.getPointer(tableName);
+	if (notNull(existing)) return *existing;
+	const shared_ptr<CsvTableWriter> writer = std::make_shared<CsvTableWriter>(m_filePrefix + "_" + tableName + ".csv", columnNames);
+	m_tables.set(tableName, writer);
+	return writer;
+}
+
+void CsvLogSink::createTable(const String& tableName, const Array<Array<String>>& columns) {
+	Array<String> columnNames;
+	for (const Array<String>& column : columns) columnNames.append(column[0]);
+	openTable(tableName, columnNames);
+}
+
+shared_ptr<LogTableWriter> CsvLogSink::tableWriter(const String& tableName, int columnCount) {
+	return openTable(tableName, Array<String>());
+}
+
+void CsvLogSink::endBatch() {
+	for (const String& tableName : m_tables.getKeys()) {
+		m_tables[tableName]->flush();
+	}
+}
+
+/***************
+ * Binary sink *
+ ***************/
+
+/** Table writer for the binary sink (values are appended to per-column buffers, which are written as one block per batch) */
+class BinaryLogSink::BinaryTableWriter : public LogTableWriter {
+protected:
+	enum ColumnType : uint8 {
+		INT64 = 0,
+		FLOAT64,
+		STRING32
+	};
+
+	/** A value bound for the current row (only the field for the column's type is used) */
+	struct RowValue {
+		int64	i = 0;
+		double	f = 0.0;
+		String	s;
+		bool	bound = false;
+	};
+
+	std::ofstream					m_file;
+	Array<ColumnType>				m_types;
+	Array<shared_ptr<BinaryOutput>>	m_columns;		///< Values written this batch (one buffer per column)
+	Array<RowValue>					m_row;			///< Values bound for the current row (copied to the column buffers by insertRow(), so binding a column twice keeps the last value)
+	uint32							m_rowCount = 0;	///< Rows written this batch
+
+	static const uint32 s_version = 1;
+
+	/** Column type from a SQL type name */
+	static ColumnType columnType(const String& sqlType) {
+		const String type = toLower(sqlType);
+		if (type.find("int") != String::npos || type.find("bool") != String::npos) return INT64;
+		if (type.find("real") != String::npos || type.find("floa") != String::npos || type.find("doub") != String::npos) return FLOAT64;
+		return STRING32;
+	}
+
+	/** Does a file hold data that doesn't start with this header? (a missing or empty file can be given the header) */
+	static bool hasOtherHeader(const String& filename, const BinaryOutput& header) {
+		std::ifstream file(filename.c_str(), std::ios_base::in | std::ios_base::binary);
+		if (!file.is_open()) return false;
+		std::string existing((size_t)header.length(), '\0');
+		file.read(&existing[0], (std::streamsize)existing.size());
+		if (file.gcount() == 0) return false;
+		return file.gcount() != (std::streamsize)existing.size() || memcmp(existing.data(), header.getCArray(), existing.size()) != 0;
+	}
+
+	RowValue& rowValue(int col) {
+		m_row[col].bound = true;
+		return m_row[col];
+	}
+
+public:
+	BinaryTableWriter(const String& filename, const Array<Array<String>>& columns) {
+		for (const Array<String>& col : columns) {
+			m_types.append(columnType(col.size() > 1 ? col[1] : "text"));
+			m_columns.append(std::make_shared<BinaryOutput>("<memory>", G3D_LITTLE_ENDIAN));
+		}
+		m_row.resize(columns.size());
+
+		BinaryOutput header("<memory>", G3D_LITTLE_ENDIAN);
+		header.writeBytes("FPSB", 4);
+		header.writeUInt32(s_version);
+		header.writeUInt32(columns.size());
+		for (int i = 0; i < columns.size(); i++) {
+			header.writeString32(columns[i][0]);
+			header.writeUInt8(m_types[i]);
+		}
+
+		// Blocks don't carry their schema, so only append to a file whose header matches these columns (otherwise use the next free "_n" filename)
+		String path = filename;
+		for (int n = 2; hasOtherHeader(path, header); n++) {
+			path = format("%s_%d.fpsb", FilePath::concat(FilePath::parent(filename), FilePath::base(filename)).c_str(), n);
+		}
+		if (path != filename) {
+			logPrintf("Binary log file %s was written with different columns, writing to %s instead\n", filename.c_str(), path.c_str());
+		}
+
+		bool writeHeader;
+		{
+			std::ifstream existing(path.c_str(), std::ios_base::in | std::ios_base::binary | std::ios_base::ate);
+			writeHeader = !existing.is_open() || existing.tellg() == std::streampos(0);
+		}
+		m_file.open(path.c_str(), std::ios_base::out | std::ios_base::binary | std::ios_base::app);
+		if (!m_file.is_open()) {
+			logPrintf("Error opening binary log file: %s\n", path.c_str());
+		}
+		if (writeHeader) {
+			m_file.write((const char*)header.getCArray(), (std::streamsize)header.length());
+		}
+	}
+
+	using LogTableWriter::bind;
+	virtual void bind(int col, double value) override {
+		switch (m_types[col]) {
+		case INT64: rowValue(col).i = (int64)value; break;
+		case FLOAT64: rowValue(col).f = value; break;
+		default: rowValue(col).s = format("%.17g", value); break;
+		}
+	}
+
+	virtual void bind(int col, int64 value) override {
+		switch (m_types[col]) {
+		case INT64: rowValue(col).i = value; break;
+		case FLOAT64: rowValue(col).f = (double)value; break;
+		default: rowValue(col).s = format("%lld", (long long)value); break;
+		}
+	}
+
+	virtual void bind(int col, const String& value) override {
+		switch (m_types[col]) {
+		case INT64: rowValue(col).i = (int64)atoll(value.c_str()); break;
+		case FLOAT64: rowValue(col).f = atof(value.c_str()); break;
+		default: rowValue(col).s = value; break;
+		}
+	}
+
+	virtual void bindNull(int col) override {
+		m_row[col].bound = false;
+	}
+
+	virtual bool insertRow() override {
+		// Every column gets a value in every row to keep the columns aligned (unbound columns are written as null values)
+		for (int i = 0; i < m_row.size(); i++) {
+			RowValue& v = m_row[i];
+			switch (m_types[i]) {
+			case INT64: m_columns[i]->writeInt64(v.bound ? v.i : 0); break;
+			case FLOAT64: m_columns[i]->writeFloat64(v.bound ? v.f : nan()); break;
+			default: m_columns[i]->writeString32(v.bound ? v.s : String("")); break;
+			}
+			v.bound = false;
+		}
+		m_rowCount++;
+		return m_file.good();
+	}
+
+	/** Write the rows from this batch as a block */
+	void flush() {
+		if (m_rowCount == 0) return;
+		BinaryOutput blockHeader("<memory>", G3D_LITTLE_ENDIAN);
+		blockHeader.writeUInt32(m_rowCount);
+		m_file.write((const char*)blockHeader.getCArray(), (std::streamsize)blockHeader.length());
+		for (const shared_ptr<BinaryOutput>& col : m_columns) {
+			m_file.write((const char*)col->getCArray(), (std::streamsize)col->length());
+			col->reset();
+		}
+		m_file.flush();
+		m_rowCount = 0;
+	}
+
+	virtual ~BinaryTableWriter() {
+		flush();
+	}
+};
+
+shared_ptr<BinaryLogSink::BinaryTableWriter> BinaryLogSink::openTable(const String& tableName, const Array<Array<String>>& columns) {
+	shared_ptr<BinaryTableWriter>* existing = m_tables.getPointer(tableName);
+	if (notNull(existing)) return *existing;
+	const shared_ptr<BinaryTableWriter> writer = std::make_shared<BinaryTableWriter>(m_filePrefix + "_" + tableName + ".fpsb", columns);
+	m_tables.set(tableName, writer);
+	return writer;
+}
+
+void BinaryLogSink::createTable(const String& tableName, const Array<Array<String>>& columns) {
+	openTable(tableName, columns);
+}
+
+shared_ptr<LogTableWriter> BinaryLogSink::tableWriter(const String& tableName, int columnCount) {
+	// Tables used without a schema are stored as text
+	Array<Array<String>> columns;
+	for (int i = 0; i < columnCount; i++) columns.append({ format("column%d", i), "text" });
+	return openTable(tableName, columns);
+}
+
+void BinaryLogSink::endBatch() {
+	for (const String& tableName : m_tables.getKeys()) {
+		m_tables[tableName]->flush();
+	}
+}
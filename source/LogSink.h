@@ -0,0 +1,150 @@
+#pragma once
+
+#include <G3D/G3D.h>
+#include <fstream>
+#include "sqlHelpers.h"
+
+/** Writes rows to a single table of a log sink
+
+	Values are bound by (0-based) column index, then insertRow() writes the row and clears the bound values.
+	Text values should NOT be quoted. */
+class LogTableWriter : public ReferenceCountedObject {
+public:
+	virtual ~LogTableWriter() {}
+
+	virtual void bind(int col, double value) = 0;
+	virtual void bind(int col, float value) { bind(col, (double)value); }
+	virtual void bind(int col, int64 value) = 0;
+	virtual void bind(int col, int value) { bind(col, (int64)value); }
+	virtual void bind(int col, uint32 value) { bind(col, (int64)value); }
+	virtual void bind(int col, bool value) { bind(col, (int64)(value ? 1 : 0)); }
+	virtual void bind(int col, const String& value) = 0;
+	virtual void bind(int col, const char* value) { bind(col, String(value)); }
+	virtual void bindNull(int col) = 0;
+
+	/** Write the currently bound values as a new row */
+	virtual bool insertRow() = 0;
+};
+
+/** Forwards every bound value/row to a group of table writers (for tables written to multiple sinks) */
+class LogTableWriterGroup : public LogTableWriter {
+protected:
+	Array<shared_ptr<LogTableWriter>> m_writers;
+
+	LogTableWriterGroup(const Array<shared_ptr<LogTableWriter>>& writers) : m_writers(writers) {}
+
+public:
+	static shared_ptr<LogTableWriterGroup> create(const Array<shared_ptr<LogTableWriter>>& writers) {
+		return createShared<LogTableWriterGroup>(writers);
+	}
+
+	virtual void bind(int col, double value) override			{ for (const shared_ptr<LogTableWriter>& w : m_writers) w->bind(col, value); }
+	virtual void bind(int col, float value) override			{ for (const shared_ptr<LogTableWriter>& w : m_writers) w->bind(col, value); }
+	virtual void bind(int col, int64 value) override			{ for (const shared_ptr<LogTableWriter>& w : m_writers) w->bind(col, value); }
+	virtual void bind(int col, int value) override				{ for (const shared_ptr<LogTableWriter>& w : m_writers) w->bind(col, value); }
+	virtual void bind(int col, uint32 value) override			{ for (const shared_ptr<LogTableWriter>& w : m_writers) w->bind(col, value); }
+	virtual void bind(int col, bool value) override				{ for (const shared_ptr<LogTableWriter>& w : m_writers) w->bind(col, value); }
+	virtual void bind(int col, const String& value) override	{ for (const shared_ptr<LogTableWriter>& w : m_writers) w->bind(col, value); }
+	virtual void bind(int col, const char* value) override		{ for (const shared_ptr<LogTableWriter>& w : m_writers) w->bind(col, value); }
+	virtual void bindNull(int col) override						{ for (const shared_ptr<LogTableWriter>& w : m_writers) w->bindNull(col); }
+
+	virtual bool insertRow() override {
+		bool ok = true;
+		for (const shared_ptr<LogTableWriter>& w : m_writers) ok = w->insertRow() && ok;
+		return ok;
+	}
+};
+
+/** An output backend for the logger tables
+
+	Tables are described using the same {name, type, modifiers} column specification as createTableInDB().
+	Rows written between beginBatch() and endBatch() are written out together. */
+class LogSink : public ReferenceCountedObject {
+public:
+	virtual ~LogSink() {}
+
+	/** Name of this sink (as used in the logger config) */
+	virtual const char* name() const = 0;
+
+	/** Create a table (or open it if it already exists) */
+	virtual void createTable(const String& tableName, const Array<Array<String>>& columns) = 0;
+
+	/** Get a writer for a table (call createTable() first so the sink knows the schema) */
+	virtual shared_ptr<LogTableWriter> tableWriter(const String& tableName, int columnCount) = 0;
+
+	virtual void beginBatch() {}
+	virtual void endBatch() {}
+
+	/** Create a sink by name ("sqlite", "csv", or "binary"), filenames for file-based sinks start with filePrefix */
+	static shared_ptr<LogSink> create(const String& sinkName, sqlite3* db, const String& filePrefix);
+};
+
+/** Writes tables to the SQLite results file (each batch is a transaction) */
+class SqliteLogSink : public LogSink {
+protected:
+	sqlite3* m_db = nullptr;						///< Results database (owned by the logger)
+
+	SqliteLogSink(sqlite3* db) : m_db(db) {}
+
+public:
+	static shared_ptr<SqliteLogSink> create(sqlite3* db) {
+		return createShared<SqliteLogSink>(db);
+	}
+
+	virtual const char* name() const override { return "sqlite"; }
+	virtual void createTable(const String& tableName, const Array<Array<String>>& columns) override;
+	virtual shared_ptr<LogTableWriter> tableWriter(const String& tableName, int columnCount) override;
+	virtual void beginBatch() override;
+	virtual void endBatch() override;
+};
+
+/** Writes each table to a "{filePrefix}_{tableName}.csv" file, which is kept open and written once per batch */
+class CsvLogSink : public LogSink {
+protected:
+	class CsvTableWriter;
+
+	String m_filePrefix;
+	Table<String, shared_ptr<CsvTableWriter>> m_tables;
+
+	CsvLogSink(const String& filePrefix) : m_filePrefix(filePrefix) {}
+
+	shared_ptr<CsvTableWriter> openTable(const String& tableName, const Array<String>& columnNames);
+
+public:
+	static shared_ptr<CsvLogSink> create(const String& filePrefix) {
+		return createShared<CsvLogSink>(filePrefix);
+	}
+
+	virtual const char* name() const override { return "csv"; }
+	virtual void createTable(const String& tableName, const Array<Array<String>>& columns) override;
+	virtual shared_ptr<LogTableWriter> tableWriter(const String& tableName, int columnCount) override;
+	virtual void endBatch() override;
+};
+
+/** Writes each table to an append-only columnar "{filePrefix}_{tableName}.fpsb" file
+
+	The file starts with a header ("FPSB", uint32 version, uint32 column count, then a string32 name and uint8 type for each column)
+	followed by one block per batch (uint32 row count, then each column's values stored contiguously).
+	Column types (0 = int64, 1 = float64, 2 = string32) come from the column types given to createTable(). All values are little endian.
+	Blocks are only appended to an existing file with the same header, otherwise the table goes to "{filePrefix}_{tableName}_{n}.fpsb". */
+class BinaryLogSink : public LogSink {
+protected:
+	class BinaryTableWriter;
+
+	String m_filePrefix;
+	Table<String, shared_ptr<BinaryTableWriter>> m_tables;
+
+	BinaryLogSink(const String& filePrefix) : m_filePrefix(filePrefix) {}
+
+	shared_ptr<BinaryTableWriter> openTable(const String& tableName, const Array<Array<String>>& columns);
+
+public:
+	static shared_ptr<BinaryLogSink> create(const String& filePrefix) {
+		return createShared<BinaryLogSink>(filePrefix);
+	}
+
+	virtual const char* name() const override { return "binary"; }
+	virtual void createTable(const String& tableName, const Array<Array<String>>& columns) override;
+	virtual shared_ptr<LogTableWriter> tableWriter(const String& tableName, int columnCount) override;
+	virtual void endBatch() override;
+};
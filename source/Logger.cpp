@@ -2,40 +2,150 @@
 #include "Session.h"
 #include "NetworkedSession.h"
 #include "FPSciApp.h"
+#include <ctime>
 
-// TODO: Replace with the G3D timestamp uses.
 // utility function for generating a unique timestamp.
 String FPSciLogger::genUniqueTimestamp() {
-	return formatFileTime(getFileTime());
+	return formatTime(getTime());
 }
 
-FILETIME FPSciLogger::getFileTime() {
-	FILETIME ft;
-	GetSystemTimePreciseAsFileTime(&ft);
-	return ft;
+int64 FPSciLogger::getTime() {
+	using namespace std::chrono;
+	static const int64 wallStartNs = duration_cast<nanoseconds>(system_clock::now().time_since_epoch()).count();
+	static const steady_clock::time_point steadyStart = steady_clock::now();
+	return wallStartNs + duration_cast<nanoseconds>(steady_clock::now() - steadyStart).count();
 }
 
-String FPSciLogger::formatFileTime(FILETIME ft) {
-	unsigned long long usecsinceepoch = (static_cast<unsigned long long>(ft.dwHighDateTime) << 32 | ft.dwLowDateTime) / 10;		// Get time since epoch in usec
-	int usec = usecsinceepoch % 1000000;
-
-	SYSTEMTIME datetime;
-	FileTimeToSystemTime(&ft, &datetime);
+/** Convert seconds since the Unix epoch to (UTC) calendar time */
+static std::tm utcTime(std::time_t secs) {
+	std::tm t;
+#ifdef G3D_WINDOWS
+	gmtime_s(&t, &secs);
+#else
+	gmtime_r(&secs, &t);
+#endif
+	return t;
+}
 
+String FPSciLogger::formatTime(int64 time) {
+	const std::tm t = utcTime((std::time_t)(time / 1000000000));
+	const int usec = (int)((time / 1000) % 1000000);
 	char tmCharArray[30] = { 0 };
-	sprintf(tmCharArray, "%04d-%02d-%02d %02d:%02d:%02d.%06d", datetime.wYear, datetime.wMonth, datetime.wDay, datetime.wHour, datetime.wMinute, datetime.wSecond, usec);
-	std::string timeStr(tmCharArray);
-	return String(timeStr);
+	sprintf(tmCharArray, "%04d-%02d-%02d %02d:%02d:%02d.%06d", t.tm_year + 1900, t.tm_mon + 1, t.tm_mday, t.tm_hour, t.tm_min, t.tm_sec, usec);
+	return String(tmCharArray);
+}
+
+static std::atomic<int64> s_frameTime{ 0 };
+
+void FPSciLogger::updateFrameTime() {
+	s_frameTime.store(getTime(), std::memory_order_relaxed);
+}
+
+int64 FPSciLogger::frameTime() {
+	const int64 time = s_frameTime.load(std::memory_order_relaxed);
+	return time == 0 ? getTime() : time;
+}
+
+static const char* playerActionTypeToString(PlayerActionType action) {
+	switch (action) {
+	case FireCooldown: return "fireCooldown";
+	case Aim: return "aim";
+	case Miss: return "miss";
+	case Hit: return "hit";
+	case Destroy: return "destroy";
+	case Move: return "move";
+	default: return "";
+	}
+}
+
+/** GUIDs are logged as their string16 representation, with unset ids logged as an empty string */
+static String guidToString(const LoggedGUID& guid) {
+	return guid.set ? guid.id.toString16() : String("");
+}
+
+/** Heap memory owned by a string (an upper bound, short strings may be stored inline) */
+static size_t stringBytes(const String& str) {
+	return str.size() > 0 ? str.size() + 1 : 0;
+}
+
+static size_t stringBytes(const Array<String>& strs) {
+	size_t bytes = strs.size() * sizeof(String);
+	for (const String& str : strs) bytes += stringBytes(str);
+	return bytes;
+}
+
+size_t FPSciLogger::recordBytes(const FrameInfo& info) {
+	return sizeof(info);
 }
 
+size_t FPSciLogger::recordBytes(const PlayerAction& action) {
+	return sizeof(action) + stringBytes(action.targetName);
+}
+
+size_t FPSciLogger::recordBytes(const RemotePlayerAction& action) {
+	return sizeof(action);
+}
+
+size_t FPSciLogger::recordBytes(const QuestionResult& question) {
+	const Question& q = question.question;
+	return sizeof(question) + stringBytes(question.sessionId) + stringBytes(question.presentedOptions) +
+		stringBytes(q.prompt) + stringBytes(q.title) + stringBytes(q.result) + stringBytes(q.options) + q.optionKeys.size() * sizeof(GKey);
+}
+
+size_t FPSciLogger::recordBytes(const TargetLocation& location) {
+	return sizeof(location) + stringBytes(location.name);
+}
+
+size_t FPSciLogger::recordBytes(const TargetInfo& target) {
+	return sizeof(target) + stringBytes(target.name) + stringBytes(target.typeId) + stringBytes(target.spawnTime);
+}
+
+size_t FPSciLogger::recordBytes(const TrialValues& trial) {
+	return sizeof(trial) + stringBytes(trial.sessionId) + stringBytes(trial.startTime) + stringBytes(trial.endTime);
+}
+
+size_t FPSciLogger::recordBytes(const UserValues& user) {
+	return sizeof(user) + stringBytes(user.subjectId) + stringBytes(user.sessionId);
+}
+
+size_t FPSciLogger::recordBytes(const NetworkedClient& client) {
+	return sizeof(client);
+}
+
+size_t FPSciLogger::recordBytes(const SnapshotStats& stats) {
+	return sizeof(stats);
+}
+
+size_t FPSciLogger::recordBytes(const InterpolationStats& stats) {
+	return sizeof(stats);
+}
+
+size_t FPSciLogger::recordBytes(const HitValidation& validation) {
+	return sizeof(validation);
+}
+
+size_t FPSciLogger::recordBytes(const PredictionCorrection& correction) {
+	return sizeof(correction);
+}
+
+size_t FPSciLogger::recordBytes(const ImpairmentRecord& record) {
+	return sizeof(record);
+}
+
+size_t FPSciLogger::recordBytes(const PlayerValues& player) {
+	return sizeof(player) + stringBytes(player.playerType);
+}
+
+size_t FPSciLogger::recordBytes(const shared_ptr<TargetConfig>& targetType) {
+	// The queue keeps the config alive, so count it (ignoring its own heap allocations)
+	return sizeof(targetType) + (isNull(targetType) ? 0 : sizeof(TargetConfig));
+}
 
 String FPSciLogger::genFileTimestamp() {
-	_SYSTEMTIME t;
-	GetSystemTime(&t);
+	const std::tm t = utcTime(std::time(nullptr));
 	char tmCharArray[30] = { 0 };
-	sprintf(tmCharArray, "%04d_%02d_%02d-%02d_%02d_%02d", t.wYear, t.wMonth, t.wDay, t.wHour, t.wMinute, t.wSecond);
-	std::string timeStr(tmCharArray);
-	return String(timeStr);
+	sprintf(tmCharArray, "%04d_%02d_%02d-%02d_%02d_%02d", t.tm_year + 1900, t.tm_mon + 1, t.tm_mday, t.tm_hour, t.tm_min, t.tm_sec);
+	return String(tmCharArray);
 }
 
 void FPSciLogger::initResultsFile(const String& filename, 
@@ -45,29 +155,53 @@ void FPSciLogger::initResultsFile(const String& filename,
 	const String& description)
 {
 	const bool createNewFile = !FileSystem::exists(filename);
+	m_sessionId = sessConfig->id;
+	m_spillFilename = filename + ".spill";
 
 	// Open the file
 	if (sqlite3_open(filename.c_str(), &m_db)) {
 		logPrintf(("Error opening log file: " + filename).c_str());					// Write an error to the log
 	}
 
-	// Create tables if a new log file is opened
+	// Apply the durability/throughput settings (page size first, it can't change once the file is in WAL mode)
+	applyPragmas(m_db);
+
+	// Create the output sinks (file-based sinks are named after the results file)
+	const String sinkFilePrefix = FilePath::concat(FilePath::parent(filename), FilePath::base(filename));
+	for (const String& sinkName : m_config.sinks) addSink(sinkName, sinkFilePrefix);
+	for (const String& tableName : m_config.tableSinks.getKeys()) {
+		for (const String& sinkName : m_config.tableSinks[tableName]) addSink(sinkName, sinkFilePrefix);
+	}
+
+	// Open the shard databases (before the tables are created so sharded tables are created in them)
+	openShards(filename);
+
+	// Create the experiment/session tables if a new log file is opened (these are always in the results database)
 	if (createNewFile) {
 		createExperimentsTable(expConfigFilename);
 		createSessionsTable(sessConfig);
-		createTargetTypeTable();
-		createTargetsTable();
-		createTrialsTable();
-		createTargetTrajectoryTable();
-		createPlayerActionTable();
-		createRemotePlayerActionTable();
-		createFrameInfoTable();
-		createQuestionsTable();
-		createUsersTable();
-		createNetworkedClientTable();
-		createPlayerConfigTable();
 	}
 
+	// Tables written by the logging thread (created/opened every time so each sink has their schema)
+	createTargetTypeTable();
+	createTargetsTable();
+	createTrialsTable();
+	createTargetTrajectoryTable();
+	createPlayerActionTable();
+	createRemotePlayerActionTable();
+	createFrameInfoTable();
+	createQuestionsTable();
+	createUsersTable();
+	createNetworkedClientTable();
+	createSnapshotStatsTable();
+	createInterpolationStatsTable();
+	createHitValidationTable();
+	createPredictionCorrectionsTable();
+	createImpairmentsTable();
+	createPlayerConfigTable();
+	createLoggerOverflowTable();
+	createLoggerStatsTable();
+
 	// Add the session info to the sessions table
 	m_openTimeStr = genUniqueTimestamp();
 	RowEntry sessValues = {
@@ -86,7 +220,253 @@ void FPSciLogger::initResultsFile(const String& filename,
 	for (String name : sessConfig->logger.sessParamsToLog) { sessValues.append("'" + a[name].unparse() + "'"); }
 	// add header row
 	insertRowIntoDB(m_db, "Sessions", sessValues);
-	//writeToFile(R"(results\CSVFailsafe)", "SessionInit.csv", sessValues);
+}
+
+void FPSciLogger::applyPragmas(sqlite3* db) {
+	execStatementInDB(db, format("PRAGMA page_size = %d;", m_config.pageSize));
+	execStatementInDB(db, "PRAGMA journal_mode = " + toUpper(m_config.journalMode) + ";");
+	execStatementInDB(db, "PRAGMA synchronous = " + toUpper(m_config.synchronous) + ";");
+	execStatementInDB(db, format("PRAGMA cache_size = %d;", -m_config.cacheSizeKB));		// Negative values are in KiB (rather than pages)
+	execStatementInDB(db, format("PRAGMA mmap_size = %lld;", (long long)m_config.mmapSizeMB * 1024 * 1024));
+	if (m_config.journalMode == "wal") {
+		execStatementInDB(db, format("PRAGMA wal_autocheckpoint = %d;", m_config.walCheckpointPages));
+	}
+	if (db != m_db) return;
+	logPrintf("Results file settings: journal_mode=%s, synchronous=%s, page_size=%d, cache_size=%dKB, mmap_size=%dMB, wal_autocheckpoint=%d\n",
+		m_config.journalMode.c_str(), m_config.synchronous.c_str(), m_config.pageSize, m_config.cacheSizeKB, m_config.mmapSizeMB, m_config.walCheckpointPages);
+}
+
+void FPSciLogger::addSink(const String& sinkName, const String& filePrefix) {
+	if (m_sinks.containsKey(sinkName)) return;
+	const shared_ptr<LogSink> sink = LogSink::create(sinkName, m_db, filePrefix);
+	if (notNull(sink)) m_sinks.set(sinkName, sink);
+}
+
+Array<shared_ptr<LogSink>> FPSciLogger::tableSinks(const String& tableName) const {
+	Array<shared_ptr<LogSink>> sinks;
+	const shared_ptr<LogShard>* shard = m_shards.getPointer(tableName);
+	if (notNull(shard)) {
+		for (const String& sinkName : (*shard)->sinks.getKeys()) sinks.append((*shard)->sinks[sinkName]);
+		return sinks;
+	}
+
+	const Array<String>* sinkNames = m_config.tableSinks.getPointer(tableName);
+	for (const String& sinkName : notNull(sinkNames) ? *sinkNames : m_config.sinks) {
+		const shared_ptr<LogSink>* sink = m_sinks.getPointer(sinkName);
+		if (notNull(sink)) sinks.append(*sink);
+	}
+	return sinks;
+}
+
+void FPSciLogger::createTable(const String& tableName, const Columns& columns) {
+	// Tables in a results file from before times were logged as integers still have text times (and are only created if they don't exist)
+	migrateTextTimes(tableName, columns);
+	for (const shared_ptr<LogSink>& sink : tableSinks(tableName)) {
+		sink->createTable(tableName, columns);
+		if (String(sink->name()) == "sqlite") {
+			// Sharded tables are also created in the results file (for the merge at close)
+			if (m_shards.containsKey(tableName)) createTableInDB(m_db, tableName, columns);
+			createTextTimeView(tableName, columns);
+		}
+	}
+}
+
+shared_ptr<LogTableWriter> FPSciLogger::tableWriter(const String& tableName, int columnCount) {
+	std::lock_guard<std::mutex> lk(m_tableWritersMutex);
+	shared_ptr<LogTableWriter>* writer = m_tableWriters.getPointer(tableName);
+	if (notNull(writer)) return *writer;
+
+	Array<shared_ptr<LogTableWriter>> writers;
+	for (const shared_ptr<LogSink>& sink : tableSinks(tableName)) {
+		writers.append(sink->tableWriter(tableName, columnCount));
+	}
+	const shared_ptr<LogTableWriter> newWriter = (writers.size() == 1) ? writers[0] : LogTableWriterGroup::create(writers);
+	m_tableWriters.set(tableName, newWriter);
+	return newWriter;
+}
+
+void FPSciLogger::beginBatch(bool includeShards) {
+	for (const String& sinkName : m_sinks.getKeys()) m_sinks[sinkName]->beginBatch();
+	if (!includeShards) return;
+	for (const String& tableName : m_shards.getKeys()) m_shards[tableName]->beginBatch();
+}
+
+void FPSciLogger::endBatch(bool includeShards) {
+	for (const String& sinkName : m_sinks.getKeys()) m_sinks[sinkName]->endBatch();
+	if (!includeShards) return;
+	for (const String& tableName : m_shards.getKeys()) m_shards[tableName]->endBatch();
+}
+
+void FPSciLogger::openShards(const String& filename) {
+	for (const String& tableName : m_config.shardedTables) {
+		if (m_shards.containsKey(tableName)) continue;
+		std::function<void()> write;
+		for (const TableJob& job : m_tableJobs) {
+			if (job.tableName == tableName) write = job.write;
+		}
+		if (!write) {
+			logPrintf("Unknown table \"%s\" in logShardedTables ignored!\n", tableName.c_str());
+			continue;
+		}
+
+		const shared_ptr<LogShard> shard = std::make_shared<LogShard>();
+		shard->tableName = tableName;
+		shard->filename = filename + "." + tableName + ".shard";
+		shard->write = write;
+		if (FileSystem::exists(shard->filename)) {
+			// Left over from a session that didn't close, don't merge those rows into this session
+			logPrintf("Removing stale logger shard file %s\n", shard->filename.c_str());
+			FileSystem::removeFile(shard->filename);
+		}
+		if (sqlite3_open(shard->filename.c_str(), &shard->db)) {
+			logPrintf("Error opening logger shard file %s, writing %s on the logging thread instead\n", shard->filename.c_str(), tableName.c_str());
+			sqlite3_close(shard->db);
+			continue;
+		}
+		applyPragmas(shard->db);
+
+		// The shard has its own copy of each of the table's sinks (so they are only used from the shard thread)
+		const String sinkFilePrefix = FilePath::concat(FilePath::parent(filename), FilePath::base(filename));
+		const Array<String>* sinkNames = m_config.tableSinks.getPointer(tableName);
+		for (const String& sinkName : notNull(sinkNames) ? *sinkNames : m_config.sinks) {
+			if (shard->sinks.containsKey(sinkName)) continue;
+			const shared_ptr<LogSink> sink = LogSink::create(sinkName, shard->db, sinkFilePrefix);
+			if (notNull(sink)) shard->sinks.set(sinkName, sink);
+		}
+		m_shards.set(tableName, shard);
+	}
+}
+
+void FPSciLogger::stopShards() {
+	for (const String& tableName : m_shards.getKeys()) {
+		LogShard* shard = m_shards[tableName].get();
+		{
+			std::lock_guard<std::mutex> lk(shard->mutex);
+			shard->running = false;
+		}
+		shard->cv.notify_all();
+		if (shard->thread.joinable()) shard->thread.join();
+	}
+}
+
+void FPSciLogger::mergeShards() {
+	for (const String& tableName : m_shards.getKeys()) {
+		const shared_ptr<LogShard> shard = m_shards[tableName];
+		const bool hasSqlite = shard->sinks.containsKey("sqlite");
+
+		// Close the shard (finalizing its statements and flushing its file sinks)
+		m_tableWriters.remove(tableName);
+		shard->sinks.clear();
+		sqlite3_close(shard->db);
+		shard->db = nullptr;
+
+		bool merged = true;
+		if (hasSqlite) {
+			const RealTime start = System::time();
+			String escapedFilename = shard->filename;
+			for (size_t pos = escapedFilename.find('\''); pos != String::npos; pos = escapedFilename.find('\'', pos + 2)) {
+				escapedFilename.insert(pos, "'");
+			}
+			merged = execStatementInDB(m_db, "ATTACH DATABASE '" + escapedFilename + "' AS shard;");
+			if (merged) {
+				beginTransactionInDB(m_db);
+				merged = execStatementInDB(m_db, "INSERT INTO main." + tableName + " SELECT * FROM shard." + tableName + ";");
+				commitTransactionInDB(m_db);
+				execStatementInDB(m_db, "DETACH DATABASE shard;");
+			}
+			logPrintf("Merged logger shard %s into the results file in %.3f ms\n", shard->filename.c_str(), 1000.0 * (System::time() - start));
+		}
+
+		if (merged) {
+			FileSystem::removeFile(shard->filename);
+		}
+		else {
+			logPrintf("Failed to merge logger shard %s, leaving it in place!\n", shard->filename.c_str());
+		}
+	}
+	m_shards.clear();
+}
+
+void FPSciLogger::migrateTextTimes(const String& tableName, const Columns& columns) {
+	bool hasIntegerTime = false;
+	for (const Array<String>& column : columns) hasIntegerTime = hasIntegerTime || (column[0] == "time" && column[1] == "integer");
+	if (!hasIntegerTime) return;
+	const Columns existing = tableColumnsInDB(m_db, tableName);
+	bool hasTextTime = false;
+	for (const Array<String>& column : existing) hasTextTime = hasTextTime || (column[0] == "time" && toLower(column[1]) == "text");
+	if (!hasTextTime) return;
+
+	// Copy the old rows into a table with the current schema. Old times are "YYYY-MM-DD hh:mm:ss.uuuuuu" (UTC), any rows
+	// appended by this version before the table was converted hold an integer stored as text.
+	const RealTime start = System::time();
+	const String legacyTableName = tableName + "_Legacy";
+	String columnNames;
+	String selectList;
+	int droppedColumns = 0;
+	for (const Array<String>& column : existing) {
+		bool current = false;
+		for (const Array<String>& c : columns) current = current || (c[0] == column[0]);
+		if (!current) {
+			droppedColumns++;
+			continue;
+		}
+		if (!columnNames.empty()) {
+			columnNames += ", ";
+			selectList += ", ";
+		}
+		columnNames += column[0];
+		if (column[0] == "time") {
+			selectList += "CASE WHEN time GLOB '[0-9][0-9][0-9][0-9]-*' "
+				"THEN CAST(strftime('%s', substr(time, 1, 19)) AS INTEGER) * 1000000000 + CAST(substr(time, 21, 6) AS INTEGER) * 1000 "
+				"ELSE CAST(time AS INTEGER) END";
+		}
+		else {
+			selectList += column[0];
+		}
+	}
+
+	// Keep the old table if some of its columns aren't in the current schema (rather than lose them)
+	beginTransactionInDB(m_db);
+	bool migrated = execStatementInDB(m_db, "DROP VIEW IF EXISTS " + tableName + "_Text_Time;") &&
+		execStatementInDB(m_db, "ALTER TABLE " + tableName + " RENAME TO " + legacyTableName + ";") &&
+		createTableInDB(m_db, tableName, columns) &&
+		execStatementInDB(m_db, "INSERT INTO " + tableName + " (" + columnNames + ") SELECT " + selectList + " FROM " + legacyTableName + ";") &&
+		(droppedColumns > 0 || execStatementInDB(m_db, "DROP TABLE " + legacyTableName + ";"));
+	if (migrated) {
+		commitTransactionInDB(m_db);
+		logPrintf("Converted the text times in %s to integer ns in %.3f ms%s\n", tableName.c_str(), 1000.0 * (System::time() - start),
+			droppedColumns > 0 ? format(" (the original rows are kept in %s)", legacyTableName.c_str()).c_str() : "");
+		return;
+	}
+
+	// Don't mix the two time formats, set the old rows aside unconverted so the table is created again with the current schema
+	execStatementInDB(m_db, "ROLLBACK TRANSACTION;");
+	if (execStatementInDB(m_db, "DROP VIEW IF EXISTS " + tableName + "_Text_Time;") &&
+		execStatementInDB(m_db, "ALTER TABLE " + tableName + " RENAME TO " + legacyTableName + ";")) {
+		logPrintf("Couldn't convert the text times in %s, its original rows were moved to %s\n", tableName.c_str(), legacyTableName.c_str());
+	}
+	else {
+		logPrintf("Couldn't convert or move the text times in %s, new rows will be mixed with them!\n", tableName.c_str());
+	}
+}
+
+void FPSciLogger::createTextTimeView(const String& tableName, const Columns& columns) {
+	if (!m_config.logTextTimeViews) return;
+	bool hasTime = false;
+	for (const Array<String>& column : columns) hasTime = hasTime || (column[0] == "time" && column[1] == "integer");
+	if (!hasTime) return;
+	String selectList;
+	for (const Array<String>& column : columns) {
+		if (!selectList.empty()) selectList += ", ";
+		if (column[0] == "time") {
+			// Matches the format from formatTime()
+			selectList += "strftime('%Y-%m-%d %H:%M:%S', time / 1000000000, 'unixepoch') || printf('.%06d', (time / 1000) % 1000000) AS time";
+		}
+		else {
+			selectList += column[0];
+		}
+	}
+	execStatementInDB(m_db, "CREATE VIEW IF NOT EXISTS " + tableName + "_Text_Time AS SELECT " + selectList + " FROM " + tableName + ";");
 }
 
 void FPSciLogger::createExperimentsTable(const String& expConfigFilename) {
@@ -113,7 +493,6 @@ void FPSciLogger::createExperimentsTable(const String& expConfigFilename) {
 	};
 	insertRowIntoDB(m_db, "Experiments", expRow);
 
-	//writeToFile(R"(results\CSVFailsafe)", "Experiments.csv", expRow);
 }
 
 void FPSciLogger::createSessionsTable(const shared_ptr<SessionConfig>& sessConfig) {
@@ -164,39 +543,39 @@ void FPSciLogger::createTargetTypeTable() {
 		{ "jump_enabled", "boolean" },
 		{ "model_file", "text" }
 	};
-	createTableInDB(m_db, "Target_Types", targetTypeColumns); // Primary Key needed for this table.
+	createTable("Target_Types", targetTypeColumns); // Primary Key needed for this table.
 }
 
 // Log target parameters into Target_Types table
 void FPSciLogger::logTargetTypes(const Array<shared_ptr<TargetConfig>>& targets) {
-	Array<RowEntry> rows;
-	for (auto config : targets) {
-		const String type = (config->destinations.size() > 0) ? "waypoint" : "parametrized";
+	for (const shared_ptr<TargetConfig>& config : targets) {
+		addToQueue(m_targetTypes, config);
+	}
+}
+
+void FPSciLogger::recordTargetTypes(const Array<shared_ptr<TargetConfig>>& targetTypes) {
+	const shared_ptr<LogTableWriter> writer = tableWriter("Target_Types", 17);
+	for (const shared_ptr<TargetConfig>& config : targetTypes) {
 		const String modelName = config->modelSpec["filename"];
-		const RowEntry targetTypeRow = {
-			"'" + config->id + "'",
-			"'" + type + "'",
-			"'" + config->destSpace + "'",
-			String(std::to_string(config->size[0])),
-			String(std::to_string(config->size[1])),
-			config->symmetricEccH ? "true" : "false",
-			config->symmetricEccV ? "true" : "false",
-			String(std::to_string(config->eccH[0])),
-			String(std::to_string(config->eccH[1])),
-			String(std::to_string(config->eccV[0])),
-			String(std::to_string(config->eccV[1])),
-			String(std::to_string(config->speed[0])),
-			String(std::to_string(config->speed[1])),
-			String(std::to_string(config->motionChangePeriod[0])),
-			String(std::to_string(config->motionChangePeriod[1])),
-			config->jumpEnabled ? "true" : "false",
-			"'" + modelName + "'"
-		};
-		rows.append(targetTypeRow);
-	}
-	insertRowsIntoDB(m_db, "Target_Types", rows);
-	/*for (RowEntry rowData : rows)
-		writeToFile(R"(results\CSVFailsafe)", "TargetTypes.csv", rowData);*/
+		writer->bind(0, config->id);
+		writer->bind(1, (config->destinations.size() > 0) ? "waypoint" : "parametrized");
+		writer->bind(2, config->destSpace);
+		writer->bind(3, config->size[0]);
+		writer->bind(4, config->size[1]);
+		writer->bind(5, config->symmetricEccH);
+		writer->bind(6, config->symmetricEccV);
+		writer->bind(7, config->eccH[0]);
+		writer->bind(8, config->eccH[1]);
+		writer->bind(9, config->eccV[0]);
+		writer->bind(10, config->eccV[1]);
+		writer->bind(11, config->speed[0]);
+		writer->bind(12, config->speed[1]);
+		writer->bind(13, config->motionChangePeriod[0]);
+		writer->bind(14, config->motionChangePeriod[1]);
+		writer->bind(15, config->jumpEnabled);
+		writer->bind(16, modelName);
+		writer->insertRow();
+	}
 }
 
 void FPSciLogger::createTargetsTable() {
@@ -209,20 +588,30 @@ void FPSciLogger::createTargetsTable() {
 		{ "spawn_ecc_h", "real"},
 		{ "spawn_ecc_v", "real"},
 	};
-	createTableInDB(m_db, "Targets", targetColumns);
+	createTable("Targets", targetColumns);
 }
 
 void FPSciLogger::addTarget(const String& name, const shared_ptr<TargetConfig>& config, const String& spawnTime, const float& size, const Point2& spawnEcc) {
-	const RowEntry targetValues = {
-		"'" + name + "'",
-		"'" + config->id + "'",
-		"'" + spawnTime + "'",
-		String(std::to_string(size)),
-		String(std::to_string(spawnEcc.x)),
-		String(std::to_string(spawnEcc.y)),
-	};
+	TargetInfo targetValues;
+	targetValues.name = name;
+	targetValues.typeId = config->id;
+	targetValues.spawnTime = spawnTime;
+	targetValues.size = size;
+	targetValues.spawnEcc = spawnEcc;
 	logTargetInfo(targetValues);
-	//writeToFile(R"(results\CSVFailsafe)", "TargetInfos.csv", targetValues);
+}
+
+void FPSciLogger::recordTargets(const Array<TargetInfo>& targets) {
+	const shared_ptr<LogTableWriter> writer = tableWriter("Targets", 6);
+	for (const TargetInfo& target : targets) {
+		writer->bind(0, target.name);
+		writer->bind(1, target.typeId);
+		writer->bind(2, target.spawnTime);
+		writer->bind(3, target.size);
+		writer->bind(4, target.spawnEcc.x);
+		writer->bind(5, target.spawnEcc.y);
+		writer->insertRow();
+	}
 }
 
 void FPSciLogger::createTrialsTable() {
@@ -239,45 +628,56 @@ void FPSciLogger::createTrialsTable() {
 		{ "destroyed_targets", "integer" },
 		{ "total_targets", "integer" }
 	};
-	createTableInDB(m_db, "Trials", trialColumns);
+	createTable("Trials", trialColumns);
+}
+
+void FPSciLogger::recordTrials(const Array<TrialValues>& trials) {
+	const shared_ptr<LogTableWriter> writer = tableWriter("Trials", 10);
+	for (const TrialValues& trial : trials) {
+		writer->bind(0, trial.sessionId);
+		writer->bind(1, trial.trialId);
+		writer->bind(2, trial.trialIndex);
+		writer->bind(3, format("Block %d", trial.blockId));
+		writer->bind(4, trial.startTime);
+		writer->bind(5, trial.endTime);
+		writer->bind(6, trial.pretrialDuration);
+		writer->bind(7, trial.taskExecutionTime);
+		writer->bind(8, trial.destroyedTargets);
+		writer->bind(9, trial.totalTargets);
+		writer->insertRow();
+	}
 }
 
 void FPSciLogger::createTargetTrajectoryTable() {
 	// Target_Trajectory, only need to create the table.
 	Columns targetTrajectoryColumns = {
-		{ "time", "text" },
+		{ "time", "integer" },
 		{ "target_id", "text"},
 		{ "state", "text"},
 		{ "position_x", "real" },
 		{ "position_y", "real" },
 		{ "position_z", "real" },
 	};
-	createTableInDB(m_db, "Target_Trajectory", targetTrajectoryColumns);
+	createTable("Target_Trajectory", targetTrajectoryColumns);
 }
 
 void FPSciLogger::recordTargetLocations(const Array<TargetLocation>& locations) {
-	Array<RowEntry> rows;
-	for (const auto& loc : locations) {
-		String stateStr = presentationStateToString(loc.state);
-		Array<String> targetTrajectoryValues = {
-			"'" + FPSciLogger::formatFileTime(loc.time) + "'",
-			"'" + loc.name + "'",
-			"'" + stateStr + "'",
-			String(std::to_string(loc.position.x)),
-			String(std::to_string(loc.position.y)),
-			String(std::to_string(loc.position.z)),
-		};
-		rows.append(targetTrajectoryValues);
-	}
-	insertRowsIntoDB(m_db, "Target_Trajectory", rows);
-	/*for (RowEntry rowData : rows)
-		writeToFile(R"(results\CSVFailsafe)", "TargetTrajectories.csv", rowData);*/
+	const shared_ptr<LogTableWriter> writer = tableWriter("Target_Trajectory", 6);
+	for (const TargetLocation& loc : locations) {
+		writer->bind(0, loc.time);
+		writer->bind(1, loc.name);
+		writer->bind(2, presentationStateToString(loc.state));
+		writer->bind(3, loc.position.x);
+		writer->bind(4, loc.position.y);
+		writer->bind(5, loc.position.z);
+		writer->insertRow();
+	}
 }
 
 void FPSciLogger::createPlayerActionTable() {
 	// Player_Action table
 	Columns viewTrajectoryColumns = {
-		{ "time", "text" },
+		{ "time", "integer" },
 		{ "position_az", "real" },
 		{ "position_el", "real" },
 		{ "position_x", "real"},
@@ -287,46 +687,29 @@ void FPSciLogger::createPlayerActionTable() {
 		{ "event", "text" },
 		{ "target_id", "text" },
 	};
-	createTableInDB(m_db, "Player_Action", viewTrajectoryColumns);
+	createTable("Player_Action", viewTrajectoryColumns);
 }
 
 void FPSciLogger::recordPlayerActions(const Array<PlayerAction>& actions) {
-	Array<RowEntry> rows;
-	for (PlayerAction action : actions) {
-		String stateStr = presentationStateToString(action.state);
-
-		String actionStr = "";
-		switch (action.action) {
-			case FireCooldown: actionStr = "fireCooldown"; break;
-			case Aim: actionStr = "aim"; break;
-			case Miss: actionStr = "miss"; break;
-			case Hit: actionStr = "hit"; break;
-			case Destroy: actionStr = "destroy"; break;
-			case Move: actionStr = "move"; break;
-		}
-
-		Array<String> playerActionValues = {
-		"'" + FPSciLogger::formatFileTime(action.time) + "'",
-		String(std::to_string(action.viewDirection.x)),
-		String(std::to_string(action.viewDirection.y)),
-		String(std::to_string(action.position.x)),
-		String(std::to_string(action.position.y)),
-		String(std::to_string(action.position.z)),
-		"'" + stateStr + "'",
-		"'" + actionStr + "'",
-		"'" + action.targetName + "'",
-		};
-		rows.append(playerActionValues);
-	}
-	insertRowsIntoDB(m_db, "Player_Action", rows); 
-	/*for (RowEntry rowData : rows)
-		writeToFile(R"(results\CSVFailsafe)", "PlayerActions.csv", rowData);*/
+	const shared_ptr<LogTableWriter> writer = tableWriter("Player_Action", 9);
+	for (const PlayerAction& action : actions) {
+		writer->bind(0, action.time);
+		writer->bind(1, action.viewDirection.x);
+		writer->bind(2, action.viewDirection.y);
+		writer->bind(3, action.position.x);
+		writer->bind(4, action.position.y);
+		writer->bind(5, action.position.z);
+		writer->bind(6, presentationStateToString(action.state));
+		writer->bind(7, playerActionTypeToString(action.action));
+		writer->bind(8, action.targetName);
+		writer->insertRow();
+	}
 }
 
 void FPSciLogger::createRemotePlayerActionTable() {
 	// Player_Action table
 	Columns viewTrajectoryColumns = {
-		{ "time", "text" },
+		{ "time", "integer" },
 		{ "position_az", "real" },
 		{ "position_el", "real" },
 		{ "position_x", "real"},
@@ -337,48 +720,31 @@ void FPSciLogger::createRemotePlayerActionTable() {
 		{ "actor_id", "text" },
 		{ "affected_id", "text"},
 	};
-	createTableInDB(m_db, "Remote_Player_Action", viewTrajectoryColumns);
+	createTable("Remote_Player_Action", viewTrajectoryColumns);
 }
 
 void FPSciLogger::recordRemotePlayerActions(const Array<RemotePlayerAction>& actions) {
-	Array<RowEntry> rows;
-	for (RemotePlayerAction action : actions) {
-		String stateStr = presentationStateToString(action.state);
-
-		String actionStr = "";
-		switch (action.action) {
-		case FireCooldown: actionStr = "fireCooldown"; break;
-		case Aim: actionStr = "aim"; break;
-		case Miss: actionStr = "miss"; break;
-		case Hit: actionStr = "hit"; break;
-		case Destroy: actionStr = "destroy"; break;
-		case Move: actionStr = "move"; break;
-		}
-
-		Array<String> playerActionValues = {
-		"'" + FPSciLogger::formatFileTime(action.time) + "'",
-		String(std::to_string(action.viewDirection.x)),
-		String(std::to_string(action.viewDirection.y)),
-		String(std::to_string(action.position.x)),
-		String(std::to_string(action.position.y)),
-		String(std::to_string(action.position.z)),
-		"'" + stateStr + "'",
-		"'" + actionStr + "'",
-		"'" + action.actorID + "'",
-		"'" + action.affectedID + "'",
-		};
-		rows.append(playerActionValues);
-	}
-	insertRowsIntoDB(m_db, "Remote_Player_Action", rows);
-	/*for (RowEntry rowData : rows)
-		writeToFile(R"(results\CSVFailsafe)", "RemotePlayerActions.csv", rowData);*/
+	const shared_ptr<LogTableWriter> writer = tableWriter("Remote_Player_Action", 10);
+	for (const RemotePlayerAction& action : actions) {
+		writer->bind(0, action.time);
+		writer->bind(1, action.viewDirection.x);
+		writer->bind(2, action.viewDirection.y);
+		writer->bind(3, action.position.x);
+		writer->bind(4, action.position.y);
+		writer->bind(5, action.position.z);
+		writer->bind(6, presentationStateToString(action.state));
+		writer->bind(7, playerActionTypeToString(action.action));
+		writer->bind(8, guidToString(action.actorID));
+		writer->bind(9, guidToString(action.affectedID));
+		writer->insertRow();
+	}
 }
 
 
 void FPSciLogger::createFrameInfoTable() {
 	// Frame_Info table
 	Columns frameInfoColumns = {
-		{"time", "text"},
+		{"time", "integer"},
 		//{"idt", "real"},
 		{"sdt", "real"},
 		{"network_RTT", "real"},
@@ -386,32 +752,27 @@ void FPSciLogger::createFrameInfoTable() {
 		{"remote_frame", "real"},
 		{"client_guid", "text"},
 	};
-	createTableInDB(m_db, "Frame_Info", frameInfoColumns);
+	createTable("Frame_Info", frameInfoColumns);
 }
 
 void FPSciLogger::recordFrameInfo(const Array<FrameInfo>& frameInfo) {
-	Array<RowEntry> rows;
-	for (FrameInfo info : frameInfo) {
-		Array<String> frameValues = {
-			"'" + FPSciLogger::formatFileTime(info.time) + "'",
-			//String(std::to_string(info.idt)),
-			String(std::to_string(info.sdt)),
-			String(std::to_string(info.network_RTT)),
-			String(std::to_string(info.local_frame)),
-			String(std::to_string(info.remote_frame)),
-			"'" + info.guid + "'"
-		};
-		rows.append(frameValues);
-	}
-	insertRowsIntoDB(m_db, "Frame_Info", rows);
-	/*for (RowEntry rowData : rows)
-		writeToFile(R"(results\CSVFailsafe)", "FrameInfos.csv", rowData);*/
+	const shared_ptr<LogTableWriter> writer = tableWriter("Frame_Info", 6);
+	for (const FrameInfo& info : frameInfo) {
+		writer->bind(0, info.time);
+		//writer->bind(1, info.idt);
+		writer->bind(1, info.sdt);
+		writer->bind(2, info.network_RTT);
+		writer->bind(3, info.local_frame);
+		writer->bind(4, info.remote_frame);
+		writer->bind(5, guidToString(info.clientID));
+		writer->insertRow();
+	}
 }
 
 void FPSciLogger::createQuestionsTable() {
 	// Questions table
 	Columns questionColumns = {
-		{"time", "text"},
+		{"time", "integer"},
 		{"session_id", "text"},
 		{"question", "text"},
 		{"response_array", "text"},
@@ -419,28 +780,37 @@ void FPSciLogger::createQuestionsTable() {
 		{"presented_responses", "text"},
 		{"response", "text"}
 	};
-	createTableInDB(m_db, "Questions", questionColumns);
+	createTable("Questions", questionColumns);
+}
+
+static bool questionHasPresentedOrder(const Question& q) {
+	return q.type == Question::Type::MultipleChoice || q.type == Question::Type::Rating;
 }
 
 void FPSciLogger::addQuestion(Question q, String session, const shared_ptr<DialogBase>& dialog) {
-	const String time = genUniqueTimestamp();
-	const String optStr = Any(q.options).unparse();
-	const String keyStr = Any(q.optionKeys).unparse();
-	String orderStr = "";
-	if (q.type == Question::Type::MultipleChoice || q.type == Question::Type::Rating) {
-		orderStr = Any(dynamic_pointer_cast<SelectionDialog>(dialog)->options()).unparse();
-	}
-	RowEntry rowContents = {
-		"'" + time + "'",
-		"'" + session + "'",
-		"'" + q.prompt + "'",
-		"'" + optStr + "'",
-		"'" + keyStr + "'",
-		"'" + orderStr + "'",
-		"'" + q.result + "'"
-	};
-	logQuestionResult(rowContents);
-	//writeToFile(R"(results\CSVFailsafe)", "QuestionResults.csv", rowContents);
+	QuestionResult result;
+	result.time = getTime();
+	result.sessionId = session;
+	result.question = q;
+	if (questionHasPresentedOrder(q)) {
+		result.presentedOptions = dynamic_pointer_cast<SelectionDialog>(dialog)->options();
+	}
+	logQuestionResult(result);
+}
+
+void FPSciLogger::recordQuestions(const Array<QuestionResult>& questions) {
+	const shared_ptr<LogTableWriter> writer = tableWriter("Questions", 7);
+	for (const QuestionResult& result : questions) {
+		const Question& q = result.question;
+		writer->bind(0, result.time);
+		writer->bind(1, result.sessionId);
+		writer->bind(2, q.prompt);
+		writer->bind(3, Any(q.options).unparse());
+		writer->bind(4, Any(q.optionKeys).unparse());
+		writer->bind(5, questionHasPresentedOrder(q) ? Any(result.presentedOptions).unparse() : String(""));
+		writer->bind(6, q.result);
+		writer->insertRow();
+	}
 }
 
 void FPSciLogger::createUsersTable() {
@@ -448,7 +818,7 @@ void FPSciLogger::createUsersTable() {
 	Columns userColumns = {
 		{"subject_id", "text"},
 		{"session_id", "text"},
-		{"time", "text"},
+		{"time", "integer"},
 		{"cmp360", "real"},
 		{"mouse_deg_per_mm", "real"},
 		{"mouse_dpi", "real"},
@@ -465,45 +835,60 @@ void FPSciLogger::createUsersTable() {
 		{"sensitivity_x", "real"},
 		{"sensitivity_y", "real"}
 	};	
-	createTableInDB(m_db, "Users", userColumns);
+	createTable("Users", userColumns);
 }
 
 void FPSciLogger::logUserConfig(const UserConfig& user, const String& sessId, const Vector2& sessTurnScale) {
 	if (!m_config.logUsers) return;
+	UserValues row;
+	row.subjectId = user.id;
+	row.sessionId = sessId;
+	row.time = getTime();
+	row.cmp360 = 36.f / (float)user.mouseDegPerMm;
+	row.mouseDegPerMm = user.mouseDegPerMm;
+	row.mouseDPI = user.mouseDPI;
+	row.reticleIndex = user.reticle.index;
+	row.reticleScale[0] = user.reticle.scale[0];
+	row.reticleScale[1] = user.reticle.scale[1];
+	row.reticleColor[0] = user.reticle.color[0];
+	row.reticleColor[1] = user.reticle.color[1];
+	row.reticleChangeTimeS = user.reticle.changeTimeS;
 	// Collapse Y-inversion into per-user turn scale (no need to complicate the log)
-	const float userYTurnScale = user.invertY ? -user.turnScale.y : user.turnScale.y;
-	const float cmp360 = 36.f / (float)user.mouseDegPerMm;
-	const Vector2 sensitivity = cmp360 * user.turnScale * sessTurnScale;
-	const String time = genUniqueTimestamp();
-
-	RowEntry row = {
-		"'" + user.id + "'",
-		"'" + sessId + "'",
-		"'" + time + "'",
-		String(std::to_string(cmp360)),
-		String(std::to_string(user.mouseDegPerMm)),
-		String(std::to_string(user.mouseDPI)),
-		String(std::to_string(user.reticle.index)),
-		String(std::to_string(user.reticle.scale[0])),
-		String(std::to_string(user.reticle.scale[1])),
-		"'" + user.reticle.color[0].toString() + "'",
-		"'" + user.reticle.color[1].toString() + "'",
-		String(std::to_string(user.reticle.changeTimeS)),
-		String(std::to_string(user.turnScale.x)),
-		String(std::to_string(userYTurnScale)),
-		String(std::to_string(sessTurnScale.x)),
-		String(std::to_string(sessTurnScale.y)),
-		String(std::to_string(sensitivity.x)),
-		String(std::to_string(sensitivity.y))
-	};
-	m_users.append(row);
-	//writeToFile(R"(results\CSVFailsafe)", "UserConfig.csv", row);
+	row.userTurnScale = Vector2(user.turnScale.x, user.invertY ? -user.turnScale.y : user.turnScale.y);
+	row.sessTurnScale = sessTurnScale;
+	row.sensitivity = row.cmp360 * user.turnScale * sessTurnScale;
+	addToQueue(m_users, row);
+}
+
+void FPSciLogger::recordUsers(const Array<UserValues>& users) {
+	const shared_ptr<LogTableWriter> writer = tableWriter("Users", 18);
+	for (const UserValues& user : users) {
+		writer->bind(0, user.subjectId);
+		writer->bind(1, user.sessionId);
+		writer->bind(2, user.time);
+		writer->bind(3, user.cmp360);
+		writer->bind(4, user.mouseDegPerMm);
+		writer->bind(5, user.mouseDPI);
+		writer->bind(6, user.reticleIndex);
+		writer->bind(7, user.reticleScale[0]);
+		writer->bind(8, user.reticleScale[1]);
+		writer->bind(9, user.reticleColor[0].toString());
+		writer->bind(10, user.reticleColor[1].toString());
+		writer->bind(11, user.reticleChangeTimeS);
+		writer->bind(12, user.userTurnScale.x);
+		writer->bind(13, user.userTurnScale.y);
+		writer->bind(14, user.sessTurnScale.x);
+		writer->bind(15, user.sessTurnScale.y);
+		writer->bind(16, user.sensitivity.x);
+		writer->bind(17, user.sensitivity.y);
+		writer->insertRow();
+	}
 }
 
 void FPSciLogger::createNetworkedClientTable() {
 	// Player_Action table
 	Columns clientColumns = {
-		{ "time", "text" },
+		{ "time", "integer" },
 		{ "local_frame", "real"},
 		{ "remote_frame", "real"},
 		{ "position_az", "real" },
@@ -515,48 +900,191 @@ void FPSciLogger::createNetworkedClientTable() {
 		{ "state", "text" },
 		{ "player_id", "text" },
 	};
-	createTableInDB(m_db, "Client_States", clientColumns);
+	createTable("Client_States", clientColumns);
 }
 
 void FPSciLogger::recordNetworkedClients(const Array<NetworkedClient>& clients) {
-	Array<RowEntry> rows;
-	for (const NetworkedClient client : clients) {
-
-		String stateStr = presentationStateToString(client.state);
-
-		String actionStr = "";
-		switch (client.action) {
-		case FireCooldown: actionStr = "fireCooldown"; break;
-		case Aim: actionStr = "aim"; break;
-		case Miss: actionStr = "miss"; break;
-		case Hit: actionStr = "hit"; break;
-		case Destroy: actionStr = "destroy"; break;
-		case Move: actionStr = "move"; break;
-		}
-
-		Array<String> networkedClientValues = {
-		"'" + FPSciLogger::formatFileTime(client.time) + "'",
-		String(std::to_string(client.localFrame)),
-		String(std::to_string(client.remoteFrame)),
-		String(std::to_string(client.viewDirection.x)),
-		String(std::to_string(client.viewDirection.y)),
-		String(std::to_string(client.position.x)),
-		String(std::to_string(client.position.y)),
-		String(std::to_string(client.position.z)),
-		"'" + actionStr + "'",
-		"'" + stateStr + "'",
-		"'" + client.playerID.toString16() + "'",
-		};
-		rows.append(networkedClientValues);
-	}
-	insertRowsIntoDB(m_db, "Client_States", rows);
-	/*for (RowEntry rowData : rows)
-		writeToFile(R"(results\CSVFailsafe)", "ClientStates.csv", rowData);*/
+	const shared_ptr<LogTableWriter> writer = tableWriter("Client_States", 11);
+	for (const NetworkedClient& client : clients) {
+		writer->bind(0, client.time);
+		writer->bind(1, client.localFrame);
+		writer->bind(2, client.remoteFrame);
+		writer->bind(3, client.viewDirection.x);
+		writer->bind(4, client.viewDirection.y);
+		writer->bind(5, client.position.x);
+		writer->bind(6, client.position.y);
+		writer->bind(7, client.position.z);
+		writer->bind(8, playerActionTypeToString(client.action));
+		writer->bind(9, presentationStateToString(client.state));
+		writer->bind(10, client.playerID.toString16());
+		writer->insertRow();
+	}
+}
+
+void FPSciLogger::createSnapshotStatsTable() {
+	Columns statsColumns = {
+		{ "time", "integer" },
+		{ "player_id", "text" },
+		{ "state", "text" },
+		{ "snapshots", "integer" },
+		{ "full_snapshots", "integer" },
+		{ "bytes_sent", "integer" },
+		{ "full_bytes", "integer" },
+		{ "entities_sent", "integer" },
+		{ "entities_total", "integer" },
+		{ "entities_relevant", "integer" },
+		{ "entities_deferred", "integer" },
+	};
+	createTable("Snapshot_Stats", statsColumns);
+}
+
+void FPSciLogger::recordSnapshotStats(const Array<SnapshotStats>& stats) {
+	const shared_ptr<LogTableWriter> writer = tableWriter("Snapshot_Stats", 11);
+	for (const SnapshotStats& row : stats) {
+		writer->bind(0, row.time);
+		writer->bind(1, row.playerID.toString16());
+		writer->bind(2, presentationStateToString(row.state));
+		writer->bind(3, row.snapshots);
+		writer->bind(4, row.fullSnapshots);
+		writer->bind(5, row.bytesSent);
+		writer->bind(6, row.fullBytes);
+		writer->bind(7, row.entitiesSent);
+		writer->bind(8, row.entitiesTotal);
+		writer->bind(9, row.entitiesRelevant);
+		writer->bind(10, row.entitiesDeferred);
+		writer->insertRow();
+	}
+}
+
+void FPSciLogger::createInterpolationStatsTable() {
+	Columns statsColumns = {
+		{ "time", "integer" },
+		{ "interpolated", "integer" },
+		{ "extrapolated", "integer" },
+		{ "held", "integer" },
+		{ "delay_ms", "real" },
+		{ "max_extrapolation_ms", "real" },
+	};
+	createTable("Interpolation_Stats", statsColumns);
+}
+
+void FPSciLogger::recordInterpolationStats(const Array<InterpolationStats>& stats) {
+	const shared_ptr<LogTableWriter> writer = tableWriter("Interpolation_Stats", 6);
+	for (const InterpolationStats& row : stats) {
+		writer->bind(0, row.time);
+		writer->bind(1, row.interpolated);
+		writer->bind(2, row.extrapolated);
+		writer->bind(3, row.held);
+		writer->bind(4, row.delayMs);
+		writer->bind(5, row.maxExtrapolationMs);
+		writer->insertRow();
+	}
+}
+
+void FPSciLogger::createHitValidationTable() {
+	Columns validationColumns = {
+		{ "time", "integer" },
+		{ "shooter_id", "text" },
+		{ "target_id", "text" },
+		{ "server_frame", "integer" },
+		{ "view_frame", "real" },
+		{ "tested_frame", "real" },
+		{ "rewind_ms", "real" },
+		{ "clamped", "boolean" },
+		{ "miss_distance", "real" },
+		{ "result", "text" },
+		{ "cost_us", "real" },
+	};
+	createTable("Hit_Validation", validationColumns);
+}
+
+void FPSciLogger::recordHitValidations(const Array<HitValidation>& validations) {
+	const shared_ptr<LogTableWriter> writer = tableWriter("Hit_Validation", 11);
+	for (const HitValidation& row : validations) {
+		writer->bind(0, row.time);
+		writer->bind(1, row.shooterID.toString16());
+		writer->bind(2, row.targetID.toString16());
+		writer->bind(3, row.serverFrame);
+		writer->bind(4, row.viewFrame);
+		writer->bind(5, row.testedFrame);
+		writer->bind(6, row.rewindMs);
+		writer->bind(7, row.clamped);
+		writer->bind(8, row.missDistance);
+		writer->bind(9, row.result);
+		writer->bind(10, row.costUs);
+		writer->insertRow();
+	}
+}
+
+void FPSciLogger::createPredictionCorrectionsTable() {
+	Columns correctionColumns = {
+		{ "time", "integer" },
+		{ "sequence", "integer" },
+		{ "server_frame", "integer" },
+		{ "position_error", "real" },
+		{ "replayed", "integer" },
+		{ "round_trip_ms", "real" },
+		{ "cost_us", "real" },
+	};
+	createTable("Prediction_Corrections", correctionColumns);
+}
+
+void FPSciLogger::recordPredictionCorrections(const Array<PredictionCorrection>& corrections) {
+	const shared_ptr<LogTableWriter> writer = tableWriter("Prediction_Corrections", 7);
+	for (const PredictionCorrection& row : corrections) {
+		writer->bind(0, row.time);
+		writer->bind(1, row.sequence);
+		writer->bind(2, row.serverFrame);
+		writer->bind(3, row.positionError);
+		writer->bind(4, row.replayed);
+		writer->bind(5, row.roundTripMs);
+		writer->bind(6, row.costUs);
+		writer->insertRow();
+	}
+}
+
+void FPSciLogger::createImpairmentsTable() {
+	Columns impairmentColumns = {
+		{ "time", "integer" },
+		{ "destination", "text" },
+		{ "packet_type", "integer" },
+		{ "reliable", "boolean" },
+		{ "bytes", "integer" },
+		{ "action", "text" },
+		{ "burst_state", "boolean" },
+		{ "reordered", "boolean" },
+		{ "delay_ms", "real" },
+		{ "jitter_ms", "real" },
+		{ "queue_ms", "real" },
+		{ "sequence", "integer" },
+	};
+	createTable("Network_Impairments", impairmentColumns);
+}
+
+void FPSciLogger::recordImpairments(const Array<ImpairmentRecord>& records) {
+	const shared_ptr<LogTableWriter> writer = tableWriter("Network_Impairments", 12);
+	for (const ImpairmentRecord& row : records) {
+		char ip[16];
+		enet_address_get_host_ip(&row.destination, ip, 16);
+		writer->bind(0, row.time);
+		writer->bind(1, format("%s:%d", ip, row.destination.port));
+		writer->bind(2, (int)row.packetType);
+		writer->bind(3, row.reliable);
+		writer->bind(4, row.bytes);
+		writer->bind(5, ImpairmentRecord::actionToString(row.action));
+		writer->bind(6, row.burst);
+		writer->bind(7, row.reordered);
+		writer->bind(8, row.delayMs);
+		writer->bind(9, row.jitterMs);
+		writer->bind(10, row.queueMs);
+		writer->bind(11, (int64)row.sequence);
+		writer->insertRow();
+	}
 }
 
 void FPSciLogger::createPlayerConfigTable() {
 	Columns playerColumns = {
-		{"time", "text"},
+		{"time", "integer"},
 		{"trial_id", "real"},
 		{"player_id", "text"},
 		{"moveRate", "real"},
@@ -577,110 +1105,141 @@ void FPSciLogger::createPlayerConfigTable() {
 		{"cornerPositionZ", "real"},
 		{"defenderRandomDisplacementAngle", "real"},
 	};
-	createTableInDB(m_db, "PlayerConfigs", playerColumns);
+	createTable("PlayerConfigs", playerColumns);
 }
 
 void FPSciLogger::logPlayerConfig(const PlayerConfig& playerConfig, const GUniqueID& id, int trialNumber) {
-	const String time = genUniqueTimestamp();
-	/*Any emptyAny = Any(Any::TABLE);
-	emptyAny = playerConfig.addToAny(emptyAny);*/
-
-	RowEntry row = {
-		"'" + time + "'",
-		String(std::to_string(trialNumber)),
-		"'" + id.toString16() + "'",
-		String(std::to_string(playerConfig.moveRate)),
-		String(std::to_string(playerConfig.respawnPos.x)),
-		String(std::to_string(playerConfig.respawnPos.y)),
-		String(std::to_string(playerConfig.respawnPos.z)),
-		String(std::to_string(playerConfig.respawnHeading)),
-		String(std::to_string(playerConfig.movementRestrictionX)),
-		String(std::to_string(playerConfig.movementRestrictionZ)),
-		String(std::to_string(playerConfig.restrictedMovementEnabled)),
-		String(std::to_string(playerConfig.restrictionBoxAngle)),
-		String(std::to_string(playerConfig.counterStrafing)),
-		String(std::to_string(playerConfig.selectedClientIdx)),
-		"'" + playerConfig.playerType + "'",
-		String(std::to_string(playerConfig.clientLatency)),
-		String(std::to_string(playerConfig.cornerPosition.x)),
-		String(std::to_string(playerConfig.cornerPosition.y)),
-		String(std::to_string(playerConfig.cornerPosition.z)),
-		String(std::to_string(playerConfig.defenderRandomDisplacementAngle)),
-	};
-	m_playerConfigs.append(row);
-	//writeToFile(R"(results\CSVFailsafe)","PlayerConfigs.csv", row);
+	PlayerValues row;
+	row.time = getTime();
+	row.trialNumber = trialNumber;
+	row.playerID = id;
+	row.moveRate = playerConfig.moveRate;
+	row.respawnPos = playerConfig.respawnPos;
+	row.respawnHeading = playerConfig.respawnHeading;
+	row.movementRestrictionX = playerConfig.movementRestrictionX;
+	row.movementRestrictionZ = playerConfig.movementRestrictionZ;
+	row.restrictedMovementEnabled = playerConfig.restrictedMovementEnabled;
+	row.restrictionBoxAngle = playerConfig.restrictionBoxAngle;
+	row.counterStrafing = playerConfig.counterStrafing;
+	row.selectedClientIdx = playerConfig.selectedClientIdx;
+	row.playerType = playerConfig.playerType;
+	row.clientLatency = playerConfig.clientLatency;
+	row.cornerPosition = playerConfig.cornerPosition;
+	row.defenderRandomDisplacementAngle = playerConfig.defenderRandomDisplacementAngle;
+	addToQueue(m_playerConfigs, row);
 }
 
+void FPSciLogger::recordPlayerConfigs(const Array<PlayerValues>& playerConfigs) {
+	const shared_ptr<LogTableWriter> writer = tableWriter("PlayerConfigs", 20);
+	for (const PlayerValues& player : playerConfigs) {
+		writer->bind(0, player.time);
+		writer->bind(1, player.trialNumber);
+		writer->bind(2, player.playerID.toString16());
+		writer->bind(3, player.moveRate);
+		writer->bind(4, player.respawnPos.x);
+		writer->bind(5, player.respawnPos.y);
+		writer->bind(6, player.respawnPos.z);
+		writer->bind(7, player.respawnHeading);
+		writer->bind(8, player.movementRestrictionX);
+		writer->bind(9, player.movementRestrictionZ);
+		writer->bind(10, player.restrictedMovementEnabled);
+		writer->bind(11, player.restrictionBoxAngle);
+		writer->bind(12, player.counterStrafing);
+		writer->bind(13, player.selectedClientIdx);
+		writer->bind(14, player.playerType);
+		writer->bind(15, player.clientLatency);
+		writer->bind(16, player.cornerPosition.x);
+		writer->bind(17, player.cornerPosition.y);
+		writer->bind(18, player.cornerPosition.z);
+		writer->bind(19, player.defenderRandomDisplacementAngle);
+		writer->insertRow();
+	}
+}
 
 void FPSciLogger::loggerThreadEntry()
 {
 	std::unique_lock<std::mutex> lk(m_queueMutex);
 	while (m_running) {
 
+		{
+			std::lock_guard<std::mutex> statsLk(m_statsMutex);
+			m_waitStart = System::time();
+		}
 		m_queueCV.wait(lk, [this]{
-			return !m_running || m_flushNow || getTotalQueueBytes() >= m_bufferLimit;
+			return !m_running || m_flushNow || m_committedSeq < m_flushFence || getTotalQueueBytes() >= m_bufferLimit;
 		});
+		const RealTime passStart = System::time();
+		{
+			std::lock_guard<std::mutex> statsLk(m_statsMutex);
+			m_idleS += passStart - m_waitStart;
+			m_waitStart = 0.0;
+			m_peakPendingBytes = max(m_peakPendingBytes, (int64)getTotalQueueBytes());
+		}
 
-		// Move all the queues into temporary local copies.
-		// This is so we can release the lock and allow the queues to grow again while writing out the results.
-		// Also allocate new storage for each.
-		decltype(m_frameInfo) frameInfo;
-		frameInfo.swap(m_frameInfo, frameInfo);
-		m_frameInfo.reserve(frameInfo.size() * 2);
-
-		decltype(m_playerActions) playerActions;
-		playerActions.swap(m_playerActions, playerActions);
-		m_playerActions.reserve(playerActions.size() * 2);
-
-		decltype(m_remotePlayerActions) remotePlayerActions;
-		remotePlayerActions.swap(m_remotePlayerActions, remotePlayerActions);
-		m_remotePlayerActions.reserve(remotePlayerActions.size() * 2);
-
-		decltype(m_questions) questions;
-		questions.swap(m_questions, questions);
-		m_questions.reserve(questions.size() * 2);
-
-		decltype(m_targetLocations) targetLocations;
-		targetLocations.swap(m_targetLocations, targetLocations);
-		m_targetLocations.reserve(targetLocations.size() * 2);
+		m_flushNow = false;
 
-		decltype(m_targets) targets;
-		targets.swap(m_targets, targets);
-		m_targets.reserve(targets.size() * 2);
+		// Release the lock while draining/writing so flush requests and wakeups aren't blocked by disk I/O.
+		// Producers push straight into the lock-free queues, so they never wait on this thread.
+		lk.unlock();
 
-		decltype(m_trials) trials;
-		trials.swap(m_trials, trials);
-		m_trials.reserve(trials.size() * 2);
+		// Start the sharded tables writing on their own threads
+		for (const String& tableName : m_shards.getKeys()) {
+			LogShard* shard = m_shards[tableName].get();
+			std::lock_guard<std::mutex> shardLk(shard->mutex);
+			shard->requestedPass++;
+			shard->cv.notify_all();
+		}
 
-		decltype(m_users) users;
-		users.swap(m_users, users);
-		m_users.reserve(users.size() * 2);
+		// Write the rest of the tables as a single batch (one transaction/file write per sink)
+		beginBatch();
+		for (const TableJob& job : m_tableJobs) {
+			if (!m_shards.containsKey(job.tableName)) job.write();
+		}
+		endBatch();
 
-		decltype(m_networkedClients) networkedClients;
-		networkedClients.swap(m_networkedClients, networkedClients);
-		m_networkedClients.reserve(networkedClients.size() * 2);
+		// The fence is only committed once every shard has written its part of this flush
+		for (const String& tableName : m_shards.getKeys()) {
+			LogShard* shard = m_shards[tableName].get();
+			std::unique_lock<std::mutex> shardLk(shard->mutex);
+			shard->cv.wait(shardLk, [shard] { return shard->completedPass >= shard->requestedPass; });
+		}
+		recordFlushStats(System::time() - passStart);
+
+		// Only records before the first one still in flight (claimed by a producer but not yet pushed, or stuck behind such a
+		// slot in its ring) are committed. A flush waiting on a later record keeps this thread going until it is drained.
+		uint64 committedSeq;
+		{
+			std::lock_guard<std::mutex> drainLk(m_drainMutex);
+			committedSeq = m_drainedSeq;
+		}
+		lk.lock();
+		if (committedSeq == m_committedSeq && committedSeq < m_flushFence) {
+			// No progress (a producer is part way through a push), don't spin on the lock
+			lk.unlock();
+			std::this_thread::yield();
+			lk.lock();
+		}
+		m_committedSeq = committedSeq;
+		m_commitCV.notify_all();
+	}
+}
 
-		decltype(m_playerConfigs) playerConfigs;
-		playerConfigs.swap(m_playerConfigs, playerConfigs);
-		m_playerConfigs.reserve(playerConfigs.size() * 2);
+void FPSciLogger::shardThreadEntry(LogShard* shard)
+{
+	std::unique_lock<std::mutex> lk(shard->mutex);
+	while (true) {
+		shard->cv.wait(lk, [shard] { return !shard->running || shard->requestedPass > shard->completedPass; });
+		if (shard->requestedPass == shard->completedPass) break;		// Stopped with no pass pending
 
-		// Unlock all the now-empty queues and write out our temporary copies
+		const uint64 pass = shard->requestedPass;
 		lk.unlock();
-
-		recordFrameInfo(frameInfo);
-		recordPlayerActions(playerActions);
-		recordRemotePlayerActions(remotePlayerActions);
-		recordTargetLocations(targetLocations);
-
-		recordNetworkedClients(networkedClients);
-
-		insertRowsIntoDB(m_db, "Questions", questions);
-		insertRowsIntoDB(m_db, "Targets", targets);
-		insertRowsIntoDB(m_db, "Users", users);
-		insertRowsIntoDB(m_db, "Trials", trials);
-		insertRowsIntoDB(m_db, "PlayerConfigs", playerConfigs);
-
+		shard->beginBatch();
+		shard->write();
+		shard->endBatch();
 		lk.lock();
+
+		shard->completedPass = pass;
+		shard->cv.notify_all();
 	}
 }
 
@@ -691,17 +1250,44 @@ FPSciLogger::FPSciLogger(const String& filename,
 	const String& description 
 	) : m_db(nullptr), m_config(sessConfig->logger)
 {
-	// Reserve some space in these arrays here
-	m_playerActions.reserve(5000);
-	m_targetLocations.reserve(5000);
+	// Overflow policy/limits (the limit can't be less than the flush threshold)
+	m_maxQueueBytes = max((size_t)max(m_config.maxQueueMB, 0) * 1024 * 1024, m_bufferLimit);
+	if (m_config.overflowPolicy == "dropoldest") m_overflowPolicy = OverflowPolicy::DropOldest;
+	else if (m_config.overflowPolicy == "spill") m_overflowPolicy = OverflowPolicy::Spill;
+	else m_overflowPolicy = OverflowPolicy::Block;
+
+	// Tables written by the logging thread (or a shard thread) and the queues they are drained from
+	m_tableJobs = {
+		tableJob(m_frameInfo, &FPSciLogger::recordFrameInfo),
+		tableJob(m_playerActions, &FPSciLogger::recordPlayerActions),
+		tableJob(m_remotePlayerActions, &FPSciLogger::recordRemotePlayerActions),
+		tableJob(m_targetLocations, &FPSciLogger::recordTargetLocations),
+		tableJob(m_networkedClients, &FPSciLogger::recordNetworkedClients),
+		tableJob(m_snapshotStats, &FPSciLogger::recordSnapshotStats),
+		tableJob(m_interpolationStats, &FPSciLogger::recordInterpolationStats),
+		tableJob(m_hitValidations, &FPSciLogger::recordHitValidations),
+		tableJob(m_predictionCorrections, &FPSciLogger::recordPredictionCorrections),
+		tableJob(m_impairments, &FPSciLogger::recordImpairments),
+		tableJob(m_targetTypes, &FPSciLogger::recordTargetTypes),
+		tableJob(m_questions, &FPSciLogger::recordQuestions),
+		tableJob(m_targets, &FPSciLogger::recordTargets),
+		tableJob(m_users, &FPSciLogger::recordUsers),
+		tableJob(m_trials, &FPSciLogger::recordTrials),
+		tableJob(m_playerConfigs, &FPSciLogger::recordPlayerConfigs),
+	};
+	m_flushHistogram.resize(flushHistogramBucketsMs().size() + 1);
+	for (uint64& count : m_flushHistogram) count = 0;
 
-	m_networkedClients.reserve(5000);
-	
 	// Create the results file
 	initResultsFile(filename, subjectID, expConfigFilename, sessConfig, description);
 
 	// Thread management
+	m_openTime = System::time();
 	m_running = true;
+	for (const String& tableName : m_shards.getKeys()) {
+		LogShard* shard = m_shards[tableName].get();
+		shard->thread = std::thread(&FPSciLogger::shardThreadEntry, this, shard);
+	}
 	m_thread = std::thread(&FPSciLogger::loggerThreadEntry, this);
 }
 
@@ -713,40 +1299,422 @@ FPSciLogger::~FPSciLogger()
 	}
 	m_queueCV.notify_one();
 	m_thread.join();
+	stopShards();
+
+	// The logging thread has written everything queued, now add any spilled records, the overflow counts, and the logger statistics
+	mergeSpillFile();
+	beginBatch();
+	recordOverflowCounts();
+	recordLoggerStats();
+	endBatch();
+
+	// Copy the sharded tables into the results file
+	mergeShards();
 
 	closeResultsFile();
 }
 
-void FPSciLogger::flush(bool blockUntilDone)
+bool FPSciLogger::flush(bool blockUntilDone, RealTime timeoutS)
 {
-	// Not implemented. Make another condition variable if this is needed.
-	assert(!blockUntilDone);
-	
-	{
-		std::lock_guard<std::mutex> lk(m_queueMutex);
-		m_flushNow = true;
-	}
+	// Anything queued before this point must be committed to complete the flush
+	const uint64 fence = m_queuedSeq.load();
+
+	std::unique_lock<std::mutex> lk(m_queueMutex);
+	m_flushNow = true;
+	if (blockUntilDone) m_flushFence = max(m_flushFence, fence);
 	m_queueCV.notify_one();
+	if (!blockUntilDone) return true;
+
+	const RealTime start = System::time();
+	const bool done = m_commitCV.wait_for(lk, std::chrono::duration<double>(timeoutS), [this, fence] {
+		return m_committedSeq >= fence || !m_running;
+	});
+	const RealTime waitMs = 1000.0 * (System::time() - start);
+	if (done) {
+		logPrintf("Logger flush (fence %llu) committed after waiting %.3f ms\n", (unsigned long long)fence, waitMs);
+	}
+	else {
+		logPrintf("Logger flush (fence %llu) timed out after %.3f ms with %llu records committed\n", (unsigned long long)fence, waitMs, (unsigned long long)m_committedSeq);
+	}
+	return done;
 }
 
-void FPSciLogger::closeResultsFile() {
-	sqlite3_close(m_db);
+void FPSciLogger::createLoggerOverflowTable() {
+	// Logger_Overflow table
+	Columns overflowColumns = {
+		{ "session_id", "text" },
+		{ "session_start_time", "text" },
+		{ "overflow_policy", "text" },
+		{ "max_queue_MB", "integer" },
+		{ "dropped_records", "integer" },
+		{ "spilled_records", "integer" },
+	};
+	createTable("Logger_Overflow", overflowColumns);
 }
 
-void FPSciLogger::writeToFile(String folderName, String fileName, RowEntry data)
-{
-	std::ofstream file;
-	if (!FileSystem::isDirectory(folderName))
-	{
-		FileSystem::createDirectory(folderName);
+void FPSciLogger::recordOverflowCounts() {
+	const shared_ptr<LogTableWriter> writer = tableWriter("Logger_Overflow", 6);
+	writer->bind(0, m_sessionId);
+	writer->bind(1, m_openTimeStr);
+	writer->bind(2, m_config.overflowPolicy);
+	writer->bind(3, m_config.maxQueueMB);
+	writer->bind(4, (int64)m_droppedRecords.load());
+	writer->bind(5, (int64)m_spilledRecords.load());
+	writer->insertRow();
+}
+
+const Array<float>& FPSciLogger::flushHistogramBucketsMs() {
+	static const Array<float> buckets = { 1.0f, 2.0f, 5.0f, 10.0f, 20.0f, 50.0f, 100.0f, 250.0f, 500.0f, 1000.0f };
+	return buckets;
+}
+
+void FPSciLogger::recordBlockedPush(RealTime blockStart) {
+	m_blockedPushes++;
+	const int64 blockNs = (int64)((System::time() - blockStart) * 1e9);
+	int64 maxNs = m_maxBlockNs.load(std::memory_order_relaxed);
+	while (blockNs > maxNs && !m_maxBlockNs.compare_exchange_weak(maxNs, blockNs, std::memory_order_relaxed)) {}
+}
+
+void FPSciLogger::recordFlushStats(RealTime flushS) {
+	const float flushMs = 1000.0f * (float)flushS;
+	const Array<float>& buckets = flushHistogramBucketsMs();
+	int bucket = 0;
+	while (bucket < buckets.size() && flushMs > buckets[bucket]) bucket++;
+
+	std::lock_guard<std::mutex> lk(m_statsMutex);
+	m_flushCount++;
+	m_totalFlushS += flushS;
+	m_lastFlushS = flushS;
+	m_maxFlushS = max(m_maxFlushS, flushS);
+	m_flushHistogram[bucket]++;
+}
+
+FPSciLogger::Stats FPSciLogger::stats() {
+	Stats stats;
+	for (const TableJob& job : m_tableJobs) {
+		TableStats& table = stats.tables.next();
+		table.tableName = job.tableName;
+		table.pendingRows = max(job.counters->pendingRows.load(std::memory_order_relaxed), (int64)0);
+		table.pendingBytes = max(job.counters->pendingBytes.load(std::memory_order_relaxed), (int64)0);
+		table.rowsWritten = job.counters->rowsWritten.load(std::memory_order_relaxed);
+		stats.rowsWritten += table.rowsWritten;
+	}
+	stats.blockedPushes = m_blockedPushes.load();
+	stats.maxBlockMs = 1e-6 * (RealTime)m_maxBlockNs.load();
+
+	std::lock_guard<std::mutex> lk(m_statsMutex);
+	const RealTime now = System::time();
+	stats.elapsedS = now - m_openTime;
+	stats.rowsPerSec = stats.elapsedS > 0.0 ? stats.rowsWritten / stats.elapsedS : 0.0;
+	stats.flushCount = m_flushCount;
+	stats.lastFlushMs = 1000.0 * m_lastFlushS;
+	stats.meanFlushMs = m_flushCount > 0 ? 1000.0 * m_totalFlushS / m_flushCount : 0.0;
+	stats.maxFlushMs = 1000.0 * m_maxFlushS;
+	stats.flushHistogram = m_flushHistogram;
+	// Include the wait in progress (if any) in the idle time
+	const RealTime idleS = m_idleS + (m_waitStart > 0.0 ? now - m_waitStart : 0.0);
+	stats.idleRatio = stats.elapsedS > 0.0 ? clamp(idleS / stats.elapsedS, 0.0, 1.0) : 1.0;
+	stats.peakPendingBytes = m_peakPendingBytes;
+	return stats;
+}
+
+void FPSciLogger::createLoggerStatsTable() {
+	// Logger_Stats table (one row per statistic, table_name is empty for the logger-wide statistics)
+	Columns statsColumns = {
+		{ "session_id", "text" },
+		{ "session_start_time", "text" },
+		{ "table_name", "text" },
+		{ "stat", "text" },
+		{ "value", "real" },
+	};
+	createTable("Logger_Stats", statsColumns);
+}
+
+void FPSciLogger::recordLoggerStats() {
+	const Stats s = stats();
+	const shared_ptr<LogTableWriter> writer = tableWriter("Logger_Stats", 5);
+	auto writeStat = [&](const String& tableName, const String& stat, double value) {
+		writer->bind(0, m_sessionId);
+		writer->bind(1, m_openTimeStr);
+		writer->bind(2, tableName);
+		writer->bind(3, stat);
+		writer->bind(4, value);
+		writer->insertRow();
+	};
+
+	for (const TableStats& table : s.tables) {
+		writeStat(table.tableName, "rows_written", (double)table.rowsWritten);
+		writeStat(table.tableName, "pending_rows", (double)table.pendingRows);
+		writeStat(table.tableName, "pending_bytes", (double)table.pendingBytes);
+	}
+	writeStat("", "elapsed_s", s.elapsedS);
+	writeStat("", "rows_written", (double)s.rowsWritten);
+	writeStat("", "rows_per_sec", s.rowsPerSec);
+	writeStat("", "flush_count", (double)s.flushCount);
+	writeStat("", "mean_flush_ms", s.meanFlushMs);
+	writeStat("", "max_flush_ms", s.maxFlushMs);
+	const Array<float>& buckets = flushHistogramBucketsMs();
+	for (int i = 0; i < s.flushHistogram.size(); i++) {
+		const String stat = (i < buckets.size()) ? format("flushes_le_%gms", buckets[i]) : format("flushes_gt_%gms", buckets.last());
+		writeStat("", stat, (double)s.flushHistogram[i]);
+	}
+	writeStat("", "writer_idle_ratio", s.idleRatio);
+	writeStat("", "peak_pending_bytes", (double)s.peakPendingBytes);
+	writeStat("", "blocked_log_calls", (double)s.blockedPushes);
+	writeStat("", "max_block_ms", s.maxBlockMs);
+}
+
+static void serializeGUID(const LoggedGUID& guid, BinaryOutput& out) {
+	out.writeBool8(guid.set);
+	guid.id.serialize(out);
+}
+
+static void deserializeGUID(LoggedGUID& guid, BinaryInput& in) {
+	guid.set = in.readBool8();
+	guid.id.deserialize(in);
+}
+
+// Spill file records are a type tag followed by the record fields (little endian)
+enum SpillRecordType : uint8 {
+	SPILL_FRAME_INFO = 0,
+	SPILL_PLAYER_ACTION,
+	SPILL_REMOTE_PLAYER_ACTION,
+	SPILL_TARGET_LOCATION,
+	SPILL_NETWORKED_CLIENT,
+	SPILL_INTERPOLATION_STATS,
+	SPILL_IMPAIRMENT
+};
+
+bool FPSciLogger::spillRecord(const FrameInfo& info) {
+	BinaryOutput out("<memory>", G3D_LITTLE_ENDIAN);
+	out.writeUInt8(SPILL_FRAME_INFO);
+	out.writeInt64(info.time);
+	out.writeFloat32(info.sdt);
+	out.writeUInt32(info.network_RTT);
+	out.writeUInt32(info.local_frame);
+	out.writeUInt32(info.remote_frame);
+	serializeGUID(info.clientID, out);
+	return appendToSpillFile(out);
+}
+
+bool FPSciLogger::spillRecord(const PlayerAction& action) {
+	BinaryOutput out("<memory>", G3D_LITTLE_ENDIAN);
+	out.writeUInt8(SPILL_PLAYER_ACTION);
+	out.writeInt64(action.time);
+	action.viewDirection.serialize(out);
+	action.position.serialize(out);
+	out.writeUInt8((uint8)action.state);
+	out.writeUInt8((uint8)action.action);
+	out.writeString32(action.targetName);
+	return appendToSpillFile(out);
+}
+
+bool FPSciLogger::spillRecord(const RemotePlayerAction& action) {
+	BinaryOutput out("<memory>", G3D_LITTLE_ENDIAN);
+	out.writeUInt8(SPILL_REMOTE_PLAYER_ACTION);
+	out.writeInt64(action.time);
+	action.viewDirection.serialize(out);
+	action.position.serialize(out);
+	out.writeUInt8((uint8)action.state);
+	out.writeUInt8((uint8)action.action);
+	serializeGUID(action.actorID, out);
+	serializeGUID(action.affectedID, out);
+	return appendToSpillFile(out);
+}
+
+bool FPSciLogger::spillRecord(const TargetLocation& location) {
+	BinaryOutput out("<memory>", G3D_LITTLE_ENDIAN);
+	out.writeUInt8(SPILL_TARGET_LOCATION);
+	out.writeInt64(location.time);
+	out.writeString32(location.name);
+	out.writeUInt8((uint8)location.state);
+	location.position.serialize(out);
+	return appendToSpillFile(out);
+}
+
+bool FPSciLogger::spillRecord(const NetworkedClient& client) {
+	BinaryOutput out("<memory>", G3D_LITTLE_ENDIAN);
+	out.writeUInt8(SPILL_NETWORKED_CLIENT);
+	out.writeInt64(client.time);
+	client.viewDirection.serialize(out);
+	client.position.serialize(out);
+	client.playerID.serialize(out);
+	out.writeUInt32(client.localFrame);
+	out.writeUInt32(client.remoteFrame);
+	out.writeUInt8((uint8)client.state);
+	out.writeUInt8((uint8)client.action);
+	return appendToSpillFile(out);
+}
+
+bool FPSciLogger::spillRecord(const InterpolationStats& stats) {
+	BinaryOutput out("<memory>", G3D_LITTLE_ENDIAN);
+	out.writeUInt8(SPILL_INTERPOLATION_STATS);
+	out.writeInt64(stats.time);
+	out.writeInt32(stats.interpolated);
+	out.writeInt32(stats.extrapolated);
+	out.writeInt32(stats.held);
+	out.writeFloat32(stats.delayMs);
+	out.writeFloat32(stats.maxExtrapolationMs);
+	return appendToSpillFile(out);
+}
+
+bool FPSciLogger::spillRecord(const ImpairmentRecord& record) {
+	BinaryOutput out("<memory>", G3D_LITTLE_ENDIAN);
+	out.writeUInt8(SPILL_IMPAIRMENT);
+	out.writeInt64(record.time);
+	out.writeUInt32(record.destination.host);
+	out.writeUInt16(record.destination.port);
+	out.writeUInt8(record.packetType);
+	out.writeBool8(record.reliable);
+	out.writeInt32(record.bytes);
+	out.writeUInt8((uint8)record.action);
+	out.writeBool8(record.burst);
+	out.writeBool8(record.reordered);
+	out.writeFloat32(record.delayMs);
+	out.writeFloat32(record.jitterMs);
+	out.writeFloat32(record.queueMs);
+	out.writeUInt64(record.sequence);
+	return appendToSpillFile(out);
+}
+
+bool FPSciLogger::appendToSpillFile(const BinaryOutput& record) {
+	std::lock_guard<std::mutex> lk(m_spillMutex);
+	if (!m_spillFile.is_open()) {
+		m_spillFile.open(m_spillFilename.c_str(), std::ios_base::binary | std::ios_base::app);
+		if (!m_spillFile.is_open()) {
+			logPrintf("Error opening logger spill file: %s\n", m_spillFilename.c_str());
+			return false;
+		}
 	}
-	file.open((folderName + R"(\)"+ fileName).c_str(), std::ios_base::app);
-	for (String cellData : data)
+	m_spillFile.write((const char*)record.getCArray(), (std::streamsize)record.length());
+	return m_spillFile.good();
+}
+
+void FPSciLogger::mergeSpillFile() {
 	{
-		file << cellData.c_str() << ",";
+		std::lock_guard<std::mutex> lk(m_spillMutex);
+		if (!m_spillFile.is_open()) return;		// Nothing was spilled
+		m_spillFile.close();
+	}
+
+	Array<FrameInfo> frameInfo;
+	Array<PlayerAction> playerActions;
+	Array<RemotePlayerAction> remotePlayerActions;
+	Array<TargetLocation> targetLocations;
+	Array<NetworkedClient> networkedClients;
+	Array<InterpolationStats> interpolationStats;
+	Array<ImpairmentRecord> impairments;
+
+	BinaryInput in(m_spillFilename, G3D_LITTLE_ENDIAN);
+	while (in.hasMore()) {
+		const uint8 type = in.readUInt8();
+		switch (type) {
+		case SPILL_FRAME_INFO: {
+			FrameInfo& info = frameInfo.next();
+			info.time = in.readInt64();
+			info.sdt = in.readFloat32();
+			info.network_RTT = in.readUInt32();
+			info.local_frame = in.readUInt32();
+			info.remote_frame = in.readUInt32();
+			deserializeGUID(info.clientID, in);
+			break;
+		}
+		case SPILL_PLAYER_ACTION: {
+			PlayerAction& action = playerActions.next();
+			action.time = in.readInt64();
+			action.viewDirection.deserialize(in);
+			action.position.deserialize(in);
+			action.state = (PresentationState)in.readUInt8();
+			action.action = (PlayerActionType)in.readUInt8();
+			action.targetName = in.readString32();
+			break;
+		}
+		case SPILL_REMOTE_PLAYER_ACTION: {
+			RemotePlayerAction& action = remotePlayerActions.next();
+			action.time = in.readInt64();
+			action.viewDirection.deserialize(in);
+			action.position.deserialize(in);
+			action.state = (PresentationState)in.readUInt8();
+			action.action = (PlayerActionType)in.readUInt8();
+			deserializeGUID(action.actorID, in);
+			deserializeGUID(action.affectedID, in);
+			break;
+		}
+		case SPILL_TARGET_LOCATION: {
+			TargetLocation& location = targetLocations.next();
+			location.time = in.readInt64();
+			location.name = in.readString32();
+			location.state = (PresentationState)in.readUInt8();
+			location.position.deserialize(in);
+			break;
+		}
+		case SPILL_NETWORKED_CLIENT: {
+			NetworkedClient& client = networkedClients.next();
+			client.time = in.readInt64();
+			client.viewDirection.deserialize(in);
+			client.position.deserialize(in);
+			client.playerID.deserialize(in);
+			client.localFrame = in.readUInt32();
+			client.remoteFrame = in.readUInt32();
+			client.state = (PresentationState)in.readUInt8();
+			client.action = (PlayerActionType)in.readUInt8();
+			break;
+		}
+		case SPILL_INTERPOLATION_STATS: {
+			InterpolationStats& stats = interpolationStats.next();
+			stats.time = in.readInt64();
+			stats.interpolated = in.readInt32();
+			stats.extrapolated = in.readInt32();
+			stats.held = in.readInt32();
+			stats.delayMs = in.readFloat32();
+			stats.maxExtrapolationMs = in.readFloat32();
+			break;
+		}
+		case SPILL_IMPAIRMENT: {
+			ImpairmentRecord& record = impairments.next();
+			record.time = in.readInt64();
+			record.destination.host = in.readUInt32();
+			record.destination.port = in.readUInt16();
+			record.packetType = in.readUInt8();
+			record.reliable = in.readBool8();
+			record.bytes = in.readInt32();
+			record.action = (ImpairmentRecord::Action)in.readUInt8();
+			record.burst = in.readBool8();
+			record.reordered = in.readBool8();
+			record.delayMs = in.readFloat32();
+			record.jitterMs = in.readFloat32();
+			record.queueMs = in.readFloat32();
+			record.sequence = in.readUInt64();
+			break;
+		}
+		default:
+			// Can't resync after an unknown record, keep the spill file so the data isn't lost
+			logPrintf("Unknown record type (%d) in logger spill file %s, leaving it in place!\n", (int)type, m_spillFilename.c_str());
+			return;
+		}
 	}
-	file << std::endl;
 
-	file.close();
+	beginBatch(true);
+	recordFrameInfo(frameInfo);
+	recordPlayerActions(playerActions);
+	recordRemotePlayerActions(remotePlayerActions);
+	recordTargetLocations(targetLocations);
+	recordNetworkedClients(networkedClients);
+	recordInterpolationStats(interpolationStats);
+	recordImpairments(impairments);
+	endBatch(true);
+
+	logPrintf("Merged %d spilled records from %s into the results file\n",
+		frameInfo.size() + playerActions.size() + remotePlayerActions.size() + targetLocations.size() + networkedClients.size() +
+		interpolationStats.size() + impairments.size(), m_spillFilename.c_str());
+	FileSystem::removeFile(m_spillFilename);
 }
 
+void FPSciLogger::closeResultsFile() {
+	// Close the sinks (finalizing any prepared statements) before closing the database
+	m_tableWriters.clear();
+	m_sinks.clear();
+	for (const String& tableName : m_shards.getKeys()) sqlite3_close(m_shards[tableName]->db);
+	m_shards.clear();
+	sqlite3_close(m_db);
+}
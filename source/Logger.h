@@ -1,12 +1,18 @@
 #pragma once
 #include <G3D/G3D.h>
 #include "sqlHelpers.h"
+#include "LogSink.h"
 #include "UserConfig.h"
 #include "Session.h"
 #include "NetworkedSession.h"
+#include "NetworkImpairment.h"
 #include "Dialogs.h"
+#include "MpscRingBuffer.h"
+#include <chrono>
+#include <functional>
 #include <iostream>
 #include <fstream>
+#include <queue>
 #include <string>
 #include <vector>
 
@@ -18,21 +24,113 @@ struct PlayerAction;
 struct RemotePlayerAction;
 struct FrameInfo;
 struct NetworkedClient;
-
-template<typename ItemType> static size_t queueBytes(Array<ItemType>& queue)
-{
-	return queue.size() * sizeof(ItemType);
-}
+struct SnapshotStats;
+struct InterpolationStats;
+struct HitValidation;
+struct PredictionCorrection;
+struct ImpairmentRecord;
 
 /** Used to log data from experiments, sessions, trials and users
 	Uses SQLITE database output. */
 class FPSciLogger : public ReferenceCountedObject {
 public:
-	using TargetInfo = RowEntry;
-	using QuestionResult = RowEntry;
-	using TrialValues = RowEntry;
-	using UserValues = RowEntry;
-	using PlayerValues = RowEntry;
+	// Typed records for the lower-rate tables (converted to SQL values only when written out by the logging thread)
+
+	/** Row for the Targets table */
+	struct TargetInfo {
+		String		name;									///< Target name (unique to a trial)
+		String		typeId;									///< Target type (TargetConfig id)
+		String		spawnTime;								///< Time the target was spawned
+		float		size = 0.0f;							///< Actual (randomized) target size
+		Point2		spawnEcc = Point2::zero();				///< Spawn eccentricity (horizontal, vertical)
+	};
+
+	/** Row for the Questions table */
+	struct QuestionResult {
+		int64			time = 0;							///< Time the question was answered
+		String			sessionId;							///< Session the question was asked in
+		Question		question;							///< Question (including its result)
+		Array<String>	presentedOptions;					///< Options as presented to the user (for MultipleChoice/Rating questions)
+	};
+
+	/** Row for the Trials table */
+	struct TrialValues {
+		String		sessionId;								///< Session ID
+		int			trialId = 0;							///< Trial index within the session
+		int			trialIndex = 0;							///< Count of completed trials of this type
+		int			blockId = 0;							///< Block number
+		String		startTime;								///< Task start time
+		String		endTime;								///< Task end time
+		float		pretrialDuration = 0.0f;				///< Pretrial duration (s)
+		RealTime	taskExecutionTime = 0.0;				///< Task execution time (s)
+		int			destroyedTargets = 0;					///< Targets destroyed in this trial
+		int			totalTargets = 0;						///< Total targets in this trial
+	};
+
+	/** Row for the Users table */
+	struct UserValues {
+		String		subjectId;								///< User ID
+		String		sessionId;								///< Session ID
+		int64		time = 0;								///< Time the user was logged
+		float		cmp360 = 0.0f;							///< cm/360 for the user's mouse
+		double		mouseDegPerMm = 0.0;					///< Mouse sensitivity (deg/mm)
+		double		mouseDPI = 0.0;							///< Mouse DPI
+		int			reticleIndex = 0;						///< Reticle index
+		float		reticleScale[2] = { 0.0f, 0.0f };		///< Reticle (min, max) scale
+		Color4		reticleColor[2];						///< Reticle (min, max) color
+		float		reticleChangeTimeS = 0.0f;				///< Reticle change time (s)
+		Vector2		userTurnScale = Vector2::zero();		///< User turn scale (Y-inversion collapsed into y)
+		Vector2		sessTurnScale = Vector2::zero();		///< Session turn scale
+		Vector2		sensitivity = Vector2::zero();			///< Effective sensitivity
+	};
+
+	/** Row for the PlayerConfigs table */
+	struct PlayerValues {
+		int64		time = 0;								///< Time the player config was logged
+		int			trialNumber = 0;						///< Round/trial number this config applies to
+		GUniqueID	playerID;								///< Player the config was sent to
+		float		moveRate = 0.0f;
+		Point3		respawnPos = Point3::zero();
+		float		respawnHeading = 0.0f;
+		float		movementRestrictionX = 0.0f;
+		float		movementRestrictionZ = 0.0f;
+		bool		restrictedMovementEnabled = false;
+		float		restrictionBoxAngle = 0.0f;
+		bool		counterStrafing = false;
+		int			selectedClientIdx = 0;
+		String		playerType;
+		float		clientLatency = 0.0f;
+		Point3		cornerPosition = Point3::zero();
+		float		defenderRandomDisplacementAngle = 0.0f;
+	};
+
+	/** Logger statistics for a single table */
+	struct TableStats {
+		String		tableName;
+		int64		pendingRows = 0;						///< Rows queued but not yet written
+		int64		pendingBytes = 0;						///< Memory held by the queued rows
+		uint64		rowsWritten = 0;						///< Rows written since the results file was opened
+	};
+
+	/** Snapshot of the logger's own performance counters (see stats()) */
+	struct Stats {
+		Array<TableStats>	tables;
+		RealTime			elapsedS = 0.0;					///< Time since the results file was opened (s)
+		uint64				rowsWritten = 0;				///< Rows written (all tables)
+		double				rowsPerSec = 0.0;				///< Average rows written per second (since the results file was opened)
+		uint64				flushCount = 0;					///< Writer passes (each writes everything queued as one batch)
+		RealTime			lastFlushMs = 0.0;
+		RealTime			meanFlushMs = 0.0;
+		RealTime			maxFlushMs = 0.0;
+		Array<uint64>		flushHistogram;					///< Flush counts for each of flushHistogramBucketsMs() (plus a final bucket for longer flushes)
+		double				idleRatio = 1.0;				///< Fraction of time the logging thread spent waiting for work
+		int64				peakPendingBytes = 0;			///< Most memory queued at the start of a flush
+		uint64				blockedPushes = 0;				///< Log calls that waited on a full queue (these are the only logger stalls a frame can see)
+		RealTime			maxBlockMs = 0.0;				///< Longest a log call waited on a full queue
+	};
+
+	/** Upper bounds (in ms) of the flush duration histogram buckets */
+	static const Array<float>& flushHistogramBucketsMs();
 
 protected:
 	sqlite3* m_db = nullptr;						///< The db used for logging
@@ -47,52 +145,351 @@ protected:
 	const size_t m_bufferLimit = 1024 * 1024;		///< Flush every this many bytes
 	const LoggerConfig& m_config;					/// Logger configuration
 
+	/** What addToQueue() does with a new record when the queue limit is reached */
+	enum class OverflowPolicy {
+		Block,										///< Wait for the logging thread to drain the queue
+		DropOldest,									///< Discard the oldest queued record of the same type
+		Spill										///< Write the record to a spill file (merged into the results file at close)
+	};
+	OverflowPolicy m_overflowPolicy = OverflowPolicy::Block;
+	size_t m_maxQueueBytes = 0;						///< Maximum bytes queued before the overflow policy applies
+
+	static const size_t s_frameQueueCapacity = 1 << 14;		///< Ring size for the per-frame record queues
+	static const size_t s_eventQueueCapacity = 1 << 8;		///< Ring size for the (low rate) per-trial/session record queues
+
 	bool m_running = false;
 	bool m_flushNow = false;
+	uint64 m_flushFence = 0;						///< Highest sequence number a flush is waiting on (the logging thread keeps writing until it is committed)
 	std::thread m_thread;
-	std::mutex m_queueMutex;
+	std::mutex m_queueMutex;						///< Only protects the wakeup state above (the queues are lock-free)
 	std::condition_variable m_queueCV;
-
-	// Output queues for reported data storage
-	Array<FrameInfo> m_frameInfo;						///< Storage for frame info (sdt, idt, rdt)
-	Array<PlayerAction> m_playerActions;				///< Storage for player action (hit, miss, aim)
-	Array<RemotePlayerAction> m_remotePlayerActions;
-	Array<QuestionResult> m_questions;
-	Array<TargetLocation> m_targetLocations;			///< Storage for target trajectory (vector3 cartesian)
-	Array<TargetInfo> m_targets;
-	Array<TrialValues> m_trials;						///< Trial ID, start/end time etc.
-	Array<UserValues> m_users;
-	Array<NetworkedClient> m_networkedClients;
-	Array<PlayerValues> m_playerConfigs;
+	std::condition_variable m_commitCV;				///< Signaled each time the logging thread commits a flush
+
+	// Flush fences (records are numbered before they are pushed and carry their number through the queue, the logging thread
+	// commits the highest number below which every record has been drained, so a record stuck behind a slot another producer
+	// hasn't published yet is never counted as committed)
+	std::atomic<uint64> m_queuedSeq{ 0 };			///< Sequence number given to the last record queued
+	uint64 m_committedSeq = 0;						///< Every record up to (and including) this sequence number is committed (protected by m_queueMutex)
+
+	std::mutex m_drainMutex;						///< Serializes consumers of the queues (the logging thread and drop-oldest producers)
+	uint64 m_drainedSeq = 0;						///< Every record up to (and including) this sequence number has been drained, dropped or spilled (protected by m_drainMutex)
+	std::priority_queue<uint64, std::vector<uint64>, std::greater<uint64>> m_drainedAhead;	///< Sequence numbers drained past a gap in m_drainedSeq (protected by m_drainMutex)
+	std::atomic<size_t> m_pendingBytes{ 0 };		///< Bytes (including owned heap memory) reserved by producers or queued, and not yet drained by the logging thread
+
+	// Overflow state
+	std::atomic<uint64> m_droppedRecords{ 0 };		///< Records discarded by the drop-oldest policy
+	std::atomic<uint64> m_spilledRecords{ 0 };		///< Records written to the spill file
+	String m_sessionId;								///< Session these records belong to (for the Logger_Overflow table)
+	String m_spillFilename;							///< Spill file (results filename + ".spill")
+	std::ofstream m_spillFile;						///< Spill file output (opened on first spill)
+	std::mutex m_spillMutex;						///< Protects m_spillFile
+
+	/** Per-table queue counters (counted before the record is pushed, so they may briefly include a push that fails and is retried) */
+	struct QueueCounters {
+		const char*				tableName;
+		std::atomic<int64>		pendingRows{ 0 };
+		std::atomic<int64>		pendingBytes{ 0 };
+		std::atomic<uint64>		rowsWritten{ 0 };
+
+		QueueCounters(const char* table) : tableName(table) {}
+	};
+
+	/** A queued record and the sequence number it was given by addToQueue() */
+	template <typename ItemType> struct QueuedRecord {
+		uint64		seq = 0;
+		ItemType	item;
+	};
+
+	/** Queue of records for a single table */
+	template <typename ItemType> class RecordQueue : public MpscRingBuffer<QueuedRecord<ItemType>>, public QueueCounters {
+	public:
+		RecordQueue(const char* table, size_t capacity) : MpscRingBuffer<QueuedRecord<ItemType>>(capacity), QueueCounters(table) {}
+	};
+
+	// Output queues for reported data storage (multiple producers, the logging thread is the single consumer)
+	RecordQueue<FrameInfo> m_frameInfo{ "Frame_Info", s_frameQueueCapacity };								///< Storage for frame info (sdt, idt, rdt)
+	RecordQueue<PlayerAction> m_playerActions{ "Player_Action", s_frameQueueCapacity };						///< Storage for player action (hit, miss, aim)
+	RecordQueue<RemotePlayerAction> m_remotePlayerActions{ "Remote_Player_Action", s_frameQueueCapacity };
+	RecordQueue<QuestionResult> m_questions{ "Questions", s_eventQueueCapacity };
+	RecordQueue<TargetLocation> m_targetLocations{ "Target_Trajectory", s_frameQueueCapacity };				///< Storage for target trajectory (vector3 cartesian)
+	RecordQueue<TargetInfo> m_targets{ "Targets", s_eventQueueCapacity };
+	RecordQueue<TrialValues> m_trials{ "Trials", s_eventQueueCapacity };									///< Trial ID, start/end time etc.
+	RecordQueue<UserValues> m_users{ "Users", s_eventQueueCapacity };
+	RecordQueue<NetworkedClient> m_networkedClients{ "Client_States", s_frameQueueCapacity };
+	RecordQueue<SnapshotStats> m_snapshotStats{ "Snapshot_Stats", s_eventQueueCapacity };				///< Periodic per client snapshot bandwidth totals
+	RecordQueue<InterpolationStats> m_interpolationStats{ "Interpolation_Stats", s_frameQueueCapacity };	///< Per frame client entity interpolation counts
+	RecordQueue<HitValidation> m_hitValidations{ "Hit_Validation", s_eventQueueCapacity };			///< Server checks of the hits clients report
+	RecordQueue<PredictionCorrection> m_predictionCorrections{ "Prediction_Corrections", s_eventQueueCapacity };	///< Client corrections of predicted movement
+	RecordQueue<ImpairmentRecord> m_impairments{ "Network_Impairments", s_frameQueueCapacity };		///< Emulated network impairment decisions (one per packet)
+	RecordQueue<PlayerValues> m_playerConfigs{ "PlayerConfigs", s_eventQueueCapacity };
+	RecordQueue<shared_ptr<TargetConfig>> m_targetTypes{ "Target_Types", s_eventQueueCapacity };
+
+	// Writer statistics (protected by m_statsMutex, except the atomics which are updated by producers)
+	std::mutex m_statsMutex;
+	RealTime m_openTime = 0.0;						///< When the results file was opened (System::time())
+	uint64 m_flushCount = 0;
+	RealTime m_totalFlushS = 0.0;
+	RealTime m_lastFlushS = 0.0;
+	RealTime m_maxFlushS = 0.0;
+	Array<uint64> m_flushHistogram;
+	RealTime m_idleS = 0.0;							///< Time the logging thread has spent waiting for work
+	RealTime m_waitStart = 0.0;						///< When the logging thread started its current wait (0 if it is writing)
+	int64 m_peakPendingBytes = 0;
+	std::atomic<uint64> m_blockedPushes{ 0 };
+	std::atomic<int64> m_maxBlockNs{ 0 };
+
+	Table<String, shared_ptr<LogSink>> m_sinks;					///< Output sinks in use (by sink name)
+	Table<String, shared_ptr<LogTableWriter>> m_tableWriters;	///< Writers for each table (to all its sinks)
+	std::mutex m_tableWritersMutex;								///< Protects m_tableWriters (shared by the logging and shard threads)
+
+	/** Drains the queue for a table and writes its records (called from the logging thread or the table's shard thread) */
+	struct TableJob {
+		String					tableName;
+		QueueCounters*			counters = nullptr;
+		std::function<void()>	write;
+	};
+	Array<TableJob> m_tableJobs;						///< Every table written by the logging thread (in write order)
+
+	/** A table written by its own thread into a separate database file (merged into the results file at close)
+		The logging thread requests a pass each time it flushes and waits for the pass to complete before committing its fence. */
+	struct LogShard {
+		String									tableName;
+		String									filename;				///< Shard database file (results filename + "." + table name + ".shard")
+		sqlite3*								db = nullptr;
+		Table<String, shared_ptr<LogSink>>		sinks;					///< This table's sinks (the "sqlite" sink writes to the shard database)
+		std::function<void()>					write;					///< Job for this table
+		std::thread								thread;
+		std::mutex								mutex;					///< Protects the pass counters/running flag
+		std::condition_variable					cv;						///< Signaled when a pass is requested or completed
+		uint64									requestedPass = 0;
+		uint64									completedPass = 0;
+		bool									running = true;
+
+		void beginBatch() { for (const String& sinkName : sinks.getKeys()) sinks[sinkName]->beginBatch(); }
+		void endBatch() { for (const String& sinkName : sinks.getKeys()) sinks[sinkName]->endBatch(); }
+	};
+	Table<String, shared_ptr<LogShard>> m_shards;		///< Sharded tables (by table name)
 
 	size_t getTotalQueueBytes()
 	{
-		return queueBytes(m_frameInfo) +
-			queueBytes(m_playerActions) +
-			queueBytes(m_remotePlayerActions) +
-			queueBytes(m_questions) +
-			queueBytes(m_targetLocations) +
-			queueBytes(m_targets) +
-			queueBytes(m_trials) + 
-			queueBytes(m_networkedClients) +
-			queueBytes(m_playerConfigs);
+		return m_pendingBytes.load(std::memory_order_relaxed);
+	}
+
+	// Memory held by a queued record (its size plus any heap memory owned by its strings/arrays)
+	static size_t recordBytes(const FrameInfo& info);
+	static size_t recordBytes(const PlayerAction& action);
+	static size_t recordBytes(const RemotePlayerAction& action);
+	static size_t recordBytes(const QuestionResult& question);
+	static size_t recordBytes(const TargetLocation& location);
+	static size_t recordBytes(const TargetInfo& target);
+	static size_t recordBytes(const TrialValues& trial);
+	static size_t recordBytes(const UserValues& user);
+	static size_t recordBytes(const NetworkedClient& client);
+	static size_t recordBytes(const SnapshotStats& stats);
+	static size_t recordBytes(const InterpolationStats& stats);
+	static size_t recordBytes(const HitValidation& validation);
+	static size_t recordBytes(const PredictionCorrection& correction);
+	static size_t recordBytes(const ImpairmentRecord& record);
+	static size_t recordBytes(const PlayerValues& player);
+	static size_t recordBytes(const shared_ptr<TargetConfig>& targetType);
+
+	/** Wake up the logging thread (the lock avoids missing a wakeup between its predicate check and wait) */
+	void wakeLoggerThread()
+	{
+		std::lock_guard<std::mutex> lk(m_queueMutex);
+		m_queueCV.notify_one();
+	}
+
+	/** Reserve room for a record in the queue limit (the check and the add are a single step, so concurrent producers can't
+		overshoot it). A record larger than the limit is let in when nothing else is queued, so it can't block forever.
+		Returns the pending bytes including this record, or 0 if it doesn't fit. */
+	size_t reserveQueueBytes(size_t itemBytes)
+	{
+		size_t pendingBytes = m_pendingBytes.load(std::memory_order_relaxed);
+		do {
+			if (pendingBytes > 0 && pendingBytes + itemBytes > m_maxQueueBytes) return 0;
+		} while (!m_pendingBytes.compare_exchange_weak(pendingBytes, pendingBytes + itemBytes, std::memory_order_relaxed));
+		return pendingBytes + itemBytes;
 	}
 
-	template<typename ItemType> void addToQueue(Array<ItemType>& queue, const ItemType& item)
+	/** Count a record as drained (caller holds m_drainMutex), advancing m_drainedSeq past any run of drained records */
+	void markDrained(uint64 seq)
 	{
-		{
-			std::lock_guard<std::mutex> lk(m_queueMutex);
-			queue.push_back(item);
+		if (seq != m_drainedSeq + 1) {
+			m_drainedAhead.push(seq);
+			return;
 		}
+		m_drainedSeq = seq;
+		while (!m_drainedAhead.empty() && m_drainedAhead.top() == m_drainedSeq + 1) {
+			m_drainedSeq = m_drainedAhead.top();
+			m_drainedAhead.pop();
+		}
+	}
+
+	template<typename ItemType> void addToQueue(RecordQueue<ItemType>& queue, const ItemType& item)
+	{
+		const size_t itemBytes = recordBytes(item);
+		// The sequence number is taken before the push, so a flush that starts after this call returns always waits for it
+		QueuedRecord<ItemType> record;
+		record.seq = ++m_queuedSeq;
+		record.item = item;
+		RealTime blockStart = 0.0;
+		size_t pendingBytes;
+		while (true) {
+			// The bytes are counted before the push makes the record visible to the logging thread, so a drain never
+			// releases bytes that haven't been added yet
+			pendingBytes = reserveQueueBytes(itemBytes);
+			if (pendingBytes > 0) {
+				queue.pendingRows.fetch_add(1, std::memory_order_relaxed);
+				queue.pendingBytes.fetch_add((int64)itemBytes, std::memory_order_relaxed);
+				if (queue.tryPush(std::move(record))) break;
+				// Ring full, give the reservation back
+				queue.pendingRows.fetch_sub(1, std::memory_order_relaxed);
+				queue.pendingBytes.fetch_sub((int64)itemBytes, std::memory_order_relaxed);
+				m_pendingBytes.fetch_sub(itemBytes, std::memory_order_relaxed);
+			}
+
+			if (blockStart == 0.0) blockStart = System::time();
+			// Queue limit reached, make sure the logging thread is draining then apply the overflow policy.
+			// Low rate records (trials, users, questions, etc.) are never discarded or spilled, these always block.
+			wakeLoggerThread();
+			if (m_overflowPolicy == OverflowPolicy::DropOldest && isPerFrameRecord(item)) {
+				if (!dropOldest(queue)) {
+					// Nothing of this type left to drop (other record types hold the memory), drop this record instead
+					m_droppedRecords++;
+					releaseSeq(record.seq);
+					recordBlockedPush(blockStart);
+					return;
+				}
+			}
+			else if (m_overflowPolicy == OverflowPolicy::Spill && isPerFrameRecord(item) && spillRecord(item)) {
+				// Spilled records reach the results file when it is closed, flushes don't wait for them
+				m_spilledRecords++;
+				releaseSeq(record.seq);
+				recordBlockedPush(blockStart);
+				return;
+			}
+			else {
+				std::this_thread::yield();
+			}
+		}
+		if (blockStart != 0.0) recordBlockedPush(blockStart);
 
-		// Wake up the logging thread if it needs to write out the results
-		size_t pendingBytes = getTotalQueueBytes();
-		if (pendingBytes >= m_bufferLimit) {
-			m_queueCV.notify_one();
+		// Wake up the logging thread if this push crossed the buffer limit
+		if (pendingBytes >= m_bufferLimit && pendingBytes - itemBytes < m_bufferLimit) {
+			wakeLoggerThread();
 		}
 	}
 
+	/** Count a record that never made it into a queue (dropped or spilled by its producer) as drained */
+	void releaseSeq(uint64 seq)
+	{
+		std::lock_guard<std::mutex> lk(m_drainMutex);
+		markDrained(seq);
+	}
+
+	/** Discard the oldest record in a queue (for the drop-oldest policy), returns false if the queue is empty */
+	template<typename ItemType> bool dropOldest(RecordQueue<ItemType>& queue)
+	{
+		std::lock_guard<std::mutex> lk(m_drainMutex);
+		QueuedRecord<ItemType> dropped;
+		if (!queue.tryPop(dropped)) return false;
+		markDrained(dropped.seq);
+		const size_t bytes = recordBytes(dropped.item);
+		m_pendingBytes.fetch_sub(bytes, std::memory_order_relaxed);
+		queue.pendingRows.fetch_sub(1, std::memory_order_relaxed);
+		queue.pendingBytes.fetch_sub((int64)bytes, std::memory_order_relaxed);
+		m_droppedRecords++;
+		return true;
+	}
+
+	/** Drain a queue into a local array (logging thread only) and release its bytes from the pending count */
+	template<typename ItemType> void drainQueue(RecordQueue<ItemType>& queue, Array<ItemType>& out)
+	{
+		std::lock_guard<std::mutex> lk(m_drainMutex);
+		const int start = out.size();
+		QueuedRecord<ItemType> record;
+		size_t bytes = 0;
+		// At most one ring's worth, so producers refilling the queue can't keep this drain going forever
+		while ((size_t)(out.size() - start) < queue.capacity() && queue.tryPop(record)) {
+			markDrained(record.seq);
+			bytes += recordBytes(record.item);
+			out.append(record.item);
+		}
+		m_pendingBytes.fetch_sub(bytes, std::memory_order_relaxed);
+		queue.pendingRows.fetch_sub(out.size() - start, std::memory_order_relaxed);
+		queue.pendingBytes.fetch_sub((int64)bytes, std::memory_order_relaxed);
+	}
+
+	/** Count a log call that had to wait on a full queue (blockStart is when the wait began) */
+	void recordBlockedPush(RealTime blockStart);
+
+	// Per-frame record types (the only ones the drop-oldest/spill policies apply to)
+	template<typename ItemType> static bool isPerFrameRecord(const ItemType&) { return false; }
+	static bool isPerFrameRecord(const FrameInfo&) { return true; }
+	static bool isPerFrameRecord(const PlayerAction&) { return true; }
+	static bool isPerFrameRecord(const RemotePlayerAction&) { return true; }
+	static bool isPerFrameRecord(const TargetLocation&) { return true; }
+	static bool isPerFrameRecord(const NetworkedClient&) { return true; }
+	static bool isPerFrameRecord(const InterpolationStats&) { return true; }
+	static bool isPerFrameRecord(const ImpairmentRecord&) { return true; }
+
+	// Spill file output (for the spill overflow policy)
+	template<typename ItemType> bool spillRecord(const ItemType&) { return false; }
+	bool spillRecord(const FrameInfo& info);
+	bool spillRecord(const PlayerAction& action);
+	bool spillRecord(const RemotePlayerAction& action);
+	bool spillRecord(const TargetLocation& location);
+	bool spillRecord(const NetworkedClient& client);
+	bool spillRecord(const InterpolationStats& stats);
+	bool spillRecord(const ImpairmentRecord& record);
+	/** Append a serialized record to the spill file */
+	bool appendToSpillFile(const BinaryOutput& record);
+	/** Write any spilled records into the results file then remove the spill file (called once the logging thread has stopped) */
+	void mergeSpillFile();
+
+	/** Write the dropped/spilled record counts for this session to the Logger_Overflow table */
+	void recordOverflowCounts();
+
 	void loggerThreadEntry();
+	void shardThreadEntry(LogShard* shard);
+
+	/** Create the job that drains a queue and writes its records using the given record function */
+	template<typename ItemType> TableJob tableJob(RecordQueue<ItemType>& queue, void (FPSciLogger::*record)(const Array<ItemType>&))
+	{
+		TableJob job;
+		job.tableName = queue.tableName;
+		job.counters = &queue;
+		job.write = [this, &queue, record] {
+			Array<ItemType> items;
+			drainQueue(queue, items);
+			(this->*record)(items);
+			queue.rowsWritten.fetch_add(items.size(), std::memory_order_relaxed);
+		};
+		return job;
+	}
+
+	/** Add a completed writer pass (flush) to the statistics */
+	void recordFlushStats(RealTime flushS);
+
+	/** Open the shard databases for the tables listed in the logger config */
+	void openShards(const String& filename);
+	/** Stop the shard threads (called once the logging thread has stopped) */
+	void stopShards();
+	/** Copy each shard's rows into the results file, then close and remove the shard files */
+	void mergeShards();
+
+	/** Create a sink (if it isn't already in use) */
+	void addSink(const String& sinkName, const String& filePrefix);
+	/** Sinks a table is written to (from the logger config) */
+	Array<shared_ptr<LogSink>> tableSinks(const String& tableName) const;
+	/** Create a table in each of its sinks */
+	void createTable(const String& tableName, const Columns& columns);
+	/** Get the (cached) writer for a table, creating it on first use */
+	shared_ptr<LogTableWriter> tableWriter(const String& tableName, int columnCount);
+	/** Start/end a batch of rows in every sink (only include the shard sinks when the shard threads are stopped) */
+	void beginBatch(bool includeShards = false);
+	void endBatch(bool includeShards = false);
 
 	/** Record an array of frame timing info */
 	void recordFrameInfo(const Array<FrameInfo>& info);
@@ -108,6 +505,18 @@ protected:
 
 
 	void recordNetworkedClients(const Array<NetworkedClient>& clients);
+	void recordSnapshotStats(const Array<SnapshotStats>& stats);
+	void recordInterpolationStats(const Array<InterpolationStats>& stats);
+	void recordHitValidations(const Array<HitValidation>& validations);
+	void recordPredictionCorrections(const Array<PredictionCorrection>& corrections);
+	void recordImpairments(const Array<ImpairmentRecord>& records);
+
+	void recordQuestions(const Array<QuestionResult>& questions);
+	void recordTargets(const Array<TargetInfo>& targets);
+	void recordTargetTypes(const Array<shared_ptr<TargetConfig>>& targetTypes);
+	void recordTrials(const Array<TrialValues>& trials);
+	void recordUsers(const Array<UserValues>& users);
+	void recordPlayerConfigs(const Array<PlayerValues>& playerConfigs);
 
 	/** Open a results file, or create it if it doesn't exist */
 	void initResultsFile(const String& filename, 
@@ -119,6 +528,16 @@ protected:
 	/** Close the results file */
 	void closeResultsFile(void);
 
+	/** Apply the SQLite journal/sync/cache settings from the logger config to an open database (the results file or a shard) */
+	void applyPragmas(sqlite3* db);
+
+	/** Convert the time column of a table in a results file written before times were logged as integer ns (where it is
+		text) so new rows can be appended to it. Tables that don't have an integer time column in columns are left alone. */
+	void migrateTextTimes(const String& tableName, const Columns& columns);
+
+	/** Create a "{tableName}_Text_Time" view of a table with its (integer) time column formatted as text */
+	void createTextTimeView(const String& tableName, const Columns& columns);
+
 	// Functions that set up the database schema
 	/** Create a session table with columns as specified by the provided sessionConfig */
 	void createExperimentsTable(const String& expConfigFilename);
@@ -133,7 +552,17 @@ protected:
 	void createQuestionsTable();
 	void createUsersTable();
 	void createNetworkedClientTable();
+	void createSnapshotStatsTable();
+	void createInterpolationStatsTable();
+	void createHitValidationTable();
+	void createPredictionCorrectionsTable();
+	void createImpairmentsTable();
 	void createPlayerConfigTable();
+	void createLoggerOverflowTable();
+	void createLoggerStatsTable();
+
+	/** Write the final logger statistics for this session to the Logger_Stats table */
+	void recordLoggerStats();
 
 	// Functions that assume the schema from above
 	//void insertSession(sessionInfo);
@@ -168,16 +597,34 @@ public:
 	void logTargetTypes(const Array<shared_ptr<TargetConfig>>& targets);
 
 	void logNetworkedClient(const NetworkedClient& client) { addToQueue(m_networkedClients, client); }
+	void logSnapshotStats(const SnapshotStats& stats) { addToQueue(m_snapshotStats, stats); }
+	void logInterpolationStats(const InterpolationStats& stats) { addToQueue(m_interpolationStats, stats); }
+	void logHitValidation(const HitValidation& validation) { addToQueue(m_hitValidations, validation); }
+	void logPredictionCorrection(const PredictionCorrection& correction) { addToQueue(m_predictionCorrections, correction); }
+	void logImpairment(const ImpairmentRecord& record) { addToQueue(m_impairments, record); }
 	void logPlayerConfig(const PlayerConfig& playerConfig, const GUniqueID& id, int trialNumber);
 
-	/** Wakes up the logging thread and flushes even if the buffer limit is not reached yet. */
-	void flush(bool blockUntilDone);
+	/** Wakes up the logging thread and flushes even if the buffer limit is not reached yet.
+		If blockUntilDone is set this waits (up to timeoutS) for everything logged before the call to be committed to the results file.
+		Returns false if the wait timed out. Records dropped or spilled by the overflow policy are not waited on. */
+	bool flush(bool blockUntilDone, RealTime timeoutS = 5.0);
 	
-	/** Generate a timestamp for logging */
+	/** Get a snapshot of the logger statistics (safe to call from any thread) */
+	Stats stats();
+
+	/** Generate a (text) timestamp for logging */
 	static String genUniqueTimestamp();
 
-	static FILETIME getFileTime();
-	static String formatFileTime(FILETIME ft);
+	/** Current time for logging in ns since the Unix epoch.
+		This is the wall clock time at startup advanced by a monotonic clock, so logged times never go backwards. */
+	static int64 getTime();
+	/** Format a getTime() value as "YYYY-MM-DD hh:mm:ss.uuuuuu" (UTC) */
+	static String formatTime(int64 time);
+
+	/** Capture the time used for per-frame records (call once at the start of each frame) */
+	static void updateFrameTime();
+	/** Time captured by the last updateFrameTime() call (or the current time if it hasn't been called yet) */
+	static int64 frameTime();
 
 	/** Genearte a timestamp for filenames */
 	static String genFileTimestamp();
@@ -187,7 +634,4 @@ public:
 
 	/** Add a target to an experiment */
 	void addTarget(const String& name, const shared_ptr<TargetConfig>& targetConfig, const String& spawnTime, const float& size, const Point2& spawnEcc);
-
-	/** Write to CSV failsafe **/
-	void writeToFile(String folderName, String fileName, RowEntry data);
 };
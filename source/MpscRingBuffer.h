@@ -0,0 +1,111 @@
+#pragma once
+#include <G3D/G3D.h>
+#include <atomic>
+#include <memory>
+
+/** Bounded lock-free multiple-producer/single-consumer ring buffer
+
+	Producers claim a slot with a single compare-and-swap on the enqueue position and publish it
+	by bumping the slot's sequence number, so pushes never block on each other or on the consumer.
+	Only one thread may call tryPop()/drainTo() at a time. The capacity is rounded up to a power of 2.
+*/
+template <typename ItemType>
+class MpscRingBuffer {
+protected:
+	struct Cell {
+		std::atomic<size_t>	sequence;				///< Publication sequence number for this slot
+		ItemType			item;					///< Stored value
+	};
+
+	std::unique_ptr<Cell[]>	m_cells;
+	size_t					m_mask = 0;
+
+	char					m_pad0[64];				///< Keep the producer/consumer positions on separate cache lines
+	std::atomic<size_t>		m_enqueuePos;			///< Next slot to be claimed by a producer
+	char					m_pad1[64];
+	size_t					m_dequeuePos = 0;		///< Next slot to be read by the (single) consumer
+
+	// Don't allow copies
+	MpscRingBuffer(const MpscRingBuffer&);
+	void operator=(const MpscRingBuffer&);
+
+	/** Claim the next free slot for a producer, returns nullptr if the ring is full */
+	Cell* claimSlot() {
+		size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+		for (;;) {
+			Cell* cell = &m_cells[pos & m_mask];
+			const size_t seq = cell->sequence.load(std::memory_order_acquire);
+			const intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+			if (diff == 0) {
+				// Slot is free, try to claim it
+				if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) return cell;
+			}
+			else if (diff < 0) {
+				return nullptr;		// Ring is full (the consumer hasn't released this slot yet)
+			}
+			else {
+				pos = m_enqueuePos.load(std::memory_order_relaxed);		// Another producer claimed this slot
+			}
+		}
+	}
+
+	/** Make a claimed slot visible to the consumer (its sequence number is the claimed position) */
+	void publishSlot(Cell* cell) {
+		cell->sequence.store(cell->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+public:
+	explicit MpscRingBuffer(size_t capacity) {
+		size_t size = 2;
+		while (size < capacity) size <<= 1;
+		m_cells.reset(new Cell[size]);
+		m_mask = size - 1;
+		for (size_t i = 0; i < size; i++) {
+			m_cells[i].sequence.store(i, std::memory_order_relaxed);
+		}
+		m_enqueuePos.store(0, std::memory_order_relaxed);
+	}
+
+	size_t capacity() const { return m_mask + 1; }
+
+	/** Push a copy of item, returns false (without blocking) if the ring is full */
+	bool tryPush(const ItemType& item) {
+		Cell* cell = claimSlot();
+		if (cell == nullptr) return false;
+		cell->item = item;
+		publishSlot(cell);
+		return true;
+	}
+
+	/** Move item into the ring, returns false (without blocking, and leaving item untouched) if the ring is full */
+	bool tryPush(ItemType&& item) {
+		Cell* cell = claimSlot();
+		if (cell == nullptr) return false;
+		cell->item = std::move(item);
+		publishSlot(cell);
+		return true;
+	}
+
+	/** Pop the oldest item (consumer thread only), returns false if nothing is ready */
+	bool tryPop(ItemType& item) {
+		Cell* cell = &m_cells[m_dequeuePos & m_mask];
+		const size_t seq = cell->sequence.load(std::memory_order_acquire);
+		if ((intptr_t)seq - (intptr_t)(m_dequeuePos + 1) < 0) return false;
+		item = std::move(cell->item);
+		cell->item = ItemType();			// Release anything the item owns now rather than on slot reuse
+		cell->sequence.store(m_dequeuePos + m_mask + 1, std::memory_order_release);
+		m_dequeuePos++;
+		return true;
+	}
+
+	/** Move up to one ring's worth of ready items into out (consumer thread only), returns the count moved */
+	size_t drainTo(Array<ItemType>& out) {
+		size_t count = 0;
+		ItemType item;
+		while (count < capacity() && tryPop(item)) {
+			out.append(item);
+			count++;
+		}
+		return count;
+	}
+};
@@ -0,0 +1,109 @@
+#include "NetworkImpairment.h"
+#include "Logger.h"
+
+const char* ImpairmentRecord::actionToString(Action action) {
+	switch (action) {
+	case DELIVERED: return "delivered";
+	case LOST: return "lost";
+	case BURST_LOST: return "burst_lost";
+	case QUEUE_DROPPED: return "queue_dropped";
+	case DUPLICATED: return "duplicated";
+	}
+	return "unknown";
+}
+
+NetworkImpairment::NetworkImpairment(const NetworkImpairmentConfig& config, uint32 stream) :
+	m_config(config),
+	m_random((uint32)config.seed + stream * 0x9E3779B9u, false)		// Spread the streams out so neighboring ones aren't correlated
+{
+	m_tokens = (double)m_config.bucketBytes;
+	m_tokenTime = Clock::now();
+}
+
+float NetworkImpairment::jitter(float u0, float u1) const {
+	if (m_config.jitterMs <= 0.0f) return 0.0f;
+	// 1 - u0 is in (0, 1], clamped so the log is always finite
+	const float logU = log(max(1.0f - u0, 1e-7f));
+	if (m_config.jitterDistribution == "normal") {
+		// Box-Muller transform, jitterMs is the standard deviation
+		return m_config.jitterMs * sqrt(-2.0f * logU) * cos(2.0f * pif() * u1);
+	}
+	else if (m_config.jitterDistribution == "exponential") {
+		// Only ever adds delay, jitterMs is the mean
+		return -m_config.jitterMs * logU;
+	}
+	return m_config.jitterMs * (2.0f * u0 - 1.0f);
+}
+
+float NetworkImpairment::queueFor(int bytes, bool reliable, Clock::time_point now, bool& dropped) {
+	dropped = false;
+	if (m_config.bandwidthKbps <= 0.0f) return 0.0f;
+	const double bytesPerS = m_config.bandwidthKbps * 1000.0 / 8.0;
+	// Refill the bucket for the time since the last packet, it goes negative while packets are queued behind the cap
+	if (now > m_tokenTime) {
+		m_tokens = min(m_tokens + bytesPerS * std::chrono::duration<double>(now - m_tokenTime).count(), (double)m_config.bucketBytes);
+		m_tokenTime = now;
+	}
+	const float queueS = (m_tokens >= bytes) ? 0.0f : (float)((bytes - m_tokens) / bytesPerS);
+	if (!reliable && 1000.0f * queueS > m_config.queueLimitMs) {
+		dropped = true;		// Tail drop, the packet never enters the queue
+		return queueS;
+	}
+	m_tokens -= bytes;
+	return queueS;
+}
+
+int NetworkImpairment::impair(Clock::time_point now, float latencyMs, const ENetAddress& destination, uint8 packetType, int bytes, bool reliable,
+	Clock::time_point sendTimes[MAX_COPIES], Array<ImpairmentRecord>& records)
+{
+	// Every packet takes the same random values whatever happens to it, so one decision never shifts the ones after it
+	float u[4 + 2 * MAX_COPIES];
+	for (float& value : u) value = m_random.uniform();
+
+	ImpairmentRecord record;
+	record.time = FPSciLogger::getTime();
+	record.destination = destination;
+	record.packetType = packetType;
+	record.reliable = reliable;
+	record.bytes = bytes;
+	record.sequence = ++m_sequence;
+
+	// Gilbert-Elliott loss (the burst state is never entered with burstStartRate = 0, leaving Bernoulli loss at lossRate)
+	m_burst = m_burst ? (u[0] >= m_config.burstEndRate) : (u[0] < m_config.burstStartRate);
+	record.burst = m_burst;
+	const float lossRate = m_burst ? m_config.burstLossRate : m_config.lossRate;
+	if (!reliable && u[1] < lossRate) {
+		record.action = m_burst ? ImpairmentRecord::BURST_LOST : ImpairmentRecord::LOST;
+		records.append(record);
+		return 0;
+	}
+
+	const bool reorder = !reliable && u[2] < m_config.reorderRate;
+	const int copies = (!reliable && u[3] < m_config.duplicateRate) ? 2 : 1;
+	int sent = 0;
+	for (int i = 0; i < copies; i++) {
+		ImpairmentRecord& copy = records.next();
+		copy = record;
+		copy.action = (i == 0) ? ImpairmentRecord::DELIVERED : ImpairmentRecord::DUPLICATED;
+
+		bool dropped;
+		copy.queueMs = 1000.0f * queueFor(bytes, reliable, now, dropped);
+		if (dropped) {
+			copy.action = ImpairmentRecord::QUEUE_DROPPED;
+			continue;
+		}
+		copy.jitterMs = jitter(u[4 + 2 * i], u[5 + 2 * i]);
+		copy.reordered = reorder;
+
+		const float delayMs = max(latencyMs + copy.jitterMs, 0.0f) + copy.queueMs + (reorder ? m_config.reorderDelayMs : 0.0f);
+		Clock::time_point sendTime = now + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(delayMs));
+		if (reliable) {
+			// ENet delivers reliable packets in order, so jitter can't reorder them
+			sendTime = std::max(sendTime, m_lastReliableTime);
+			m_lastReliableTime = sendTime;
+		}
+		copy.delayMs = std::chrono::duration<float, std::milli>(sendTime - now).count();
+		sendTimes[sent++] = sendTime;
+	}
+	return sent;
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <G3D/G3D.h>
+#include <enet/enet.h>
+#include <chrono>
+#include "FpsConfig.h"
+
+/** Data storage object for logging what the impairment emulator did with a packet (or a duplicate of one) */
+struct ImpairmentRecord {
+	enum Action : uint8 {
+		DELIVERED = 0,		///< Sent (after any added delay)
+		LOST,				///< Dropped by the (Bernoulli or good state) loss rate
+		BURST_LOST,			///< Dropped in the Gilbert-Elliott burst loss state
+		QUEUE_DROPPED,		///< Dropped because it would have queued longer than the queue limit for the bandwidth cap
+		DUPLICATED			///< An extra copy of the previous packet was sent
+	};
+
+	int64		time = 0;				///< Time the packet was sent (from FPSciLogger::getTime())
+	ENetAddress	destination;
+	uint8		packetType = 0;
+	bool		reliable = false;
+	int			bytes = 0;
+	Action		action = DELIVERED;
+	bool		burst = false;			///< Was the loss model in the burst loss state?
+	bool		reordered = false;		///< Was the packet held back (so later packets overtake it)?
+	float		delayMs = 0.0f;			///< Total delay added to the packet (latency, jitter, queueing and reordering)
+	float		jitterMs = 0.0f;
+	float		queueMs = 0.0f;			///< Time spent queued for the bandwidth cap
+	uint64		sequence = 0;			///< Packet number (counted per emulator, starting from 1)
+
+	static const char* actionToString(Action action);
+};
+
+/** Emulates network conditions (jitter, loss, reordering, duplication and a bandwidth cap) for the packets sent to one destination
+
+	The decisions come from a random number generator seeded from the config's seed (and a stream number, so each client
+	can be given its own sequence), and every packet uses the same number of random values whatever happens to it. Given
+	the same packets, a run with the same seed makes the same decisions. Only the bandwidth cap depends on when packets are
+	sent.
+
+	Reliable packets are delayed (and kept in order) but never lost, reordered or duplicated, as ENet would hide that from
+	the application (by retransmitting and reordering on receipt) anyway.
+*/
+class NetworkImpairment {
+public:
+	typedef std::chrono::high_resolution_clock Clock;
+
+	static const int MAX_COPIES = 2;			///< Most copies sent for a packet (the original and a duplicate)
+
+protected:
+	NetworkImpairmentConfig		m_config;
+	Random						m_random;
+	bool						m_burst = false;					///< Is the loss model in the (Gilbert-Elliott) burst loss state?
+	double						m_tokens = 0.0;						///< Bytes that can be sent without queueing (negative while packets are queued)
+	Clock::time_point			m_tokenTime;						///< Time m_tokens was last updated
+	Clock::time_point			m_lastReliableTime;					///< Send time of the last reliable packet (so they stay in order)
+	uint64						m_sequence = 0;
+
+	/** Draw a jitter value (in ms) from the configured distribution using two uniform random values */
+	float jitter(float u0, float u1) const;
+	/** Time (in s) a packet of this size would queue for the bandwidth cap, and take its bytes from the bucket if it isn't dropped */
+	float queueFor(int bytes, bool reliable, Clock::time_point now, bool& dropped);
+
+public:
+	NetworkImpairment(const NetworkImpairmentConfig& config, uint32 stream);
+
+	static shared_ptr<NetworkImpairment> create(const NetworkImpairmentConfig& config, uint32 stream = 0) {
+		return createShared<NetworkImpairment>(config, stream);
+	}
+
+	const NetworkImpairmentConfig& config() const { return m_config; }
+
+	/** Decide what happens to a packet sent now with the given latency (in ms) added. Fills sendTimes with the time to send
+		each copy of the packet, appends a record of each decision to records, and returns the number of copies to send
+		(0 if the packet is dropped). */
+	int impair(Clock::time_point now, float latencyMs, const ENetAddress& destination, uint8 packetType, int bytes, bool reliable,
+		Clock::time_point sendTimes[MAX_COPIES], Array<ImpairmentRecord>& records);
+};
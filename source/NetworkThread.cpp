@@ -0,0 +1,200 @@
+#include "NetworkThread.h"
+#include "NetworkUtils.h"
+#include "LatentNetwork.h"
+
+std::atomic<NetworkThread*> NetworkThread::s_running{ nullptr };
+
+const Array<float>& NetworkThread::waitHistogramBucketsUs() {
+	static const Array<float> buckets = { 100.0f, 250.0f, 500.0f, 1000.0f, 2000.0f, 4000.0f, 8000.0f, 16000.0f, 33000.0f };
+	return buckets;
+}
+
+NetworkThread::NetworkThread(ENetHost* host, ENetSocket* socket) : m_host(host), m_socket(socket)
+{
+	// Bind the wake socket to an arbitrary loopback port (posting a task sends it a byte)
+	m_wakeSocket = enet_socket_create(ENET_SOCKET_TYPE_DATAGRAM);
+	enet_socket_set_option(m_wakeSocket, ENET_SOCKOPT_NONBLOCK, 1);
+	enet_address_set_host(&m_wakeAddress, "127.0.0.1");
+	m_wakeAddress.port = 0;
+	if (m_wakeSocket == ENET_SOCKET_NULL || enet_socket_bind(m_wakeSocket, &m_wakeAddress) || enet_socket_get_address(m_wakeSocket, &m_wakeAddress)) {
+		if (m_wakeSocket != ENET_SOCKET_NULL) enet_socket_destroy(m_wakeSocket);
+		throw std::runtime_error("Could not create the network thread's wake socket");
+	}
+
+	m_waitHistogram.resize(waitHistogramBucketsUs().size() + 1);
+	for (uint64& count : m_waitHistogram) count = 0;
+
+	m_running = true;
+	m_waiting = false;
+	m_thread = std::thread(&NetworkThread::threadMain, this);
+	m_threadId = m_thread.get_id();
+	s_running = this;
+	logPrintf("Started the network thread\n");
+}
+
+NetworkThread::~NetworkThread()
+{
+	stop();
+}
+
+void NetworkThread::threadMain()
+{
+	while (m_running) {
+		runHandedOver();
+		receivePending();
+		waitForWork();
+	}
+	runHandedOver();		// Send anything handed over before stop()
+}
+
+int NetworkThread::runHandedOver()
+{
+	int count = 0;
+	Task task;
+	while (m_tasks.tryPop(task)) {
+		task();
+		count++;
+	}
+	shared_ptr<LatentPacket> packet;
+	while (m_latentPackets.tryPop(packet)) {
+		const LatentNetwork::Clock::time_point sentTime = LatentNetwork::Clock::now();
+		packet->send();
+		LatentNetwork::getInstance().recordSend(*packet, sentTime);
+		count++;
+	}
+	// Reliable packets would otherwise wait for the next service of the host to go out
+	if (count > 0) enet_host_flush(m_host);
+	return count;
+}
+
+void NetworkThread::receivePending()
+{
+	while (!m_received.full()) {
+		const shared_ptr<GenericPacket> packet = NetworkUtils::receivePacket(m_host, m_socket);
+		if (isNull(packet)) return;
+		m_received.tryPush(packet);
+	}
+}
+
+void NetworkThread::waitForWork()
+{
+	if (m_received.full()) {
+		// The simulation is behind, leave the rest on the sockets until it catches up
+		std::this_thread::sleep_for(std::chrono::microseconds(100));
+		return;
+	}
+
+	m_waiting = true;
+	std::atomic_thread_fence(std::memory_order_seq_cst);		// Pairs with the fence in post() so a handed over task is never missed
+	if (m_tasks.empty() && m_latentPackets.empty()) {
+		ENetSocketSet readSet;
+		ENET_SOCKETSET_EMPTY(readSet);
+		ENET_SOCKETSET_ADD(readSet, m_host->socket);
+		ENET_SOCKETSET_ADD(readSet, *m_socket);
+		ENET_SOCKETSET_ADD(readSet, m_wakeSocket);
+		const ENetSocket maxSocket = std::max(std::max(m_host->socket, *m_socket), m_wakeSocket);
+		if (enet_socketset_select(maxSocket, &readSet, nullptr, s_pollTimeoutMs) < 0) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(s_pollTimeoutMs));
+		}
+	}
+	m_waiting = false;
+
+	// Drain the wake ups
+	uint8 wakeData[16];
+	ENetBuffer buff;
+	buff.data = wakeData;
+	buff.dataLength = sizeof(wakeData);
+	ENetAddress from;
+	while (enet_socket_receive(m_wakeSocket, &from, &buff, 1) > 0) {}
+}
+
+void NetworkThread::wake()
+{
+	if (!m_waiting) return;
+	uint8 wakeData = 0;
+	ENetBuffer buff;
+	buff.data = &wakeData;
+	buff.dataLength = 1;
+	enet_socket_send(m_wakeSocket, &m_wakeAddress, &buff, 1);
+}
+
+void NetworkThread::post(const Task& task)
+{
+	while (!m_tasks.tryPush(task)) {
+		wake();
+		std::this_thread::yield();
+	}
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	wake();
+}
+
+void NetworkThread::postLatent(const shared_ptr<LatentPacket>& packet)
+{
+	while (!m_latentPackets.tryPush(packet)) {
+		wake();
+		std::this_thread::yield();
+	}
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	wake();
+}
+
+void NetworkThread::stop()
+{
+	if (!m_running.exchange(false)) return;
+	wake();
+	m_thread.join();
+	s_running = nullptr;
+
+	// The latent network may have handed packets over after the thread's last look
+	shared_ptr<LatentPacket> packet;
+	while (m_latentPackets.tryPop(packet)) {
+		const LatentNetwork::Clock::time_point sentTime = LatentNetwork::Clock::now();
+		packet->send();
+		LatentNetwork::getInstance().recordSend(*packet, sentTime);
+	}
+	enet_host_flush(m_host);
+	enet_socket_destroy(m_wakeSocket);
+	logHandoffReport();
+}
+
+bool NetworkThread::receive(shared_ptr<GenericPacket>& packet)
+{
+	m_maxQueued = max(m_maxQueued, (int)m_received.size());
+	if (!m_received.tryPop(packet)) return false;
+
+	const double waitUs = std::chrono::duration<double, std::micro>(Clock::now() - packet->m_arrivalTime).count();
+	const Array<float>& buckets = waitHistogramBucketsUs();
+	int bucket = 0;
+	while (bucket < buckets.size() && waitUs > buckets[bucket]) bucket++;
+	m_dispatched++;
+	m_waitSumUs += waitUs;
+	m_maxWaitUs = max(m_maxWaitUs, waitUs);
+	m_waitHistogram[bucket]++;
+	return true;
+}
+
+NetworkThread::HandoffStats NetworkThread::stats() const
+{
+	HandoffStats s;
+	s.dispatched = m_dispatched;
+	s.meanWaitUs = (m_dispatched > 0) ? m_waitSumUs / m_dispatched : 0.0;
+	s.maxWaitUs = m_maxWaitUs;
+	s.waitHistogram = m_waitHistogram;
+	s.maxQueued = m_maxQueued;
+	return s;
+}
+
+void NetworkThread::logHandoffReport() const
+{
+	const HandoffStats s = stats();
+	if (s.dispatched == 0) return;
+	logPrintf("Network thread handed %llu packets to the simulation, which waited %.1f us on average to be dispatched (max %.1f us, at most %d queued):\n",
+		(unsigned long long)s.dispatched, s.meanWaitUs, s.maxWaitUs, s.maxQueued);
+	const Array<float>& buckets = waitHistogramBucketsUs();
+	uint64 cumulative = 0;
+	for (int i = 0; i < s.waitHistogram.size(); i++) {
+		cumulative += s.waitHistogram[i];
+		const String range = (i < buckets.size()) ? format("<= %6.0f us", buckets[i]) : format(" > %6.0f us", buckets.last());
+		logPrintf("\t%s: %8llu (%5.1f%% cumulative)\n", range.c_str(), (unsigned long long)s.waitHistogram[i], 100.0 * cumulative / s.dispatched);
+	}
+}
@@ -0,0 +1,109 @@
+#pragma once
+#include <G3D/G3D.h>
+#include <enet/enet.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include "Packet.h"
+#include "SpscRingBuffer.h"
+
+struct LatentPacket;
+
+/** Polls the network on a dedicated thread, so packets are read (and timestamped) as they arrive rather than once per frame
+
+	While it runs, this thread is the only one that uses the ENet host and the unreliable socket. Received packets are parsed
+	here and handed to the simulation (render) thread through a single producer/single consumer queue, which the simulation
+	drains with PacketDispatcher::dispatchQueued(). Sends made on the simulation thread (through NetworkUtils) come back the
+	same way as tasks run here, and the LatentNetwork thread hands its due packets over on a queue of its own. The thread
+	waits on the sockets between packets and is woken (by a datagram to a loopback socket) when a send is handed over.
+*/
+class NetworkThread {
+public:
+	typedef std::chrono::high_resolution_clock Clock;
+	typedef std::function<void()> Task;
+
+	static const int QUEUE_CAPACITY = 4096;		///< Most packets (or tasks) waiting in each queue
+
+	/** Time received packets waited between being read from the network and being dispatched by the simulation */
+	struct HandoffStats {
+		uint64			dispatched = 0;
+		double			meanWaitUs = 0.0;
+		double			maxWaitUs = 0.0;
+		Array<uint64>	waitHistogram;				///< Packet counts for each of waitHistogramBucketsUs() (plus a final bucket for longer waits)
+		int				maxQueued = 0;				///< Most packets waiting to be dispatched at once
+	};
+
+	/** Upper bounds (in us) of the handoff wait histogram buckets */
+	static const Array<float>& waitHistogramBucketsUs();
+
+protected:
+	static std::atomic<NetworkThread*> s_running;		///< The running network thread (nullptr if there isn't one)
+
+	ENetHost*	m_host;
+	ENetSocket*	m_socket;
+	ENetSocket	m_wakeSocket;						///< Loopback socket the thread also waits on, so posting a task can wake it
+	ENetAddress	m_wakeAddress;
+
+	SpscRingBuffer<shared_ptr<GenericPacket>>	m_received{ QUEUE_CAPACITY };		///< Network thread -> simulation
+	SpscRingBuffer<Task>						m_tasks{ QUEUE_CAPACITY };			///< Simulation -> network thread
+	SpscRingBuffer<shared_ptr<LatentPacket>>	m_latentPackets{ QUEUE_CAPACITY };	///< LatentNetwork thread -> network thread
+
+	std::atomic<bool>	m_running;
+	std::atomic<bool>	m_waiting;						///< Is the thread (about to be) waiting on the sockets?
+	std::thread			m_thread;
+	std::thread::id		m_threadId;
+
+	// Handoff statistics (simulation thread only)
+	uint64			m_dispatched = 0;
+	double			m_waitSumUs = 0.0;
+	double			m_maxWaitUs = 0.0;
+	Array<uint64>	m_waitHistogram;
+	int				m_maxQueued = 0;
+
+	static const int s_pollTimeoutMs = 1;			///< Longest wait on the sockets (so ENet's timers are still serviced when nothing arrives)
+
+	void threadMain();
+	/** Run the tasks and send the delayed packets handed to this thread, returns the number run */
+	int runHandedOver();
+	/** Read and parse everything pending on the sockets (as long as there is room in the received queue) */
+	void receivePending();
+	/** Wait for the sockets to be readable, a wake up, or s_pollTimeoutMs */
+	void waitForWork();
+	/** Wake the thread up if it is waiting */
+	void wake();
+
+	// Don't allow copies
+	NetworkThread(const NetworkThread&);
+	void operator=(const NetworkThread&);
+
+public:
+	NetworkThread(ENetHost* host, ENetSocket* socket);
+	~NetworkThread();
+
+	/** Start polling the host and socket on a new thread (the caller must no longer use them directly) */
+	static shared_ptr<NetworkThread> create(ENetHost* host, ENetSocket* socket) {
+		return createShared<NetworkThread>(host, socket);
+	}
+
+	/** The running network thread, nullptr if there isn't one */
+	static NetworkThread* running() { return s_running.load(); }
+	/** Is the caller the network thread? */
+	bool isCurrentThread() const { return std::this_thread::get_id() == m_threadId; }
+
+	/** Stop the thread (running anything already handed to it first) */
+	void stop();
+
+	/** Have the network thread run a task (simulation thread only), e.g. a send. Blocks while the task queue is full. */
+	void post(const Task& task);
+	/** Have the network thread send a packet that is due (LatentNetwork thread only). Blocks while the queue is full. */
+	void postLatent(const shared_ptr<LatentPacket>& packet);
+
+	/** Take the next received packet (simulation thread only), returns false if there isn't one */
+	bool receive(shared_ptr<GenericPacket>& packet);
+
+	/** Handoff wait statistics (simulation thread only) */
+	HandoffStats stats() const;
+	/** Write the handoff wait distribution to the log */
+	void logHandoffReport() const;
+};
@@ -1,8 +1,53 @@
 #include "NetworkUtils.h"
 #include "TargetEntity.h"
 #include "LatentNetwork.h"
+#include "DatagramBatch.h"
+#include "NetworkThread.h"
+#include "PacketDispatcher.h"
 #include "FpsConfig.h"
 
+uint16 EntityIndexTable::assign(const String& name) {
+	if (m_nextIndex == NetworkedEntity::NO_NETWORK_INDEX) {
+		logPrintf("WARNING: Out of network indices, no updates will be sent for entity %s\n", name.c_str());
+		return NetworkedEntity::NO_NETWORK_INDEX;
+	}
+	const uint16 index = m_nextIndex++;
+	set(index, name);
+	return index;
+}
+
+void EntityIndexTable::set(uint16 index, const String& name) {
+	if (index == NetworkedEntity::NO_NETWORK_INDEX) return;
+	remove(name);
+	if (index >= m_names.size()) m_names.resize(index + 1);
+	if (!m_names[index].empty()) m_indices.remove(m_names[index]);		// The index was reassigned
+	m_names[index] = name;
+	m_indices.set(name, index);
+}
+
+void EntityIndexTable::remove(const String& name) {
+	const uint16* index = m_indices.getPointer(name);
+	if (isNull(index)) return;
+	m_names[*index] = "";
+	m_indices.remove(name);
+}
+
+void EntityIndexTable::clear() {
+	m_indices.clear();
+	m_names.fastClear();
+	m_nextIndex = 0;
+}
+
+uint16 EntityIndexTable::indexOf(const String& name) const {
+	const uint16* index = m_indices.getPointer(name);
+	return isNull(index) ? NetworkedEntity::NO_NETWORK_INDEX : *index;
+}
+
+const String* EntityIndexTable::nameOf(uint16 index) const {
+	if (index >= m_names.size() || m_names[index].empty()) return nullptr;
+	return &m_names[index];
+}
+
 NetworkUtils::ConnectedClient* NetworkUtils::registerClient(RegisterClientPacket* packet) {
 	ConnectedClient* newClient = new ConnectedClient();
 	newClient->peer = packet->m_peer;
@@ -16,150 +61,163 @@ NetworkUtils::ConnectedClient* NetworkUtils::registerClient(RegisterClientPacket
 	return newClient;
 }
 
+/** Typed packets for this thread's receives (see PacketPool) */
+static thread_local PacketPool s_packetPool;
+
 shared_ptr<GenericPacket> NetworkUtils::createTypedPacket(PacketType type, ENetAddress srcAddr, BinaryInput& inBuffer, ENetEvent* event) {
-	switch (type) {
-	case PacketType::BATCH_ENTITY_UPDATE:
-		return GenericPacket::createReceive<BatchEntityUpdatePacket>(srcAddr, inBuffer);
-		break;
-	case PacketType::CREATE_ENTITY:
-		return GenericPacket::createReceive<CreateEntityPacket>(srcAddr, inBuffer);
-		break;
-	case PacketType::DESTROY_ENTITY:
-		return GenericPacket::createReceive<DestroyEntityPacket>(srcAddr, inBuffer);
-		break;
-	case PacketType::MOVE_CLIENT:
-		return GenericPacket::createReceive<MoveClientPacket>(srcAddr, inBuffer);
-		break;
-	case PacketType::REGISTER_CLIENT: {
+	if (type == PacketType::REGISTER_CLIENT && isNull(event)) {
 		// TODO: Refactor this to be less bad
-		if (event == nullptr) {
-			debugPrintf("WARNING: received a RegisterClientPacket on the unreliable channel\n");
-			break;
-		}
-		shared_ptr<RegisterClientPacket> packet = GenericPacket::createReceive<RegisterClientPacket>(srcAddr, inBuffer);
-		packet->m_peer = event->peer;
-		return packet;
-		break;
-	}
-	case PacketType::CLIENT_REGISTRATION_REPLY:
-		return GenericPacket::createReceive<RegistrationReplyPacket>(srcAddr, inBuffer);
-		break;
-	case PacketType::HANDSHAKE:
-		return GenericPacket::createReceive<HandshakePacket>(srcAddr, inBuffer);
-		break;
-	case PacketType::HANDSHAKE_REPLY:
-		return GenericPacket::createReceive<HandshakeReplyPacket>(srcAddr, inBuffer);
-		break;
-	case PacketType::REPORT_HIT:
-		return GenericPacket::createReceive<ReportHitPacket>(srcAddr, inBuffer);
-		break;
-	case PacketType::SET_SPAWN_LOCATION:
-		return GenericPacket::createReceive<SetSpawnPacket>(srcAddr, inBuffer);
-		break;
-	case PacketType::RESPAWN_CLIENT:
-		return GenericPacket::createReceive<RespawnClientPacket>(srcAddr, inBuffer);
-		break;
-	case PacketType::READY_UP_CLIENT:
-		return GenericPacket::createReceive<ReadyUpClientPacket>(srcAddr, inBuffer);
-		break;
-	case PacketType::START_NETWORKED_SESSION:
-		return GenericPacket::createReceive<StartSessionPacket>(srcAddr, inBuffer);
-		break;
-	case PacketType::PLAYER_INTERACT:
-		return GenericPacket::createReceive<PlayerInteractPacket>(srcAddr, inBuffer);
-		break;
-	case PacketType::SEND_PLAYER_CONFIG:
-		return GenericPacket::createReceive<SendPlayerConfigPacket>(srcAddr, inBuffer);
-		break;
-	case PacketType::ADD_POINTS:
-		return GenericPacket::createReceive<AddPointPacket>(srcAddr, inBuffer);
-		break;
-	case PacketType::RESET_CLIENT_ROUND:
-		return GenericPacket::createReceive<ResetClientRoundPacket>(srcAddr, inBuffer);
-		break;
-	case PacketType::CLIENT_FEEDBACK_START:
-		return GenericPacket::createReceive<ClientFeedbackStartPacket>(srcAddr, inBuffer);
-		break;
-	case PacketType::CLIENT_SESSION_END:
-		return GenericPacket::createReceive<ClientSessionEndPacket>(srcAddr, inBuffer);
-		break;
-	case PacketType::CLIENT_ROUND_TIMEOUT:
-		return GenericPacket::createReceive<ClientRoundTimeoutPacket>(srcAddr, inBuffer);
-		break;
-	case PacketType::CLIENT_FEEDBACK_SUBMITTED:
-		return GenericPacket::createReceive<ClientFeedbackSubmittedPacket>(srcAddr, inBuffer);
-		break;
-	default:
+		debugPrintf("WARNING: received a RegisterClientPacket on the unreliable channel\n");
+		return nullptr;
+	}
+	if (!s_packetPool.hasType(type)) {
 		debugPrintf("WARNING: Could not create a typed packet of for type %d. Returning GenericPacket instead\n", type);
 		return GenericPacket::createReceive<GenericPacket>(srcAddr, inBuffer);
-		break;
 	}
+	shared_ptr<GenericPacket> packet = s_packetPool.acquire(type, srcAddr, inBuffer);
+	if (type == PacketType::REGISTER_CLIENT) {
+		static_cast<RegisterClientPacket*>(packet.get())->m_peer = event->peer;
+	}
+	return packet;
+}
+
+/** Datagrams received on the unreliable socket but not yet returned by receivePacket() (the buffers are reused for every batch,
+	the typed packets copy out everything they need) */
+static thread_local DatagramBatch s_receiveBatch;
+static thread_local int s_nextDatagram = 0;			///< Next datagram in s_receiveBatch to parse
+static thread_local ENetSocket s_batchSocket;		///< Socket s_receiveBatch was read from
+static thread_local std::chrono::high_resolution_clock::time_point s_batchTime;	///< Time s_receiveBatch was read
+
+shared_ptr<GenericPacket> NetworkUtils::parsePacket(ENetAddress srcAddr, const uint8* data, size_t length, ENetEvent* event) {
+	if (length == 0) return nullptr;
+	BinaryInput inBuffer(data, (int64)length, G3D_BIG_ENDIAN, false, false);	// Wrap the data rather than copying it
+	return NetworkUtils::createTypedPacket((PacketType)data[0], srcAddr, inBuffer, event); // Create a typed packet that reads all data based on type
 }
 
 shared_ptr<GenericPacket> NetworkUtils::receivePacket(ENetHost* host, ENetSocket* socket) {
-	ENetAddress srcAddr;
-	ENetBuffer buff;
-	void* data = malloc(ENET_HOST_DEFAULT_MTU);  //Allocate 1 mtu worth of space for the data from the packet
-	buff.data = data;
-	buff.dataLength = ENET_HOST_DEFAULT_MTU;
-	shared_ptr<GenericPacket> packet = nullptr;
-	if (enet_socket_receive(*socket, &srcAddr, &buff, 1)) {
-		BinaryInput inBuffer((const uint8*)buff.data, buff.dataLength, G3D_BIG_ENDIAN, false, true);
-		packet =  GenericPacket::createReceive<GenericPacket>(srcAddr, inBuffer); // Create a generic packet that reads just the type
-		inBuffer.setPosition(0);
-		packet = NetworkUtils::createTypedPacket(packet->type(), srcAddr, inBuffer); // Create a typed packet that reads all data based on type
-		packet->m_reliable = false;
-		return packet; // Return here so we only read from the socket and dont drop packets
+	if (s_batchSocket != *socket) {
+		// Datagrams from another socket can't be returned for this one
+		s_nextDatagram = s_receiveBatch.count();
+		s_batchSocket = *socket;
 	}
+	while (true) {
+		if (s_nextDatagram >= s_receiveBatch.count()) {
+			// A result <= 0 is nothing pending or a socket error (e.g. an ICMP port unreachable from a client that left), check the reliable channel
+			s_nextDatagram = 0;
+			if (s_receiveBatch.receive(*socket, batchedIO) <= 0) break;
+			s_batchTime = std::chrono::high_resolution_clock::now();
+		}
+		const int i = s_nextDatagram++;
+		if (s_receiveBatch.length(i) == 0) {
+			// Empty, or truncated (see DatagramBatch::receive())
+			debugPrintf("WARNING: dropped an empty or truncated datagram on the unreliable channel (%llu longer than %d bytes so far)\n", (unsigned long long)s_receiveBatch.truncatedCount(), DatagramBatch::DATAGRAM_SIZE);
+			continue;
+		}
+		shared_ptr<GenericPacket> packet = parsePacket(s_receiveBatch.address(i), s_receiveBatch.data(i), s_receiveBatch.length(i));
+		if (notNull(packet)) {
+			packet->m_reliable = false;
+			packet->m_arrivalTime = s_batchTime;
+			return packet; // Return here so we only read from the socket and dont drop packets
+		}
+	}
+
 	ENetEvent event;
-	if (enet_host_service(host, &event, 0)) {
-		 switch( event.type){
-		 case ENET_EVENT_TYPE_CONNECT: {
-			 packet = ReliableConnectPacket::createReceive(event.peer->address);
-			 packet->m_reliable = true;
-			 break;
-		 }
-		 case ENET_EVENT_TYPE_DISCONNECT: {
-			 packet = ReliableDisconnectPacket::createReceive(event.peer->address);
-			 packet->m_reliable = true;
-			 break;
-		 }
-		 case ENET_EVENT_TYPE_RECEIVE: {
-			 BinaryInput inBuffer(event.packet->data, event.packet->dataLength, G3D_BIG_ENDIAN);
-			 shared_ptr<GenericPacket> genPacket = GenericPacket::createReceive<GenericPacket>(event.peer->address, inBuffer);
-			 inBuffer.setPosition(0);
-			 packet = NetworkUtils::createTypedPacket(genPacket->type(), event.peer->address, inBuffer, &event);
-			 packet->m_reliable = true;
-			 break;
-		 }
-		 }
-		 return packet;
-		 enet_packet_destroy(event.packet);
-	}
-	free(data);
+	while (enet_host_service(host, &event, 0) > 0) {
+		shared_ptr<GenericPacket> packet = nullptr;
+		switch (event.type) {
+		case ENET_EVENT_TYPE_CONNECT: {
+			packet = ReliableConnectPacket::createReceive(event.peer->address);
+			break;
+		}
+		case ENET_EVENT_TYPE_DISCONNECT: {
+			packet = ReliableDisconnectPacket::createReceive(event.peer->address);
+			break;
+		}
+		case ENET_EVENT_TYPE_RECEIVE: {
+			// Own the ENet packet first so it is released even if it can't be parsed
+			const shared_ptr<ENetPacket> enetPacket(event.packet, enet_packet_destroy);
+			packet = parsePacket(event.peer->address, enetPacket->data, enetPacket->dataLength, &event);
+			if (notNull(packet)) packet->m_enetPacket = enetPacket;
+			break;
+		}
+		default:
+			break;
+		}
+		if (notNull(packet)) {
+			packet->m_reliable = true;
+			packet->m_arrivalTime = std::chrono::high_resolution_clock::now();
+			return packet;
+		}
+	}
 	// No new packets to receive
 	return nullptr;
 }
 
 void NetworkUtils::broadcastReliable(shared_ptr<GenericPacket> packet, ENetHost* localHost) {
+	// Serialize once (on the calling thread), the peers are only looked at where ENet is used
+	const shared_ptr<const BinaryOutput> payload = packet->serializeShared();
+	runSend([payload, localHost] { broadcastSerializedReliable(payload, localHost); });
+}
+
+void NetworkUtils::broadcastSerializedReliable(const shared_ptr<const BinaryOutput>& payload, ENetHost* localHost) {
+	// Every peer without added latency is sent the same ENet packet (ENet reference counts it per peer)
+	ENetPacket* sharedPacket = nullptr;
 	for (int i = 0; i < localHost->peerCount; i ++) {
 		/* 
 		 * Must loop through all the possible peers because ENet does not remove 
 		 * a peer from the array when they disconnect 
 		 */
-		if (localHost->peers[i].state == ENET_PEER_STATE_CONNECTED) {
-			shared_ptr<GenericPacket> packetCopy = packet->clone();
-			packetCopy->setReliableDest(&localHost->peers[i]);
-			NetworkUtils::send(packetCopy);
+		ENetPeer* peer = &localHost->peers[i];
+		if (peer->state != ENET_PEER_STATE_CONNECTED) continue;
+		const int latency = latencyFor(peer->address);
+		const shared_ptr<NetworkImpairment> impairment = impairmentFor(peer->address);
+		if (notNull(impairment)) {
+			sendImpaired(*impairment, payload, peer, nullptr, peer->address, latency);
+		}
+		else if (latency == 0) {
+			if (isNull(sharedPacket)) sharedPacket = enet_packet_create((void*)payload->getCArray(), payload->length(), ENET_PACKET_FLAG_RELIABLE);
+			enet_peer_send(peer, 0, sharedPacket);
 		}
+		else {
+			sendSerializedDelayed(payload, peer, nullptr, peer->address, latency);
+		}
+	}
+	if (notNull(sharedPacket) && sharedPacket->referenceCount == 0) {
+		enet_packet_destroy(sharedPacket);		// No peer queued it, so ENet won't free it
 	}
 }
 
 void NetworkUtils::broadcastUnreliable(shared_ptr<GenericPacket> packet, ENetSocket* srcSocket, Array<ENetAddress*> addresses) {
+	// Serialize once, addresses without added latency are sent the same bytes together (one system call per batch where supported)
+	const shared_ptr<const BinaryOutput> payload = packet->serializeShared();
+	Array<ENetAddress> immediate;
 	for (ENetAddress* destAddr : addresses) {
-		shared_ptr<GenericPacket> packetCopy = packet->clone();
-		packetCopy->setUnreliableDest(srcSocket, destAddr);
-		NetworkUtils::send(packetCopy);
+		const int latency = latencyFor(*destAddr);
+		const shared_ptr<NetworkImpairment> impairment = impairmentFor(*destAddr);
+		if (notNull(impairment)) {
+			sendImpaired(*impairment, payload, nullptr, srcSocket, *destAddr, latency);
+		}
+		else if (latency == 0) {
+			immediate.append(*destAddr);
+		}
+		else {
+			sendSerializedDelayed(payload, nullptr, srcSocket, *destAddr, latency);
+		}
+	}
+	if (immediate.size() > 0) {
+		runSend([payload, srcSocket, immediate] {
+			DatagramBatch::sendToAll(*srcSocket, payload->getCArray(), (size_t)payload->length(), immediate, batchedIO);
+		});
+	}
+}
+
+void NetworkUtils::runSend(const std::function<void()>& sendTask) {
+	NetworkThread* networkThread = NetworkThread::running();
+	if (notNull(networkThread) && !networkThread->isCurrentThread()) {
+		networkThread->post(sendTask);		// Only the network thread uses ENet while it runs
+	}
+	else {
+		sendTask();
 	}
 }
 
@@ -170,37 +228,117 @@ void NetworkUtils::sendPacketDelayed(shared_ptr<GenericPacket> packet, int delay
 	LatentNetwork::getInstance().enqueuePacket(latentPacket);
 }
 
+void NetworkUtils::sendSerializedDelayed(const shared_ptr<const BinaryOutput>& payload, ENetPeer* destPeer, ENetSocket* srcSocket, const ENetAddress& destAddr, int delay) {
+	const std::chrono::time_point<std::chrono::high_resolution_clock> timestamp = std::chrono::high_resolution_clock::now() + std::chrono::milliseconds(delay);
+	LatentNetwork::getInstance().enqueuePacket(LatentPacket::createSerialized(payload, destPeer, srcSocket, destAddr, timestamp));
+}
+
+void NetworkUtils::sendImpaired(NetworkImpairment& impairment, const shared_ptr<const BinaryOutput>& payload, ENetPeer* destPeer, ENetSocket* srcSocket, const ENetAddress& destAddr, int latency) {
+	const NetworkImpairment::Clock::time_point now = NetworkImpairment::Clock::now();
+	NetworkImpairment::Clock::time_point sendTimes[NetworkImpairment::MAX_COPIES];
+	int copies;
+	{
+		std::lock_guard<std::mutex> lk(addressMutex);
+		const uint8 type = (payload->length() > 0) ? payload->getCArray()[0] : 0;		// Every packet starts with its type
+		copies = impairment.impair(now, (float)latency, destAddr, type, (int)payload->length(), notNull(destPeer), sendTimes, impairmentRecords);
+	}
+	// Every copy goes through the latent network (even without a delay) so it can't overtake earlier delayed packets
+	for (int i = 0; i < copies; i++) {
+		LatentNetwork::getInstance().enqueuePacket(LatentPacket::createSerialized(payload, destPeer, srcSocket, destAddr, sendTimes[i]));
+	}
+}
+
+void NetworkUtils::setAddressImpairment(const Array<ENetAddress>& addrs, const NetworkImpairmentConfig& config, uint32 stream)
+{
+	std::lock_guard<std::mutex> lk(addressMutex);
+	// Addresses given together share an emulator (and start over with a new one each time they are set)
+	const shared_ptr<NetworkImpairment> impairment = config.enable ? NetworkImpairment::create(config, stream) : nullptr;
+	for (const ENetAddress& addr : addrs) {
+		impairmentMap.erase(addr);
+		if (notNull(impairment)) impairmentMap.insert({ addr, impairment });
+	}
+}
+
+void NetworkUtils::removeAddressImpairment(ENetAddress addr)
+{
+	std::lock_guard<std::mutex> lk(addressMutex);
+	impairmentMap.erase(addr);
+}
+
+void NetworkUtils::takeImpairmentRecords(Array<ImpairmentRecord>& records)
+{
+	records.fastClear();
+	std::lock_guard<std::mutex> lk(addressMutex);
+	Array<ImpairmentRecord>::swap(records, impairmentRecords);
+}
+
+shared_ptr<NetworkImpairment> NetworkUtils::impairmentFor(const ENetAddress& addr)
+{
+	std::lock_guard<std::mutex> lk(addressMutex);
+	auto searchResult = impairmentMap.find(addr);
+	return (searchResult != impairmentMap.end()) ? searchResult->second : nullptr;
+}
+
 void NetworkUtils::setAddressLatency(ENetAddress addr, int latency)
 {
+	std::lock_guard<std::mutex> lk(addressMutex);
 	NetworkUtils::latencyMap.erase(addr);
 	NetworkUtils::latencyMap.insert({ addr, latency });
 }
 
 void NetworkUtils::removeAddressLatency(ENetAddress addr)
 {
+	std::lock_guard<std::mutex> lk(addressMutex);
 	NetworkUtils::latencyMap.erase(addr);
 }
 
 void NetworkUtils::setDefaultLatency(int latency)
 {
+	std::lock_guard<std::mutex> lk(addressMutex);
 	NetworkUtils::defaultLatency = latency;
 }
 
-void NetworkUtils::send(shared_ptr<GenericPacket> packet)
+void NetworkUtils::setBatchedIO(bool enable)
 {
-	int latency = NetworkUtils::defaultLatency;
+	NetworkUtils::batchedIO = enable && DatagramBatch::supported();
+	logPrintf("Unreliable channel datagram batching is %s\n", NetworkUtils::batchedIO ? "enabled" : "disabled");
+}
 
-	ENetAddress addr = *(packet->getDestinationAddress());
+int NetworkUtils::latencyFor(const ENetAddress& addr)
+{
+	std::lock_guard<std::mutex> lk(addressMutex);
 	auto searchResult = NetworkUtils::latencyMap.find(addr);
 	if (searchResult != NetworkUtils::latencyMap.end()) {
-		latency = searchResult->second;
-	}
-	else {
-		//debugPrintf("could not find address!\n");
+		return searchResult->second;
 	}
+	return NetworkUtils::defaultLatency;
+}
+
+void NetworkUtils::send(shared_ptr<GenericPacket> packet)
+{
+	const ENetAddress& destAddr = *(packet->getDestinationAddress());
+	const int latency = latencyFor(destAddr);
+	const shared_ptr<NetworkImpairment> impairment = impairmentFor(destAddr);
 
-	if (latency == 0) { // don't bother the other thread if we don't want any delay
-		packet->send();
+	if (notNull(impairment)) {
+		sendImpaired(*impairment, packet->serializeShared(), packet->isReliable() ? packet->destPeer() : nullptr, packet->srcSocket(), destAddr, latency);
+	}
+	else if (latency == 0) { // don't bother the other thread if we don't want any delay
+		if (isNull(NetworkThread::running())) {
+			packet->send();
+		}
+		else {
+			// Serialize now, so the packet can't change before the network thread sends it
+			const shared_ptr<const BinaryOutput> payload = packet->serializeShared();
+			if (packet->isReliable()) {
+				ENetPeer* destPeer = packet->destPeer();
+				runSend([payload, destPeer] { GenericPacket::sendSerialized(*payload, destPeer); });
+			}
+			else {
+				ENetSocket* srcSocket = packet->srcSocket();
+				runSend([payload, srcSocket, destAddr] { GenericPacket::sendSerialized(*payload, srcSocket, &destAddr); });
+			}
+		}
 	}
 	else {
 		sendPacketDelayed(packet, latency);
@@ -209,4 +347,8 @@ void NetworkUtils::send(shared_ptr<GenericPacket> packet)
 
 // default latency is none by default:
 int NetworkUtils::defaultLatency = 0;
-std::map<ENetAddress, int, ENetAddressCompare> NetworkUtils::latencyMap;
\ No newline at end of file
+bool NetworkUtils::batchedIO = false;
+std::map<ENetAddress, int, ENetAddressCompare> NetworkUtils::latencyMap;
+std::mutex NetworkUtils::addressMutex;
+std::map<ENetAddress, shared_ptr<NetworkImpairment>, ENetAddressCompare> NetworkUtils::impairmentMap;
+Array<ImpairmentRecord> NetworkUtils::impairmentRecords;
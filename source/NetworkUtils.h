@@ -2,9 +2,14 @@
 #include <G3D/G3D.h>
 #include <enet/enet.h>
 #include <map>
+#include <mutex>
+#include <functional>
 #include "TargetEntity.h"
 #include "PlayerEntity.h"
 #include "Packet.h"
+#include "SnapshotHistory.h"
+#include "ClientInterest.h"
+#include "NetworkImpairment.h"
 /*
 			PACKET STRUCTURE:
 			UInt8: type
@@ -14,17 +19,26 @@
 			Type BATCH_ENTITY_UPDATE:
 			UInt8: type (BATCH_ENTITY_UPDATE)
 			uint32: Frame Number
-			UInt8: object_count # number of frames contained in this packet
-			<DATA> * n: Opaque view of data, written to and from with NetworkUtils
-			[DEPRECATED] GUID * n: ID of object
-			[DEPRECATED] * n: CFrames of objects
+			UInt16: object_count # number of frames contained in this packet (part)
+			UInt8: update type
+			UInt32: baseline frame (DELTA_FRAME updates) or last snapshot frame received (client updates), 0 for none
+			UInt8: part index (updates too large for one datagram are split, see BatchEntityUpdatePacket::split)
+			UInt8: part count
+			For each object (REPLACE_FRAME updates):
+				UInt16: entity index (from CREATE_ENTITY)
+				UInt64: position (3 x 21 bit fixed point, see BatchEntityUpdatePacket::packPosition)
+				UInt32: rotation ("smallest three" quaternion, see BatchEntityUpdatePacket::packRotation)
+			For each changed object (DELTA_FRAME updates, unchanged objects are left out):
+				UInt16: entity index
+				UInt8: changed fields (bit 0 = position, bit 1 = rotation)
+				UInt64: position (if changed)
+				UInt32: rotation (if changed)
 
 			Type CREATE_ENTITY:
 			UInt8: type (CREATE_ENTITY)
 			uint32: Frame Number
 			GUID: object ID
-			Uint8: Entity Type
-			... : misc. data for constructor, dependent on Entity type
+			UInt16: entity index (used in BATCH_ENTITY_UPDATE)
 
 			Type DESTROY_ENTITY:
 			UInt8: type (DESTROY_ENTITY)
@@ -43,6 +57,7 @@
 			uint32: Frame Number
 			GUID: player's ID
 			UInt8: status [0 = success, 1 = Failure, ....]
+			UInt16: player's entity index (used in BATCH_ENTITY_UPDATE)
 
 
 			Type HANDSHAKE
@@ -64,6 +79,9 @@
 			uint32: Frame Number
 			GUID: entity shot
 			GUID: shooter
+			Float64: server frame the shooter saw (fractional when interpolated)
+			Vector3: shot origin
+			Vector3: shot direction
 			...
 
 			Type NOTIFY_HIT:
@@ -98,6 +116,32 @@
 			uint8: action type
 			GUID: Player
 
+			Type PLAYER_INPUT:
+			UInt8: type (PLAYER_INPUT)
+			uint32: Frame Number
+			UInt8: input count
+			For each input (oldest first):
+				UInt32: sequence number
+				Float32: time step (s)
+				Vector2: movement input
+				Vector2: yaw/pitch change (radians)
+				UInt8: flags (see PlayerEntity::InputCommand::Flags)
+				Float64: time the input was taken
+				Movement state (RESPAWNED inputs only, see PLAYER_STATE)
+
+			Type PLAYER_STATE:
+			UInt8: type (PLAYER_STATE)
+			uint32: Frame Number
+			UInt32: sequence number of the last input simulated
+			Movement state:
+				Point3: position
+				Float32: heading, head tilt (radians)
+				Vector3: desired velocity, linear vector, last direction
+				Float32: accelerated velocity, last jump velocity
+				Float64: last jump time
+				UInt8: contact (bit 0 = in air, bit 1 = in contact)
+				Point3: restricted movement center
+
 */
 
 
@@ -108,6 +152,32 @@ struct ENetAddressCompare {
 };
 
 
+/** Session-scoped mapping between networked entity names (GUIDs) and the compact indices used to identify them in entity updates
+
+	The server assigns an index when it creates an entity and sends it along in the CREATE_ENTITY (and registration reply)
+	packets, clients record the indices they are sent. Indices aren't reused within a session, so a late update for a
+	removed entity can't be applied to a new one.
+*/
+class EntityIndexTable {
+protected:
+	Table<String, uint16>	m_indices;			///< Index for each entity name
+	Array<String>			m_names;			///< Name for each index ("" for unused indices)
+	uint16					m_nextIndex = 0;	///< Next index to assign
+
+public:
+	/** Assign the next free index to an entity (server only), returns NetworkedEntity::NO_NETWORK_INDEX if all are in use */
+	uint16 assign(const String& name);
+	/** Record the index for an entity (as sent by the server) */
+	void set(uint16 index, const String& name);
+	void remove(const String& name);
+	void clear();
+
+	/** Index for this entity name, NetworkedEntity::NO_NETWORK_INDEX if it hasn't got one */
+	uint16 indexOf(const String& name) const;
+	/** Name of the entity with this index, nullptr if there isn't one */
+	const String* nameOf(uint16 index) const;
+};
+
 class NetworkUtils
 {
 public:
@@ -118,23 +188,63 @@ public:
 		GUniqueID guid;
 		ENetAddress unreliableAddress;
 		uint32 frameNumber;
+		SnapshotHistory snapshots;			///< Snapshots sent to this client (baselines for its delta updates)
+		ClientInterest interest;			///< Which entities this client is sent (with interest management)
+		PlayerConfig playerConfig;			///< Player config the client moves with (as last sent to it)
+		shared_ptr<PlayerEntity> movement;	///< The client's movement simulated from its inputs (with prediction enabled, not in the scene)
+		uint32 inputSequence = 0;			///< Last input from the client simulated
+		bool inputsSimulated = false;		///< Were inputs simulated since the client was last sent its state?
 	};
 
 	static ConnectedClient* registerClient(RegisterClientPacket* packet);
 
+	/** Parse the typed packet for this type from the inBuffer (using a per-thread PacketPool, so the packet may be a reused one) */
 	static shared_ptr<GenericPacket> createTypedPacket(PacketType type, ENetAddress srcAddr, BinaryInput& inBuffer, ENetEvent* event = NULL);
+	/** Parse a typed packet from received data (without copying it), returns nullptr if the packet can't be used */
+	static shared_ptr<GenericPacket> parsePacket(ENetAddress srcAddr, const uint8* data, size_t length, ENetEvent* event = NULL);
+	/** Receive the next packet (unreliable channel first), returns nullptr if nothing is pending. The packet's m_arrivalTime is set to when it was read.
+		This doesn't allocate any receive buffers, datagrams are read in batches into reused per-thread buffers and
+		reliable packets are parsed in place (the ENet packet is released as soon as the last reference to the returned packet is dropped). */
 	static shared_ptr<GenericPacket> receivePacket(ENetHost* host, ENetSocket* socket);
 
+	/** Use batched (recvmmsg/sendmmsg) I/O on the unreliable socket where supported (see DatagramBatch) */
+	static void setBatchedIO(bool enable);
+
+	/** Send a packet to every connected peer (and addresses) on the reliable (unreliable) channel.
+		The packet is serialized once and the same bytes are sent to every destination, so it is never copied per destination. */
 	static void broadcastReliable(shared_ptr<GenericPacket> packet, ENetHost* localHost);
 	static void broadcastUnreliable(shared_ptr<GenericPacket> packet, ENetSocket* srcSocket, Array<ENetAddress*> addresses);
 
 	static void setAddressLatency(ENetAddress addr, int latency);
 	static void removeAddressLatency(ENetAddress addr);
 	static void setDefaultLatency(int latency);
+	/** Emulate network conditions (on top of any added latency) for packets sent to these addresses, i.e. both of a connection's channels.
+		The addresses share one emulator (so they share its bandwidth cap and loss state), whose decisions are seeded from the config's
+		seed and the stream number (e.g. the client's index). A disabled config removes any impairment for the addresses. */
+	static void setAddressImpairment(const Array<ENetAddress>& addrs, const NetworkImpairmentConfig& config, uint32 stream = 0);
+	static void removeAddressImpairment(ENetAddress addr);
+	/** Move the impairment decisions made since the last call into records (to be logged) */
+	static void takeImpairmentRecords(Array<ImpairmentRecord>& records);
 	static void send(shared_ptr<GenericPacket> packet);
 
 	protected:
+		/** Send every peer of the host the serialized bytes on the reliable channel (where ENet is used, see runSend()) */
+		static void broadcastSerializedReliable(const shared_ptr<const BinaryOutput>& payload, ENetHost* localHost);
+		/** Run a task that uses ENet to send now, or hand it to the network thread if one is running (see NetworkThread) */
+		static void runSend(const std::function<void()>& sendTask);
 		static void sendPacketDelayed(shared_ptr<GenericPacket> packet, int delay);
+		/** Send serialized bytes after a delay, over the reliable channel if destPeer is set (otherwise unreliably to destAddr) */
+		static void sendSerializedDelayed(const shared_ptr<const BinaryOutput>& payload, ENetPeer* destPeer, ENetSocket* srcSocket, const ENetAddress& destAddr, int delay);
+		/** Latency to add to packets sent to an address (in ms) */
+		static int latencyFor(const ENetAddress& addr);
+		/** Impairment emulator for packets sent to an address, nullptr if there isn't one */
+		static shared_ptr<NetworkImpairment> impairmentFor(const ENetAddress& addr);
+		/** Send serialized bytes through an impairment emulator, over the reliable channel if destPeer is set (otherwise unreliably to destAddr) */
+		static void sendImpaired(NetworkImpairment& impairment, const shared_ptr<const BinaryOutput>& payload, ENetPeer* destPeer, ENetSocket* srcSocket, const ENetAddress& destAddr, int latency);
 		static int defaultLatency;
+		static bool batchedIO;
 		static std::map<ENetAddress, int, ENetAddressCompare> latencyMap;
+		static std::mutex addressMutex;					///< Protects the per-address latencies, impairment emulators and impairment records (sends may come from several threads)
+		static std::map<ENetAddress, shared_ptr<NetworkImpairment>, ENetAddressCompare> impairmentMap;
+		static Array<ImpairmentRecord> impairmentRecords;	///< Decisions made since the last takeImpairmentRecords()
 };
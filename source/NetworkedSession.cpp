@@ -34,6 +34,7 @@
 #include "Dialogs.h"
 #include "Weapon.h"
 #include "FPSciAnyTableReader.h"
+#include "LatentNetwork.h"
 
 
 
@@ -55,7 +56,7 @@ void NetworkedSession::onSimulation(RealTime rdt, SimTime sdt, SimTime idt)
 		for (NetworkUtils::ConnectedClient* client : serverApp->getConnectedClients()) {
 			//TODO should be accumulate? not sure, but doing this for now to prevent crash:
 			if (notNull(logger)) {
-				logger->logFrameInfo(FrameInfo(FPSciLogger::getFileTime(), sdt, client->peer->lastRoundTripTime, serverApp->m_networkFrameNum, client->frameNumber, client->guid));
+				logger->logFrameInfo(FrameInfo(FPSciLogger::frameTime(), sdt, client->peer->lastRoundTripTime, serverApp->m_networkFrameNum, client->frameNumber, client->guid));
 			}
 		}
 	}
@@ -152,6 +153,9 @@ void NetworkedSession::feedbackStart() {
 
 void NetworkedSession::endSession() {
 	endLogging();
+	// Don't quit with (artificially) delayed packets still waiting to be sent
+	LatentNetwork::getInstance().flush(true);
+	LatentNetwork::getInstance().logDeliveryReport();
 	m_app->quitRequest();
 }
 
@@ -165,7 +169,7 @@ void NetworkedSession::logNetworkedEntity(shared_ptr<NetworkedEntity> entity, ui
 		Point2 dir = entity->getLookAzEl();
 		Point3 loc = entity->frame().translation;
 		GUniqueID id = GUniqueID::fromString16(entity->name());
-		NetworkedClient nc = NetworkedClient(FPSciLogger::getFileTime(), dir, loc, id, m_app->m_networkFrameNum, remoteFrame, currentState, action);
+		NetworkedClient nc = NetworkedClient(FPSciLogger::frameTime(), dir, loc, id, m_app->m_networkFrameNum, remoteFrame, currentState, action);
 		logger->logNetworkedClient(nc);
 		//debugPrintf("Logged...");
 	}
@@ -173,7 +177,7 @@ void NetworkedSession::logNetworkedEntity(shared_ptr<NetworkedEntity> entity, ui
 
 void NetworkedSession::accumulateFrameInfo(RealTime t, float sdt, float idt) {
 	if (notNull(logger) && m_config->logger.logFrameInfo) {
-		logger->logFrameInfo(FrameInfo(FPSciLogger::getFileTime(), sdt));
+		logger->logFrameInfo(FrameInfo(FPSciLogger::frameTime(), sdt));
 	}
 }
 
@@ -33,17 +33,17 @@
 #include "Session.h"
 
 struct RemotePlayerAction {
-	FILETIME			time;
+	int64				time = 0;
 	Point2				viewDirection = Point2::zero();
 	Point3				position = Point3::zero();
 	PresentationState	state;
 	PlayerActionType	action = PlayerActionType::None;
-	String				actorID = "";
-	String				affectedID = "";
+	LoggedGUID			actorID;
+	LoggedGUID			affectedID;
 
 	RemotePlayerAction() {};
 
-	RemotePlayerAction(FILETIME t, Point2 playerViewDirection, Point3 playerPosition, PresentationState trialState, PlayerActionType playerAction, String actor, String affected) {
+	RemotePlayerAction(int64 t, Point2 playerViewDirection, Point3 playerPosition, PresentationState trialState, PlayerActionType playerAction, GUniqueID actor, GUniqueID affected) {
 		time = t;
 		viewDirection = playerViewDirection;
 		position = playerPosition;
@@ -60,7 +60,7 @@ struct RemotePlayerAction {
 
 /* Data storage object for Logging purposes*/
 struct NetworkedClient {
-	FILETIME	time;
+	int64		time = 0;
 	Point2		viewDirection = Point2::zero();
 	Point3		position = Point3::zero();
 	GUniqueID	playerID = GUniqueID::NONE(0);
@@ -71,7 +71,7 @@ struct NetworkedClient {
 
 	NetworkedClient() {};
 
-	NetworkedClient(FILETIME t, Point2 playerViewDirection, Point3 playerPosition, GUniqueID id, uint32 local_frame, uint32 remote_frame) {
+	NetworkedClient(int64 t, Point2 playerViewDirection, Point3 playerPosition, GUniqueID id, uint32 local_frame, uint32 remote_frame) {
 		time = t;
 		viewDirection = playerViewDirection;
 		position = playerPosition;
@@ -80,7 +80,7 @@ struct NetworkedClient {
 		playerID = id;
 	}
 
-	NetworkedClient(FILETIME t, Point2 playerViewDirection, Point3 playerPosition, GUniqueID id, uint32 local_frame, uint32 remote_frame, PresentationState playerState, PlayerActionType playerAction) {
+	NetworkedClient(int64 t, Point2 playerViewDirection, Point3 playerPosition, GUniqueID id, uint32 local_frame, uint32 remote_frame, PresentationState playerState, PlayerActionType playerAction) {
 		time = t;
 		viewDirection = playerViewDirection;
 		position = playerPosition;
@@ -98,6 +98,56 @@ struct NetworkedClient {
 
 };
 
+/* Data storage object for logging the snapshot (entity update) bandwidth used for a client */
+struct SnapshotStats {
+	int64		time = 0;
+	GUniqueID	playerID = GUniqueID::NONE(0);
+	PresentationState	state;
+	int			snapshots = 0;
+	int			fullSnapshots = 0;
+	int64		bytesSent = 0;
+	int64		fullBytes = 0;
+	int64		entitiesSent = 0;
+	int64		entitiesTotal = 0;
+	int64		entitiesRelevant = 0;
+	int64		entitiesDeferred = 0;
+};
+
+/* Data storage object for logging how a client showed the remote entities on a frame (see SnapshotInterpolator) */
+struct InterpolationStats {
+	int64		time = 0;
+	int			interpolated = 0;
+	int			extrapolated = 0;
+	int			held = 0;
+	float		delayMs = 0.0f;
+	float		maxExtrapolationMs = 0.0f;
+};
+
+/* Data storage object for logging the server's check of a hit a client reported (see LagCompensator) */
+struct HitValidation {
+	int64		time = 0;
+	GUniqueID	shooterID = GUniqueID::NONE(0);
+	GUniqueID	targetID = GUniqueID::NONE(0);
+	uint32		serverFrame = 0;
+	double		viewFrame = 0.0;
+	double		testedFrame = 0.0;
+	float		rewindMs = 0.0f;
+	bool		clamped = false;
+	float		missDistance = 0.0f;
+	const char*	result = "";
+	float		costUs = 0.0f;
+};
+
+/* Data storage object for logging a client's correction of its predicted movement to the server's state (see PlayerPrediction) */
+struct PredictionCorrection {
+	int64		time = 0;
+	uint32		sequence = 0;
+	uint32		serverFrame = 0;
+	float		positionError = 0.0f;
+	int			replayed = 0;
+	float		roundTripMs = 0.0f;
+	float		costUs = 0.0f;
+};
 
 class NetworkedSession : public Session {
 protected:
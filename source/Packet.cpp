@@ -29,22 +29,45 @@ GenericPacket::GenericPacket(ENetSocket* srcSocket, ENetAddress* destAddr) {
 	m_reliable = false;
 }
 
+void GenericPacket::receive(ENetAddress srcAddr, BinaryInput& inBuffer) {
+	m_srcAddr = srcAddr;
+	m_inbound = true;
+	m_enetPacket.reset();
+	this->deserialize(inBuffer);
+}
+
 int GenericPacket::send() {
 	BinaryOutput outBuffer;
 	outBuffer.setEndian(G3D_BIG_ENDIAN);
 	this->serialize(outBuffer);
 	if (m_reliable) {
-		ENetPacket* packet = enet_packet_create((void*)outBuffer.getCArray(), outBuffer.length(), ENET_PACKET_FLAG_RELIABLE);
-		return enet_peer_send(m_destPeer, 0, packet);
+		return sendSerialized(outBuffer, m_destPeer);
 	}
 	else {
-		ENetBuffer buff;
-		buff.data = (void*)outBuffer.getCArray();
-		buff.dataLength = outBuffer.length();
-		return enet_socket_send(*m_srcSocket, m_destAddr, &buff, 1);
+		return sendSerialized(outBuffer, m_srcSocket, m_destAddr);
 	}
 }
 
+shared_ptr<const BinaryOutput> GenericPacket::serializeShared() {
+	const shared_ptr<BinaryOutput> outBuffer = std::make_shared<BinaryOutput>("<memory>", G3D_BIG_ENDIAN);
+	this->serialize(*outBuffer);
+	return outBuffer;
+}
+
+int GenericPacket::sendSerialized(const BinaryOutput& bytes, ENetPeer* destPeer) {
+	ENetPacket* packet = enet_packet_create((void*)bytes.getCArray(), bytes.length(), ENET_PACKET_FLAG_RELIABLE);
+	const int result = enet_peer_send(destPeer, 0, packet);
+	if (result < 0) enet_packet_destroy(packet);		// Not queued, so ENet won't free it
+	return result;
+}
+
+int GenericPacket::sendSerialized(const BinaryOutput& bytes, ENetSocket* srcSocket, const ENetAddress* destAddr) {
+	ENetBuffer buff;
+	buff.data = (void*)bytes.getCArray();
+	buff.dataLength = bytes.length();
+	return enet_socket_send(*srcSocket, destAddr, &buff, 1);
+}
+
 void GenericPacket::serialize(BinaryOutput& outBuffer) {
 	outBuffer.writeUInt8(this->type());
 }
@@ -58,64 +81,211 @@ void GenericPacket::deserialize(BinaryInput& inBuffer) {
  * Batch Entity Udpate Packet *
  ******************************/
 
-void BatchEntityUpdatePacket::populate(uint32 frameNumber, Array<EntityUpdate> updates, NetworkUpdateType updateType) {
+void BatchEntityUpdatePacket::populate(uint32 frameNumber, Array<EntityUpdate> updates, NetworkUpdateType updateType, uint32 baselineFrame) {
 	m_updates = updates;
 	m_frameNumber = frameNumber;
 	m_updateType = updateType;
+	m_baselineFrame = baselineFrame;
+	m_partIndex = 0;
+	m_partCount = 1;
+}
+
+void BatchEntityUpdatePacket::populateDelta(uint32 frameNumber, uint32 baselineFrame, const Array<EntityDelta>& deltas) {
+	m_deltas = deltas;
+	m_frameNumber = frameNumber;
+	m_updateType = DELTA_FRAME;
+	m_baselineFrame = baselineFrame;
+	m_partIndex = 0;
+	m_partCount = 1;
+}
+
+int BatchEntityUpdatePacket::serializedSize() const {
+	if (m_updateType != DELTA_FRAME) return HEADER_BYTES + m_updates.size() * REPLACE_BYTES_PER_ENTITY;
+	int size = HEADER_BYTES;
+	for (const EntityDelta& d : m_deltas) {
+		size += deltaBytes(d);
+	}
+	return size;
+}
+
+int BatchEntityUpdatePacket::deltaBytes(const EntityDelta& delta) {
+	int size = 3;
+	if (delta.changed & EntityDelta::POSITION) size += 8;
+	if (delta.changed & EntityDelta::ROTATION) size += 4;
+	return size;
+}
+
+void BatchEntityUpdatePacket::split(Array<shared_ptr<BatchEntityUpdatePacket>>& parts, int maxBytes) const {
+	parts.fastClear();
+	const bool delta = (m_updateType == DELTA_FRAME);
+	const int count = delta ? m_deltas.size() : m_updates.size();
+	int i = 0;
+	do {
+		if (parts.size() == MAX_PARTS) {
+			logPrintf("Entity update for frame %d needs more than %d parts, dropped the last %d entities\n", m_frameNumber, MAX_PARTS, count - i);
+			break;
+		}
+		shared_ptr<BatchEntityUpdatePacket> part = GenericPacket::createForBroadcast<BatchEntityUpdatePacket>();
+		part->m_frameNumber = m_frameNumber;
+		part->m_baselineFrame = m_baselineFrame;
+		part->m_updateType = m_updateType;
+		part->m_partIndex = (uint8)parts.size();
+		int bytes = HEADER_BYTES;
+		// Always take at least one entity, so the loop ends even if maxBytes is smaller than a single entity
+		while (i < count) {
+			const int entityBytes = delta ? deltaBytes(m_deltas[i]) : REPLACE_BYTES_PER_ENTITY;
+			if (bytes + entityBytes > maxBytes && bytes > HEADER_BYTES) break;
+			if (delta) part->m_deltas.append(m_deltas[i]);
+			else part->m_updates.append(m_updates[i]);
+			bytes += entityBytes;
+			i++;
+		}
+		parts.append(part);
+	} while (i < count);
+	for (shared_ptr<BatchEntityUpdatePacket>& part : parts) {
+		part->m_partCount = (uint8)parts.size();
+	}
 }
 
 void BatchEntityUpdatePacket::serialize(BinaryOutput& outBuffer) {
 	GenericPacket::serialize(outBuffer);	// Call the super serialize
 	outBuffer.writeUInt32(m_frameNumber);
-	outBuffer.writeUInt8(m_updates.size());
+	outBuffer.writeUInt16(m_updateType == DELTA_FRAME ? m_deltas.size() : m_updates.size());
 	outBuffer.writeUInt8(m_updateType);
-	for (EntityUpdate e : m_updates) {
+	outBuffer.writeUInt32(m_baselineFrame);
+	outBuffer.writeUInt8(m_partIndex);
+	outBuffer.writeUInt8(m_partCount);
+	if (m_updateType == DELTA_FRAME) {
+		for (const EntityDelta& d : m_deltas) {
+			outBuffer.writeUInt16(d.state.index);
+			outBuffer.writeUInt8(d.changed);
+			if (d.changed & EntityDelta::POSITION) outBuffer.writeUInt64(d.state.position);
+			if (d.changed & EntityDelta::ROTATION) outBuffer.writeUInt32(d.state.rotation);
+		}
+		return;
+	}
+	for (const EntityUpdate& e : m_updates) {
 		if (e.frame.translation[0] != e.frame.translation[0]) {
 			debugPrintf("Oops, updated with a nan\n");
 		}
-		GUniqueID guid = GUniqueID::fromString16(e.name.c_str());
-		guid.serialize(outBuffer);
-		e.frame.serialize(outBuffer);
+		outBuffer.writeUInt16(e.index);
+		outBuffer.writeUInt64(packPosition(e.frame.translation));
+		outBuffer.writeUInt32(packRotation(e.frame.rotation));
 	}
 }
 
 void BatchEntityUpdatePacket::deserialize(BinaryInput& inBuffer) {
 	GenericPacket::deserialize(inBuffer);	// Call the super deserialize
 	m_frameNumber = inBuffer.readUInt32();
-	uint8 numEntities = inBuffer.readUInt8();
+	uint16 numEntities = inBuffer.readUInt16();
 	m_updateType = (NetworkUpdateType)inBuffer.readUInt8();
-	m_updates = Array<EntityUpdate>();
+	m_baselineFrame = inBuffer.readUInt32();
+	m_partIndex = inBuffer.readUInt8();
+	m_partCount = inBuffer.readUInt8();
+	m_updates.fastClear();		// Keep the allocations when this packet is reused
+	m_deltas.fastClear();
 	switch (m_updateType) {
 	case REPLACE_FRAME:
 		for (int i = 0; i < numEntities; i++) {
-			GUniqueID guid;
-			guid.deserialize(inBuffer);
-			CFrame frame;
-			frame.deserialize(inBuffer);
-			m_updates.append(EntityUpdate(frame, guid.toString16()));
+			const uint16 index = inBuffer.readUInt16();
+			const Point3 position = unpackPosition(inBuffer.readUInt64());
+			const Matrix3 rotation = unpackRotation(inBuffer.readUInt32());
+			m_updates.append(EntityUpdate(CFrame(rotation, position), index));
+		}
+		break;
+	case DELTA_FRAME:
+		for (int i = 0; i < numEntities; i++) {
+			EntityDelta& d = m_deltas.next();
+			d.state.index = inBuffer.readUInt16();
+			d.changed = inBuffer.readUInt8();
+			// Fields that weren't sent are left for the receiver to fill in from its baseline
+			d.state.position = (d.changed & EntityDelta::POSITION) ? inBuffer.readUInt64() : 0;
+			d.state.rotation = (d.changed & EntityDelta::ROTATION) ? inBuffer.readUInt32() : 0;
 		}
+		break;
+	}
+}
+
+uint64 BatchEntityUpdatePacket::packPosition(const Point3& position) {
+	const int offset = 1 << (POSITION_BITS - 1);		// Components are stored offset so they are always positive
+	uint64 packed = 0;
+	for (int i = 0; i < 3; i++) {
+		const float steps = clamp(position[i] * POSITION_STEPS_PER_METER, (float)(1 - offset), (float)(offset - 1));
+		packed |= (uint64)(iRound(steps) + offset) << (i * POSITION_BITS);
+	}
+	return packed;
+}
+
+Point3 BatchEntityUpdatePacket::unpackPosition(uint64 packed) {
+	const int offset = 1 << (POSITION_BITS - 1);
+	const uint64 mask = (1ull << POSITION_BITS) - 1;
+	Point3 position;
+	for (int i = 0; i < 3; i++) {
+		position[i] = (float)((int)((packed >> (i * POSITION_BITS)) & mask) - offset) / POSITION_STEPS_PER_METER;
+	}
+	return position;
+}
+
+uint32 BatchEntityUpdatePacket::packRotation(const Matrix3& rotation) {
+	const Quat q = Quat(rotation).toUnit();
+	int largest = 0;
+	for (int i = 1; i < 4; i++) {
+		if (fabs(q[i]) > fabs(q[largest])) largest = i;
 	}
+	// q and -q are the same rotation, so flip the sign to make the dropped component positive
+	const float sign = (q[largest] < 0.0f) ? -1.0f : 1.0f;
+	const int maxValue = (1 << ROTATION_BITS) - 1;
+	uint32 packed = (uint32)largest << (3 * ROTATION_BITS);
+	int shift = 2 * ROTATION_BITS;
+	for (int i = 0; i < 4; i++) {
+		if (i == largest) continue;
+		// The other components are in [-1/sqrt(2), 1/sqrt(2)], map them to [0, maxValue]
+		const float value = clamp(sign * q[i] * (float)sqrt(2.0), -1.0f, 1.0f);
+		packed |= (uint32)iRound((value * 0.5f + 0.5f) * maxValue) << shift;
+		shift -= ROTATION_BITS;
+	}
+	return packed;
+}
+
+Matrix3 BatchEntityUpdatePacket::unpackRotation(uint32 packed) {
+	const int largest = (int)(packed >> (3 * ROTATION_BITS));
+	const uint32 maxValue = (1 << ROTATION_BITS) - 1;
+	Quat q;
+	float sumSquares = 0.0f;
+	int shift = 2 * ROTATION_BITS;
+	for (int i = 0; i < 4; i++) {
+		if (i == largest) continue;
+		const float value = ((float)((packed >> shift) & maxValue) / maxValue * 2.0f - 1.0f) / (float)sqrt(2.0);
+		q[i] = value;
+		sumSquares += value * value;
+		shift -= ROTATION_BITS;
+	}
+	q[largest] = sqrt(max(0.0f, 1.0f - sumSquares));
+	return q.toRotationMatrix();
 }
 
 /************************
  * Create Entity Packet *
  ************************/
 
-void CreateEntityPacket::populate(uint32 frameNumber, GUniqueID guid) {
+void CreateEntityPacket::populate(uint32 frameNumber, GUniqueID guid, uint16 entityIndex) {
 	m_frameNumber = frameNumber;
 	m_guid = guid;
+	m_entityIndex = entityIndex;
 }
 
 void CreateEntityPacket::serialize(BinaryOutput& outBuffer) {
 	GenericPacket::serialize(outBuffer);	// Call the super serialize
 	outBuffer.writeUInt32(m_frameNumber);
 	m_guid.serialize(outBuffer);
+	outBuffer.writeUInt16(m_entityIndex);
 }
 
 void CreateEntityPacket::deserialize(BinaryInput& inBuffer) {
 	GenericPacket::deserialize(inBuffer);	// Call the super deserialize
 	m_frameNumber = inBuffer.readUInt32();
 	m_guid.deserialize(inBuffer);
+	m_entityIndex = inBuffer.readUInt16();
 }
 
 /*************************
@@ -165,21 +335,24 @@ void RegisterClientPacket::deserialize(BinaryInput& inBuffer) {
  * Registration Reply Packet *
  *****************************/
 
-void RegistrationReplyPacket::populate(GUniqueID guid, uint8 status) {
+void RegistrationReplyPacket::populate(GUniqueID guid, uint8 status, uint16 entityIndex) {
 	m_guid = guid;
 	m_status = status;
+	m_entityIndex = entityIndex;
 }
 
 void RegistrationReplyPacket::serialize(BinaryOutput& outBuffer) {
 	GenericPacket::serialize(outBuffer);	// Call the super serialize
 	m_guid.serialize(outBuffer);
 	outBuffer.writeUInt8(m_status);
+	outBuffer.writeUInt16(m_entityIndex);
 }
 
 void RegistrationReplyPacket::deserialize(BinaryInput& inBuffer) {
 	GenericPacket::deserialize(inBuffer);	// Call the super deserialize
 	m_guid.deserialize(inBuffer);
 	m_status = inBuffer.readUInt8();
+	m_entityIndex = inBuffer.readUInt16();
 }
 
 /********************
@@ -235,10 +408,13 @@ void MoveClientPacket::deserialize(BinaryInput& inBuffer) {
  * Report Hit Packet *
  *********************/
 
-void ReportHitPacket::populate(uint32 frameNumber, GUniqueID shotID, GUniqueID shooterID) {
+void ReportHitPacket::populate(uint32 frameNumber, GUniqueID shotID, GUniqueID shooterID, double viewFrame, const Ray& shot) {
 	m_frameNumber = frameNumber;
 	m_shotID = shotID;
 	m_shooterID = shooterID;
+	m_viewFrame = viewFrame;
+	m_shotOrigin = shot.origin();
+	m_shotDirection = shot.direction();
 }
 
 void ReportHitPacket::serialize(BinaryOutput& outBuffer) {
@@ -246,6 +422,9 @@ void ReportHitPacket::serialize(BinaryOutput& outBuffer) {
 	outBuffer.writeUInt32(m_frameNumber);
 	m_shotID.serialize(outBuffer);
 	m_shooterID.serialize(outBuffer);
+	outBuffer.writeFloat64(m_viewFrame);
+	m_shotOrigin.serialize(outBuffer);
+	m_shotDirection.serialize(outBuffer);
 }
 
 void ReportHitPacket::deserialize(BinaryInput& inBuffer) {
@@ -253,6 +432,9 @@ void ReportHitPacket::deserialize(BinaryInput& inBuffer) {
 	m_frameNumber = inBuffer.readUInt32();
 	m_shotID.deserialize(inBuffer);
 	m_shooterID.deserialize(inBuffer);
+	m_viewFrame = inBuffer.readFloat64();
+	m_shotOrigin.deserialize(inBuffer);
+	m_shotDirection.deserialize(inBuffer);
 }
 
 /********************
@@ -359,14 +541,18 @@ void SendPlayerConfigPacket::populate(PlayerConfig playerConfig, float sessionPr
 	m_networkedSessionProgress = sessionProgress;
 }
 
-void SendPlayerConfigPacket::serialize(BinaryOutput& outBuffer) {
-	GenericPacket::serialize(outBuffer);	// Call the super serialize
-	PlayerConfig selectedConfig = *m_playerConfig;
+PlayerConfig SendPlayerConfigPacket::selectedConfig() const {
 	if ((*m_playerConfig).readFromFile == true) {
-		int index = (*m_playerConfig).selectedClientIdx ? index = 0 : index = 1;
-		selectedConfig = (*m_playerConfig).clientPlayerConfigs[index];
-		(*m_playerConfig).readFromFile = false;
+		int index = (*m_playerConfig).selectedClientIdx ? 0 : 1;
+		return (*m_playerConfig).clientPlayerConfigs[index];
 	}
+	return *m_playerConfig;
+}
+
+void SendPlayerConfigPacket::serialize(BinaryOutput& outBuffer) {
+	GenericPacket::serialize(outBuffer);	// Call the super serialize
+	PlayerConfig selectedConfig = this->selectedConfig();
+	(*m_playerConfig).readFromFile = false;
 	outBuffer.writeFloat32(selectedConfig.moveRate);
 	outBuffer.writeVector2(selectedConfig.moveScale);
 
@@ -410,6 +596,8 @@ void SendPlayerConfigPacket::serialize(BinaryOutput& outBuffer) {
 
 	outBuffer.writeVector3(selectedConfig.cornerPosition);
 	outBuffer.writeFloat32(selectedConfig.defenderRandomDisplacementAngle);
+
+	selectedConfig.uplinkImpairment.serialize(outBuffer);
 }
 
 void SendPlayerConfigPacket::deserialize(BinaryInput& inBuffer) {
@@ -459,6 +647,8 @@ void SendPlayerConfigPacket::deserialize(BinaryInput& inBuffer) {
 
 	m_playerConfig->cornerPosition = inBuffer.readVector3();
 	m_playerConfig->defenderRandomDisplacementAngle = inBuffer.readFloat32();
+
+	m_playerConfig->uplinkImpairment.deserialize(inBuffer);
 }
 
 
@@ -535,4 +725,103 @@ void ClientFeedbackSubmittedPacket::serialize(BinaryOutput& outBuffer) {
 
 void ClientFeedbackSubmittedPacket::deserialize(BinaryInput& inBuffer) {
 	GenericPacket::deserialize(inBuffer);	// Call the super deserialize
-}
\ No newline at end of file
+}
+
+/***********************
+ * PLAYER INPUT PACKET *
+ ***********************/
+
+void PlayerInputPacket::populate(uint32 frameNumber, const Array<PlayerEntity::InputCommand>& inputs) {
+	m_frameNumber = frameNumber;
+	m_inputs = inputs;
+}
+
+void PlayerInputPacket::serializeState(BinaryOutput& outBuffer, const PlayerEntity::MovementState& state) {
+	state.position.serialize(outBuffer);
+	outBuffer.writeFloat32(state.heading);
+	outBuffer.writeFloat32(state.headTilt);
+	state.desiredOSVelocity.serialize(outBuffer);
+	state.linearVector.serialize(outBuffer);
+	state.lastDirection.serialize(outBuffer);
+	outBuffer.writeFloat32(state.acceleratedVelocity);
+	outBuffer.writeFloat32(state.lastJumpVelocity);
+	outBuffer.writeFloat64(state.lastJumpTime);
+	outBuffer.writeUInt8((state.inAir ? 1 : 0) | (state.inContact ? 2 : 0));
+	state.restrictionCenter.serialize(outBuffer);
+}
+
+void PlayerInputPacket::deserializeState(BinaryInput& inBuffer, PlayerEntity::MovementState& state) {
+	state.position.deserialize(inBuffer);
+	state.heading = inBuffer.readFloat32();
+	state.headTilt = inBuffer.readFloat32();
+	state.desiredOSVelocity.deserialize(inBuffer);
+	state.linearVector.deserialize(inBuffer);
+	state.lastDirection.deserialize(inBuffer);
+	state.acceleratedVelocity = inBuffer.readFloat32();
+	state.lastJumpVelocity = inBuffer.readFloat32();
+	state.lastJumpTime = inBuffer.readFloat64();
+	const uint8 contact = inBuffer.readUInt8();
+	state.inAir = (contact & 1) != 0;
+	state.inContact = (contact & 2) != 0;
+	state.restrictionCenter.deserialize(inBuffer);
+}
+
+void PlayerInputPacket::serialize(BinaryOutput& outBuffer) {
+	GenericPacket::serialize(outBuffer);	// Call the super serialize
+	outBuffer.writeUInt32(m_frameNumber);
+	outBuffer.writeUInt8((uint8)m_inputs.size());
+	for (const PlayerEntity::InputCommand& input : m_inputs) {
+		outBuffer.writeUInt32(input.sequence);
+		outBuffer.writeFloat32(input.dt);
+		input.move.serialize(outBuffer);
+		input.turn.serialize(outBuffer);
+		outBuffer.writeUInt8(input.flags);
+		outBuffer.writeFloat64(input.time);
+		if (input.flags & PlayerEntity::InputCommand::RESPAWNED) {
+			serializeState(outBuffer, input.result);
+		}
+	}
+}
+
+void PlayerInputPacket::deserialize(BinaryInput& inBuffer) {
+	GenericPacket::deserialize(inBuffer);	// Call the super deserialize
+	m_frameNumber = inBuffer.readUInt32();
+	m_inputs.fastClear();					// Packets are reused, drop the previous inputs
+	const int count = inBuffer.readUInt8();
+	for (int i = 0; i < count; i++) {
+		PlayerEntity::InputCommand& input = m_inputs.next();
+		input.sequence = inBuffer.readUInt32();
+		input.dt = inBuffer.readFloat32();
+		input.move.deserialize(inBuffer);
+		input.turn.deserialize(inBuffer);
+		input.flags = inBuffer.readUInt8();
+		input.time = inBuffer.readFloat64();
+		if (input.flags & PlayerEntity::InputCommand::RESPAWNED) {
+			deserializeState(inBuffer, input.result);
+		}
+	}
+}
+
+/***********************
+ * PLAYER STATE PACKET *
+ ***********************/
+
+void PlayerStatePacket::populate(uint32 frameNumber, uint32 sequence, const PlayerEntity::MovementState& state) {
+	m_frameNumber = frameNumber;
+	m_sequence = sequence;
+	m_state = state;
+}
+
+void PlayerStatePacket::serialize(BinaryOutput& outBuffer) {
+	GenericPacket::serialize(outBuffer);	// Call the super serialize
+	outBuffer.writeUInt32(m_frameNumber);
+	outBuffer.writeUInt32(m_sequence);
+	PlayerInputPacket::serializeState(outBuffer, m_state);
+}
+
+void PlayerStatePacket::deserialize(BinaryInput& inBuffer) {
+	GenericPacket::deserialize(inBuffer);	// Call the super deserialize
+	m_frameNumber = inBuffer.readUInt32();
+	m_sequence = inBuffer.readUInt32();
+	PlayerInputPacket::deserializeState(inBuffer, m_state);
+}
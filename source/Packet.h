@@ -1,7 +1,9 @@
 #pragma once
 #include <G3D/G3D.h>
 #include <enet/enet.h>
+#include <chrono>
 #include "TargetEntity.h"
+#include "PlayerEntity.h"
 #include "FPSConfig.h"
 
 enum PacketType {
@@ -37,8 +39,13 @@ enum PacketType {
 	CLIENT_ROUND_TIMEOUT,
 	CLIENT_FEEDBACK_SUBMITTED,
 
+	PLAYER_INPUT,
+	PLAYER_STATE,
+
 	RELIABLE_CONNECT,			///< Packet type to represent an enet event type connect
-	RELIABLE_DISCONNECT			///< Packet type to represent an enet event type disconnect
+	RELIABLE_DISCONNECT,		///< Packet type to represent an enet event type disconnect
+
+	PACKET_TYPE_COUNT			///< Number of packet types (not a real packet type)
 };
 
 /** A Generic Packet type that contains only the type of packet and basic information for sending/receiving a packet
@@ -53,7 +60,9 @@ enum PacketType {
 * method a getTypedPacket method, a populate method (and memeber variables),
 * and a serialize/deserialize method. Existing packets can be used as an
 * example for how to implement these functions and what they need for
-* implementation.
+* implementation. Received packets are constructed by type in PacketPool, so
+* new packet types also need to be added there (and have a handler registered
+* in the app's registerPacketHandlers()).
 */
 
 class GenericPacket : public ReferenceCountedObject {
@@ -138,6 +147,10 @@ public:
 
 	/** Returns whether the packet was sent/received on the reliable channel */
 	bool isReliable() { return m_reliable; }
+	/** Returns the peer a reliable packet is sent to */
+	ENetPeer* destPeer() { return m_destPeer; }
+	/** Returns the socket an unreliable packet is sent on */
+	ENetSocket* srcSocket() { return m_srcSocket; }
 	/** Returns the source address (only used on inbound packets */
 	ENetAddress srcAddr() { return m_srcAddr; }
 	/** Returns whether the packet is inbound */
@@ -150,8 +163,21 @@ public:
 
 	/** Sends the packet over the network on the correct channel */
 	int send();
+	/** Writes the packet as it is sent over the network (big endian) */
+	void serializeTo(BinaryOutput& outBuffer) { serialize(outBuffer); }
+	/** Serializes the packet once into a (read only) buffer that can be shared by every destination it is broadcast to */
+	shared_ptr<const BinaryOutput> serializeShared();
+
+	/** Sends already serialized bytes over the reliable channel to the peer */
+	static int sendSerialized(const BinaryOutput& bytes, ENetPeer* destPeer);
+	/** Sends already serialized bytes over the unreliable channel to the destAddr */
+	static int sendSerialized(const BinaryOutput& bytes, ENetSocket* srcSocket, const ENetAddress* destAddr);
+	/** Re-initializes this packet as an inbound packet parsed from the inBuffer (used to reuse pooled packets) */
+	void receive(ENetAddress srcAddr, BinaryInput& inBuffer);
 
 	bool m_reliable;									///< which channel to send/was received on; also determines which ENet fields are defined
+	shared_ptr<ENetPacket> m_enetPacket;				///< ENet packet this was received in (reliable inbound packets only), released along with the last reference to this packet
+	std::chrono::high_resolution_clock::time_point m_arrivalTime;	///< When the packet was read from the network (inbound packets only, see NetworkUtils::receivePacket())
 
 protected:
 	virtual void serialize(BinaryOutput& outBuffer);	///< serialize the data in this packet
@@ -184,26 +210,86 @@ protected:
 public:
 	/** Struct containing all information needed to update a single entity */
 	struct EntityUpdate {
-		CFrame frame;								///< CFrame to use in the update
-		String name;								///< Name of the entity this update applies to
+		CFrame frame;								///< CFrame to use in the update (sent quantized, see packPosition() and packRotation())
+		uint16 index = NetworkedEntity::NO_NETWORK_INDEX;	///< Network index of the entity this update applies to (see EntityIndexTable)
 		/** Constructor to create and populate an update */
-		EntityUpdate(CFrame entityFrame, String entityName) {
+		EntityUpdate(CFrame entityFrame, uint16 entityIndex) {
 			frame = entityFrame;
-			name = entityName;
+			index = entityIndex;
 		}
 		EntityUpdate() {}
 	};
+	/** Quantized state of a single entity, exactly as it is sent (see packPosition() and packRotation()) */
+	struct EntityState {
+		uint16 index = NetworkedEntity::NO_NETWORK_INDEX;	///< Network index of the entity (see EntityIndexTable)
+		uint64 position = 0;						///< Packed position
+		uint32 rotation = 0;						///< Packed rotation
+		EntityState(uint16 entityIndex, const CFrame& frame) {
+			index = entityIndex;
+			position = packPosition(frame.translation);
+			rotation = packRotation(frame.rotation);
+		}
+		EntityState() {}
+		CFrame frame() const { return CFrame(unpackRotation(rotation), unpackPosition(position)); }
+	};
+	/** The fields of an entity's state that changed relative to the baseline snapshot (DELTA_FRAME updates) */
+	struct EntityDelta {
+		enum Field : uint8 {
+			POSITION = 1,
+			ROTATION = 2,
+			ALL_FIELDS = POSITION | ROTATION
+		};
+		EntityState state;							///< New state (only the fields in changed are sent)
+		uint8 changed = ALL_FIELDS;					///< Bitmask of the changed fields
+		EntityDelta(const EntityState& entityState, uint8 changedFields) {
+			state = entityState;
+			changed = changedFields;
+		}
+		EntityDelta() {}
+	};
 	/** Indicates what type of update this is (changes how updates are applied) */
 	enum NetworkUpdateType {
 		NOOP,										///< Do Nothing (No-Op)
 		REPLACE_FRAME,								///< Replace the frame with the one in the update (absolute position)
+		DELTA_FRAME,								///< Only the entities/fields that changed since the baseline snapshot (see SnapshotHistory)
 	};
 
 	PacketType type() override { return BATCH_ENTITY_UPDATE; }
 	shared_ptr<GenericPacket> clone() override { return createShared<BatchEntityUpdatePacket>(*this); }
 
-	/** Fills in the member varibales from the parameters (Must be called prior to calling send()) */
-	void populate(uint32 frameNumber, Array<EntityUpdate> updates, NetworkUpdateType updateType);
+	/** Fills in the member varibales from the parameters (Must be called prior to calling send()).
+		Clients pass the frame number of the last snapshot they received as the baselineFrame (acknowledging it). */
+	void populate(uint32 frameNumber, Array<EntityUpdate> updates, NetworkUpdateType updateType, uint32 baselineFrame = 0);
+	/** Fills in a DELTA_FRAME update relative to the snapshot for baselineFrame (0 if there is no baseline, so every entity is sent in full) */
+	void populateDelta(uint32 frameNumber, uint32 baselineFrame, const Array<EntityDelta>& deltas);
+
+	static const int HEADER_BYTES = 14;				///< Serialized size of an update with no entities
+	static const int REPLACE_BYTES_PER_ENTITY = 14;	///< Serialized size of each entity in a REPLACE_FRAME update
+	static const int MAX_DATAGRAM_BYTES = ENET_HOST_DEFAULT_MTU;	///< Largest part split() makes (datagrams are received into buffers of one MTU)
+	static const int MAX_PARTS = 255;				///< Most parts an update can be split into
+
+	/** Size of this update once serialized (computed without serializing it) */
+	int serializedSize() const;
+	/** Serialized size of a single entity in a DELTA_FRAME update */
+	static int deltaBytes(const EntityDelta& delta);
+
+	/** Split this update into parts (for broadcast) that each serialize to at most maxBytes, so no datagram is fragmented
+		(or truncated by the receiver). Every part carries the frame number (which identifies the snapshot), its part index
+		and the part count, the receiver puts them back together with an EntityBatchAssembler. An update that already fits
+		is returned as a single part, entities past MAX_PARTS parts are dropped (and logged). */
+	void split(Array<shared_ptr<BatchEntityUpdatePacket>>& parts, int maxBytes = MAX_DATAGRAM_BYTES) const;
+
+	static const int POSITION_BITS = 21;			///< Bits per (signed, fixed point) position component
+	static const int POSITION_STEPS_PER_METER = 512;	///< Position resolution (so positions are limited to +/-2048 m)
+	static const int ROTATION_BITS = 10;			///< Bits per stored quaternion component
+
+	/** Pack a position into 3 fixed point components (clamped to the representable range) */
+	static uint64 packPosition(const Point3& position);
+	static Point3 unpackPosition(uint64 packed);
+	/** Pack a rotation as a "smallest three" quaternion: the index of the largest component (2 bits) and the other 3 components
+		(ROTATION_BITS each). The largest component is rebuilt from the others, so no precision is spent on it. */
+	static uint32 packRotation(const Matrix3& rotation);
+	static Matrix3 unpackRotation(uint32 packed);
 
 protected:
 	void serialize(BinaryOutput& outBuffer) override;
@@ -211,9 +297,13 @@ protected:
 
 
 public:
-	Array<EntityUpdate> m_updates;					///< Array of updates to be applied
+	Array<EntityUpdate> m_updates;					///< Array of updates to be applied (REPLACE_FRAME updates)
+	Array<EntityDelta> m_deltas;					///< Changes relative to the baseline snapshot (DELTA_FRAME updates)
 	uint32 m_frameNumber;							///< Frame number that these updates apply to
+	uint32 m_baselineFrame = 0;						///< Baseline snapshot for DELTA_FRAME updates, or the last snapshot received in client updates (0 for none)
 	NetworkUpdateType m_updateType;					///< type of update (how to apply updates)
+	uint8 m_partIndex = 0;							///< Index of this part of the update (see split())
+	uint8 m_partCount = 1;							///< Number of parts the update was split into
 };
 
 /** A Packet signaling the receiver to create a new entity
@@ -233,10 +323,11 @@ public:
 	shared_ptr<GenericPacket> clone() override { return createShared<CreateEntityPacket>(*this); }
 
 	/** Fills in the member varibales from the parameters (Must be called prior to calling send()) */
-	void populate(uint32 frameNumber, GUniqueID guid);
+	void populate(uint32 frameNumber, GUniqueID guid, uint16 entityIndex);
 
 	uint32 m_frameNumber;							///< Frame number that the entity was created on
 	GUniqueID m_guid;								///< GUID of the new entity (used as Entity->name)
+	uint16 m_entityIndex;							///< Network index of the new entity (used to identify it in entity updates)
 
 protected:
 	void serialize(BinaryOutput& outBuffer) override;
@@ -317,10 +408,11 @@ public:
 	shared_ptr<GenericPacket> clone() override { return createShared<RegistrationReplyPacket>(*this); }
 
 	/** Fills in the member varibales from the parameters (Must be called prior to calling send()) */
-	void populate(GUniqueID guid, uint8 status);
+	void populate(GUniqueID guid, uint8 status, uint16 entityIndex);
 
 	GUniqueID m_guid;								///< GUID of the newly connected client
 	uint8 m_status;									///< Status code of the connection (0 is success)
+	uint16 m_entityIndex;							///< Network index of the client's player (used to identify it in entity updates)
 
 protected:
 	void serialize(BinaryOutput& outBuffer) override;
@@ -414,11 +506,14 @@ public:
 	shared_ptr<GenericPacket> clone() override { return static_pointer_cast<GenericPacket> (createShared<ReportHitPacket>(*this)); }
 
 	/** Fills in the member varibales from the parameters (Must be called prior to calling send()) */
-	void populate(uint32 frameNumber, GUniqueID shotID, GUniqueID shooterID);
+	void populate(uint32 frameNumber, GUniqueID shotID, GUniqueID shooterID, double viewFrame, const Ray& shot);
 
 	uint32 m_frameNumber;							///< Frame Number that the hit occured
 	GUniqueID m_shotID;								///< GUID of the client that was hit
 	GUniqueID m_shooterID;							///< GUID of the client that fired the shot
+	double m_viewFrame;								///< Server frame of the entity states the shooter saw (fractional when interpolated), checked by the server's lag compensation
+	Point3 m_shotOrigin;							///< Origin of the shot's ray
+	Vector3 m_shotDirection;						///< Direction of the shot's ray
 
 protected:
 	void serialize(BinaryOutput& outBuffer) override;
@@ -573,6 +668,8 @@ public:
 
 	/** Fills in the member varibales from the parameters (Must be called prior to calling send()) */
 	void populate(PlayerConfig playerConfig, float sessionProgress);
+	/** The config the client is sent (one of clientPlayerConfigs when readFromFile is set) */
+	PlayerConfig selectedConfig() const;
 
 	shared_ptr<PlayerConfig> m_playerConfig;					///< playerConfig to be sent
 	float m_networkedSessionProgress;							///< Networked Session progression to be sent
@@ -719,6 +816,67 @@ protected:
 };
 
 
+/** A Packet carrying the client's recent movement inputs (client side prediction)
+*
+* The client predicts its own movement from its inputs and sends the ones the
+* server hasn't acknowledged yet on every network frame, so a lost packet is
+* covered by the next one. The server simulates each input it hasn't seen
+* (in sequence order) and acknowledges the last one in a PlayerStatePacket.
+*/
+class PlayerInputPacket : public GenericPacket {
+protected:
+	PlayerInputPacket() : GenericPacket() {}
+	PlayerInputPacket(ENetAddress srcAddr, BinaryInput& inBuffer) : GenericPacket(srcAddr) { this->deserialize(inBuffer); }
+	PlayerInputPacket(ENetPeer* destPeer) : GenericPacket(destPeer) {}
+	PlayerInputPacket(ENetSocket* srcSocket, ENetAddress* destAddr) : GenericPacket(srcSocket, destAddr) {}
+
+public:
+	PacketType type() override { return PLAYER_INPUT; }
+	shared_ptr<GenericPacket> clone() override { return createShared<PlayerInputPacket>(*this); }
+
+	/** Fills in the member varibales from the parameters (Must be called prior to calling send()) */
+	void populate(uint32 frameNumber, const Array<PlayerEntity::InputCommand>& inputs);
+
+	uint32 m_frameNumber;							///< Client frame number the inputs were sent on
+	Array<PlayerEntity::InputCommand> m_inputs;		///< Unacknowledged inputs (oldest first)
+
+	/** Write/read a player's movement state (shared with PlayerStatePacket) */
+	static void serializeState(BinaryOutput& outBuffer, const PlayerEntity::MovementState& state);
+	static void deserializeState(BinaryInput& inBuffer, PlayerEntity::MovementState& state);
+
+protected:
+	void serialize(BinaryOutput& outBuffer) override;
+	void deserialize(BinaryInput& inBuffer) override;
+};
+
+/** A Packet carrying the server's (authoritative) movement state for a client
+*
+* Sent to each predicting client on every network frame, with the sequence number
+* of the last input the server simulated. The client compares the state with its
+* own prediction for that input and replays the inputs sent since when they differ.
+*/
+class PlayerStatePacket : public GenericPacket {
+protected:
+	PlayerStatePacket() : GenericPacket() {}
+	PlayerStatePacket(ENetAddress srcAddr, BinaryInput& inBuffer) : GenericPacket(srcAddr) { this->deserialize(inBuffer); }
+	PlayerStatePacket(ENetPeer* destPeer) : GenericPacket(destPeer) {}
+	PlayerStatePacket(ENetSocket* srcSocket, ENetAddress* destAddr) : GenericPacket(srcSocket, destAddr) {}
+
+public:
+	PacketType type() override { return PLAYER_STATE; }
+	shared_ptr<GenericPacket> clone() override { return createShared<PlayerStatePacket>(*this); }
+
+	/** Fills in the member varibales from the parameters (Must be called prior to calling send()) */
+	void populate(uint32 frameNumber, uint32 sequence, const PlayerEntity::MovementState& state);
+
+	uint32 m_frameNumber;							///< Server frame number the state was sent on
+	uint32 m_sequence;								///< Sequence number of the last input the server simulated
+	PlayerEntity::MovementState m_state;			///< The client's movement state after that input
+
+protected:
+	void serialize(BinaryOutput& outBuffer) override;
+	void deserialize(BinaryInput& inBuffer) override;
+};
 
 /** A Packet representing an incoming connection on the reliable channel
 *
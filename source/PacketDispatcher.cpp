@@ -0,0 +1,90 @@
+#include "PacketDispatcher.h"
+#include "NetworkUtils.h"
+#include "NetworkThread.h"
+
+PacketPool::PacketPool() {
+	addType<BatchEntityUpdatePacket>(BATCH_ENTITY_UPDATE);
+	addType<CreateEntityPacket>(CREATE_ENTITY);
+	addType<DestroyEntityPacket>(DESTROY_ENTITY);
+	addType<MoveClientPacket>(MOVE_CLIENT);
+	addType<RegisterClientPacket>(REGISTER_CLIENT);
+	addType<RegistrationReplyPacket>(CLIENT_REGISTRATION_REPLY);
+	addType<HandshakePacket>(HANDSHAKE);
+	addType<HandshakeReplyPacket>(HANDSHAKE_REPLY);
+	addType<ReportHitPacket>(REPORT_HIT);
+	addType<SetSpawnPacket>(SET_SPAWN_LOCATION);
+	addType<RespawnClientPacket>(RESPAWN_CLIENT);
+	addType<ReadyUpClientPacket>(READY_UP_CLIENT);
+	addType<StartSessionPacket>(START_NETWORKED_SESSION);
+	addType<PlayerInteractPacket>(PLAYER_INTERACT);
+	addType<SendPlayerConfigPacket>(SEND_PLAYER_CONFIG);
+	addType<AddPointPacket>(ADD_POINTS);
+	addType<ResetClientRoundPacket>(RESET_CLIENT_ROUND);
+	addType<ClientFeedbackStartPacket>(CLIENT_FEEDBACK_START);
+	addType<ClientSessionEndPacket>(CLIENT_SESSION_END);
+	addType<ClientRoundTimeoutPacket>(CLIENT_ROUND_TIMEOUT);
+	addType<ClientFeedbackSubmittedPacket>(CLIENT_FEEDBACK_SUBMITTED);
+	addType<PlayerInputPacket>(PLAYER_INPUT);
+	addType<PlayerStatePacket>(PLAYER_STATE);
+}
+
+void PacketPool::Returner::operator()(GenericPacket*) {
+	// The ENet packet goes with the last reference, not with the next reuse (destroying a received ENet packet only frees
+	// its memory, so this is safe on any thread)
+	owner->m_enetPacket.reset();
+	// The queue publishes the packet with release ordering, so the owning thread sees every write made by its last user.
+	// If the queue is full the packet stays here and is destroyed along with this deleter.
+	queue->tryPush(std::move(owner));
+}
+
+shared_ptr<GenericPacket> PacketPool::acquire(PacketType type, ENetAddress srcAddr, BinaryInput& inBuffer) {
+	if (!hasType(type)) return nullptr;
+	shared_ptr<GenericPacket> packet;
+	if (m_returned[type]->tryPop(packet)) {
+		packet->receive(srcAddr, inBuffer);
+	}
+	else {
+		packet = m_factories[type](srcAddr, inBuffer);
+	}
+	GenericPacket* const rawPacket = packet.get();
+	return shared_ptr<GenericPacket>(rawPacket, Returner{ m_returned[type], std::move(packet) });
+}
+
+void PacketDispatcher::on(PacketType type, Channel channel, const Handler& handler) {
+	debugAssertM(type >= 0 && type < PACKET_TYPE_COUNT, "Packet handler registered for an invalid packet type");
+	m_handlers[channel][type] = handler;
+}
+
+bool PacketDispatcher::dispatch(const shared_ptr<GenericPacket>& packet) {
+	const PacketType type = packet->type();
+	const Channel channel = packet->isReliable() ? RELIABLE : UNRELIABLE;
+	if (type < 0 || type >= PACKET_TYPE_COUNT || !m_handlers[channel][type]) {
+		debugPrintf("WARNING: unhandled packet received on the %s channel of type: %d\n", channel == RELIABLE ? "reliable" : "unreliable", type);
+		return false;
+	}
+	m_handlers[channel][type](packet.get());
+	return true;
+}
+
+int PacketDispatcher::dispatchPending(ENetHost* host, ENetSocket* socket) {
+	int count = 0;
+	while (true) {
+		// Each packet is released before the next is received so its pooled packet can be reused right away
+		const shared_ptr<GenericPacket> packet = NetworkUtils::receivePacket(host, socket);
+		if (isNull(packet)) break;
+		dispatch(packet);
+		count++;
+	}
+	return count;
+}
+
+int PacketDispatcher::dispatchQueued(NetworkThread& thread) {
+	int count = 0;
+	shared_ptr<GenericPacket> packet;
+	while (thread.receive(packet)) {
+		dispatch(packet);
+		packet.reset();		// Let the network thread's pool reuse the packet
+		count++;
+	}
+	return count;
+}
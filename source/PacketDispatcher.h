@@ -0,0 +1,93 @@
+#pragma once
+#include <G3D/G3D.h>
+#include <enet/enet.h>
+#include <functional>
+#include "MpscRingBuffer.h"
+#include "Packet.h"
+
+class NetworkThread;
+
+/** Constructs inbound packets by type, reusing previously received packets where possible
+
+	Each packet type has a factory (registered in the constructor) and a return queue of released packets. acquire() hands
+	out a reference whose deleter releases the packet's ENet packet and pushes the packet onto its type's return queue once
+	the last copy of that reference is dropped, so handlers may keep the packets they are given and may release them on any
+	thread. Only the thread that owns the pool reuses packets from the queues. Packets released while their queue is full
+	(or after the pool is gone) are destroyed.
+*/
+class PacketPool {
+public:
+	static const int MAX_POOLED = 8;			///< Most released packets of each type kept for reuse
+
+	typedef shared_ptr<GenericPacket>(*Factory)(ENetAddress srcAddr, BinaryInput& inBuffer);
+	typedef MpscRingBuffer<shared_ptr<GenericPacket>> ReturnQueue;
+
+protected:
+	/** Deleter for the references handed out by acquire(), returns the packet it owns to its queue */
+	struct Returner {
+		shared_ptr<ReturnQueue>		queue;
+		shared_ptr<GenericPacket>	owner;
+		void operator()(GenericPacket*);
+	};
+
+	Factory						m_factories[PACKET_TYPE_COUNT] = {};	///< Constructor for each packet type (nullptr for types that aren't received)
+	shared_ptr<ReturnQueue>		m_returned[PACKET_TYPE_COUNT];			///< Released packets of each type (any thread pushes, the owning thread pops)
+
+	template <class packetType>
+	static shared_ptr<GenericPacket> construct(ENetAddress srcAddr, BinaryInput& inBuffer) {
+		return GenericPacket::createReceive<packetType>(srcAddr, inBuffer);
+	}
+
+	template <class packetType>
+	void addType(PacketType type) {
+		m_factories[type] = &construct<packetType>;
+		m_returned[type] = std::make_shared<ReturnQueue>(MAX_POOLED);
+	}
+
+public:
+	PacketPool();
+
+	/** Is there a typed packet for this type? */
+	bool hasType(PacketType type) const { return type >= 0 && type < PACKET_TYPE_COUNT && m_factories[type] != nullptr; }
+
+	/** Get a packet of the given type parsed from inBuffer (reused from the pool where possible), returns nullptr for unknown types.
+		Only call this from the thread that owns the pool. */
+	shared_ptr<GenericPacket> acquire(PacketType type, ENetAddress srcAddr, BinaryInput& inBuffer);
+};
+
+/** Routes received packets to the handler registered for their type and channel
+
+	Handlers are looked up in a table indexed by channel and packet type, so each packet costs a single lookup
+	no matter how many types are handled. Packets without a handler are reported (in debug output) and dropped.
+*/
+class PacketDispatcher {
+public:
+	typedef std::function<void(GenericPacket*)> Handler;
+
+	enum Channel {
+		UNRELIABLE = 0,
+		RELIABLE,
+		CHANNEL_COUNT
+	};
+
+protected:
+	Handler m_handlers[CHANNEL_COUNT][PACKET_TYPE_COUNT];
+
+public:
+	/** Register (or replace) the handler for a packet type received on a channel */
+	void on(PacketType type, Channel channel, const Handler& handler);
+
+	/** Register a method taking the typed packet as the handler, i.e. on(CREATE_ENTITY, RELIABLE, this, &FPSciApp::onCreateEntity) */
+	template <class ownerType, class methodOwnerType, class packetType>
+	void on(PacketType type, Channel channel, ownerType* owner, void (methodOwnerType::*method)(packetType*)) {
+		on(type, channel, [owner, method](GenericPacket* packet) { (owner->*method)(static_cast<packetType*>(packet)); });
+	}
+
+	/** Call the handler for this packet, returns false if there isn't one */
+	bool dispatch(const shared_ptr<GenericPacket>& packet);
+
+	/** Receive and dispatch every pending packet (see NetworkUtils::receivePacket()), returns the number received */
+	int dispatchPending(ENetHost* host, ENetSocket* socket);
+	/** Dispatch every packet the network thread has received so far (instead of dispatchPending()), returns the number dispatched */
+	int dispatchQueued(NetworkThread& thread);
+};
@@ -62,3 +62,13 @@ void PhysicsScene::staticIntersectBox(const AABox& box, Array<Tri>& triArray) co
     }
 }
 
+bool PhysicsScene::staticLineOfSight(const Point3& from, const Point3& to) const {
+    if (isNull(m_collisionTree) || m_collisionTree->size() == 0) return true;
+    const Vector3 delta = to - from;
+    const float distance = delta.length();
+    if (distance <= 0.0f) return true;
+    TriTree::Hit hit;
+    const Ray ray = Ray::fromOriginAndDirection(from, delta / distance, 0.0f, distance);
+    return !m_collisionTree->intersectRay(ray, hit, TriTree::OCCLUSION_TEST_ONLY | TriTree::DO_NOT_CULL_BACKFACES);
+}
+
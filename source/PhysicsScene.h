@@ -34,6 +34,9 @@ public:
     /** Gets all static triangles within this world-space box. */
     void staticIntersectBox(const AABox& box, Array<Tri>& triArray) const;
 
+    /** Is the segment between these points clear of the static geometry? (true if there is no static geometry, e.g. on a headless server) */
+    bool staticLineOfSight(const Point3& from, const Point3& to) const;
+
     const CPUVertexArray& vertexArrayOfCollisionTree() const {
         return m_collisionTree->vertexArray();
     }
@@ -1,5 +1,6 @@
 #include "PlayerEntity.h"
 #include "PhysicsScene.h"
+#include "FpsConfig.h"
 
 // Disable collisions
 // #define NO_COLLISIONS
@@ -89,13 +90,36 @@ void PlayerEntity::onPose(Array<shared_ptr<Surface> >& surfaceArray) {
     VisibleEntity::onPose(surfaceArray);
 }
 
-void PlayerEntity::updateFromInput(UserInput* ui) {
+PlayerEntity::InputCommand PlayerEntity::updateFromInput(UserInput* ui) {
+	InputCommand input;
+	input.time = System::time();
 	if (!m_PlayerMovement)
+		return input;
+
+	input.flags = InputCommand::APPLIED;
+	if (m_jumpPressed) input.flags |= InputCommand::JUMP;
+	if (m_sprinting) input.flags |= InputCommand::SPRINT;
+	m_jumpPressed = false;
+	input.move = Vector2(ui->getX(), ui->getY());
+	// Get the mouse rotation here
+	input.turn = ui->mouseDXY() * turnScale * (float)m_cameraRadiansPerMouseDot;
+
+	applyInput(input);
+	return input;
+}
+
+void PlayerEntity::applyInput(const InputCommand& input) {
+	if (input.flags & InputCommand::HALTED) {
+		setDesiredOSVelocity(Vector3::zero());
+		setDesiredAngularVelocity(0.0, 0.0);
+		return;
+	}
+	if (!(input.flags & InputCommand::APPLIED))
 		return;
 
 	m_walkSpeed = 0;
 
-	if (!m_sprinting) {
+	if (!(input.flags & InputCommand::SPRINT)) {
 		m_walkSpeed = *moveRate * units::meters() / units::seconds();
 	}
 	else {
@@ -106,13 +130,13 @@ void PlayerEntity::updateFromInput(UserInput* ui) {
 		m_linearVector = Vector3(0, 0, 0);
 	}
 	else if ((*axisLock)[0]) {
-		m_linearVector = Vector3(ui->getX() * moveScale->x, 0, 0);
+		m_linearVector = Vector3(input.move.x * moveScale->x, 0, 0);
 	}
 	else if ((*axisLock)[2]) {
-		m_linearVector = Vector3(0, 0, -ui->getY() * moveScale->y);
+		m_linearVector = Vector3(0, 0, -input.move.y * moveScale->y);
 	}
 	else {
-		m_linearVector = Vector3(ui->getX() * moveScale->x, 0, -ui->getY() * moveScale->y);
+		m_linearVector = Vector3(input.move.x * moveScale->x, 0, -input.move.y * moveScale->y);
 	}
 
 	// Counter strafing
@@ -125,25 +149,98 @@ void PlayerEntity::updateFromInput(UserInput* ui) {
 		m_gettingMovementInput = true;
 	}
 
-	// Add jump here (if needed)
-	RealTime timeSinceLastJump = System::time() - m_lastJumpTime;
-	if (m_jumpPressed && timeSinceLastJump > *jumpInterval) {
+	// Add jump here (if needed), timed by when the input was taken so a replayed input jumps the same way
+	RealTime timeSinceLastJump = input.time - m_lastJumpTime;
+	if ((input.flags & InputCommand::JUMP) && timeSinceLastJump > *jumpInterval) {
 		// Allow jumping if jumpTouch = False or if jumpTouch = True and the player is in contact w/ the map
 		if (!(*jumpTouch) || m_inContact) {
 			const Vector3 jv(0, *jumpVelocity * units::meters() / units::seconds(), 0);
 			m_linearVector += jv;
-			m_lastJumpTime = System::time();
+			m_lastJumpTime = input.time;
 		}
 	}
-	m_jumpPressed = false;
-
-	// Get the mouse rotation here
-	Vector2 mouseRotate = ui->mouseDXY() * turnScale * (float)m_cameraRadiansPerMouseDot;
-	float yaw = mouseRotate.x;
-	float pitch = mouseRotate.y;
 
 	// Set the player view velocity
-	setDesiredAngularVelocity(yaw, pitch);
+	setDesiredAngularVelocity(input.turn.x, input.turn.y);
+}
+
+void PlayerEntity::simulateInput(const InputCommand& input, SimTime absoluteTime) {
+	if (input.flags & InputCommand::RESPAWNED) {
+		setMovementState(input.result);
+		return;
+	}
+	const bool motionEnable = m_motionEnable;
+	m_motionEnable = !(input.flags & InputCommand::MOTION_DISABLED);
+	applyInput(input);
+	onSimulation(absoluteTime, input.dt);
+	m_motionEnable = motionEnable;
+}
+
+PlayerEntity::MovementState PlayerEntity::movementState() const {
+	MovementState state;
+	state.position = m_frame.translation;
+	state.heading = m_headingRadians;
+	state.headTilt = m_headTilt;
+	state.desiredOSVelocity = m_desiredOSVelocity;
+	state.linearVector = m_linearVector;
+	state.lastDirection = m_lastDirection;
+	state.acceleratedVelocity = m_acceleratedVelocity;
+	state.lastJumpVelocity = m_lastJumpVelocity;
+	state.lastJumpTime = m_lastJumpTime;
+	state.inAir = m_inAir;
+	state.inContact = m_inContact;
+	state.restrictionCenter = m_PlayersRestrictedMovementCenterPos;
+	return state;
+}
+
+void PlayerEntity::setMovementState(const MovementState& state) {
+	m_frame.translation = state.position;
+	m_headingRadians = state.heading;
+	m_headTilt = state.headTilt;
+	m_frame.rotation = Matrix3::fromAxisAngle(Vector3::unitY(), -m_headingRadians) * Matrix3::fromAxisAngle(Vector3::unitX(), m_headTilt);
+	m_desiredOSVelocity = state.desiredOSVelocity;
+	m_linearVector = state.linearVector;
+	m_lastDirection = state.lastDirection;
+	m_acceleratedVelocity = state.acceleratedVelocity;
+	m_lastJumpVelocity = state.lastJumpVelocity;
+	m_lastJumpTime = state.lastJumpTime;
+	m_inAir = state.inAir;
+	m_inContact = state.inContact;
+	m_PlayersRestrictedMovementCenterPos = state.restrictionCenter;
+}
+
+void PlayerEntity::setConfig(PlayerConfig* config) {
+	moveRate = &config->moveRate;
+	sprintMultiplier = &config->sprintMultiplier;
+	headBobEnabled = &config->headBobEnabled;
+	headBobAmplitude = &config->headBobAmplitude;
+	headBobFrequency = &config->headBobFrequency;
+	respawnPos = &config->respawnPos;
+	respawnToPos = &config->respawnToPos;
+	respawnHeading = &config->respawnHeading;
+	accelerationEnabled = &config->accelerationEnabled;
+	movementAcceleration = &config->movementAcceleration;
+	movementDeceleration = &config->movementDeceleration;
+	moveScale = &config->moveScale;
+	axisLock = &config->axisLock;
+	jumpVelocity = &config->jumpVelocity;
+	jumpInterval = &config->jumpInterval;
+	jumpTouch = &config->jumpTouch;
+	height = &config->height;
+	crouchHeight = &config->crouchHeight;
+	movementRestrictionX = &config->movementRestrictionX;
+	movementRestrictionZ = &config->movementRestrictionZ;
+	restrictedMovementEnabled = &config->restrictedMovementEnabled;
+	restrictionBoxAngle = &config->restrictionBoxAngle;
+	counterStrafing = &config->counterStrafing;
+	propagatePlayerConfigsToAll = &config->propagatePlayerConfigsToAll;
+	propagatePlayerConfigsToSelectedClient = &config->propagatePlayerConfigsToSelectedClient;
+	readFromFile = &config->readFromFile;
+	selectedClientIdx = &config->selectedClientIdx;
+	clientPlayerConfigs = &config->clientPlayerConfigs;
+	cornerPosition = &config->cornerPosition;
+	defenderRandomDisplacementAngle = &config->defenderRandomDisplacementAngle;
+	playerType = &config->playerType;
 }
 
 /** Maximum coordinate values for the player ship */
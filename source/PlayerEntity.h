@@ -3,6 +3,45 @@
 class PlayerConfig;
 
 class PlayerEntity : public VisibleEntity {
+public:
+    /** The state that determines how the player moves next, so the player can be put back in a past (or the server's) state and resimulated */
+    struct MovementState {
+        Point3      position;
+        float       heading = 0.0f;                     ///< Radians
+        float       headTilt = 0.0f;                    ///< Radians
+        Vector3     desiredOSVelocity;                  ///< Velocity the next slideMove() applies (set from the previous input)
+        Vector3     linearVector;
+        Vector3     lastDirection;
+        float       acceleratedVelocity = 0.0f;
+        float       lastJumpVelocity = 0.0f;
+        RealTime    lastJumpTime = 0.0;
+        bool        inAir = true;
+        bool        inContact = false;
+        Point3      restrictionCenter;                  ///< Center of the restricted movement box
+
+        /** Distance between the positions of two states */
+        float positionError(const MovementState& other) const { return (position - other.position).length(); }
+    };
+
+    /** One frame of the player's movement input, as it was simulated (so it can be sent to the server and replayed) */
+    struct InputCommand {
+        enum Flags : uint8 {
+            APPLIED     = 1,                            ///< Movement input was taken (the player's movement is enabled)
+            HALTED      = 2,                            ///< The player's velocities were zeroed instead (e.g. while a menu is open)
+            JUMP        = 4,
+            SPRINT      = 8,
+            RESPAWNED   = 16,                           ///< The player was respawned or moved on this frame, so result is taken as is rather than simulated
+            MOTION_DISABLED = 32                        ///< The player's motion was disabled (e.g. between trials), so it only turned
+        };
+        uint32          sequence = 0;                   ///< Number of this input (in the order the client simulated them)
+        float           dt = 0.0f;                      ///< Simulation time step (s)
+        Vector2         move;                           ///< Movement input (x = strafe, y = forward)
+        Vector2         turn;                           ///< Yaw and pitch change (radians, already scaled by the player's sensitivity)
+        uint8           flags = 0;
+        RealTime        time = 0.0;                     ///< Time the input was taken (for the jump interval)
+        MovementState   result;                         ///< State after this input (only used for RESPAWNED inputs)
+    };
+
 protected:
     Vector3         m_desiredOSVelocity;
     /** In object-space */
@@ -21,18 +60,18 @@ protected:
 	float			m_respawnHeight = fnan();
 	Point3			m_respawnPosition;
 
-	RealTime		m_lastJumpTime;
+	RealTime		m_lastJumpTime = 0.0;
 
 	bool			m_crouched = false;					///< Is the player crouched?
 	bool			m_inAir = true;						///< Is the player in the air (i.e. not in collision w/ a ground plane)?
-	float			m_lastJumpVelocity;
+	float			m_lastJumpVelocity = 0.0f;
 	float			m_health = 1.0f;					///< Player health storage
 
-    float           m_walkSpeed;                        ///< Players movement speed
+    float           m_walkSpeed = 0.0f;                 ///< Players movement speed
 
-    bool            m_gettingMovementInput;             ///< Is getting movement input from user?
-    bool            m_headBobPolarity;                  ///< Is head moving up/down?
-    float           m_headBobCurrentHeight;             ///< Headbob current that gets added to camera y
+    bool            m_gettingMovementInput = false;     ///< Is getting movement input from user?
+    bool            m_headBobPolarity = false;          ///< Is head moving up/down?
+    float           m_headBobCurrentHeight = 0.0f;      ///< Headbob current that gets added to camera y
 
 	bool			m_inContact = false;				///< Is the player in contact w/ anything?
 	bool			m_motionEnable = true;				///< Flag to disable player motion
@@ -42,7 +81,7 @@ protected:
 
     Vector3         m_linearVector;                     ///< Vector for movement
     Vector3         m_lastDirection;                    ///< Holds players last heading
-    float           m_acceleratedVelocity;              ///< Velocity after adding acceleration
+    float           m_acceleratedVelocity = 0.0f;       ///< Velocity after adding acceleration
 
     bool            m_PlayerReady = false;            ///< Indicates if the player is ready for play or not
     bool            m_PlayerMovement = false;         ///< Indicates if the player can move or not
@@ -51,6 +90,8 @@ protected:
 
     Point3          m_PlayerLastPosition;                 ///< Holds players last frame position 
 
+    uint32          m_teleports = 0;                      ///< Number of times the player was respawned or moved (rather than simulated)
+
     PlayerEntity() {}
 
 #ifdef G3D_OSX
@@ -92,10 +133,10 @@ public:
     bool* respawnToPos = nullptr;              ///< Respawns the player if true
     float* respawnHeading = nullptr;           ///< Holds pointer to where the player will be looking after respawn
 
-    float* movementRestrictionX;               ///< Holds the X distance of how far player can go when restricted movement is enabled.
-    float* movementRestrictionZ;               ///< Holds the Z distance of how far player can go when restricted movement is enabled.
-    bool* restrictedMovementEnabled;           ///< Checks if restricted movement is enabled or not
-    float* restrictionBoxAngle;                ///< Adds an angle element to the movement restriction
+    float* movementRestrictionX = nullptr;     ///< Holds the X distance of how far player can go when restricted movement is enabled.
+    float* movementRestrictionZ = nullptr;     ///< Holds the Z distance of how far player can go when restricted movement is enabled.
+    bool* restrictedMovementEnabled = nullptr; ///< Checks if restricted movement is enabled or not
+    float* restrictionBoxAngle = nullptr;      ///< Adds an angle element to the movement restriction
 
     bool* counterStrafing = nullptr;           ///< Checks if counter strafing is enabled or not
 
@@ -165,6 +206,7 @@ public:
 	void setCrouched(bool crouched) { m_crouched = crouched; };
 	void setJumpPressed(bool pressed=true) { m_jumpPressed = pressed; }
 	void setMoveEnable(bool enabled) { m_motionEnable = enabled; }
+	bool moveEnabled() const { return m_motionEnable; }
 
 	void setRespawnPosition(Point3 pos) { m_respawnPosition = pos; }
     void setRespawnHeadingDegrees(float headingDeg) { m_spawnHeadingRadians = pif() / 180.f * headingDeg; }
@@ -178,6 +220,7 @@ public:
 
 	void respawn() {
 
+        m_teleports++;
         m_frame.translation = m_respawnPosition;
 
         if (playerType!= nullptr && playerType->compare("DEFENDER") == 0) {
@@ -211,6 +254,14 @@ public:
         m_PlayersRestrictedMovementCenterPos = m_respawnPosition;
 	}
 
+    /** Move the player to a frame (rather than simulating it there) */
+    void teleport(const CFrame& frame) {
+        setFrame(frame);
+        m_teleports++;
+    }
+    /** Number of times the player was respawned or teleported, so a caller can tell it was moved rather than simulated */
+    uint32 teleports() const { return m_teleports; }
+
 	float health(void) { return m_health; }
     /** In radians... not used for rendering, use for first-person cameras */
     float headTilt() const { return m_headTilt; }
@@ -236,6 +287,15 @@ public:
     void setDesiredOSVelocity(const Vector3& objectSpaceVelocity) {  m_desiredOSVelocity = objectSpaceVelocity; }
     const Vector3& desiredOSVelocity() { return m_desiredOSVelocity; }
 
+    const Sphere& collisionProxySphere() const { return m_collisionProxySphere; }
+    void setCollisionProxySphere(const Sphere& sphere) { m_collisionProxySphere = sphere; }
+
+    /** Point the movement parameters at a player config (which must outlive this player) */
+    void setConfig(PlayerConfig* config);
+
+    MovementState movementState() const;
+    void setMovementState(const MovementState& state);
+
     void setDesiredAngularVelocity(const float y, const float p) {
         m_desiredYawVelocity    = y;
         m_desiredPitchVelocity  = p;
@@ -248,7 +308,12 @@ public:
     
     virtual void onPose(Array<shared_ptr<Surface> >& surfaceArray) override;
 	virtual void onSimulation(SimTime absoluteTime, SimTime deltaTime) override;
-	void updateFromInput(UserInput* ui);
+	/** Take this frame's movement input from the user (see applyInput()), returning it so it can be recorded */
+	InputCommand updateFromInput(UserInput* ui);
+	/** Set the player's desired velocities from a frame's input (simulated by the next onSimulation()) */
+	void applyInput(const InputCommand& input);
+	/** Apply an input and simulate its time step (or, for a RESPAWNED input, take its result), e.g. to replay it */
+	void simulateInput(const InputCommand& input, SimTime absoluteTime);
     
     double rotatePointXwrtCenter(double x, double y, float angle);
     double rotatePointYwrtCenter(double x, double y, float angle);
@@ -0,0 +1,40 @@
+#include "PlayerPrediction.h"
+
+uint32 PlayerPrediction::record(InputCommand& input, const MovementState& predicted) {
+	input.sequence = m_nextSequence++;
+	if (m_pending.size() >= CAPACITY) m_pending.popFront();
+	Prediction p;
+	p.input = input;
+	p.state = predicted;
+	m_pending.pushBack(p);
+	return input.sequence;
+}
+
+void PlayerPrediction::unacked(int maxCount, Array<InputCommand>& inputs) const {
+	inputs.fastClear();
+	for (int i = max(0, m_pending.size() - maxCount); i < m_pending.size(); i++) {
+		inputs.append(m_pending[i].input);
+	}
+}
+
+bool PlayerPrediction::acknowledge(uint32 sequence, const MovementState& serverState, float& positionError, RealTime& inputTime) {
+	if (sequence <= m_ackedSequence || sequence >= m_nextSequence) return false;
+	m_ackedSequence = sequence;
+
+	positionError = finf();
+	inputTime = 0.0;
+	while (m_pending.size() > 0 && m_pending[0].input.sequence <= sequence) {
+		const Prediction p = m_pending.popFront();
+		if (p.input.sequence == sequence) {
+			positionError = p.state.positionError(serverState);
+			inputTime = p.input.time;
+		}
+	}
+	return true;
+}
+
+void PlayerPrediction::clear() {
+	m_pending.clear();
+	m_nextSequence = 1;
+	m_ackedSequence = 0;
+}
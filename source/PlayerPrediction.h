@@ -0,0 +1,52 @@
+#pragma once
+#include <G3D/G3D.h>
+#include <chrono>
+#include "PlayerEntity.h"
+
+/** The client's record of the movement inputs it predicted but the server hasn't acknowledged yet (client side prediction)
+
+	The client simulates its own player from each frame's input straight away, numbers the input and records it here with
+	the state it predicted. The unacknowledged inputs are sent to the server on every network frame, and the server
+	simulates each one it hasn't seen and sends back its state after the last one. When that state differs from the
+	prediction for the same input the client takes the server's state and replays the inputs still pending on top of it.
+*/
+class PlayerPrediction {
+public:
+	typedef std::chrono::high_resolution_clock Clock;
+	typedef PlayerEntity::InputCommand InputCommand;
+	typedef PlayerEntity::MovementState MovementState;
+
+	static const int CAPACITY = 512;				///< Inputs kept (about 2 s of frames at 240 Hz), older ones are dropped unacknowledged
+
+	/** An input and the state the client predicted after it */
+	struct Prediction {
+		InputCommand	input;
+		MovementState	state;
+	};
+
+protected:
+	Queue<Prediction>	m_pending;					///< Unacknowledged inputs (oldest first)
+	uint32				m_nextSequence = 1;			///< Sequence number of the next input (0 means no input)
+	uint32				m_ackedSequence = 0;		///< Last input the server acknowledged
+
+public:
+	/** Number the input (setting its sequence) and store it with the state predicted after it. Returns the sequence number. */
+	uint32 record(InputCommand& input, const MovementState& predicted);
+	/** Get (up to) the newest maxCount unacknowledged inputs, oldest first */
+	void unacked(int maxCount, Array<InputCommand>& inputs) const;
+	/** Drop the inputs up to (and including) sequence, which the server simulated to serverState. Returns false for
+		acknowledgements that are stale (reordered behind a newer one). Otherwise positionError is set to the distance
+		between the server's state and the prediction for that input (infinite if the prediction was already dropped) and
+		inputTime to the time the input was taken (0 if it was dropped). */
+	bool acknowledge(uint32 sequence, const MovementState& serverState, float& positionError, RealTime& inputTime);
+	void clear();
+
+	/** Number of unacknowledged inputs */
+	int pending() const { return m_pending.size(); }
+	const Prediction& operator[](int i) const { return m_pending[i]; }
+	/** Replace the prediction for a pending input (after replaying it) */
+	void setPredicted(int i, const MovementState& state) { m_pending[i].state = state; }
+
+	uint32 ackedSequence() const { return m_ackedSequence; }
+	uint32 latestSequence() const { return m_nextSequence - 1; }
+};
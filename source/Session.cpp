@@ -629,18 +629,17 @@ void Session::recordTrialResponse(int destroyedTargets, int totalTargets)
 	if (!m_config->logger.enable) return;		// Skip this if the logger is disabled
 	if (m_config->logger.logTrialResponse) {
 		// Trials table. Record trial start time, end time, and task completion time.
-		FPSciLogger::TrialValues trialValues = {
-			"'" + m_config->id + "'",
-			String(std::to_string(m_currTrialIdx)),
-			String(std::to_string(m_completedTrials[m_currTrialIdx])),
-			format("'Block %d'", m_currBlock),
-			"'" + m_taskStartTime + "'",
-			"'" + m_taskEndTime + "'",
-			String(std::to_string(m_pretrialDuration)),
-			String(std::to_string(m_taskExecutionTime)),
-			String(std::to_string(destroyedTargets)),
-			String(std::to_string(totalTargets))
-		};
+		FPSciLogger::TrialValues trialValues;
+		trialValues.sessionId = m_config->id;
+		trialValues.trialId = m_currTrialIdx;
+		trialValues.trialIndex = m_completedTrials[m_currTrialIdx];
+		trialValues.blockId = m_currBlock;
+		trialValues.startTime = m_taskStartTime;
+		trialValues.endTime = m_taskEndTime;
+		trialValues.pretrialDuration = m_pretrialDuration;
+		trialValues.taskExecutionTime = m_taskExecutionTime;
+		trialValues.destroyedTargets = destroyedTargets;
+		trialValues.totalTargets = totalTargets;
 		logger->logTrial(trialValues);
 	}
 }
@@ -652,7 +651,7 @@ void Session::accumulateTrajectories()
 			if (!target->isLogged()) continue;
 			String name = target->name();
 			Point3 pos = target->frame().translation;
-			TargetLocation location = TargetLocation(FPSciLogger::getFileTime(), name, currentState, pos);
+			TargetLocation location = TargetLocation(FPSciLogger::frameTime(), name, currentState, pos);
 			if (m_config->logger.logOnChange) {
 				// Check for target in logged position table
 				if (m_lastLogTargetLoc.containsKey(name)  && location.noChangeFrom(m_lastLogTargetLoc[name])) {	
@@ -683,7 +682,7 @@ void Session::accumulatePlayerAction(PlayerActionType action, String targetName)
 		// recording target trajectories
 		Point2 dir = getViewDirection();
 		Point3 loc = getPlayerLocation();
-		PlayerAction pa = PlayerAction(FPSciLogger::getFileTime(), dir, loc, currentState, action, targetName);
+		PlayerAction pa = PlayerAction(FPSciLogger::frameTime(), dir, loc, currentState, action, targetName);
 		// Check for log only on change condition
 		if (m_config->logger.logOnChange && pa.noChangeFrom(lastPA)) {
 			return;		// Early exit for (would be) duplicate log entry
@@ -696,7 +695,7 @@ void Session::accumulatePlayerAction(PlayerActionType action, String targetName)
 
 void Session::accumulateFrameInfo(RealTime t, float sdt, float idt) {
 	if (notNull(logger) && m_config->logger.logFrameInfo) {
-		logger->logFrameInfo(FrameInfo(FPSciLogger::getFileTime(), sdt));
+		logger->logFrameInfo(FrameInfo(FPSciLogger::frameTime(), sdt));
 	}
 }
 
@@ -837,7 +836,8 @@ void Session::endLogging() {
 	if (notNull(logger)) {
 
 		//m_logger->logUserConfig(*m_app->currentUser(), m_config->id, m_config->player.turnScale);
-		logger->flush(false);
+		// Make sure everything logged in this session is in the results file before moving on
+		logger->flush(true);
 		logger.reset();
 	}
 }
@@ -29,6 +29,7 @@
 
 #include <G3D/G3D.h>
 #include "FpsConfig.h"
+#include "Subprocess.h"
 #include <ctime>
 
 class FPSciApp;
@@ -52,41 +53,53 @@ public:
 	};
 };
 
+/** GUID field of a log record that remembers whether it was set (an unset id is logged as an empty string, a set one as its
+	string16 representation even if it is zero, as when these fields were logged as strings) */
+struct LoggedGUID {
+	GUniqueID	id;
+	bool		set = false;
+
+	LoggedGUID() {}
+	LoggedGUID(const GUniqueID& guid) : id(guid), set(true) {}
+
+	bool operator==(const LoggedGUID& other) const { return set == other.set && id == other.id; }
+};
+
  struct FrameInfo {
-	FILETIME time;
+	int64 time = 0;					///< Time logged (ns since the Unix epoch, see FPSciLogger::getTime())
 	//float idt = 0.0f;
 	float sdt = 0.0f;
 	uint32 network_RTT = 0;
 	uint32 local_frame = 0;
 	uint32 remote_frame = 0;
-	String guid = "";
+	LoggedGUID clientID;
 
 	FrameInfo() {};
 
-	FrameInfo(FILETIME t, float simDeltaTime) {
+	FrameInfo(int64 t, float simDeltaTime) {
 		time = t;
 		sdt = simDeltaTime;
 	}
 
-	FrameInfo(FILETIME t, float simDeltaTime, uint32 rtt, uint32 localFrameNum, uint32 remoteFrameNum, GUniqueID clientGUID) {
+	FrameInfo(int64 t, float simDeltaTime, uint32 rtt, uint32 localFrameNum, uint32 remoteFrameNum, GUniqueID clientGUID) {
 		time = t;
 		sdt = simDeltaTime;
 		network_RTT = rtt;
 		local_frame = localFrameNum;
 		remote_frame = remoteFrameNum;
-		guid = clientGUID.toString16();
+		clientID = clientGUID;
 	}
 };
 
 struct TargetLocation {
-	FILETIME time;
+	int64 time = 0;
 	String name = "";
 	PresentationState state;
 	Point3 position = Point3::zero();
 
 	TargetLocation() {};
 
-	TargetLocation(FILETIME t, String targetName, PresentationState trialState, Point3 targetPosition) {
+	TargetLocation(int64 t, String targetName, PresentationState trialState, Point3 targetPosition) {
 		time = t;
 		name = targetName;
 		state = trialState;
@@ -109,7 +122,7 @@ enum PlayerActionType{
 };
 
 struct PlayerAction {
-	FILETIME			time;
+	int64				time = 0;
 	Point2				viewDirection = Point2::zero();
 	Point3				position = Point3::zero();
 	PresentationState	state;
@@ -118,7 +131,7 @@ struct PlayerAction {
 
 	PlayerAction() {};
 
-	PlayerAction(FILETIME t, Point2 playerViewDirection, Point3 playerPosition, PresentationState trialState, PlayerActionType playerAction, String name) {
+	PlayerAction(int64 t, Point2 playerViewDirection, Point3 playerPosition, PresentationState trialState, PlayerActionType playerAction, String name) {
 		time = t;
 		viewDirection = playerViewDirection;
 		position = playerPosition;
@@ -237,8 +250,8 @@ protected:
 	// Could move timer above to stopwatch in future
 	//Stopwatch stopwatch;			
 
-	Array<HANDLE> m_sessProcesses;						///< Handles for session-level processes
-	Array<HANDLE> m_trialProcesses;						///< Handles for trial-level processes
+	Array<Subprocess::Handle> m_sessProcesses;			///< Handles for session-level processes
+	Array<Subprocess::Handle> m_trialProcesses;			///< Handles for trial-level processes
 
 	// Target parameters
 	const float m_targetDistance = 1.0f;				///< Actual distance to target
@@ -263,7 +276,7 @@ protected:
 
 	inline void closeTrialProcesses() {
 		for (auto handle : m_trialProcesses) { 
-			TerminateProcess(handle, 0); 
+			Subprocess::terminate(handle); 
 		}
 		m_trialProcesses.clear();
 	}
@@ -278,7 +291,7 @@ protected:
 
 	inline void closeSessionProcesses() {
 		for (auto handle : m_sessProcesses) { 
-			TerminateProcess(handle, 0); 
+			Subprocess::terminate(handle); 
 		}
 		m_sessProcesses.clear();
 	}
@@ -358,47 +371,14 @@ protected:
 		return m_camera->frame().translation;
 	}
 
-	HANDLE runCommand(CommandSpec cmd, String evt) {
-		STARTUPINFO si;
-		PROCESS_INFORMATION pi;
-		ZeroMemory(&si, sizeof(si));
-		si.cb = sizeof(si);
-		ZeroMemory(&pi, sizeof(pi));
-
-		// Run the (formatted command)
-		LPSTR command = LPSTR(formatCommand(cmd.cmdStr).c_str());
-		bool success;
-		if (cmd.foreground) {	// Run process in the foreground
-			success = CreateProcess(NULL, command, NULL, NULL, FALSE, CREATE_NEW_CONSOLE, NULL, NULL, &si, &pi);
-		}
-		else {				// Run process silently in the background
-			success = CreateProcess(NULL, command, NULL, NULL, TRUE, CREATE_NO_WINDOW, NULL, NULL, &si, &pi);
-		}
-
-		if (!success) {
-			logPrintf("Failed to run %s command: \"%s\". %s\n", evt, cmd, GetLastErrorString());
-		}
-
-		if (cmd.blocking) {	// Optional blocking behavior
-			WaitForSingleObject(pi.hProcess, INFINITE);
-		}
-
-		return pi.hProcess;
-	}
-
-	String GetLastErrorString() {
-		DWORD error = GetLastError();
-		if (error) {
-			LPVOID lpMsgBuf;
-			DWORD bufLen = FormatMessage(FORMAT_MESSAGE_ALLOCATE_BUFFER | FORMAT_MESSAGE_FROM_SYSTEM | FORMAT_MESSAGE_IGNORE_INSERTS, NULL, error, MAKELANGID(LANG_NEUTRAL, SUBLANG_DEFAULT), (LPTSTR)&lpMsgBuf, 0, NULL);
-			if (bufLen) {
-				LPCSTR lpMsgStr = (LPCSTR)lpMsgBuf;
-				std::string result(lpMsgStr, lpMsgStr + bufLen);
-				LocalFree(lpMsgBuf);
-				return String(result);
-			}
+	Subprocess::Handle runCommand(CommandSpec cmd, String evt) {
+		// Run the (formatted command), in the foreground or silently in the background
+		String error;
+		const Subprocess::Handle handle = Subprocess::run(formatCommand(cmd.cmdStr), cmd.foreground, !cmd.foreground, cmd.blocking, error);
+		if (handle == Subprocess::INVALID) {
+			logPrintf("Failed to run %s command: \"%s\". %s\n", evt.c_str(), cmd.cmdStr.c_str(), error.c_str());
 		}
-		return String();
+		return handle;
 	}
 
 public:
@@ -0,0 +1,58 @@
+#include "SnapshotHistory.h"
+
+void SnapshotHistory::record(uint32 frame, const shared_ptr<const Snapshot>& snapshot) {
+	const int slot = frame % CAPACITY;
+	m_frames[slot] = frame;
+	m_snapshots[slot] = snapshot;
+	m_latestFrame = max(m_latestFrame, frame);
+}
+
+shared_ptr<const SnapshotHistory::Snapshot> SnapshotHistory::find(uint32 frame) const {
+	if (frame == 0) return nullptr;
+	const int slot = frame % CAPACITY;
+	return (m_frames[slot] == frame) ? m_snapshots[slot] : nullptr;
+}
+
+void SnapshotHistory::clear() {
+	for (int i = 0; i < CAPACITY; i++) {
+		m_frames[i] = 0;
+		m_snapshots[i].reset();
+	}
+	m_latestFrame = 0;
+	m_ackedFrame = 0;
+}
+
+void SnapshotHistory::diff(const Snapshot* baseline, const Snapshot& current, Array<EntityDelta>& deltas) {
+	deltas.fastClear();
+	int b = 0;
+	for (const EntityState& state : current) {
+		// Both snapshots are sorted by index, so walk them together
+		while (notNull(baseline) && b < baseline->size() && (*baseline)[b].index < state.index) b++;
+		if (isNull(baseline) || b >= baseline->size() || (*baseline)[b].index != state.index) {
+			deltas.append(EntityDelta(state, EntityDelta::ALL_FIELDS));
+			continue;
+		}
+		const EntityState& old = (*baseline)[b];
+		uint8 changed = 0;
+		if (old.position != state.position) changed |= EntityDelta::POSITION;
+		if (old.rotation != state.rotation) changed |= EntityDelta::ROTATION;
+		if (changed != 0) deltas.append(EntityDelta(state, changed));
+	}
+}
+
+void SnapshotHistory::apply(const Snapshot* baseline, Array<EntityDelta>& deltas, Snapshot& result) {
+	result.fastClear();
+	int b = 0;
+	const int baselineSize = notNull(baseline) ? baseline->size() : 0;
+	for (EntityDelta& d : deltas) {
+		// Keep the (unchanged) baseline entities before this one
+		while (b < baselineSize && (*baseline)[b].index < d.state.index) result.append((*baseline)[b++]);
+		if (b < baselineSize && (*baseline)[b].index == d.state.index) {
+			const EntityState& old = (*baseline)[b++];
+			if (!(d.changed & EntityDelta::POSITION)) d.state.position = old.position;
+			if (!(d.changed & EntityDelta::ROTATION)) d.state.rotation = old.rotation;
+		}
+		result.append(d.state);
+	}
+	while (b < baselineSize) result.append((*baseline)[b++]);
+}
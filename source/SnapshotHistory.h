@@ -0,0 +1,59 @@
+#pragma once
+#include <G3D/G3D.h>
+#include "Packet.h"
+
+/** A ring of recent entity snapshots used as baselines for delta compressed entity updates
+
+	The server keeps one history per client holding the snapshots it sent to that client, the client keeps one holding the
+	snapshots it received (rebuilt from the deltas). Each client acknowledges the last snapshot it received in its own
+	updates, and the server encodes the next snapshot relative to that one (or in full if it has already left the ring).
+*/
+class SnapshotHistory {
+public:
+	typedef BatchEntityUpdatePacket::EntityState EntityState;
+	typedef BatchEntityUpdatePacket::EntityDelta EntityDelta;
+	/** The state of every networked entity on a frame (sorted by index) */
+	typedef Array<EntityState> Snapshot;
+
+	static const int CAPACITY = 128;				///< Snapshots kept (about 0.5 s of network frames at 240 Hz)
+
+	/** Totals for the snapshots sent to a client (logged to the Snapshot_Stats table, then reset) */
+	struct SendStats {
+		int		snapshots = 0;					///< Snapshots sent
+		int		fullSnapshots = 0;				///< Snapshots sent without a baseline
+		int64	bytesSent = 0;					///< Bytes sent
+		int64	fullBytes = 0;					///< Bytes the same snapshots take as (absolute) REPLACE_FRAME updates
+		int64	entitiesSent = 0;				///< Entity states sent
+		int64	entitiesTotal = 0;				///< Entity states in the snapshots
+		int64	entitiesRelevant = 0;			///< Entities relevant to the client (all of them without interest management)
+		int64	entitiesDeferred = 0;			///< Entities that were due to be sent but didn't fit the client's bandwidth budget
+	};
+	SendStats	sendStats;
+
+protected:
+	uint32						m_frames[CAPACITY] = {};	///< Frame number of each stored snapshot (0 for empty slots)
+	shared_ptr<const Snapshot>	m_snapshots[CAPACITY];		///< Stored snapshots (shared, so the same snapshot can be recorded for many clients)
+	uint32						m_latestFrame = 0;			///< Most recently recorded frame
+	uint32						m_ackedFrame = 0;			///< Most recent frame acknowledged by the receiver
+
+public:
+	/** Store the snapshot for this frame (replacing the oldest snapshot) */
+	void record(uint32 frame, const shared_ptr<const Snapshot>& snapshot);
+	/** The snapshot for this frame, nullptr if it isn't held (any more) */
+	shared_ptr<const Snapshot> find(uint32 frame) const;
+	/** Mark a frame as received (acknowledgements only move forward, so reordered ones are ignored) */
+	void acknowledge(uint32 frame) { if (frame > m_ackedFrame) m_ackedFrame = frame; }
+	void clear();
+
+	uint32 latestFrame() const { return m_latestFrame; }
+	uint32 ackedFrame() const { return m_ackedFrame; }
+	/** The acknowledged snapshot to encode the next snapshot against, nullptr if it isn't held */
+	shared_ptr<const Snapshot> baseline() const { return find(m_ackedFrame); }
+
+	/** Get the changes from the baseline to the current snapshot. Unchanged entities are left out, entities that aren't in
+		the baseline (or everything if baseline is null) are included in full. */
+	static void diff(const Snapshot* baseline, const Snapshot& current, Array<EntityDelta>& deltas);
+	/** Rebuild a snapshot from its baseline (nullptr if the deltas are complete) and the deltas. Entities that weren't sent
+		keep their baseline state, deltas are completed (in place) with the fields taken from the baseline. */
+	static void apply(const Snapshot* baseline, Array<EntityDelta>& deltas, Snapshot& result);
+};
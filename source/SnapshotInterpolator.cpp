@@ -0,0 +1,102 @@
+#include "SnapshotInterpolator.h"
+
+void SnapshotInterpolator::addSnapshot(uint32 frame, Clock::time_point arrivalTime) {
+	if (m_arrivalCount == 0) m_timeBase = seconds(arrivalTime);
+	Arrival& arrival = m_arrivals[m_nextArrival];
+	arrival.frame = frame;
+	arrival.time = seconds(arrivalTime) - m_timeBase;
+	m_nextArrival = (m_nextArrival + 1) % CLOCK_SAMPLES;
+	m_arrivalCount = min(m_arrivalCount + 1, CLOCK_SAMPLES);
+	m_latestFrame = max(m_latestFrame, frame);
+
+	// Rate from the oldest and newest arrivals held
+	const Arrival& oldest = m_arrivals[(m_arrivalCount == CLOCK_SAMPLES) ? m_nextArrival : 0];
+	const double span = arrival.time - oldest.time;
+	if (span < MIN_CLOCK_SPAN_S || arrival.frame <= oldest.frame) return;
+	m_framesPerSecond = (arrival.frame - oldest.frame) / span;
+
+	// Offset from the arrival that was least delayed (the one furthest ahead of the others at this rate)
+	m_frameOffset = -finf();
+	for (int i = 0; i < m_arrivalCount; i++) {
+		m_frameOffset = max(m_frameOffset, m_arrivals[i].frame - m_framesPerSecond * m_arrivals[i].time);
+	}
+}
+
+void SnapshotInterpolator::addSample(uint16 index, uint32 frame, const CFrame& cframe) {
+	if (index >= m_entities.size()) m_entities.resize(index + 1);
+	Array<Sample>& samples = m_entities[index];
+	int i = samples.size();
+	while (i > 0 && samples[i - 1].frame >= frame) i--;		// Samples (almost always) arrive in order, so search from the end
+	if (i < samples.size() && samples[i].frame == frame) return;
+	Sample sample;
+	sample.frame = frame;
+	sample.position = cframe.translation;
+	sample.rotation = Quat(cframe.rotation);
+	samples.insert(i, sample);
+	if (samples.size() > ENTITY_SAMPLES) samples.remove(0);
+}
+
+void SnapshotInterpolator::removeEntity(uint16 index) {
+	if (index < m_entities.size()) m_entities[index].fastClear();
+}
+
+void SnapshotInterpolator::clear() {
+	for (Array<Sample>& samples : m_entities) {
+		samples.fastClear();
+	}
+	m_arrivalCount = 0;
+	m_nextArrival = 0;
+	m_latestFrame = 0;
+	m_framesPerSecond = 0.0;
+	m_frameOffset = 0.0;
+}
+
+double SnapshotInterpolator::renderFrame(Clock::time_point now, double delayS) const {
+	if (!synchronized()) return m_latestFrame;
+	return m_frameOffset + m_framesPerSecond * (seconds(now) - m_timeBase - delayS);
+}
+
+SnapshotInterpolator::Result SnapshotInterpolator::evaluate(uint16 index, double frame, double maxExtrapolationS, CFrame& cframe, FrameStats& stats) const {
+	if (index >= m_entities.size() || m_entities[index].size() == 0) return NO_DATA;
+	const Array<Sample>& samples = m_entities[index];
+	const Sample& last = samples.last();
+
+	if (!synchronized() || frame <= samples[0].frame || (frame > last.frame && samples.size() < 2)) {
+		const Sample& held = (synchronized() && frame <= samples[0].frame) ? samples[0] : last;
+		cframe = CFrame(held.rotation.toRotationMatrix(), held.position);
+		stats.held++;
+		return HELD;
+	}
+
+	if (frame <= last.frame) {
+		int i = samples.size() - 2;
+		while (samples[i].frame > frame) i--;
+		const Sample& a = samples[i];
+		const Sample& b = samples[i + 1];
+		const float alpha = (float)((frame - a.frame) / (b.frame - a.frame));
+		cframe = CFrame(a.rotation.slerp(b.rotation, alpha).toRotationMatrix(), a.position.lerp(b.position, alpha));
+		stats.interpolated++;
+		return INTERPOLATED;
+	}
+
+	// Continue the latest motion (rotations aren't extrapolated, a wrong turn looks worse than a late one)
+	const Sample& previous = samples[samples.size() - 2];
+	const Vector3 velocity = (last.position - previous.position) / (float)(last.frame - previous.frame);		// Per frame
+	const double extrapolationS = framesToSeconds(frame - last.frame);
+	const double frames = min(frame - last.frame, maxExtrapolationS * m_framesPerSecond);
+	cframe = CFrame(last.rotation.toRotationMatrix(), last.position + velocity * (float)frames);
+	if (extrapolationS > maxExtrapolationS) {
+		stats.held++;
+		return HELD;
+	}
+	stats.extrapolated++;
+	stats.maxExtrapolationMs = max(stats.maxExtrapolationMs, (float)(1000.0 * extrapolationS));
+	return EXTRAPOLATED;
+}
+
+void SnapshotInterpolator::getEntities(Array<uint16>& indices) const {
+	indices.fastClear();
+	for (int i = 0; i < m_entities.size(); i++) {
+		if (m_entities[i].size() > 0) indices.append((uint16)i);
+	}
+}
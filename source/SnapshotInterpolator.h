@@ -0,0 +1,89 @@
+#pragma once
+#include <G3D/G3D.h>
+#include <chrono>
+
+/** Buffers the entity states received from the server so remote entities are shown a fixed delay behind the server,
+	interpolating between snapshots (rather than jumping to each one as it arrives, with whatever jitter it arrived with)
+
+	The server's frame rate and clock are estimated from the frame numbers and arrival times of recent snapshots: the
+	rate from the oldest and newest arrivals held, and the clock from the snapshot that arrived with the least delay.
+	Entities are then shown as they were on the (fractional) server frame the delay before the estimated server clock.
+	When that frame is past an entity's latest sample its motion is extrapolated (positions only) for up to the
+	extrapolation limit, after which it is held.
+*/
+class SnapshotInterpolator {
+public:
+	typedef std::chrono::high_resolution_clock Clock;
+
+	static const int CLOCK_SAMPLES = 256;			///< Snapshot arrivals used to estimate the server's clock
+	static const int ENTITY_SAMPLES = 32;			///< Samples held for each entity
+	static constexpr double MIN_CLOCK_SPAN_S = 0.25;	///< Arrivals must span at least this long before the clock is estimated
+
+	/** How an entity's frame was found */
+	enum Result {
+		NO_DATA,									///< No samples for the entity
+		INTERPOLATED,								///< Between two samples
+		EXTRAPOLATED,								///< Past the latest sample (within the extrapolation limit)
+		HELD										///< A sample shown as is: past the extrapolation limit, before the oldest sample, or before the clock is estimated
+	};
+
+	/** Totals for one rendered frame */
+	struct FrameStats {
+		int		interpolated = 0;
+		int		extrapolated = 0;
+		int		held = 0;
+		float	delayMs = 0.0f;						///< Time between the newest snapshot received and the frame shown
+		float	maxExtrapolationMs = 0.0f;			///< Longest extrapolation (past an entity's latest sample)
+	};
+
+protected:
+	/** An entity's state on one server frame */
+	struct Sample {
+		uint32		frame = 0;
+		Point3		position;
+		Quat		rotation;
+	};
+
+	/** A snapshot's frame number and local arrival time (s) */
+	struct Arrival {
+		uint32		frame = 0;
+		double		time = 0.0;
+	};
+
+	Array<Array<Sample>>	m_entities;				///< Samples for each entity (indexed by network index, sorted by frame)
+	Arrival					m_arrivals[CLOCK_SAMPLES];
+	int						m_arrivalCount = 0;
+	int						m_nextArrival = 0;
+	uint32					m_latestFrame = 0;
+	double					m_timeBase = 0.0;			///< Arrival time of the first snapshot (times are held relative to it, for precision)
+	double					m_framesPerSecond = 0.0;	///< Estimated server frame rate (0 until estimated)
+	double					m_frameOffset = 0.0;		///< Estimated server frame at m_timeBase
+
+	static double seconds(Clock::time_point time) { return std::chrono::duration<double>(time.time_since_epoch()).count(); }
+
+public:
+	/** Record the arrival of a snapshot (updating the server clock estimate) */
+	void addSnapshot(uint32 frame, Clock::time_point arrivalTime);
+	/** Add an entity's state on a server frame */
+	void addSample(uint16 index, uint32 frame, const CFrame& cframe);
+	/** Forget an entity's samples (e.g. when it is destroyed, since its index may be reused) */
+	void removeEntity(uint16 index);
+	/** Forget everything (e.g. when reconnecting, as frame numbers start over) */
+	void clear();
+
+	/** Has the server clock been estimated yet? */
+	bool synchronized() const { return m_framesPerSecond > 0.0; }
+	/** The (fractional) server frame to show at this time (delayS behind the estimated server clock) */
+	double renderFrame(Clock::time_point now, double delayS) const;
+	/** Time a number of server frames take (at the estimated rate, 0 until it is estimated) */
+	double framesToSeconds(double frames) const { return synchronized() ? frames / m_framesPerSecond : 0.0; }
+	/** Newest snapshot frame received */
+	uint32 latestFrame() const { return m_latestFrame; }
+
+	/** Find an entity's frame on the given (fractional) server frame, extrapolating up to maxExtrapolationS past its latest
+		sample. Adds the result to stats (when not NO_DATA). */
+	Result evaluate(uint16 index, double frame, double maxExtrapolationS, CFrame& cframe, FrameStats& stats) const;
+
+	/** Indices of the entities with samples */
+	void getEntities(Array<uint16>& indices) const;
+};
@@ -0,0 +1,63 @@
+#pragma once
+#include <G3D/G3D.h>
+#include <atomic>
+#include <memory>
+
+/** Bounded lock-free single-producer/single-consumer ring buffer
+
+	The producer only writes the enqueue position and the consumer only writes the dequeue position, so neither side ever
+	waits on the other (or takes a lock). Only one thread may push and only one (other) thread may pop. The capacity is
+	rounded up to a power of 2.
+*/
+template <typename ItemType>
+class SpscRingBuffer {
+protected:
+	std::unique_ptr<ItemType[]>	m_items;
+	size_t						m_mask = 0;
+
+	char						m_pad0[64];				///< Keep the producer/consumer positions on separate cache lines
+	std::atomic<size_t>			m_enqueuePos;			///< Next slot the producer writes
+	char						m_pad1[64];
+	std::atomic<size_t>			m_dequeuePos;			///< Next slot the consumer reads
+
+	// Don't allow copies
+	SpscRingBuffer(const SpscRingBuffer&);
+	void operator=(const SpscRingBuffer&);
+
+public:
+	explicit SpscRingBuffer(size_t capacity) {
+		size_t size = 2;
+		while (size < capacity) size <<= 1;
+		m_items.reset(new ItemType[size]);
+		m_mask = size - 1;
+		m_enqueuePos.store(0, std::memory_order_relaxed);
+		m_dequeuePos.store(0, std::memory_order_relaxed);
+	}
+
+	size_t capacity() const { return m_mask + 1; }
+
+	/** Number of items waiting (exact from either thread for its own side, may be stale for the other) */
+	size_t size() const { return m_enqueuePos.load(std::memory_order_acquire) - m_dequeuePos.load(std::memory_order_acquire); }
+	bool empty() const { return size() == 0; }
+	/** Is there no room for another push? (producer thread only) */
+	bool full() const { return size() >= capacity(); }
+
+	/** Push a copy of item (producer thread only), returns false (without blocking) if the ring is full */
+	bool tryPush(const ItemType& item) {
+		const size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+		if (pos - m_dequeuePos.load(std::memory_order_acquire) >= capacity()) return false;
+		m_items[pos & m_mask] = item;
+		m_enqueuePos.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	/** Pop the oldest item (consumer thread only), returns false if nothing is ready */
+	bool tryPop(ItemType& item) {
+		const size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+		if (pos == m_enqueuePos.load(std::memory_order_acquire)) return false;
+		item = std::move(m_items[pos & m_mask]);
+		m_items[pos & m_mask] = ItemType();		// Release anything the item owns now rather than on slot reuse
+		m_dequeuePos.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+};
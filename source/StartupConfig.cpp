@@ -88,6 +88,10 @@ StartupConfig::StartupConfig(const Any& any) {
 		reader.getIfPresent("windowSize", windowSize);
 		reader.getIfPresent("jsonAnyOutput", jsonAnyOutput);
 		reader.getIfPresent("lowerFrameRateInBackground", lowerFrameRateInBackground);
+		reader.getIfPresent("serverTickRate", serverTickRate);
+		if (serverTickRate <= 0.0f) {
+			throw format("serverTickRate (%f) must be greater than 0!", serverTickRate);
+		}
 		
 		foundDefault = reader.getIfPresent("defaultExperiment", defaultExperiment);
 		if (!foundDefault) {
@@ -150,6 +154,7 @@ Any StartupConfig::toAny(const bool forceAll) const {
 	if (forceAll || def.audioEnable != audioEnable)									a["audioEnable"] = audioEnable;
 	if (forceAll || def.jsonAnyOutput != jsonAnyOutput)								a["jsonAnyOutput"] = jsonAnyOutput;
 	if (forceAll || def.lowerFrameRateInBackground != lowerFrameRateInBackground)	a["lowerFrameRateInBackground"] = lowerFrameRateInBackground;
+	if (forceAll || def.serverTickRate != serverTickRate)							a["serverTickRate"] = serverTickRate;
 	a["defaultExperiment"] = defaultExperiment;
 	a["experimentList"] = experimentList;
 
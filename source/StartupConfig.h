@@ -48,4 +48,5 @@ public:
 	bool validateExperiments() const;							///< Validate the experiments in the experiment list
 
 	bool lowerFrameRateInBackground = true;						///< Run windows in the background at a 4fps or at full speed
+	float serverTickRate = 128.0f;								///< Ticks per second of the headless server (which doesn't render frames)
 };
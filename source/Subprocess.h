@@ -0,0 +1,94 @@
+#pragma once
+
+#include <G3D/G3D.h>
+#ifndef G3D_WINDOWS
+#include <errno.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+/** Runs external commands (session/trial commands and the python hardware logger)
+
+	Uses CreateProcess on Windows and fork/exec of /bin/sh elsewhere (where there is no console, so foreground commands
+	run like background ones).
+*/
+class Subprocess {
+public:
+#ifdef G3D_WINDOWS
+	typedef HANDLE Handle;
+#else
+	typedef pid_t Handle;
+#endif
+	static constexpr Handle INVALID = 0;
+
+	/** Start a command, waiting for it to exit if blocking is set. Returns INVALID (and sets error) if it couldn't be started. */
+	static Handle run(const String& command, bool foreground, bool inheritHandles, bool blocking, String& error) {
+		error = "";
+#ifdef G3D_WINDOWS
+		STARTUPINFO si;
+		PROCESS_INFORMATION pi;
+		ZeroMemory(&si, sizeof(si));
+		si.cb = sizeof(si);
+		ZeroMemory(&pi, sizeof(pi));
+
+		std::string commandLine = command.c_str();		// CreateProcess may modify the command line
+		if (!CreateProcess(NULL, &commandLine[0], NULL, NULL, inheritHandles, foreground ? CREATE_NEW_CONSOLE : CREATE_NO_WINDOW, NULL, NULL, &si, &pi)) {
+			error = lastErrorString();
+			return INVALID;
+		}
+		if (blocking) {
+			WaitForSingleObject(pi.hProcess, INFINITE);
+		}
+		CloseHandle(pi.hThread);
+		return pi.hProcess;
+#else
+		(void)foreground;
+		(void)inheritHandles;
+		const pid_t pid = fork();
+		if (pid == 0) {
+			execl("/bin/sh", "sh", "-c", command.c_str(), (char*)nullptr);
+			_exit(127);
+		}
+		if (pid < 0) {
+			error = strerror(errno);
+			return INVALID;
+		}
+		if (blocking) {
+			waitpid(pid, nullptr, 0);
+		}
+		return pid;
+#endif
+	}
+
+	/** Stop a command started by run() (if it is still running) */
+	static void terminate(Handle handle) {
+		if (handle == INVALID) return;
+#ifdef G3D_WINDOWS
+		TerminateProcess(handle, 0);
+#else
+		kill(handle, SIGTERM);
+		waitpid(handle, nullptr, WNOHANG);
+#endif
+	}
+
+#ifdef G3D_WINDOWS
+	/** Message for the last Windows error (empty if there wasn't one) */
+	static String lastErrorString() {
+		DWORD error = GetLastError();
+		if (error) {
+			LPVOID lpMsgBuf;
+			DWORD bufLen = FormatMessage(FORMAT_MESSAGE_ALLOCATE_BUFFER | FORMAT_MESSAGE_FROM_SYSTEM | FORMAT_MESSAGE_IGNORE_INSERTS, NULL, error, MAKELANGID(LANG_NEUTRAL, SUBLANG_DEFAULT), (LPTSTR)&lpMsgBuf, 0, NULL);
+			if (bufLen) {
+				LPCSTR lpMsgStr = (LPCSTR)lpMsgBuf;
+				std::string result(lpMsgStr, lpMsgStr + bufLen);
+				LocalFree(lpMsgBuf);
+				return String(result);
+			}
+		}
+		return String();
+	}
+#endif
+};
@@ -1,6 +1,12 @@
 #include "SystemInfo.h"
+#ifndef G3D_WINDOWS
+#include <fstream>
+#include <string>
+#include <unistd.h>
+#endif
 
-SystemInfo SystemInfo::get(void) {
+#ifdef G3D_WINDOWS
+SystemInfo SystemInfo::get(bool hasGLContext) {
 	SystemInfo info;
 
 	info.hostName = getenv("COMPUTERNAME");		// Get the host (computer) name
@@ -45,9 +51,7 @@ SystemInfo SystemInfo::get(void) {
 	info.memCapacityMB = (long)(statex.ullTotalPhys / (1024 * 1024));
 
 	// Get GPU name string
-	String gpuVendor = String((char*)glGetString(GL_VENDOR)).append(" ");
-	String gpuRenderer = String((char*)glGetString(GL_RENDERER));
-	info.gpuName = gpuVendor.append(gpuRenderer);
+	info.gpuName = gpuName(hasGLContext);
 
 	// Get display information (monitor name)
 	// This seems to break on many systems/provide less than descriptive names!!!
@@ -73,6 +77,47 @@ SystemInfo SystemInfo::get(void) {
 
 	return info;
 }
+#else
+SystemInfo SystemInfo::get(bool hasGLContext) {
+	SystemInfo info;
+
+	char hostName[256] = { 0 };
+	gethostname(hostName, sizeof(hostName) - 1);
+	info.hostName = hostName;
+	const char* userName = getenv("USER");
+	info.userName = notNull(userName) ? userName : "";
+
+	// CPU name from the first processor's model name
+	std::ifstream cpuInfo("/proc/cpuinfo");
+	std::string line;
+	while (std::getline(cpuInfo, line)) {
+		if (line.compare(0, 10, "model name") == 0 && line.find(':') != std::string::npos) {
+			info.cpuName = trimWhitespace(String(line.substr(line.find(':') + 1)));
+			break;
+		}
+	}
+
+	info.coreCount = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	info.memCapacityMB = (long)((int64)sysconf(_SC_PHYS_PAGES) * (int64)sysconf(_SC_PAGE_SIZE) / (1024 * 1024));
+	info.gpuName = gpuName(hasGLContext);
+
+	// No display information outside of Windows (there may not be a display at all, e.g. on a headless server)
+	info.displayName = String("TODO");
+	info.displayXRes = 0;
+	info.displayYRes = 0;
+	info.displayXSize = 0;
+	info.displayYSize = 0;
+
+	return info;
+}
+#endif
+
+String SystemInfo::gpuName(bool hasGLContext) {
+	if (!hasGLContext) return "None (no GL context)";
+	String gpuVendor = String((char*)glGetString(GL_VENDOR)).append(" ");
+	String gpuRenderer = String((char*)glGetString(GL_RENDERER));
+	return gpuVendor.append(gpuRenderer);
+}
 
 Any SystemInfo::toAny(const bool forceAll) const {
 	Any a(Any::TABLE);
@@ -2,7 +2,7 @@
 #include <G3D/G3D.h>
 
 /** Information about the system being used
-The current implementation is heavily Windows-specific */
+The current implementation is heavily Windows-specific (elsewhere there is no display information) */
 class SystemInfo {
 public:
 	// Output/runtime read parameters
@@ -18,7 +18,8 @@ public:
 	int		displayXSize;		///< The horizontal size of the display in mm
 	int		displayYSize;		///< The vertical size of the display in mm
 
-	static SystemInfo get(void);						// Get the system info using (windows) calls
+	static SystemInfo get(bool hasGLContext = true);	// Get the system info using (windows) calls, the GPU is only queried with a GL context
+	static String gpuName(bool hasGLContext);			// Get the GPU vendor and renderer from GL
 
 	Any toAny(const bool forceAll = true) const;
 	void printToLog();
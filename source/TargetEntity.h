@@ -462,6 +462,9 @@ public:
 
 
 class NetworkedEntity : public TargetEntity {
+public:
+	static const uint16 NO_NETWORK_INDEX = 0xFFFF;					///< Network index of an entity that hasn't been assigned one
+
 protected:
 	float			m_speed = 0.0f;									///< Speed of the target (deg/s or m/s depending on space)
 	Point3			m_orbitCenter;									///< World space point at center of orbit
@@ -482,6 +485,7 @@ protected:
 	bool			m_axisLocks[3] = { false };					///< Axis locks (for world space motion)
 
 	bool			m_remote;
+	uint16			m_networkIndex = NO_NETWORK_INDEX;			///< Session-scoped index identifying this entity in entity updates
 
 	NetworkedEntity() {}
 	void init(AnyTableReader& propertyTable);
@@ -506,6 +510,9 @@ public:
 		m_speed = speed;
 	}
 
+	void setNetworkIndex(uint16 index) { m_networkIndex = index; }
+	uint16 networkIndex() const { return m_networkIndex; }
+
 	void fromNetwork(BinaryInput b);
 	BinaryOutput toNetwork();
 
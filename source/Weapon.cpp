@@ -242,6 +242,7 @@ void Weapon::simulateProjectiles(SimTime sdt, const Array<shared_ptr<TargetEntit
 			}
 			// Check for target hit
 			if (closest < hitThreshold) {
+				m_hitRay = ray;
 				m_hitCallback(closestTarget);
 				// Offset position slightly along normal to avoid Z-fighting the target
 				drawDecal(info.point + 0.01 * info.normal, m_camera->frame().lookVector(), true);
@@ -427,6 +428,7 @@ shared_ptr<TargetEntity> Weapon::fire(
 			target = targets[closestIndex];			// Assign the target pointer here (not null indicates the hit)
 			targetIdx = closestIndex;				// Write back the index of the target
 
+			m_hitRay = ray;
 			m_hitCallback(target);				// If we did, we are in hitscan mode, apply the damage and manage the target here
 			// Offset position slightly along shot direction to avoid Z-fighting the target
 			drawDecal(hitInfo.point + 0.01f * -ray.direction(), ray.direction(), true);
@@ -150,6 +150,7 @@ protected:
 
 	std::function<void(shared_ptr<TargetEntity>)> m_hitCallback;		///< This is set to FPSciApp::hitTarget
 	std::function<void(void)> m_missCallback;							///< This is set to FPSciApp::missEvent
+	Ray								m_hitRay;							///< Ray of the shot (or projectile step) that last hit a target
 
 	int										m_lastDecalID = 0;
 	shared_ptr<ArticulatedModel>			m_missDecalModel;					///< Model for the miss decal
@@ -228,6 +229,8 @@ public:
 	void playSound(bool shotFired, bool shootButtonUp);
 	
 	void setHitCallback(std::function<void(shared_ptr<TargetEntity>)> callback) { m_hitCallback = callback; }
+	/** The ray of the shot (or, for projectiles, the step of its flight) that last hit a target, e.g. for the hit callback to report */
+	const Ray& hitRay() const { return m_hitRay; }
 	void setMissCallback(std::function<void(void)> callback) { m_missCallback = callback; }
 	
 	void setConfig(WeaponConfig* config) { m_config = config; }
@@ -80,3 +80,72 @@ bool insertRowsIntoDB(sqlite3* db, const String tableName, const Array<Array<Str
 	return ret == SQLITE_OK;
 }
 
+
+bool execStatementInDB(sqlite3* db, const String& statement) {
+	char* errmsg;
+	int ret = sqlite3_exec(db, statement.c_str(), 0, 0, &errmsg);
+	if (ret != SQLITE_OK) {
+		logPrintf("Error in SQL statement (%s): %s\n", statement.c_str(), errmsg);
+		sqlite3_free(errmsg);
+	}
+	return ret == SQLITE_OK;
+}
+
+Array<Array<String>> tableColumnsInDB(sqlite3* db, const String& tableName) {
+	Array<Array<String>> columns;
+	const String query = "PRAGMA table_info(" + tableName + ");";
+	sqlite3_stmt* stmt = nullptr;
+	if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+		logPrintf("Error in SQL statement (%s): %s\n", query.c_str(), sqlite3_errmsg(db));
+		return columns;
+	}
+	// Rows are (cid, name, type, notnull, dflt_value, pk)
+	while (sqlite3_step(stmt) == SQLITE_ROW) {
+		const char* name = (const char*)sqlite3_column_text(stmt, 1);
+		const char* type = (const char*)sqlite3_column_text(stmt, 2);
+		columns.append({ String(notNull(name) ? name : ""), String(notNull(type) ? type : "") });
+	}
+	sqlite3_finalize(stmt);
+	return columns;
+}
+
+bool beginTransactionInDB(sqlite3* db) {
+	return execStatementInDB(db, "BEGIN TRANSACTION;");
+}
+
+bool commitTransactionInDB(sqlite3* db) {
+	return execStatementInDB(db, "COMMIT TRANSACTION;");
+}
+
+SqlInsertStatement::SqlInsertStatement(sqlite3* db, const String& tableName, int columnCount, const String& colNames) :
+	m_db(db), m_tableName(tableName), m_columnCount(columnCount)
+{
+	// Build the query once with a placeholder per column, i.e. "INSERT INTO {tableName}{colNames} VALUES(?,?,...);"
+	String insertC = "INSERT INTO " + tableName + colNames + " VALUES(";
+	for (int i = 0; i < columnCount; i++) {
+		insertC += "?";
+		if (i < columnCount - 1) insertC += ",";
+	}
+	insertC += ");";
+	int ret = sqlite3_prepare_v2(m_db, insertC.c_str(), -1, &m_stmt, nullptr);
+	if (ret != SQLITE_OK) {
+		logPrintf("Error preparing INSERT INTO statement (%s): %s\n", insertC.c_str(), sqlite3_errmsg(m_db));
+		m_stmt = nullptr;
+	}
+}
+
+SqlInsertStatement::~SqlInsertStatement() {
+	// Statements must be finalized before the database can be closed
+	sqlite3_finalize(m_stmt);
+}
+
+bool SqlInsertStatement::insertRow() {
+	if (!valid()) return false;
+	int ret = sqlite3_step(m_stmt);
+	if (ret != SQLITE_DONE) {
+		logPrintf("Error inserting row into %s: %s\n", m_tableName.c_str(), sqlite3_errmsg(m_db));
+	}
+	sqlite3_reset(m_stmt);
+	sqlite3_clear_bindings(m_stmt);
+	return ret == SQLITE_DONE;
+}
@@ -7,3 +7,54 @@
 bool createTableInDB(sqlite3* db, const String tableName, const Array<Array<String>>& columns);
 bool insertRowIntoDB(sqlite3* db, const String tableName, const Array<String>& values, const String colNames = "");
 bool insertRowsIntoDB(sqlite3* db, const String tableName, const Array<Array<String>>& valueVector, const String colNames = "");
+
+/** Run a statement that returns no rows (e.g. transaction control or pragmas) */
+bool execStatementInDB(sqlite3* db, const String& statement);
+/** Names and declared types of a table's columns (as {name, type} for each column), empty if the table doesn't exist */
+Array<Array<String>> tableColumnsInDB(sqlite3* db, const String& tableName);
+/** Begin an explicit transaction (all inserts until commitTransactionInDB() are written together) */
+bool beginTransactionInDB(sqlite3* db);
+/** Commit the transaction started by beginTransactionInDB() */
+bool commitTransactionInDB(sqlite3* db);
+
+/** A prepared "INSERT INTO {tableName}{colNames} VALUES(?, ...)" statement that is parsed once and reused for every row
+
+	Values are bound by (0-based) column index using typed binds, then insertRow() steps and resets the statement.
+	Unlike insertRowsIntoDB() text values should NOT be quoted. */
+class SqlInsertStatement : public ReferenceCountedObject {
+protected:
+	sqlite3*		m_db = nullptr;
+	sqlite3_stmt*	m_stmt = nullptr;
+	String			m_tableName;
+	int				m_columnCount = 0;
+
+	SqlInsertStatement(sqlite3* db, const String& tableName, int columnCount, const String& colNames);
+
+	// Don't allow copies (the statement handle is owned by this object)
+	SqlInsertStatement(const SqlInsertStatement&);
+	void operator=(const SqlInsertStatement&);
+
+public:
+	virtual ~SqlInsertStatement();
+
+	static shared_ptr<SqlInsertStatement> create(sqlite3* db, const String& tableName, int columnCount, const String& colNames = "") {
+		return createShared<SqlInsertStatement>(db, tableName, columnCount, colNames);
+	}
+
+	bool valid() const { return notNull(m_stmt); }
+	int columnCount() const { return m_columnCount; }
+	const String& tableName() const { return m_tableName; }
+
+	void bind(int col, double value)		{ sqlite3_bind_double(m_stmt, col + 1, value); }
+	void bind(int col, float value)			{ sqlite3_bind_double(m_stmt, col + 1, (double)value); }
+	void bind(int col, int value)			{ sqlite3_bind_int(m_stmt, col + 1, value); }
+	void bind(int col, uint32 value)		{ sqlite3_bind_int64(m_stmt, col + 1, (sqlite3_int64)value); }
+	void bind(int col, int64 value)			{ sqlite3_bind_int64(m_stmt, col + 1, (sqlite3_int64)value); }
+	void bind(int col, bool value)			{ sqlite3_bind_int(m_stmt, col + 1, value ? 1 : 0); }
+	void bind(int col, const String& value) { sqlite3_bind_text(m_stmt, col + 1, value.c_str(), (int)value.size(), SQLITE_TRANSIENT); }
+	void bind(int col, const char* value)	{ sqlite3_bind_text(m_stmt, col + 1, value, -1, SQLITE_TRANSIENT); }
+	void bindNull(int col)					{ sqlite3_bind_null(m_stmt, col + 1); }
+
+	/** Write the currently bound values as a new row, then reset the statement for the next row */
+	bool insertRow();
+};
@@ -909,4 +909,1466 @@ TEST_F(FPSciTests, TestFreshStart) {
 	// Delete the sessions csv
 	failDelete = remove("test/emptystatus.sessions.csv");
 	EXPECT_FALSE(failDelete) << "User Status sessions csv not generated!";
-}
\ No newline at end of file
+}
+
+/** Contents of a (binary) file, empty if it can't be read */
+static std::string readFileBytes(const String& filename) {
+	std::ifstream file(filename.c_str(), std::ios_base::in | std::ios_base::binary);
+	return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+TEST(LoggerTests, BinarySinkKeepsColumnsAligned)
+{
+	const String prefix = "test/binarysink";
+	const String filename = prefix + "_Rows.fpsb";
+	const String otherFilename = prefix + "_Rows_2.fpsb";
+	remove(filename.c_str());
+	remove(otherFilename.c_str());
+
+	const Columns columns = { { "time", "integer" }, { "name", "text" } };
+	Columns otherColumns = columns;
+	otherColumns.append({ "speed", "real" });
+	for (const Columns& cols : { columns, otherColumns, columns }) {
+		const shared_ptr<LogSink> sink = BinaryLogSink::create(prefix);
+		sink->createTable("Rows", cols);
+		const shared_ptr<LogTableWriter> writer = sink->tableWriter("Rows", cols.size());
+		// Binding a column twice keeps the last value, an unbound column is written as null
+		writer->bind(0, (int64)1);
+		writer->bind(0, (int64)2);
+		writer->bind(1, "a");
+		writer->insertRow();
+		writer->bind(1, "b");
+		writer->insertRow();
+		sink->endBatch();
+	}
+
+	// The file with different columns was written separately, the same columns were appended
+	const std::string data = readFileBytes(filename);
+	EXPECT_FALSE(readFileBytes(otherFilename).empty());
+	BinaryInput in((const uint8*)data.data(), (int64)data.size(), G3D_LITTLE_ENDIAN, false, true);
+	EXPECT_EQ("FPSB", in.readFixedLengthString(4));
+	in.readUInt32();
+	ASSERT_EQ(2u, in.readUInt32());
+	for (int i = 0; i < 2; i++) {
+		EXPECT_EQ(columns[i][0], in.readString32());
+		in.readUInt8();
+	}
+	for (int block = 0; block < 2; block++) {
+		ASSERT_EQ(2u, in.readUInt32());
+		EXPECT_EQ(2, in.readInt64());
+		EXPECT_EQ(0, in.readInt64());
+		EXPECT_EQ("a", in.readString32());
+		EXPECT_EQ("b", in.readString32());
+	}
+	EXPECT_FALSE(in.hasMore());
+
+	remove(filename.c_str());
+	remove(otherFilename.c_str());
+}
+
+/** Open a new (empty) SQLite database */
+static sqlite3* openNewDB(const String& filename) {
+	remove(filename.c_str());
+	sqlite3* db = nullptr;
+	if (sqlite3_open(filename.c_str(), &db) != SQLITE_OK) {
+		sqlite3_close(db);
+		return nullptr;
+	}
+	return db;
+}
+
+/** Result of a single integer query (e.g. a row count), -1 if the query fails */
+static int64 queryIntInDB(sqlite3* db, const String& query) {
+	sqlite3_stmt* stmt = nullptr;
+	int64 result = -1;
+	if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) == SQLITE_OK && sqlite3_step(stmt) == SQLITE_ROW) {
+		result = sqlite3_column_int64(stmt, 0);
+	}
+	sqlite3_finalize(stmt);
+	return result;
+}
+
+// Insert throughput of the per-frame tables, built as SQL strings for sqlite3_exec() (as the logger used to) vs. bound to
+// prepared statements in a transaction per flush. Run with --gtest_also_run_disabled_tests
+TEST(LoggerTests, DISABLED_InsertRate)
+{
+	const int rowCount = 200000;
+	const int flushRows = 500;
+	const int64 startTime = FPSciLogger::getTime();
+
+	struct InsertCase {
+		String									table;
+		Columns									columns;
+		std::function<RowEntry(int)>			values;		///< Row i as SQL values
+		std::function<void(SqlInsertStatement&, int)>	bind;		///< Bind row i to a prepared insert
+	};
+	const InsertCase cases[] = {
+		{
+			"Player_Action",
+			{ { "time", "integer" }, { "position_az", "real" }, { "position_el", "real" }, { "position_x", "real" }, { "position_y", "real" },
+				{ "position_z", "real" }, { "state", "text" }, { "event", "text" }, { "target_id", "text" } },
+			[startTime](int i) {
+				return RowEntry({ "'" + FPSciLogger::formatTime(startTime + (int64)i * 1000000) + "'", String(std::to_string(0.01f * i)), String(std::to_string(0.5f)),
+					String(std::to_string(1.0f)), String(std::to_string(2.0f)), String(std::to_string(0.001f * i)), "'trialTask'", "'aim'", "'target0'" });
+			},
+			[startTime](SqlInsertStatement& stmt, int i) {
+				stmt.bind(0, startTime + (int64)i * 1000000);
+				stmt.bind(1, 0.01f * i);
+				stmt.bind(2, 0.5f);
+				stmt.bind(3, 1.0f);
+				stmt.bind(4, 2.0f);
+				stmt.bind(5, 0.001f * i);
+				stmt.bind(6, "trialTask");
+				stmt.bind(7, "aim");
+				stmt.bind(8, "target0");
+			}
+		},
+		{
+			"Target_Trajectory",
+			{ { "time", "integer" }, { "target_id", "text" }, { "state", "text" }, { "position_x", "real" }, { "position_y", "real" }, { "position_z", "real" } },
+			[startTime](int i) {
+				return RowEntry({ "'" + FPSciLogger::formatTime(startTime + (int64)i * 1000000) + "'", "'target0'", "'trialTask'",
+					String(std::to_string(0.01f * i)), String(std::to_string(1.0f)), String(std::to_string(-5.0f)) });
+			},
+			[startTime](SqlInsertStatement& stmt, int i) {
+				stmt.bind(0, startTime + (int64)i * 1000000);
+				stmt.bind(1, "target0");
+				stmt.bind(2, "trialTask");
+				stmt.bind(3, 0.01f * i);
+				stmt.bind(4, 1.0f);
+				stmt.bind(5, -5.0f);
+			}
+		}
+	};
+
+	const String filename = "test/insertrate.db";
+	for (const InsertCase& c : cases) {
+		double rowsPerSec[2];
+		for (int prepared = 0; prepared < 2; prepared++) {
+			sqlite3* db = openNewDB(filename);
+			ASSERT_NE(nullptr, db);
+			createTableInDB(db, c.table, c.columns);
+			shared_ptr<SqlInsertStatement> stmt = SqlInsertStatement::create(db, c.table, c.columns.size());
+
+			const RealTime start = System::time();
+			for (int first = 0; first < rowCount; first += flushRows) {
+				if (prepared) {
+					beginTransactionInDB(db);
+					for (int i = first; i < first + flushRows; i++) {
+						c.bind(*stmt, i);
+						stmt->insertRow();
+					}
+					commitTransactionInDB(db);
+				}
+				else {
+					Array<RowEntry> rows;
+					for (int i = first; i < first + flushRows; i++) rows.append(c.values(i));
+					insertRowsIntoDB(db, c.table, rows);
+				}
+			}
+			rowsPerSec[prepared] = rowCount / (System::time() - start);
+
+			EXPECT_EQ(rowCount, queryIntInDB(db, "SELECT COUNT(*) FROM " + c.table + ";"));
+			stmt.reset();
+			sqlite3_close(db);
+		}
+		printf("%s (%d rows, %d per flush): %.0f rows/s with sqlite3_exec, %.0f rows/s with prepared statements (%.2fx)\n",
+			c.table.c_str(), rowCount, flushRows, rowsPerSec[0], rowsPerSec[1], rowsPerSec[1] / rowsPerSec[0]);
+	}
+	remove(filename.c_str());
+}
+
+/** Remove a results file (and any SQLite journal files left with it) */
+static void removeResultsFile(const String& filename) {
+	for (const char* suffix : { "", "-journal", "-wal", "-shm" }) {
+		remove((filename + suffix).c_str());
+	}
+}
+
+/** Logger writing to a new results file for the given session config */
+static shared_ptr<FPSciLogger> createTestLogger(const String& filename, const shared_ptr<SessionConfig>& config) {
+	removeResultsFile(filename);
+	return FPSciLogger::create(filename, "testUser", FPSciApp::startupConfig.experimentList[0].experimentConfigFilename, config);
+}
+
+TEST(LoggerTests, MpscRingKeepsProducerOrder)
+{
+	// A small ring so the producers keep finding it full
+	const int producerCount = 4;
+	const int pushCount = 20000;
+	MpscRingBuffer<int> ring(64);
+	EXPECT_EQ(64, (int)ring.capacity());
+	std::vector<std::thread> producers;
+	for (int p = 0; p < producerCount; p++) {
+		producers.push_back(std::thread([&ring, p, pushCount] {
+			for (int i = 0; i < pushCount; i++) {
+				while (!ring.tryPush(p * pushCount + i)) std::this_thread::yield();
+			}
+		}));
+	}
+
+	// Every item comes out once, with each producer's items in the order they were pushed
+	int expected[producerCount] = {};
+	int popped = 0;
+	bool ordered = true;
+	int value;
+	while (popped < producerCount * pushCount && ordered) {
+		if (!ring.tryPop(value)) {
+			std::this_thread::yield();
+			continue;
+		}
+		const int p = value / pushCount;
+		ordered = p >= 0 && p < producerCount && value % pushCount == expected[p];
+		if (ordered) expected[p]++;
+		popped++;
+	}
+	for (std::thread& producer : producers) producer.join();
+	EXPECT_TRUE(ordered);
+	for (int p = 0; p < producerCount; p++) {
+		EXPECT_EQ(pushCount, expected[p]);
+	}
+	Array<int> remaining;
+	EXPECT_EQ(0u, ring.drainTo(remaining));
+}
+
+// Time taken by each log call while the logging thread is writing (flushes are requested every ms).
+// Run with --gtest_also_run_disabled_tests
+TEST_F(FPSciTests, DISABLED_LoggerProducerLatency)
+{
+	const int recordCount = 200000;
+	const String filename = "test/producerlatency.db";
+	const shared_ptr<SessionConfig> config = SessionConfig::create();
+	config->id = "latency";
+	shared_ptr<FPSciLogger> logger = createTestLogger(filename, config);
+
+	std::atomic<bool> producing{ true };
+	std::thread flusher([&logger, &producing] {
+		while (producing) {
+			logger->flush(false);
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	});
+
+	typedef std::chrono::high_resolution_clock Clock;
+	Array<double> latencyUs;
+	latencyUs.resize(recordCount);
+	for (int i = 0; i < recordCount; i++) {
+		const PlayerAction action(FPSciLogger::getTime(), Point2(0.01f * i, 0.5f), Point3(1.0f, 2.0f, 0.001f * i), PresentationState::trialTask, PlayerActionType::Aim, "target0");
+		const Clock::time_point start = Clock::now();
+		logger->logPlayerAction(action);
+		latencyUs[i] = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+	}
+	producing = false;
+	flusher.join();
+	const FPSciLogger::Stats stats = logger->stats();
+
+	std::sort(latencyUs.begin(), latencyUs.end());
+	printf("Logged %d player actions while the logger was writing: p50 %.3f us, p99 %.3f us, p99.9 %.3f us, max %.3f us (%llu pushes waited on a full queue)\n",
+		recordCount, latencyUs[recordCount / 2], latencyUs[recordCount * 99 / 100], latencyUs[recordCount * 999 / 1000], latencyUs.last(),
+		(unsigned long long)stats.blockedPushes);
+
+	logger.reset();
+	removeResultsFile(filename);
+}
+
+// Blocking flush latency for each journal mode/synchronous level, run with --gtest_also_run_disabled_tests
+TEST_F(FPSciTests, DISABLED_LoggerFlushLatencyBySqliteSettings)
+{
+	const int flushCount = 50;
+	const int recordsPerFlush = 1000;
+	const String filename = "test/flushlatency.db";
+	const Array<String> journalModes = { "delete", "truncate", "persist", "memory", "wal", "off" };
+	const Array<String> syncLevels = { "off", "normal", "full", "extra" };
+
+	printf("Flush latency (ms) for %d records per flush, p50 / max over %d flushes:\n%-10s", recordsPerFlush, flushCount, "");
+	for (const String& sync : syncLevels) printf("%20s", ("synchronous=" + sync).c_str());
+	printf("\n");
+	for (const String& journalMode : journalModes) {
+		printf("%-10s", journalMode.c_str());
+		for (const String& sync : syncLevels) {
+			const shared_ptr<SessionConfig> config = SessionConfig::create();
+			config->id = "flushLatency";
+			config->logger.journalMode = journalMode;
+			config->logger.synchronous = sync;
+			shared_ptr<FPSciLogger> logger = createTestLogger(filename, config);
+
+			Array<double> flushMs;
+			for (int f = 0; f < flushCount; f++) {
+				for (int i = 0; i < recordsPerFlush; i++) {
+					logger->logPlayerAction(PlayerAction(FPSciLogger::getTime(), Point2(0.01f * i, 0.5f), Point3(1.0f, 2.0f, 0.001f * i), PresentationState::trialTask, PlayerActionType::Aim, "target0"));
+				}
+				const RealTime start = System::time();
+				EXPECT_TRUE(logger->flush(true, 30.0));
+				flushMs.append(1000.0 * (System::time() - start));
+			}
+			logger.reset();
+			removeResultsFile(filename);
+
+			std::sort(flushMs.begin(), flushMs.end());
+			printf("%20s", format("%.2f / %.2f", flushMs[flushCount / 2], flushMs.last()).c_str());
+		}
+		printf("\n");
+	}
+}
+
+TEST_F(FPSciTests, LoggerFormatsSetAndUnsetGUIDs)
+{
+	const String filename = "test/loggerguids.db";
+	const shared_ptr<SessionConfig> config = SessionConfig::create();
+	config->id = "guids";
+	shared_ptr<FPSciLogger> logger = createTestLogger(filename, config);
+	const int64 time = FPSciLogger::getTime();
+	logger->logFrameInfo(FrameInfo(time, 0.01f));								// No client id
+	logger->logFrameInfo(FrameInfo(time, 0.01f, 0, 0, 0, GUniqueID()));			// A zero id that was set
+	logger->logFrameInfo(FrameInfo(time, 0.01f, 0, 0, 0, GUniqueID::create()));
+	logger.reset();
+
+	// Only the unset id is logged as an empty string, set ids (even zero) are logged as their string16 representation
+	sqlite3* db = nullptr;
+	ASSERT_EQ(SQLITE_OK, sqlite3_open(filename.c_str(), &db));
+	EXPECT_EQ(1, queryIntInDB(db, "SELECT COUNT(*) FROM Frame_Info WHERE client_guid = '';"));
+	EXPECT_EQ(1, queryIntInDB(db, "SELECT COUNT(*) FROM Frame_Info WHERE client_guid = '" + GUniqueID().toString16() + "';"));
+	EXPECT_EQ(3, queryIntInDB(db, "SELECT COUNT(*) FROM Frame_Info;"));
+	sqlite3_close(db);
+	removeResultsFile(filename);
+}
+
+TEST_F(FPSciTests, LoggerMergesShardsAtClose)
+{
+	const int recordCount = 5000;
+	const String filename = "test/loggershards.db";
+	const String shardFilename = filename + ".Player_Action.shard";
+	const shared_ptr<SessionConfig> config = SessionConfig::create();
+	config->id = "shards";
+	config->logger.shardedTables = { "Player_Action" };
+	shared_ptr<FPSciLogger> logger = createTestLogger(filename, config);
+
+	// Some rows are written by earlier flushes and the rest at close
+	const int64 startTime = FPSciLogger::getTime();
+	for (int i = 0; i < recordCount; i++) {
+		logger->logPlayerAction(PlayerAction(startTime + i, Point2(0.01f * i, 0.5f), Point3::zero(), PresentationState::trialTask, PlayerActionType::Aim, "target0"));
+		logger->logFrameInfo(FrameInfo());
+		if (i % 1000 == 999) {
+			EXPECT_TRUE(logger->flush(true));
+		}
+	}
+	EXPECT_TRUE(std::ifstream(shardFilename.c_str()).good());
+	logger.reset();
+
+	// Every row is merged into the results file once, and the shard is removed
+	EXPECT_FALSE(std::ifstream(shardFilename.c_str()).good());
+	sqlite3* db = nullptr;
+	ASSERT_EQ(SQLITE_OK, sqlite3_open(filename.c_str(), &db));
+	EXPECT_EQ(recordCount, queryIntInDB(db, "SELECT COUNT(*) FROM Player_Action;"));
+	EXPECT_EQ(recordCount, queryIntInDB(db, "SELECT COUNT(DISTINCT time) FROM Player_Action;"));
+	EXPECT_EQ(startTime, queryIntInDB(db, "SELECT MIN(time) FROM Player_Action;"));
+	EXPECT_EQ(startTime + recordCount - 1, queryIntInDB(db, "SELECT MAX(time) FROM Player_Action;"));
+	EXPECT_EQ(recordCount, queryIntInDB(db, "SELECT COUNT(*) FROM Frame_Info;"));
+	sqlite3_close(db);
+	removeResultsFile(filename);
+}
+
+// Client_States ingest rate (until committed) with a producer thread per client, written by the logging thread or its own
+// shard thread. Run with --gtest_also_run_disabled_tests
+TEST_F(FPSciTests, DISABLED_LoggerIngestRateByClientCount)
+{
+	const int recordsPerClient = 20000;
+	const String filename = "test/ingestrate.db";
+	const Array<int> clientCounts = { 1, 2, 4, 8, 16 };
+
+	for (int sharded = 0; sharded < 2; sharded++) {
+		for (const int clientCount : clientCounts) {
+			const shared_ptr<SessionConfig> config = SessionConfig::create();
+			config->id = "ingestRate";
+			if (sharded) config->logger.shardedTables = { "Client_States" };
+			shared_ptr<FPSciLogger> logger = createTestLogger(filename, config);
+
+			const RealTime start = System::time();
+			std::vector<std::thread> clients;
+			for (int c = 0; c < clientCount; c++) {
+				clients.push_back(std::thread([&logger, c, recordsPerClient] {
+					const GUniqueID id = GUniqueID::create();
+					for (int i = 0; i < recordsPerClient; i++) {
+						// Every other record type still goes through the logging thread
+						logger->logNetworkedClient(NetworkedClient(FPSciLogger::getTime(), Point2(0.01f * i, 0.5f), Point3::zero(), id, i, i));
+						logger->logFrameInfo(FrameInfo());
+					}
+				}));
+			}
+			for (std::thread& client : clients) client.join();
+			EXPECT_TRUE(logger->flush(true, 60.0));
+			const RealTime elapsed = System::time() - start;
+
+			const int64 rows = 2 * (int64)clientCount * recordsPerClient;
+			printf("%2d clients%s: %lld rows in %.3f s, %.0f rows/s\n", clientCount, sharded ? " (Client_States sharded)" : "", (long long)rows, elapsed, rows / elapsed);
+			logger.reset();
+			removeResultsFile(filename);
+		}
+	}
+}
+
+/** Logger that lets a test stall its writers (they can't drain the queues while the drain lock is held) */
+class StallableLogger : public FPSciLogger {
+public:
+	using FPSciLogger::FPSciLogger;
+	std::mutex& drainMutex() { return m_drainMutex; }
+};
+
+TEST_F(FPSciTests, LoggerFlushWaitsForQueuedRecords)
+{
+	const int recordCount = 3000;
+	const String filename = "test/loggerflush.db";
+	const shared_ptr<SessionConfig> config = SessionConfig::create();
+	config->id = "flush";
+	removeResultsFile(filename);
+	shared_ptr<StallableLogger> logger = std::make_shared<StallableLogger>(filename, "testUser", FPSciApp::startupConfig.experimentList[0].experimentConfigFilename, config, "None");
+	sqlite3* db = nullptr;
+	ASSERT_EQ(SQLITE_OK, sqlite3_open(filename.c_str(), &db));
+
+	const int64 startTime = FPSciLogger::getTime();
+	{
+		// Nothing can be committed while the writers are stalled, so the flush times out
+		std::lock_guard<std::mutex> stall(logger->drainMutex());
+		for (int i = 0; i < recordCount; i++) {
+			logger->logPlayerAction(PlayerAction(startTime + i, Point2::zero(), Point3::zero(), PresentationState::trialTask, PlayerActionType::Aim, "target0"));
+		}
+		const RealTime start = System::time();
+		EXPECT_FALSE(logger->flush(true, 0.1));
+		EXPECT_GE(System::time() - start, 0.09);
+		EXPECT_EQ(0, queryIntInDB(db, "SELECT COUNT(*) FROM Player_Action;"));
+	}
+
+	// Once the flush returns everything queued before it is committed (including the records the timed out flush waited on)
+	EXPECT_TRUE(logger->flush(true));
+	EXPECT_EQ(recordCount, queryIntInDB(db, "SELECT COUNT(*) FROM Player_Action;"));
+	for (int i = recordCount; i < 2 * recordCount; i++) {
+		logger->logPlayerAction(PlayerAction(startTime + i, Point2::zero(), Point3::zero(), PresentationState::trialTask, PlayerActionType::Aim, "target0"));
+	}
+	EXPECT_TRUE(logger->flush(true));
+	EXPECT_EQ(2 * recordCount, queryIntInDB(db, "SELECT COUNT(*) FROM Player_Action;"));
+	EXPECT_EQ(startTime + 2 * recordCount - 1, queryIntInDB(db, "SELECT MAX(time) FROM Player_Action;"));
+
+	// A flush with nothing queued returns straight away
+	EXPECT_TRUE(logger->flush(true, 0.0));
+
+	sqlite3_close(db);
+	logger.reset();
+	removeResultsFile(filename);
+}
+
+TEST_F(FPSciTests, LoggerFlushCoversRecordsFromEveryProducer)
+{
+	const int producerCount = 4;
+	const int flushCount = 50;
+	const int recordsPerFlush = 20;
+	const String filename = "test/loggerflushproducers.db";
+	const shared_ptr<SessionConfig> config = SessionConfig::create();
+	config->id = "flushproducers";
+	removeResultsFile(filename);
+	shared_ptr<FPSciLogger> logger = createTestLogger(filename, config);
+
+	// Each producer flushes right after queuing, so its records race the others' for ring slots. Once the flush returns,
+	// every record that producer queued must be in the database (even if it landed behind a slot that wasn't published yet).
+	const int64 startTime = FPSciLogger::getTime();
+	std::atomic<int> missing{ 0 };
+	std::atomic<int> timedOut{ 0 };
+	std::vector<std::thread> producers;
+	for (int p = 0; p < producerCount; p++) {
+		producers.push_back(std::thread([&, p] {
+			sqlite3* db = nullptr;
+			sqlite3_open(filename.c_str(), &db);
+			for (int f = 0; f < flushCount; f++) {
+				const int64 firstTime = startTime + ((int64)p * flushCount + f) * recordsPerFlush;
+				for (int i = 0; i < recordsPerFlush; i++) {
+					logger->logPlayerAction(PlayerAction(firstTime + i, Point2::zero(), Point3::zero(), PresentationState::trialTask, PlayerActionType::Aim, "target0"));
+					logger->logFrameInfo(FrameInfo(firstTime + i, 0.01f));
+				}
+				if (!logger->flush(true)) timedOut++;
+				const int64 found = queryIntInDB(db, format("SELECT COUNT(*) FROM Player_Action WHERE time >= %lld AND time < %lld;", firstTime, firstTime + recordsPerFlush));
+				if (found != recordsPerFlush) missing++;
+			}
+			sqlite3_close(db);
+		}));
+	}
+	for (std::thread& producer : producers) producer.join();
+	EXPECT_EQ(0, timedOut.load());
+	EXPECT_EQ(0, missing.load());
+
+	logger.reset();
+	removeResultsFile(filename);
+}
+
+TEST_F(FPSciTests, LoggerOverflowPoliciesApplyToPerFrameRecords)
+{
+	// Three times the per-frame ring size, logged faster than the writer drains (it isn't woken until the ring fills)
+	const int recordCount = 3 * (1 << 14);
+	const String filename = "test/loggeroverflow.db";
+	const String spillFilename = filename + ".spill";
+	struct PerFrameTable {
+		const char*										name;
+		std::function<void(FPSciLogger&, int64)>		log;
+	};
+	const Array<PerFrameTable> tables = {
+		{ "Interpolation_Stats", [](FPSciLogger& logger, int64 time) {
+			InterpolationStats stats;
+			stats.time = time;
+			stats.interpolated = 3;
+			logger.logInterpolationStats(stats);
+		} },
+		{ "Network_Impairments", [](FPSciLogger& logger, int64 time) {
+			ImpairmentRecord record;
+			record.time = time;
+			enet_address_set_host(&record.destination, "127.0.0.1");
+			record.destination.port = 1234;
+			record.delayMs = 20.0f;
+			logger.logImpairment(record);
+		} },
+	};
+
+	for (const String policy : { "dropoldest", "spill" }) {
+		for (const PerFrameTable& table : tables) {
+			SCOPED_TRACE((policy + " " + table.name).c_str());
+			const shared_ptr<SessionConfig> config = SessionConfig::create();
+			config->id = "overflow";
+			config->logger.overflowPolicy = policy;
+			config->logger.maxQueueMB = 1;
+			shared_ptr<FPSciLogger> logger = createTestLogger(filename, config);
+			const int64 startTime = FPSciLogger::getTime();
+			for (int i = 0; i < recordCount; i++) {
+				table.log(*logger, startTime + i);
+			}
+			// Records that waited in the spill file are merged into the results file at close
+			logger.reset();
+			EXPECT_FALSE(std::ifstream(spillFilename.c_str()).good());
+
+			sqlite3* db = nullptr;
+			ASSERT_EQ(SQLITE_OK, sqlite3_open(filename.c_str(), &db));
+			const int64 rows = queryIntInDB(db, format("SELECT COUNT(*) FROM %s;", table.name));
+			const int64 dropped = queryIntInDB(db, "SELECT dropped_records FROM Logger_Overflow;");
+			const int64 spilled = queryIntInDB(db, "SELECT spilled_records FROM Logger_Overflow;");
+			EXPECT_EQ(rows, queryIntInDB(db, format("SELECT COUNT(DISTINCT time) FROM %s;", table.name)));
+			if (policy == "dropoldest") {
+				// Every record is either written or counted as dropped
+				EXPECT_GT(dropped, 0);
+				EXPECT_EQ(recordCount, rows + dropped);
+				EXPECT_EQ(0, spilled);
+			}
+			else {
+				// Nothing is lost
+				EXPECT_GT(spilled, 0);
+				EXPECT_EQ(recordCount, rows);
+				EXPECT_EQ(0, dropped);
+			}
+			sqlite3_close(db);
+			removeResultsFile(filename);
+		}
+	}
+}
+
+/** Serialized (as sent over the network) BATCH_ENTITY_UPDATE packet with entityCount updates */
+static Array<uint8> serializedEntityUpdate(int entityCount, uint32 frameNumber = 42) {
+	Array<BatchEntityUpdatePacket::EntityUpdate> updates;
+	for (int i = 0; i < entityCount; i++) {
+		updates.append(BatchEntityUpdatePacket::EntityUpdate(CFrame::fromXYZYPRDegrees((float)i, 1.0f, 2.0f, 90.0f), (uint16)i));
+	}
+	shared_ptr<BatchEntityUpdatePacket> packet = GenericPacket::createForBroadcast<BatchEntityUpdatePacket>();
+	packet->populate(frameNumber, updates, BatchEntityUpdatePacket::NetworkUpdateType::REPLACE_FRAME);
+	BinaryOutput out("<memory>", G3D_BIG_ENDIAN);
+	packet->serializeTo(out);
+	Array<uint8> data;
+	data.resize((int)out.length());
+	memcpy(data.getCArray(), out.getCArray(), (size_t)out.length());
+	return data;
+}
+
+TEST(NetworkTests, QuantizedEntityTransforms)
+{
+	Random rng(1234, false);
+	for (int i = 0; i < 1000; i++) {
+		const Point3 position(rng.uniform(-1000.0f, 1000.0f), rng.uniform(-10.0f, 10.0f), rng.uniform(-1000.0f, 1000.0f));
+		const Point3 unpacked = BatchEntityUpdatePacket::unpackPosition(BatchEntityUpdatePacket::packPosition(position));
+		EXPECT_LE((unpacked - position).abs().max(), 0.5f / BatchEntityUpdatePacket::POSITION_STEPS_PER_METER + 1e-4f);
+
+		const Matrix3 rotation = Matrix3::fromEulerAnglesYXZ(rng.uniform(-pif(), pif()), rng.uniform(-halfPi(), halfPi()), rng.uniform(-pif(), pif()));
+		const Matrix3 unpackedRotation = BatchEntityUpdatePacket::unpackRotation(BatchEntityUpdatePacket::packRotation(rotation));
+		for (int axis = 0; axis < 3; axis++) {
+			// Within a quarter of a degree
+			EXPECT_GT(rotation.column(axis).dot(unpackedRotation.column(axis)), cos(toRadians(0.25f)));
+		}
+	}
+	// Positions out of range are clamped rather than wrapped
+	EXPECT_GT(BatchEntityUpdatePacket::unpackPosition(BatchEntityUpdatePacket::packPosition(Point3(1e6f, 0.0f, 0.0f))).x, 2000.0f);
+}
+
+TEST(NetworkTests, DispatchReusesPooledPackets)
+{
+	const Array<uint8> data = serializedEntityUpdate(4);
+	ENetAddress srcAddr;
+	srcAddr.host = ENET_HOST_ANY;
+	srcAddr.port = 1234;
+
+	PacketDispatcher dispatcher;
+	int handled = 0;
+	dispatcher.on(BATCH_ENTITY_UPDATE, PacketDispatcher::UNRELIABLE, [&handled](GenericPacket* packet) {
+		BatchEntityUpdatePacket* update = static_cast<BatchEntityUpdatePacket*>(packet);
+		EXPECT_EQ(42, update->m_frameNumber);
+		EXPECT_EQ(4, update->m_updates.size());
+		EXPECT_FLOAT_EQ(3.0f, update->m_updates[3].frame.translation.x);
+		handled++;
+	});
+
+	shared_ptr<GenericPacket> packet = NetworkUtils::parsePacket(srcAddr, data.getCArray(), (size_t)data.size());
+	ASSERT_NE(nullptr, packet);
+	packet->m_reliable = false;
+	EXPECT_TRUE(dispatcher.dispatch(packet));
+	GenericPacket* firstPacket = packet.get();
+
+	// A packet that is still referenced can't be reused
+	shared_ptr<GenericPacket> secondPacket = NetworkUtils::parsePacket(srcAddr, data.getCArray(), (size_t)data.size());
+	EXPECT_NE(firstPacket, secondPacket.get());
+
+	// Once released it goes back to the pool and a later packet of the same type is parsed into it (the pool hands out
+	// released packets oldest first, and may hold some from earlier tests)
+	packet.reset();
+	for (int i = 0; i <= PacketPool::MAX_POOLED && packet.get() != firstPacket; i++) {
+		packet = NetworkUtils::parsePacket(srcAddr, data.getCArray(), (size_t)data.size());
+	}
+	EXPECT_EQ(firstPacket, packet.get());
+	packet->m_reliable = false;
+	EXPECT_TRUE(dispatcher.dispatch(packet));
+	EXPECT_EQ(2, handled);
+
+	// Nothing is registered for the reliable channel
+	packet->m_reliable = true;
+	EXPECT_FALSE(dispatcher.dispatch(packet));
+}
+
+static int s_releasedEnetPackets = 0;			///< ENet packets destroyed (counted by their free callback)
+static void countReleasedEnetPacket(ENetPacket*) { s_releasedEnetPackets++; }
+
+TEST(NetworkTests, ReceivedPacketsAreReleased)
+{
+	ASSERT_EQ(0, enet_initialize());
+	ENetAddress address;
+	enet_address_set_host(&address, "127.0.0.1");
+	address.port = 0;		// Any free port
+
+	// "Server" reliable host and unreliable socket, and a client connected to them
+	ENetHost* serverHost = enet_host_create(&address, 1, 2, 0, 0);
+	ASSERT_NE(nullptr, serverHost);
+	ENetSocket serverSocket = enet_socket_create(ENET_SOCKET_TYPE_DATAGRAM);
+	enet_socket_set_option(serverSocket, ENET_SOCKOPT_NONBLOCK, 1);
+	ASSERT_EQ(0, enet_socket_bind(serverSocket, &address));
+	ENetAddress serverSocketAddress;
+	ASSERT_EQ(0, enet_socket_get_address(serverSocket, &serverSocketAddress));
+	enet_address_set_host(&serverSocketAddress, "127.0.0.1");
+	ENetAddress serverHostAddress = serverHost->address;
+	enet_address_set_host(&serverHostAddress, "127.0.0.1");
+
+	ENetHost* clientHost = enet_host_create(NULL, 1, 2, 0, 0);
+	ENetSocket clientSocket = enet_socket_create(ENET_SOCKET_TYPE_DATAGRAM);
+	ENetPeer* peer = enet_host_connect(clientHost, &serverHostAddress, 2, 0);
+	ASSERT_NE(nullptr, peer);
+	ENetEvent event;
+	const RealTime connectStart = System::time();
+	while (peer->state != ENET_PEER_STATE_CONNECTED && System::time() - connectStart < 5.0) {
+		enet_host_service(clientHost, &event, 1);
+		NetworkUtils::receivePacket(serverHost, &serverSocket);
+	}
+	ASSERT_EQ(ENET_PEER_STATE_CONNECTED, peer->state);
+
+	const Array<uint8> data = serializedEntityUpdate(8);
+	const int rounds = 50;
+	const int packetsPerRound = 100;
+	const int holdEvery = 10;			// Keep every 10th packet until the end of its round (as a handler that stores packets would)
+	int receivedEnetPackets = 0;
+	for (int round = 0; round < rounds; round++) {
+		for (int i = 0; i < packetsPerRound; i++) {
+			enet_peer_send(peer, 0, enet_packet_create(data.getCArray(), (size_t)data.size(), ENET_PACKET_FLAG_RELIABLE));
+			ENetBuffer buff;
+			buff.data = (void*)data.getCArray();
+			buff.dataLength = (size_t)data.size();
+			enet_socket_send(clientSocket, &serverSocketAddress, &buff, 1);
+		}
+		enet_host_flush(clientHost);
+
+		int received[2] = { 0, 0 };
+		int heldReliable = 0;
+		Array<shared_ptr<GenericPacket>> held;
+		std::set<GenericPacket*> parsedPackets;
+		const RealTime start = System::time();
+		while ((received[0] < packetsPerRound || received[1] < packetsPerRound) && System::time() - start < 5.0) {
+			enet_host_service(clientHost, &event, 0);
+			{
+				shared_ptr<GenericPacket> packet = NetworkUtils::receivePacket(serverHost, &serverSocket);
+				if (isNull(packet) || packet->type() != BATCH_ENTITY_UPDATE) continue;
+				EXPECT_EQ(8, static_cast<BatchEntityUpdatePacket*>(packet.get())->m_updates.size());
+				if (packet->m_reliable) {
+					ASSERT_NE(nullptr, packet->m_enetPacket);
+					packet->m_enetPacket->freeCallback = &countReleasedEnetPacket;
+					receivedEnetPackets++;
+				}
+				const int count = ++received[packet->m_reliable ? 1 : 0];
+				parsedPackets.insert(packet.get());
+				if (count % holdEvery == 0) {
+					if (packet->m_reliable) heldReliable++;
+					held.append(packet);
+				}
+			}
+			// Only the ENet packets of the packets still referenced are alive
+			EXPECT_EQ(heldReliable, receivedEnetPackets - s_releasedEnetPackets);
+		}
+		ASSERT_EQ(packetsPerRound, received[0]) << "Unreliable datagrams lost on loopback in round " << round;
+		ASSERT_EQ(packetsPerRound, received[1]);
+
+		// The packets released straight away were parsed into a handful of pooled ones
+		EXPECT_LE(parsedPackets.size(), (size_t)(held.size() + PacketPool::MAX_POOLED));
+
+		held.clear();
+		EXPECT_EQ(receivedEnetPackets, s_releasedEnetPackets);
+	}
+
+	enet_peer_disconnect_now(peer, 0);
+	enet_host_destroy(clientHost);
+	enet_host_destroy(serverHost);
+	enet_socket_destroy(clientSocket);
+	enet_socket_destroy(serverSocket);
+}
+
+TEST(NetworkTests, DeltaSnapshotsRebuildSnapshot)
+{
+	SnapshotHistory::Snapshot baseline;
+	for (int i = 0; i < 5; i++) {
+		baseline.append(SnapshotHistory::EntityState((uint16)(2 * i), CFrame::fromXYZYPRDegrees((float)i, 1.0f, 2.0f, 90.0f)));
+	}
+
+	// Nothing changed, so only the header is sent
+	Array<BatchEntityUpdatePacket::EntityDelta> deltas;
+	SnapshotHistory::diff(&baseline, baseline, deltas);
+	EXPECT_EQ(0, deltas.size());
+
+	// Move one entity, turn another, and add a new one
+	SnapshotHistory::Snapshot current = baseline;
+	current[1] = SnapshotHistory::EntityState(2, CFrame::fromXYZYPRDegrees(5.0f, 1.0f, 2.0f, 90.0f));
+	current[3] = SnapshotHistory::EntityState(6, CFrame::fromXYZYPRDegrees(3.0f, 1.0f, 2.0f, 45.0f));
+	current.insert(3, SnapshotHistory::EntityState(5, CFrame::fromXYZYPRDegrees(-1.0f, 0.0f, 0.0f)));
+	SnapshotHistory::diff(&baseline, current, deltas);
+	ASSERT_EQ(3, deltas.size());
+	EXPECT_EQ(BatchEntityUpdatePacket::EntityDelta::POSITION, deltas[0].changed);
+	EXPECT_EQ(BatchEntityUpdatePacket::EntityDelta::ALL_FIELDS, deltas[1].changed);
+	EXPECT_EQ(BatchEntityUpdatePacket::EntityDelta::ROTATION, deltas[2].changed);
+
+	shared_ptr<BatchEntityUpdatePacket> packet = GenericPacket::createForBroadcast<BatchEntityUpdatePacket>();
+	packet->populateDelta(43, 42, deltas);
+	BinaryOutput out("<memory>", G3D_BIG_ENDIAN);
+	packet->serializeTo(out);
+	EXPECT_EQ((int)out.length(), packet->serializedSize());
+	EXPECT_EQ(BatchEntityUpdatePacket::HEADER_BYTES + 11 + 15 + 7, packet->serializedSize());
+
+	// Rebuild the snapshot on the receiving side
+	ENetAddress srcAddr;
+	srcAddr.host = ENET_HOST_ANY;
+	srcAddr.port = 1234;
+	shared_ptr<BatchEntityUpdatePacket> received = dynamic_pointer_cast<BatchEntityUpdatePacket>(NetworkUtils::parsePacket(srcAddr, out.getCArray(), (size_t)out.length()));
+	ASSERT_NE(nullptr, received);
+	EXPECT_EQ(42u, received->m_baselineFrame);
+	SnapshotHistory::Snapshot rebuilt;
+	SnapshotHistory::apply(&baseline, received->m_deltas, rebuilt);
+	ASSERT_EQ(current.size(), rebuilt.size());
+	for (int i = 0; i < current.size(); i++) {
+		EXPECT_EQ(current[i].index, rebuilt[i].index);
+		EXPECT_EQ(current[i].position, rebuilt[i].position);
+		EXPECT_EQ(current[i].rotation, rebuilt[i].rotation);
+	}
+
+	// Only acknowledged snapshots still in the ring are used as baselines
+	SnapshotHistory history;
+	history.record(42, std::make_shared<SnapshotHistory::Snapshot>(baseline));
+	EXPECT_EQ(nullptr, history.baseline());
+	history.acknowledge(42);
+	history.acknowledge(41);
+	EXPECT_NE(nullptr, history.baseline());
+	history.record(42 + SnapshotHistory::CAPACITY, std::make_shared<SnapshotHistory::Snapshot>(current));
+	EXPECT_EQ(nullptr, history.baseline());
+}
+
+TEST(NetworkTests, LargeEntityBatchesSplitAndReassemble)
+{
+	// More entities than the old 8-bit count could describe, and far more than fit in one datagram
+	Array<BatchEntityUpdatePacket::EntityUpdate> updates;
+	for (int i = 0; i < 600; i++) {
+		updates.append(BatchEntityUpdatePacket::EntityUpdate(CFrame::fromXYZYPRDegrees((float)i, 1.0f, 2.0f, 90.0f), (uint16)i));
+	}
+	shared_ptr<BatchEntityUpdatePacket> packet = GenericPacket::createForBroadcast<BatchEntityUpdatePacket>();
+	packet->populate(42, updates, BatchEntityUpdatePacket::NetworkUpdateType::REPLACE_FRAME);
+
+	Array<shared_ptr<BatchEntityUpdatePacket>> parts;
+	packet->split(parts);
+	ASSERT_EQ(7, parts.size());
+
+	// Serialize every part, then deliver them out of order (with a duplicate)
+	ENetAddress srcAddr;
+	srcAddr.host = ENET_HOST_ANY;
+	srcAddr.port = 1234;
+	Array<shared_ptr<BatchEntityUpdatePacket>> received;
+	for (const shared_ptr<BatchEntityUpdatePacket>& part : parts) {
+		BinaryOutput out("<memory>", G3D_BIG_ENDIAN);
+		part->serializeTo(out);
+		EXPECT_LE((int)out.length(), BatchEntityUpdatePacket::MAX_DATAGRAM_BYTES);
+		EXPECT_EQ((int)out.length(), part->serializedSize());
+		received.append(dynamic_pointer_cast<BatchEntityUpdatePacket>(NetworkUtils::parsePacket(srcAddr, out.getCArray(), (size_t)out.length())));
+		ASSERT_NE(nullptr, received.last());
+		EXPECT_EQ(42u, received.last()->m_frameNumber);
+		EXPECT_EQ(7, received.last()->m_partCount);
+	}
+	EntityBatchAssembler assembler;
+	const int order[] = { 3, 0, 6, 0, 1, 5, 2 };
+	for (const int i : order) {
+		EXPECT_EQ(nullptr, assembler.add(received[i].get()));
+	}
+	BatchEntityUpdatePacket* assembled = assembler.add(received[4].get());
+	ASSERT_NE(nullptr, assembled);
+	EXPECT_EQ(42u, assembled->m_frameNumber);
+	ASSERT_EQ(updates.size(), assembled->m_updates.size());
+	for (int i = 0; i < updates.size(); i++) {
+		EXPECT_EQ(updates[i].index, assembled->m_updates[i].index);
+		EXPECT_LT((assembled->m_updates[i].frame.translation - updates[i].frame.translation).length(), 0.01f);
+	}
+
+	// Parts of a snapshot that already completed are ignored, an incomplete one is dropped once a newer one completes
+	EXPECT_EQ(nullptr, assembler.add(received[2].get()));
+	received[0]->m_frameNumber = 43;
+	EXPECT_EQ(nullptr, assembler.add(received[0].get()));
+	for (const shared_ptr<BatchEntityUpdatePacket>& part : received) {
+		part->m_frameNumber = 44;
+		assembler.add(part.get());
+	}
+	EXPECT_EQ(2, assembler.completedCount());
+	EXPECT_EQ(1, assembler.droppedCount());
+
+	// Updates that fit in one datagram aren't split
+	packet->m_updates.resize(10);
+	packet->split(parts);
+	ASSERT_EQ(1, parts.size());
+	EXPECT_EQ(1, parts[0]->m_partCount);
+	EXPECT_EQ(parts[0].get(), assembler.add(parts[0].get()));
+}
+
+TEST(NetworkTests, InterestManagementFiltersAndBudgets)
+{
+	// The client (index 0) is at the origin looking down -z (there is no scene, so nothing is occluded)
+	const Point3 positions[] = { Point3(0, 0, 0), Point3(0, 0, -10), Point3(0, 0, 10), Point3(0, 0, -500), Point3(5, 0, -10) };
+	SnapshotHistory::Snapshot current;
+	for (int i = 0; i < 5; i++) {
+		current.append(SnapshotHistory::EntityState((uint16)i, CFrame(positions[i])));
+	}
+	InterestConfig config;
+	config.enable = true;
+	const Array<float> priorities = { config.playerPriority, config.targetPriority, config.targetPriority, config.targetPriority, config.playerPriority };
+
+	// Not the client's own entity or the one out of range, the one behind the client is sent at the hidden rate
+	ClientInterest interest;
+	SnapshotHistory::Snapshot view;
+	interest.select(config, CFrame(), 0, nullptr, current, priorities, nullptr, true, 0.0, view);
+	ASSERT_EQ(3, view.size());
+	EXPECT_EQ(1, view[0].index);
+	EXPECT_EQ(2, view[1].index);
+	EXPECT_EQ(4, view[2].index);
+	EXPECT_EQ(3, interest.stats().relevant);
+	EXPECT_EQ(2, interest.stats().visible);
+
+	// Everything moves, the hidden entity keeps its baseline state until it is due again
+	const SnapshotHistory::Snapshot baseline = view;
+	for (SnapshotHistory::EntityState& state : current) {
+		state = SnapshotHistory::EntityState(state.index, CFrame(BatchEntityUpdatePacket::unpackPosition(state.position) + Vector3(1, 0, 0)));
+	}
+	interest.select(config, CFrame(), 0, nullptr, current, priorities, &baseline, true, 0.1, view);
+	ASSERT_EQ(3, view.size());
+	EXPECT_EQ(current[1].position, view[0].position);
+	EXPECT_EQ(baseline[1].position, view[1].position);
+	EXPECT_EQ(current[4].position, view[2].position);
+	EXPECT_EQ(2, interest.stats().sent);
+	interest.select(config, CFrame(), 0, nullptr, current, priorities, &baseline, true, 0.3, view);
+	EXPECT_EQ(current[2].position, view[1].position);
+
+	// With room for a single entity (15 bytes) in the budget, the other player goes first and the rest are deferred
+	config.bandwidthKbps = 4.0f;
+	ClientInterest budgeted;
+	budgeted.select(config, CFrame(), 0, nullptr, current, priorities, nullptr, true, 0.0, view);
+	EXPECT_EQ(0, view.size());
+	EXPECT_EQ(3, budgeted.stats().deferred);
+	budgeted.select(config, CFrame(), 0, nullptr, current, priorities, nullptr, true, 0.1, view);
+	ASSERT_EQ(1, view.size());
+	EXPECT_EQ(4, view[0].index);
+	EXPECT_EQ(2, budgeted.stats().deferred);
+}
+
+TEST(NetworkTests, SnapshotInterpolationAndExtrapolation)
+{
+	// An entity moving 1 m per server frame, with snapshots sent at 100 Hz and every other one arriving 4 ms late
+	typedef SnapshotInterpolator::Clock Clock;
+	const Clock::time_point start = Clock::now();
+	SnapshotInterpolator interpolator;
+	SnapshotInterpolator::FrameStats stats;
+	CFrame cframe;
+	for (uint32 frame = 1; frame <= 60; frame++) {
+		interpolator.addSnapshot(frame, start + std::chrono::microseconds(10000 * frame + ((frame % 2 == 0) ? 4000 : 0)));
+		interpolator.addSample(3, frame, CFrame(Point3((float)frame, 0.0f, 0.0f)));
+		if (frame == 1) {
+			// The clock can't be estimated from one snapshot, so the latest sample is shown as is
+			EXPECT_FALSE(interpolator.synchronized());
+			EXPECT_EQ(SnapshotInterpolator::HELD, interpolator.evaluate(3, 5.0, 0.1, cframe, stats));
+			EXPECT_EQ(1.0f, cframe.translation.x);
+		}
+	}
+	ASSERT_TRUE(interpolator.synchronized());
+	EXPECT_EQ(SnapshotInterpolator::NO_DATA, interpolator.evaluate(4, 50.0, 0.1, cframe, stats));
+
+	// Shown 100 ms (10 frames) behind the server clock, which is set by the snapshots that weren't delayed
+	EXPECT_NEAR(50.0, interpolator.renderFrame(start + std::chrono::microseconds(600000), 0.1), 0.5);
+	EXPECT_EQ(SnapshotInterpolator::INTERPOLATED, interpolator.evaluate(3, 50.25, 0.1, cframe, stats));
+	EXPECT_NEAR(50.25f, cframe.translation.x, 1e-3f);
+
+	// Late snapshots are extrapolated for up to 100 ms, then held
+	EXPECT_EQ(SnapshotInterpolator::EXTRAPOLATED, interpolator.evaluate(3, 65.0, 0.1, cframe, stats));
+	EXPECT_NEAR(65.0f, cframe.translation.x, 1e-3f);
+	EXPECT_EQ(SnapshotInterpolator::HELD, interpolator.evaluate(3, 80.0, 0.1, cframe, stats));
+	EXPECT_NEAR(70.0f, cframe.translation.x, 0.5f);
+
+	// Only the latest samples are held
+	EXPECT_EQ(SnapshotInterpolator::HELD, interpolator.evaluate(3, 10.0, 0.1, cframe, stats));
+	EXPECT_EQ((float)(60 - SnapshotInterpolator::ENTITY_SAMPLES + 1), cframe.translation.x);
+
+	EXPECT_EQ(1, stats.interpolated);
+	EXPECT_EQ(1, stats.extrapolated);
+	EXPECT_EQ(3, stats.held);
+}
+
+TEST(NetworkTests, LagCompensationRewindsToShooterFrame)
+{
+	// Entity 2 moves 0.1 m along x every network frame (at 100 Hz), 10 m in front of a shooter at the origin
+	LagCompensator history;
+	for (uint32 frame = 1; frame <= 100; frame++) {
+		const shared_ptr<SnapshotHistory::Snapshot> snapshot = std::make_shared<SnapshotHistory::Snapshot>();
+		snapshot->append(SnapshotHistory::EntityState(2, CFrame(Point3(0.1f * frame, 0.0f, -10.0f))));
+		history.record(frame, 0.01 * frame, snapshot);
+	}
+	// The shooter aimed at the entity as it was shown on frame 90
+	const Ray shot = Ray::fromOriginAndDirection(Point3::zero(), Vector3(9.0f, 0.0f, -10.0f).direction());
+	LagCompensationConfig config;
+
+	// Rewound to the shooter's frame the shot hits
+	LagCompensator::Validation v = history.validate(config, shot, 90.0, 2, nullptr);
+	EXPECT_EQ(LagCompensator::HIT, v.result);
+	EXPECT_FALSE(v.clamped);
+	EXPECT_EQ(90.0, v.testedFrame);
+	EXPECT_NEAR(100.0f, v.rewindMs, 0.01f);
+	EXPECT_EQ(0.0f, v.missDistance);
+	EXPECT_GE(v.costUs, 0.0f);
+	// Between frames the pose is interpolated
+	CFrame pose;
+	ASSERT_TRUE(history.pose(2, 89.5, pose));
+	EXPECT_NEAR(8.95f, pose.translation.x, 5e-3f);
+	EXPECT_EQ(LagCompensator::HIT, history.validate(config, shot, 89.5, 2, nullptr).result);
+	EXPECT_EQ(LagCompensator::NO_HISTORY, history.validate(config, shot, 90.0, 7, nullptr).result);
+
+	// Tested against the current pose, the shot passes behind the entity
+	config.favorShooter = false;
+	v = history.validate(config, shot, 90.0, 2, nullptr);
+	EXPECT_EQ(LagCompensator::MISSED, v.result);
+	EXPECT_EQ(100.0, v.testedFrame);
+	EXPECT_NEAR(0.243f, v.missDistance, 1e-3f);
+
+	// Shooters can only be rewound as far as the window (frame 97 here), where the shot just misses unless tolerated
+	config.favorShooter = true;
+	config.rewindWindowMs = 35.0f;
+	v = history.validate(config, shot, 90.0, 2, nullptr);
+	EXPECT_EQ(LagCompensator::MISSED, v.result);
+	EXPECT_TRUE(v.clamped);
+	EXPECT_EQ(97.0, v.testedFrame);
+	config.toleranceM = 0.1f;
+	EXPECT_EQ(LagCompensator::HIT, history.validate(config, shot, 90.0, 2, nullptr).result);
+
+	// Spheres behind the shooter aren't hit
+	float hitDistance;
+	EXPECT_EQ(0.0f, LagCompensator::rayMissDistance(Ray::fromOriginAndDirection(Point3::zero(), -Vector3::unitZ()), Point3(0.0f, 0.0f, -10.0f), 0.5f, hitDistance));
+	EXPECT_NEAR(9.5f, hitDistance, 1e-4f);
+	EXPECT_NEAR(9.5f, LagCompensator::rayMissDistance(Ray::fromOriginAndDirection(Point3::zero(), -Vector3::unitZ()), Point3(0.0f, 0.0f, 10.0f), 0.5f, hitDistance), 1e-4f);
+}
+
+TEST(NetworkTests, PredictionAcknowledgesAndReplaysInputs)
+{
+	// Five inputs, each predicted to move the player 1 m along x
+	PlayerPrediction prediction;
+	for (int i = 1; i <= 5; i++) {
+		PlayerEntity::InputCommand input;
+		input.time = 10.0 + i;
+		PlayerEntity::MovementState state;
+		state.position = Point3((float)i, 0.0f, 0.0f);
+		EXPECT_EQ((uint32)i, prediction.record(input, state));
+		EXPECT_EQ((uint32)i, input.sequence);
+	}
+	EXPECT_EQ(5, prediction.pending());
+
+	// Only the newest inputs are sent when there are more than fit a packet
+	Array<PlayerEntity::InputCommand> inputs;
+	prediction.unacked(3, inputs);
+	ASSERT_EQ(3, inputs.size());
+	EXPECT_EQ(3u, inputs[0].sequence);
+	EXPECT_EQ(5u, inputs[2].sequence);
+
+	// The server agrees with the prediction for input 2
+	PlayerEntity::MovementState server;
+	server.position = Point3(2.0f, 0.0f, 0.0f);
+	float error;
+	RealTime inputTime;
+	ASSERT_TRUE(prediction.acknowledge(2, server, error, inputTime));
+	EXPECT_EQ(0.0f, error);
+	EXPECT_EQ(12.0, inputTime);
+	EXPECT_EQ(3, prediction.pending());
+	EXPECT_EQ(3u, prediction[0].input.sequence);
+
+	// Reordered (or unsent) acknowledgements are ignored
+	EXPECT_FALSE(prediction.acknowledge(1, server, error, inputTime));
+	EXPECT_FALSE(prediction.acknowledge(6, server, error, inputTime));
+	EXPECT_EQ(3, prediction.pending());
+
+	// The server put input 4 half a meter short, leaving input 5 to replay
+	server.position = Point3(3.5f, 0.0f, 0.0f);
+	ASSERT_TRUE(prediction.acknowledge(4, server, error, inputTime));
+	EXPECT_FLOAT_EQ(0.5f, error);
+	ASSERT_EQ(1, prediction.pending());
+	EXPECT_EQ(5u, prediction[0].input.sequence);
+	server.position = Point3(4.5f, 0.0f, 0.0f);
+	prediction.setPredicted(0, server);
+	EXPECT_EQ(4.5f, prediction[0].state.position.x);
+	EXPECT_EQ(4u, prediction.ackedSequence());
+
+	prediction.clear();
+	EXPECT_EQ(0, prediction.pending());
+	EXPECT_EQ(0u, prediction.latestSequence());
+}
+
+TEST(NetworkTests, ImpairmentConfigRejectsOutOfRangeValues)
+{
+	EXPECT_NO_THROW(NetworkImpairmentConfig(Any::parse("{ enable = true; lossRate = 1.0; duplicateRate = 0.0; jitterMs = 5.0; }")));
+	// Rates are probabilities
+	for (const char* rate : { "lossRate", "burstStartRate", "burstEndRate", "burstLossRate", "reorderRate", "duplicateRate" }) {
+		EXPECT_THROW(NetworkImpairmentConfig(Any::parse(format("{ %s = 1.5; }", rate))), String) << rate;
+		EXPECT_THROW(NetworkImpairmentConfig(Any::parse(format("{ %s = -0.1; }", rate))), String) << rate;
+	}
+	// Delays can't be negative
+	for (const char* delay : { "jitterMs", "reorderDelayMs", "queueLimitMs", "bandwidthKbps" }) {
+		EXPECT_THROW(NetworkImpairmentConfig(Any::parse(format("{ %s = -1.0; }", delay))), String) << delay;
+	}
+	EXPECT_THROW(NetworkImpairmentConfig(Any::parse("{ bucketBytes = 0; }")), String);
+}
+
+TEST(NetworkTests, ImpairmentDecisionsAreReproducible)
+{
+	NetworkImpairmentConfig config;
+	config.enable = true;
+	config.seed = 7;
+	config.jitterMs = 5.0f;
+	config.jitterDistribution = "normal";
+	config.lossRate = 0.1f;
+	config.burstStartRate = 0.05f;
+	config.burstEndRate = 0.5f;
+	config.reorderRate = 0.1f;
+	config.duplicateRate = 0.1f;
+
+	ENetAddress dest;
+	dest.host = ENET_HOST_ANY;
+	dest.port = 1234;
+	const NetworkImpairment::Clock::time_point start = NetworkImpairment::Clock::now();
+	NetworkImpairment::Clock::time_point sendTimes[NetworkImpairment::MAX_COPIES];
+
+	// The same seed (and stream) makes the same decisions, another stream doesn't
+	Array<ImpairmentRecord> records[3];
+	const shared_ptr<NetworkImpairment> impairments[3] = { NetworkImpairment::create(config, 0), NetworkImpairment::create(config, 0), NetworkImpairment::create(config, 1) };
+	for (int i = 0; i < 3; i++) {
+		for (int p = 0; p < 5000; p++) {
+			impairments[i]->impair(start, 20.0f, dest, BATCH_ENTITY_UPDATE, 100, false, sendTimes, records[i]);
+		}
+	}
+	ASSERT_EQ(records[0].size(), records[1].size());
+	int lost = 0;
+	bool sameAsOtherStream = records[0].size() == records[2].size();
+	for (int r = 0; r < records[0].size(); r++) {
+		EXPECT_EQ(records[0][r].action, records[1][r].action);
+		EXPECT_EQ(records[0][r].delayMs, records[1][r].delayMs);
+		if (records[0][r].action == ImpairmentRecord::LOST || records[0][r].action == ImpairmentRecord::BURST_LOST) lost++;
+		if (sameAsOtherStream && (records[0][r].action != records[2][r].action || records[0][r].delayMs != records[2][r].delayMs)) sameAsOtherStream = false;
+	}
+	EXPECT_FALSE(sameAsOtherStream);
+	// Expect the long run loss of the Gilbert-Elliott model (1/11 of packets in the burst state): 0.1 * 10/11 + 1.0 * 1/11 ~= 0.18
+	EXPECT_NEAR(0.18, lost / 5000.0, 0.03);
+
+	// Reliable packets are never dropped and stay in order
+	Array<ImpairmentRecord> reliableRecords;
+	const shared_ptr<NetworkImpairment> reliable = NetworkImpairment::create(config);
+	NetworkImpairment::Clock::time_point lastSend = start;
+	for (int p = 0; p < 100; p++) {
+		ASSERT_EQ(1, reliable->impair(start, 20.0f, dest, CREATE_ENTITY, 100, true, sendTimes, reliableRecords));
+		EXPECT_GE(sendTimes[0], lastSend);
+		lastSend = sendTimes[0];
+	}
+}
+
+TEST(NetworkTests, SpscHandoffKeepsOrder)
+{
+	// A small ring so the producer keeps finding it full
+	const int count = 100000;
+	SpscRingBuffer<int> ring(16);
+	EXPECT_EQ(16, (int)ring.capacity());
+	std::thread producer([&ring, count] {
+		for (int i = 0; i < count; i++) {
+			while (!ring.tryPush(i)) std::this_thread::yield();
+		}
+	});
+	int expected = 0;
+	int value;
+	while (expected < count) {
+		if (!ring.tryPop(value)) continue;
+		if (value != expected) break;
+		expected++;
+	}
+	producer.join();
+	EXPECT_EQ(count, expected);
+	EXPECT_TRUE(ring.empty());
+}
+
+TEST(NetworkTests, BatchedReceiveDropsTruncatedDatagrams)
+{
+	if (!DatagramBatch::supported()) return;		// recvmmsg() batching is Linux only
+	ASSERT_EQ(0, enet_initialize());
+	ENetAddress address;
+	enet_address_set_host(&address, "127.0.0.1");
+	address.port = 0;		// Any free port
+	ENetSocket serverSocket = enet_socket_create(ENET_SOCKET_TYPE_DATAGRAM);
+	enet_socket_set_option(serverSocket, ENET_SOCKOPT_NONBLOCK, 1);
+	ASSERT_EQ(0, enet_socket_bind(serverSocket, &address));
+	ENetAddress serverSocketAddress;
+	ASSERT_EQ(0, enet_socket_get_address(serverSocket, &serverSocketAddress));
+	enet_address_set_host(&serverSocketAddress, "127.0.0.1");
+	ENetSocket clientSocket = enet_socket_create(ENET_SOCKET_TYPE_DATAGRAM);
+
+	// A datagram too long for the receive buffers (that starts like a valid packet), then a valid one
+	const Array<uint8> data = serializedEntityUpdate(8);
+	Array<uint8> oversized = data;
+	oversized.resize(DatagramBatch::DATAGRAM_SIZE + 100);
+	ENetBuffer buff;
+	buff.data = (void*)oversized.getCArray();
+	buff.dataLength = (size_t)oversized.size();
+	ASSERT_EQ(oversized.size(), enet_socket_send(clientSocket, &serverSocketAddress, &buff, 1));
+	buff.data = (void*)data.getCArray();
+	buff.dataLength = (size_t)data.size();
+	ASSERT_EQ(data.size(), enet_socket_send(clientSocket, &serverSocketAddress, &buff, 1));
+
+	std::unique_ptr<DatagramBatch> batch(new DatagramBatch());		// Too large for the stack
+	Array<size_t> lengths;
+	const RealTime start = System::time();
+	while (lengths.size() < 2 && System::time() - start < 1.0) {
+		ASSERT_GE(batch->receive(serverSocket, true), 0);
+		for (int i = 0; i < batch->count(); i++) {
+			lengths.append(batch->length(i));
+			if (batch->length(i) > 0) {
+				EXPECT_EQ(0, memcmp(data.getCArray(), batch->data(i), (size_t)data.size()));
+			}
+		}
+	}
+	ASSERT_EQ(2, lengths.size());
+	EXPECT_EQ((size_t)0, lengths[0]);
+	EXPECT_EQ((size_t)data.size(), lengths[1]);
+	EXPECT_EQ((uint64)1, batch->truncatedCount());
+
+	enet_socket_destroy(clientSocket);
+	enet_socket_destroy(serverSocket);
+}
+
+TEST(NetworkTests, LatentPacketsSentOnTime)
+{
+	typedef LatentNetwork::Clock Clock;
+	LatentNetwork& network = LatentNetwork::getInstance();
+	// Record the sends rather than making them (the packets have nothing to send)
+	std::mutex sentMutex;
+	Array<shared_ptr<LatentPacket>> sent;
+	Array<Clock::time_point> sentTimes;
+	network.setSendHook([&](const shared_ptr<LatentPacket>& packet) {
+		const Clock::time_point now = Clock::now();
+		std::lock_guard<std::mutex> lk(sentMutex);
+		sent.append(packet);
+		sentTimes.append(now);
+	});
+	const uint64 sentBefore = network.stats().sent;
+
+	// Packets due 1-21 ms from now, enqueued out of send time order
+	const int count = 200;
+	const Clock::time_point start = Clock::now();
+	Clock::time_point lastDue = start;
+	for (int i = 0; i < count; i++) {
+		const Clock::time_point due = start + std::chrono::microseconds(1000 + (i * 7919) % 20000);
+		lastDue = std::max(lastDue, due);
+		network.enqueuePacket(LatentPacket::create(nullptr, due));
+	}
+
+	// The flush only returns once every packet enqueued before it has gone out
+	ASSERT_TRUE(network.flush(true));
+	EXPECT_GE(Clock::now(), lastDue);
+	{
+		std::lock_guard<std::mutex> lk(sentMutex);
+		ASSERT_EQ(count, sent.size());
+		int onTime = 0;
+		for (int i = 0; i < count; i++) {
+			// Never early, in send time order, and (but for the odd late wake up on a loaded machine) within the longest spin window
+			const double errorUs = std::chrono::duration<double, std::micro>(sentTimes[i] - sent[i]->timeToSend).count();
+			EXPECT_GE(errorUs, 0.0);
+			if (i > 0) EXPECT_LE(sent[i - 1]->timeToSend, sent[i]->timeToSend);
+			if (errorUs <= 2000.0) onTime++;
+		}
+		EXPECT_GE(onTime, 0.95 * count);
+	}
+	EXPECT_EQ(sentBefore + count, network.stats().sent);
+
+	network.setSendHook(nullptr);
+}
+
+// Decode throughput microbenchmark, run with --gtest_also_run_disabled_tests
+TEST(NetworkTests, DISABLED_PacketDecodeRate)
+{
+	const int packetCount = 1000000;
+	const Array<uint8> data = serializedEntityUpdate(8);
+	ENetAddress srcAddr;
+	srcAddr.host = ENET_HOST_ANY;
+	srcAddr.port = 1234;
+
+	PacketDispatcher dispatcher;
+	uint32 frameSum = 0;
+	dispatcher.on(BATCH_ENTITY_UPDATE, PacketDispatcher::UNRELIABLE, [&frameSum](GenericPacket* packet) {
+		frameSum += static_cast<BatchEntityUpdatePacket*>(packet)->m_frameNumber;
+	});
+
+	const RealTime start = System::time();
+	for (int i = 0; i < packetCount; i++) {
+		const shared_ptr<GenericPacket> packet = NetworkUtils::parsePacket(srcAddr, data.getCArray(), (size_t)data.size());
+		packet->m_reliable = false;
+		dispatcher.dispatch(packet);
+	}
+	const RealTime elapsed = System::time() - start;
+
+	EXPECT_EQ((uint32)packetCount * 42u, frameSum);
+	printf("Decoded and dispatched %d packets (%d bytes each) in %.3f s: %.0f packets/s\n", packetCount, data.size(), elapsed, packetCount / elapsed);
+}
+
+// Server frame time against client count over loopback, with batched and unbatched datagram I/O (see NetworkUtils::setBatchedIO()),
+// run with --gtest_also_run_disabled_tests
+TEST(NetworkTests, DISABLED_ServerFrameTimeByClientCount)
+{
+	ASSERT_EQ(0, enet_initialize());
+	ENetAddress address;
+	enet_address_set_host(&address, "127.0.0.1");
+	address.port = 0;		// Any free port
+	ENetHost* serverHost = enet_host_create(&address, 1, 2, 0, 0);
+	ASSERT_NE(nullptr, serverHost);
+	ENetSocket serverSocket = enet_socket_create(ENET_SOCKET_TYPE_DATAGRAM);
+	enet_socket_set_option(serverSocket, ENET_SOCKOPT_NONBLOCK, 1);
+	ASSERT_EQ(0, enet_socket_bind(serverSocket, &address));
+	ENetAddress serverSocketAddress;
+	ASSERT_EQ(0, enet_socket_get_address(serverSocket, &serverSocketAddress));
+	enet_address_set_host(&serverSocketAddress, "127.0.0.1");
+
+	const Array<uint8> input = serializedEntityUpdate(1);			// Each client's update to the server
+	const Array<uint8> snapshot = serializedEntityUpdate(32);		// The server's update to every client
+	const int frames = 1000;
+	uint8 drain[DatagramBatch::DATAGRAM_SIZE];
+
+	for (int clientCount : { 1, 4, 16, 64 }) {
+		Array<ENetSocket> clientSockets;
+		Array<ENetAddress> clientAddresses;
+		for (int c = 0; c < clientCount; c++) {
+			ENetSocket clientSocket = enet_socket_create(ENET_SOCKET_TYPE_DATAGRAM);
+			enet_socket_set_option(clientSocket, ENET_SOCKOPT_NONBLOCK, 1);
+			ASSERT_EQ(0, enet_socket_bind(clientSocket, &address));
+			ENetAddress clientAddress;
+			ASSERT_EQ(0, enet_socket_get_address(clientSocket, &clientAddress));
+			enet_address_set_host(&clientAddress, "127.0.0.1");
+			clientSockets.append(clientSocket);
+			clientAddresses.append(clientAddress);
+		}
+
+		for (bool batched : { false, true }) {
+			if (batched && !DatagramBatch::supported()) {
+				printf("%3d clients, batched:   not supported on this platform\n", clientCount);
+				continue;
+			}
+			NetworkUtils::setBatchedIO(batched);
+			RealTime total = 0;
+			RealTime slowest = 0;
+			int lost = 0;
+			for (int f = 0; f < frames; f++) {
+				// Every client sends its update for this frame (not timed)
+				ENetBuffer buff;
+				buff.data = (void*)input.getCArray();
+				buff.dataLength = (size_t)input.size();
+				for (ENetSocket clientSocket : clientSockets) {
+					enet_socket_send(clientSocket, &serverSocketAddress, &buff, 1);
+				}
+
+				// The server's frame: receive every client's update, then send the snapshot to all of them
+				const RealTime start = System::time();
+				int received = 0;
+				while (received < clientCount && System::time() - start < 0.1) {
+					if (notNull(NetworkUtils::receivePacket(serverHost, &serverSocket))) received++;
+				}
+				lost += clientCount - received;
+				DatagramBatch::sendToAll(serverSocket, snapshot.getCArray(), (size_t)snapshot.size(), clientAddresses, batched);
+				const RealTime elapsed = System::time() - start;
+				total += elapsed;
+				slowest = max(slowest, elapsed);
+
+				// Clients read their snapshot (not timed)
+				buff.data = drain;
+				buff.dataLength = sizeof(drain);
+				for (ENetSocket clientSocket : clientSockets) {
+					ENetAddress from;
+					while (enet_socket_receive(clientSocket, &from, &buff, 1) > 0) {}
+				}
+			}
+			printf("%3d clients, %s: %.1f us per server frame (slowest %.1f us), %d updates lost\n", clientCount, batched ? "batched  " : "unbatched",
+				1e6 * total / frames, 1e6 * slowest, lost);
+		}
+
+		for (ENetSocket clientSocket : clientSockets) {
+			enet_socket_destroy(clientSocket);
+		}
+	}
+
+	NetworkUtils::setBatchedIO(false);		// The default
+	enet_host_destroy(serverHost);
+	enet_socket_destroy(serverSocket);
+}
+
+// One-way latency over loopback from send until a packet is read from the network and until the frame loop handles it, polling
+// once per frame or on the network thread (see NetworkThread), at 60/144/360 Hz. Run with --gtest_also_run_disabled_tests
+TEST(NetworkTests, DISABLED_OneWayLatencyByFrameRate)
+{
+	typedef NetworkThread::Clock Clock;
+	ASSERT_EQ(0, enet_initialize());
+	ENetAddress address;
+	enet_address_set_host(&address, "127.0.0.1");
+	address.port = 0;		// Any free port
+	ENetHost* serverHost = enet_host_create(&address, 1, 2, 0, 0);
+	ASSERT_NE(nullptr, serverHost);
+	ENetSocket serverSocket = enet_socket_create(ENET_SOCKET_TYPE_DATAGRAM);
+	enet_socket_set_option(serverSocket, ENET_SOCKOPT_NONBLOCK, 1);
+	ASSERT_EQ(0, enet_socket_bind(serverSocket, &address));
+	ENetAddress serverSocketAddress;
+	ASSERT_EQ(0, enet_socket_get_address(serverSocket, &serverSocketAddress));
+	enet_address_set_host(&serverSocketAddress, "127.0.0.1");
+
+	// The sender numbers its packets (in the frame number) so each can be matched with its send time
+	const auto sendInterval = std::chrono::microseconds(2000);
+	const auto runTime = std::chrono::seconds(3);
+	const int packetCount = 1600;
+	Array<Array<uint8>> datagrams;
+	for (int seq = 0; seq < packetCount; seq++) {
+		datagrams.append(serializedEntityUpdate(1, (uint32)seq));
+	}
+	auto percentile = [](Array<double> values, float p) {
+		if (values.size() == 0) return 0.0;
+		values.sort();
+		return values[iMin(values.size() - 1, (int)(p * values.size()))];
+	};
+	auto mean = [](const Array<double>& values) {
+		double sum = 0.0;
+		for (double value : values) sum += value;
+		return values.size() > 0 ? sum / values.size() : 0.0;
+	};
+
+	printf("rate    polling   read mean/p99 (us)   handled mean/p99 (us)\n");
+	for (float rate : { 60.0f, 144.0f, 360.0f }) {
+		for (bool threaded : { false, true }) {
+			std::vector<Clock::time_point> sendTimes(packetCount);
+			std::atomic<int> sent{ 0 };
+			std::atomic<bool> sending{ true };
+			shared_ptr<NetworkThread> networkThread = threaded ? NetworkThread::create(serverHost, &serverSocket) : nullptr;
+			std::thread sender([&] {
+				ENetSocket clientSocket = enet_socket_create(ENET_SOCKET_TYPE_DATAGRAM);
+				for (int seq = 0; seq < packetCount && sending; seq++) {
+					ENetBuffer buff;
+					buff.data = (void*)datagrams[seq].getCArray();
+					buff.dataLength = (size_t)datagrams[seq].size();
+					sendTimes[seq] = Clock::now();
+					sent.store(seq + 1, std::memory_order_release);
+					enet_socket_send(clientSocket, &serverSocketAddress, &buff, 1);
+					std::this_thread::sleep_for(sendInterval);
+				}
+				enet_socket_destroy(clientSocket);
+			});
+
+			// A frame limited loop that handles everything received once per frame
+			Array<double> readUs;
+			Array<double> handledUs;
+			const auto frameTime = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / rate));
+			const Clock::time_point end = Clock::now() + runTime;
+			Clock::time_point nextFrame = Clock::now();
+			while (Clock::now() < end) {
+				nextFrame += frameTime;
+				std::this_thread::sleep_until(nextFrame);
+				shared_ptr<GenericPacket> packet;
+				while (threaded ? networkThread->receive(packet) : notNull(packet = NetworkUtils::receivePacket(serverHost, &serverSocket))) {
+					const Clock::time_point handled = Clock::now();
+					if (packet->type() != BATCH_ENTITY_UPDATE) continue;
+					const int seq = (int)static_cast<BatchEntityUpdatePacket*>(packet.get())->m_frameNumber;
+					if (seq >= sent.load(std::memory_order_acquire)) continue;
+					readUs.append(std::chrono::duration<double, std::micro>(packet->m_arrivalTime - sendTimes[seq]).count());
+					handledUs.append(std::chrono::duration<double, std::micro>(handled - sendTimes[seq]).count());
+				}
+			}
+			sending = false;
+			sender.join();
+			if (threaded) {
+				networkThread->stop();
+				networkThread.reset();
+			}
+			// Leave nothing behind for the next run
+			while (notNull(NetworkUtils::receivePacket(serverHost, &serverSocket))) {}
+
+			EXPECT_GT(readUs.size(), 0);
+			printf("%3.0f Hz  %s   %7.0f / %7.0f      %7.0f / %7.0f\n", rate, threaded ? "thread   " : "per-frame",
+				mean(readUs), percentile(readUs, 0.99f), mean(handledUs), percentile(handledUs, 0.99f));
+		}
+	}
+
+	enet_host_destroy(serverHost);
+	enet_socket_destroy(serverSocket);
+}
+
+TEST(HeadlessServerTests, RunsTicksWithoutAWindow)
+{
+	// Runs on CI machines with no GPU or display: nothing here may need a GL context
+	const StartupConfig previousConfig = FPSciApp::startupConfig;
+	FPSciApp::startupConfig = Any::fromFile("test/startupconfig.Any");
+	FPSciApp::startupConfig.serverTickRate = 200.0f;
+	FPSciApp::startupConfig.fullscreen = false;
+	FPSciApp::startupConfig.audioEnable = false;
+
+	GApp::Settings settings(*g_settings);
+	settings.window.visible = false;
+	{
+		FPSciServerApp server(settings, true);
+		EXPECT_TRUE(server.headless());
+		const int tickCount = 20;
+		const RealTime start = System::time();
+		EXPECT_EQ(0, server.runHeadless(tickCount));
+		const RealTime elapsed = System::time() - start;
+
+		EXPECT_EQ((uint64)tickCount, server.ticksRun());
+		EXPECT_EQ(nullptr, server.renderDevice);
+		// The model free headless scene is loaded in place of the session's scene
+		EXPECT_NE(nullptr, server.scene()->typedEntity<PlayerEntity>("player"));
+		// Ticks keep to the fixed schedule rather than running back to back (loading the session may make the first ones late)
+		EXPECT_GE(elapsed, (tickCount - 5) / FPSciApp::startupConfig.serverTickRate);
+	}
+	FPSciApp::startupConfig = previousConfig;
+}
@@ -1,8 +1,17 @@
 #pragma once
 
 #include <memory>
+#include <set>
 #include "TestFakeInput.h"
+#include <DatagramBatch.h>
 #include <FPSciApp.h>
+#include <FPSciServerApp.h>
+#include <LagCompensator.h>
+#include <LatentNetwork.h>
+#include <LogSink.h>
+#include <Logger.h>
+#include <MpscRingBuffer.h>
+#include <PlayerPrediction.h>
 #include <PlayerEntity.h>
 #include <Session.h>
 #include <gtest/gtest.h>
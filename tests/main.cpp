@@ -3,6 +3,7 @@
 
 #include <gtest/gtest.h>
 #include <FPSciApp.h>
+#ifdef G3D_WINDOWS
 #include <crtdbg.h>
 
 int AbortReportHook(int reportType, char* message, int* returnValue)
@@ -19,13 +20,16 @@ int AbortReportHook(int reportType, char* message, int* returnValue)
 	*returnValue = 1;
 	return true; // no popup!
 }
+#endif
 // Tells C++ to invoke command-line main() function even on OS X and Win32.
 G3D_START_AT_MAIN();
 
 int main(int argc, const char** argv)
 {
+#ifdef G3D_WINDOWS
 	// Stop visual studio creating an abort popup and stalling the CI runner
 	_CrtSetReportHook(AbortReportHook);
+#endif
 
 	// Hack to disable error popups during automated testing because there is no dynamic version of G3D_DEBUG_NOGUI
 	G3D::_internal::_consolePrintHook = nullptr;